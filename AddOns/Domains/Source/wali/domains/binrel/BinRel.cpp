@@ -10,9 +10,12 @@
 //#include "BuddyExt.hpp"
 #include "combination.hpp"
 
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 #include <cmath>
+#include <chrono>
+#include <thread>
 
 #include <boost/algorithm/string/predicate.hpp>
 
@@ -47,11 +50,38 @@ namespace wali
        * idx2Name gives strings to print for bdd level indices.
        * This is passed to the callback function in buddy.
        * This is currently a global so that it can be 
-       * accessed in BinRelManager.
+       * accessed in BinRelManager. Like BuDDy, it is per thread.
        **/
-      RevBddContext idx2Name;
+      thread_local RevBddContext idx2Name;
+
+      /**
+       * Reordering state of this thread's BuDDy. groups lists the BDD
+       * variables of the candidate blocks in the order they were added;
+       * the first 'covered' of them have been made blocks or given up.
+       **/
+      struct ReorderState
+      {
+        ReorderState() : enabled(false), covered(0) {}
+        bool enabled;
+        ReorderOptions options;
+        ReorderStats stats;
+        std::vector< std::vector<int> > groups;
+        size_t covered;
+        std::vector<bool> blocked;
+        std::chrono::steady_clock::time_point started;
+      };
+      thread_local ReorderState reorderState;
 
       static void myFddStrmHandler(std::ostream &o, int var);
+#if (NWA_DETENSOR == 0)
+      static void myReorderHandler(int prestate);
+#endif
+      static void blockReorderGroups(bool all);
+      static std::vector<int> varLevels();
+      static std::vector<size_t> chooseBlocks(std::vector<int> const & level,
+          size_t from, std::vector<bool> & blocked);
+      static std::vector<std::string> orderKeys();
+      static void checkTensorStrategy(TensorStrategy const & s);
       static BinRel* convert(wali::SemElem* se);
 
 
@@ -73,7 +103,7 @@ namespace wali
           return k.first.id() << 1 & (int) k.second;
         }
       };
-      std::tr1::unordered_map< StarCacheKey, sem_elem_t, StarCacheHash> star_cache;
+      thread_local std::tr1::unordered_map< StarCacheKey, sem_elem_t, StarCacheHash> star_cache;
 
 
       namespace details {
@@ -151,7 +181,8 @@ namespace wali
 // ////////////////////////////
 // Definitions of static members from BddContext/BinRel class
 
-int BddContext::numBddContexts = 0;
+thread_local int BddContext::numBddContexts = 0;
+thread_local TensorStrategy BddContext::defaultStrategy;
 // ////////////////////////////
 
 std::ostream& BddInfo::print(std::ostream& o) const
@@ -178,10 +209,130 @@ namespace wali
     {
       static void myFddStrmHandler(std::ostream &o, int var)
       {
-        extern RevBddContext idx2Name;
+        extern thread_local RevBddContext idx2Name;
         o << idx2Name[var];
       }
 
+#if (NWA_DETENSOR == 0)
+      // Called by BuDDy around automatic reorderings, and by
+      // BddContext::reorder around explicit ones.
+      static void myReorderHandler(int prestate)
+      {
+        ReorderStats & stats = reorderState.stats;
+        if(prestate){
+          // Variables made since the last blocking must be in a block
+          // before sifting, or it moves blocks past them.
+          blockReorderGroups(true);
+          reorderState.started = std::chrono::steady_clock::now();
+        }else{
+          stats.reorderings++;
+          stats.seconds += std::chrono::duration<double>(
+              std::chrono::steady_clock::now() - reorderState.started).count();
+          stats.nodes = bdd_getnodenum();
+          stats.gain = bdd_reorder_gain();
+        }
+        // Keeps BuDDy's printing under bdd_reorder_verbose
+        bdd_default_reohandler(prestate);
+      }
+#endif
+
+      // The level of each BDD variable
+      static std::vector<int> varLevels()
+      {
+        std::vector<int> level(bdd_varnum());
+        for(int v = 0; v < (int) level.size(); ++v)
+          level[v] = bdd_var2level(v);
+        return level;
+      }
+
+      // The groups, from 'from' on, that are blocks when the variables are
+      // at the given levels. A group is only a block if its variables are
+      // next to each other, both by number and by level, and none is in a
+      // block yet; the variables of each block are marked in 'blocked'.
+      static std::vector<size_t> chooseBlocks(std::vector<int> const & level,
+          size_t from, std::vector<bool> & blocked)
+      {
+        std::vector< std::vector<int> > const & groups = reorderState.groups;
+        std::vector<size_t> blocks;
+        for(size_t i = from; i < groups.size(); ++i){
+          std::vector<int> const & g = groups[i];
+          if(g.empty())
+            continue;
+          int first = g[0], last = g[0];
+          int top = level[g[0]], bottom = top;
+          bool taken = false;
+          for(std::vector<int>::const_iterator it = g.begin(); it != g.end(); ++it){
+            taken = taken || blocked[*it];
+            first = std::min(first, *it);
+            last = std::max(last, *it);
+            top = std::min(top, level[*it]);
+            bottom = std::max(bottom, level[*it]);
+          }
+          int size = (int) g.size();
+          if(taken || last - first + 1 != size || bottom - top + 1 != size)
+            continue;
+          blocks.push_back(i);
+          for(std::vector<int>::const_iterator it = g.begin(); it != g.end(); ++it)
+            blocked[*it] = true;
+        }
+        return blocks;
+      }
+
+      // Turn the groups added since the last call into fixed blocks. With
+      // 'all', the variables still not in a block get one of their own.
+      static void blockReorderGroups(bool all)
+      {
+        ReorderState & rs = reorderState;
+        int nvars = bdd_varnum();
+        rs.blocked.resize(nvars, false);
+        std::vector<size_t> blocks = chooseBlocks(varLevels(), rs.covered, rs.blocked);
+        for(std::vector<size_t>::const_iterator b = blocks.begin(); b != blocks.end(); ++b){
+          std::vector<int> const & g = rs.groups[*b];
+          bdd_intaddvarblock(*std::min_element(g.begin(), g.end()),
+                             *std::max_element(g.begin(), g.end()),
+                             BDD_REORDER_FIXED);
+        }
+        rs.covered = rs.groups.size();
+        if(all){
+          for(int v = 0; v < nvars; ++v){
+            if(!rs.blocked[v]){
+              bdd_intaddvarblock(v, v, BDD_REORDER_FIXED);
+              rs.blocked[v] = true;
+            }
+          }
+        }
+      }
+
+      // A name for each BDD variable that does not depend on the order:
+      // the name of its fdd, which fdd of that name it is (contexts of a
+      // thread may reuse names) and its bit. Later fdds, made by
+      // fdd_overlapdomain, take over the variables they share.
+      static std::vector<std::string> orderKeys()
+      {
+        std::vector<std::string> keys(bdd_varnum());
+        std::map<std::string, int> seen;
+        for(int d = 0; d < fdd_domainnum(); ++d){
+          RevBddContext::const_iterator name = idx2Name.find(d);
+          if(name == idx2Name.end())
+            continue;
+          int occurrence = seen[name->second]++;
+          int const * vars = fdd_vars(d);
+          for(int b = 0; b < fdd_varnum(d); ++b){
+            std::stringstream key;
+            key << name->second << " " << occurrence << " " << b;
+            keys[vars[b]] = key.str();
+          }
+        }
+        for(size_t v = 0; v < keys.size(); ++v){
+          if(keys[v].empty()){
+            std::stringstream key;
+            key << "- " << v;
+            keys[v] = key.str();
+          }
+        }
+        return keys;
+      }
+
       // Helper function that converts a SemElem
       // into a BinRel*
       static BinRel* convert(wali::SemElem* se) 
@@ -203,13 +354,14 @@ namespace wali
 
 BddContext::BddContext(int bddMemSize, int cacheSize) :
   std::map< const std::string, bddinfo_t>(),
-  count(0)
+  count(0),
+  strategy(defaultStrategy)
 {
   //If buddy has not been initialized, initialize it.
   //We handle this by keeping track of the number of BddContext objects
   //lying around. Since every BinRel also has a BddContext object in it,
   //if there are no BddContext objects, there is Nothing!
-  //lock mutex
+  //The count and BuDDy are both per thread, so this needs no lock.
   if(numBddContexts == 0){
     // ///////////////////////
     // Begin initialize BuDDy
@@ -234,7 +386,6 @@ BddContext::BddContext(int bddMemSize, int cacheSize) :
     // ///////////////////////
   }
   numBddContexts++;
-  //release mutex
 
   baseSwap = BddPairPtr(bdd_newpair());
   tensor1Swap = BddPairPtr(bdd_newpair());
@@ -281,6 +432,7 @@ BddContext::BddContext(int bddMemSize, int cacheSize) :
 BddContext::BddContext(const BddContext& other) :
   std::map< const std::string, bddinfo_t>(other),
   count(0),
+  strategy(other.strategy),
   baseSwap(other.baseSwap),
   tensor1Swap(other.tensor1Swap),
   baseRightShift(other.baseRightShift),
@@ -294,6 +446,7 @@ BddContext::BddContext(const BddContext& other) :
   baseSecBddContextSet(other.baseSecBddContextSet),
   tensorSecBddContextSet(other.tensorSecBddContextSet),
   commonBddContextSet23(other.commonBddContextSet23),
+  commonBddContextId23(other.commonBddContextId23),
   commonBddContextSet13(other.commonBddContextSet13),
   commonBddContextId13(other.commonBddContextId13),
   cachedBaseOne(other.cachedBaseOne),
@@ -322,6 +475,7 @@ BddContext& BddContext::operator = (const BddContext& other)
 {
   if(this!=&other){
     count=0;
+    strategy=other.strategy;
     baseSwap=other.baseSwap;
     tensor1Swap = other.baseSwap;
     baseRightShift=other.baseRightShift;
@@ -335,6 +489,7 @@ BddContext& BddContext::operator = (const BddContext& other)
     baseSecBddContextSet=other.baseSecBddContextSet;
     tensorSecBddContextSet=other.tensorSecBddContextSet;
     commonBddContextSet23=other.commonBddContextSet23;
+    commonBddContextId23=other.commonBddContextId23;
     commonBddContextSet13=other.commonBddContextSet13;
     commonBddContextId13=other.commonBddContextId13;
     cachedBaseOne=other.cachedBaseOne;
@@ -380,19 +535,19 @@ BddContext::~BddContext()
   //Clear the bddinfo_t vector.
   this->clear();
 
-  //lock mutex
   numBddContexts--;
   if(numBddContexts == 0){
-    //All BddContexts are now dead. So we must shutdown buddy.
+    //All BddContexts of this thread are now dead. So we must shutdown its buddy.
     star_cache.clear();
     if(bdd_isrunning() != 0)
       bdd_done();
     //Now clear the reverse map.
     idx2Name.clear();
+    //and forget the blocks, settings and statistics of reordering.
+    reorderState = ReorderState();
     //Also clean up the BinRel class
     BinRel::reset();
   }
-  //release mutex
 }
 
 void BddContext::addBoolVar(std::string name)
@@ -409,7 +564,6 @@ void BddContext::setIntVars(const std::map<std::string, int>& flatvars)
 
 void BddContext::createIntVars(const std::vector<std::map<std::string, int> >& vars)
 {
-  int vari;
   // First work through the variable list and create the vocabulary structure
   // This will collect information about the fdds to be created in buddy
   for(std::vector<std::map<std::string, int> >::const_iterator cvi = vars.begin(); cvi != vars.end(); ++cvi){
@@ -424,7 +578,51 @@ void BddContext::createIntVars(const std::vector<std::map<std::string, int> >& v
     }
   }
 
-#if (TENSOR_MAX_AFFINITY == 1)
+  switch(strategy.layout){
+    case LAYOUT_TENSOR_MAX_AFFINITY:
+      createMaxAffinityLevels(vars);
+      break;
+    case LAYOUT_TENSOR_MIN_AFFINITY:
+      createMinAffinityLevels(vars);
+      break;
+    case LAYOUT_TENSOR_MATCHED_PAREN:
+      createMatchedParenLevels(vars);
+      break;
+    case LAYOUT_BASE_MAX_AFFINITY_TENSOR_MIXED:
+      createMixedTensorLevels(vars);
+      break;
+    default:
+      *waliErr << "[ERROR] Unknown bdd level arrangement " << strategy.layout << endl;
+      assert(false);
+  }
+
+  // Reordering keeps the copies of each bit together
+  for(std::vector<std::map<std::string, int> >::const_iterator cvi = vars.begin(); cvi != vars.end(); ++cvi)
+    for(std::map<std::string, int>::const_iterator cmi = (*cvi).begin(); cmi != (*cvi).end(); ++cmi)
+      addReorderGroups((*this)[cmi->first]);
+
+  // Also update the reverse vocabulary for printing.
+  for(std::map<const std::string, bddinfo_t>::const_iterator ci = this->begin(); ci != this->end(); ++ci){
+    bddinfo_t varInfo = ci->second;
+    idx2Name[varInfo->baseLhs] = ci->first;
+    idx2Name[varInfo->baseRhs] = ci->first + "'";
+    idx2Name[varInfo->baseExtra] = ci->first + "''";
+    idx2Name[varInfo->tensor1Lhs] = ci->first + "_t1";
+    idx2Name[varInfo->tensor1Rhs] = ci->first + "_t1'";
+    idx2Name[varInfo->tensor1Extra] = ci->first + "_t1''";
+    idx2Name[varInfo->tensor2Lhs] = ci->first + "_t2";
+    idx2Name[varInfo->tensor2Rhs] = ci->first + "_t2'";
+    idx2Name[varInfo->tensor2Extra] = ci->first + "_t2''";
+  } 
+
+#if (NWA_DETENSOR == 1)
+  setupLevelArray();
+#endif
+}
+
+void BddContext::createMaxAffinityLevels(const std::vector<std::map<std::string, int> >& vars)
+{
+  int vari;
   for(std::vector<std::map<std::string, int> >::const_iterator cvi = vars.begin(); cvi != vars.end(); ++cvi){
     std::map<std::string, int> interleavedVars = *cvi;
     int * domains = new int[9 * interleavedVars.size()];
@@ -461,7 +659,11 @@ void BddContext::createIntVars(const std::vector<std::map<std::string, int> >& v
       vari++;  
     }
   }
-#elif (TENSOR_MIN_AFFINITY == 1)
+}
+
+void BddContext::createMinAffinityLevels(const std::vector<std::map<std::string, int> >& vars)
+{
+  int vari;
   //First the base levels
   for(std::vector<std::map<std::string, int> >::const_iterator cvi = vars.begin(); cvi != vars.end(); ++cvi){
     std::map<std::string, int> interleavedVars = *cvi;
@@ -555,8 +757,11 @@ void BddContext::createIntVars(const std::vector<std::map<std::string, int> >& v
       vari++;  
     }
   }
+}
 
-#elif (TENSOR_MATCHED_PAREN == 1)
+void BddContext::createMatchedParenLevels(const std::vector<std::map<std::string, int> >& vars)
+{
+  int vari;
   //First the base levels
   for(std::vector<std::map<std::string, int> >::const_iterator cvi = vars.begin(); cvi != vars.end(); ++cvi){
     std::map<std::string, int> interleavedVars = *cvi;
@@ -651,7 +856,11 @@ void BddContext::createIntVars(const std::vector<std::map<std::string, int> >& v
       vari++;  
     }
   }
-#elif (BASE_MAX_AFFINITY_TENSOR_MIXED == 1)
+}
+
+void BddContext::createMixedTensorLevels(const std::vector<std::map<std::string, int> >& vars)
+{
+  int vari;
   //First the base levels
   for(std::vector<std::map<std::string, int> >::const_iterator cvi = vars.begin(); cvi != vars.end(); ++cvi){
     std::map<std::string, int> interleavedVars = *cvi;
@@ -717,27 +926,6 @@ void BddContext::createIntVars(const std::vector<std::map<std::string, int> >& v
       vari++;  
     }
   }
-#else
-#error "Unknown bdd level arrangement macro"
-#endif
-
-  // Also update the reverse vocabulary for printing.
-  for(std::map<const std::string, bddinfo_t>::const_iterator ci = this->begin(); ci != this->end(); ++ci){
-    bddinfo_t varInfo = ci->second;
-    idx2Name[varInfo->baseLhs] = ci->first;
-    idx2Name[varInfo->baseRhs] = ci->first + "'";
-    idx2Name[varInfo->baseExtra] = ci->first + "''";
-    idx2Name[varInfo->tensor1Lhs] = ci->first + "_t1";
-    idx2Name[varInfo->tensor1Rhs] = ci->first + "_t1'";
-    idx2Name[varInfo->tensor1Extra] = ci->first + "_t1''";
-    idx2Name[varInfo->tensor2Lhs] = ci->first + "_t2";
-    idx2Name[varInfo->tensor2Rhs] = ci->first + "_t2'";
-    idx2Name[varInfo->tensor2Extra] = ci->first + "_t2''";
-  } 
-
-#if (NWA_DETENSOR == 1)
-  setupLevelArray();
-#endif
 }
 
 void BddContext::setIntVars(const std::vector<std::map<std::string, int> >& vars)
@@ -849,16 +1037,8 @@ void BddContext::setupCachedBdds()
   commonBddContextSet13 &= fdd_makeset(tensor2Lhs, this->size());
   assert(this->size() == 0 || (baseSecBddContextSet != bddfalse && tensorSecBddContextSet != bddfalse
         && tensorSecBddContextSet != bddfalse && commonBddContextSet23 != bddfalse && commonBddContextSet13 != bddfalse));
-#if (DETENSOR_TOGETHER == 1)
-  // Somehow make this efficient
-  for(std::map<const std::string, bddinfo_t>::const_iterator ci = this->begin(); ci != this->end(); ++ci){
-    bddinfo_t varInfo = ci->second;
-    commonBddContextId23 = commonBddContextId23 &
-      fdd_equals(varInfo->tensor1Rhs, varInfo->tensor2Lhs);
-    commonBddContextId13 = commonBddContextId13 & 
-      fdd_equals(varInfo->tensor1Lhs, varInfo->tensor2Lhs);
-  }
-#endif
+  if(strategy.detensor == DETENSOR_METHOD_TOGETHER)
+    setupDetensorIds();
 
   // Create cached BinRel objects
   // Somehow make this efficient
@@ -944,6 +1124,7 @@ void BddContext::addIntVar(std::string name, unsigned size)
   varInfo->tensor2Rhs = base + 1;
   varInfo->tensor2Extra = base + 2;
   //release mutex
+  addReorderGroups(varInfo);
 
   //We will now update all the cached bdds and bddpairs 
   //update bddPairs
@@ -1023,6 +1204,528 @@ void BddContext::populateCache()
 #endif
 }
 
+ReorderOptions::ReorderOptions() :
+  method(BDD_REORDER_SIFT),
+  budget(-1),
+  growth(100),
+  timeLimit(0)
+{}
+
+ReorderStats::ReorderStats() :
+  reorderings(0),
+  seconds(0),
+  nodes(0),
+  gain(0)
+{}
+
+namespace wali
+{
+  namespace domains
+  {
+    namespace binrel
+    {
+      std::ostream & operator << (std::ostream & out, ReorderStats const & s)
+      {
+        out << "Reorderings : " << s.reorderings << "\n";
+        out << "Time reordering (sec) : " << s.seconds << "\n";
+        out << "Nodes after last reordering : " << s.nodes << "\n";
+        out << "Gain of last reordering (%) : " << s.gain << "\n";
+        return out;
+      }
+    }
+  }
+}
+
+void BddContext::addReorderGroups(int const * fdds, int num)
+{
+  int bits = 0;
+  for(int i = 0; i < num; ++i)
+    bits = std::max(bits, fdd_varnum(fdds[i]));
+  for(int b = 0; b < bits; ++b){
+    std::vector<int> group;
+    for(int i = 0; i < num; ++i)
+      if(b < fdd_varnum(fdds[i]))
+        group.push_back(fdd_vars(fdds[i])[b]);
+    reorderState.groups.push_back(group);
+  }
+  if(reorderState.enabled)
+    blockReorderGroups(false);
+}
+
+void BddContext::addReorderGroups(bddinfo_t varInfo)
+{
+  // If the nine copies of a bit are not next to each other (it depends on
+  // the level arrangement), each ply may still be.
+  int all[9] = {
+    (int) varInfo->baseLhs, (int) varInfo->baseRhs, (int) varInfo->baseExtra,
+    (int) varInfo->tensor1Lhs, (int) varInfo->tensor1Rhs, (int) varInfo->tensor1Extra,
+    (int) varInfo->tensor2Lhs, (int) varInfo->tensor2Rhs, (int) varInfo->tensor2Extra};
+  addReorderGroups(all, 9);
+  addReorderGroups(all, 3);
+  addReorderGroups(all + 3, 3);
+  addReorderGroups(all + 6, 3);
+}
+
+void BddContext::enableReordering(ReorderOptions const & options)
+{
+#if (NWA_DETENSOR == 1)
+  (void) options;
+  *waliErr << "[WARNING] Reordering is not supported with NWA_DETENSOR." << endl;
+#else
+  reorderState.enabled = true;
+  reorderState.options = options;
+  bdd_reorder_hook(myReorderHandler);
+  bdd_setreordergrowth(options.growth);
+  bdd_reorder_timelimit(options.timeLimit);
+  if(options.budget < 0)
+    bdd_autoreorder(options.method);
+  else
+    bdd_autoreorder_times(options.method, options.budget);
+  blockReorderGroups(false);
+#endif
+}
+
+void BddContext::disableReordering()
+{
+  reorderState.enabled = false;
+  bdd_autoreorder(BDD_REORDER_NONE);
+}
+
+void BddContext::reorder()
+{
+#if (NWA_DETENSOR == 1)
+  *waliErr << "[WARNING] Reordering is not supported with NWA_DETENSOR." << endl;
+#else
+  myReorderHandler(1);
+  bdd_reorder(reorderState.options.method);
+  myReorderHandler(0);
+#endif
+}
+
+ReorderStats const & BddContext::getReorderStats()
+{
+  return reorderState.stats;
+}
+
+void BddContext::resetReorderStats()
+{
+  reorderState.stats = ReorderStats();
+}
+
+void BddContext::saveVariableOrder(std::ostream & out)
+{
+  std::vector<std::string> keys = orderKeys();
+  out << "# BDD variable order, top level first: name, which of that name, bit\n";
+  for(int level = 0; level < (int) keys.size(); ++level)
+    out << keys[bdd_level2var(level)] << "\n";
+}
+
+bool BddContext::loadVariableOrder(std::istream & in)
+{
+  std::vector<std::string> keys = orderKeys();
+  int nvars = (int) keys.size();
+  std::map<std::string, int> var;
+  for(int v = 0; v < nvars; ++v)
+    var[keys[v]] = v;
+
+  std::vector<int> order;
+  std::vector<bool> placed(nvars, false);
+  std::string line;
+  while(std::getline(in, line)){
+    if(line.empty() || line[0] == '#')
+      continue;
+    std::map<std::string, int>::const_iterator it = var.find(line);
+    if(it != var.end() && !placed[it->second]){
+      order.push_back(it->second);
+      placed[it->second] = true;
+    }
+  }
+  bool complete = ((int) order.size() == nvars);
+  for(int level = 0; level < nvars; ++level){
+    int v = bdd_level2var(level);
+    if(!placed[v])
+      order.push_back(v);
+  }
+  if(nvars == 0)
+    return true;
+
+  // BuDDy only sets an order without blocks, so they are made again from
+  // the groups. Refuse an order under which they would not all come back.
+  std::vector<int> level(nvars);
+  for(int l = 0; l < nvars; ++l)
+    level[order[l]] = l;
+  std::vector<bool> blockedNow(nvars, false), blockedThen(nvars, false);
+  std::vector<size_t> now = chooseBlocks(varLevels(), 0, blockedNow);
+  std::vector<size_t> then = chooseBlocks(level, 0, blockedThen);
+  if(now != then){
+    *waliErr << "[WARNING] loadVariableOrder: the order splits reordering blocks; it is ignored." << endl;
+    return false;
+  }
+
+  bdd_clrvarblocks();
+  reorderState.covered = 0;
+  reorderState.blocked.assign(nvars, false);
+  bdd_setvarorder(&order[0]);
+  if(reorderState.enabled)
+    blockReorderGroups(false);
+  return complete;
+}
+
+void BddContext::setTensorStrategy(TensorStrategy const & s)
+{
+  checkTensorStrategy(s);
+  bool needIds = (s.detensor == DETENSOR_METHOD_TOGETHER
+      && strategy.detensor != DETENSOR_METHOD_TOGETHER);
+  strategy = s;
+  if(needIds)
+    setupDetensorIds();
+}
+
+TensorStrategy const & BddContext::getTensorStrategy() const
+{
+  return strategy;
+}
+
+void BddContext::setDefaultTensorStrategy(TensorStrategy const & s)
+{
+  checkTensorStrategy(s);
+  defaultStrategy = s;
+}
+
+TensorStrategy const & BddContext::getDefaultTensorStrategy()
+{
+  return defaultStrategy;
+}
+
+void BddContext::setupDetensorIds()
+{
+  // Somehow make this efficient
+  commonBddContextId23 = bddtrue;
+  commonBddContextId13 = bddtrue;
+  for(std::map<const std::string, bddinfo_t>::const_iterator ci = this->begin(); ci != this->end(); ++ci){
+    bddinfo_t varInfo = ci->second;
+    commonBddContextId23 = commonBddContextId23 &
+      fdd_equals(varInfo->tensor1Rhs, varInfo->tensor2Lhs);
+    commonBddContextId13 = commonBddContextId13 & 
+      fdd_equals(varInfo->tensor1Lhs, varInfo->tensor2Lhs);
+  }
+}
+
+namespace wali
+{
+  namespace domains
+  {
+    namespace binrel
+    {
+      TensorStrategy::TensorStrategy() :
+#if (TENSOR_MIN_AFFINITY == 1)
+        layout(LAYOUT_TENSOR_MIN_AFFINITY),
+#elif (BASE_MAX_AFFINITY_TENSOR_MIXED == 1)
+        layout(LAYOUT_BASE_MAX_AFFINITY_TENSOR_MIXED),
+#elif (TENSOR_MATCHED_PAREN == 1)
+        layout(LAYOUT_TENSOR_MATCHED_PAREN),
+#else
+        layout(LAYOUT_TENSOR_MAX_AFFINITY),
+#endif
+#if (DETENSOR_TOGETHER == 1)
+        detensor(DETENSOR_METHOD_TOGETHER)
+#elif (NWA_DETENSOR == 1)
+        detensor(DETENSOR_METHOD_NWA)
+#else
+        detensor(DETENSOR_METHOD_BIT_BY_BIT)
+#endif
+      {}
+
+      TensorStrategy::TensorStrategy(TensorLayout l, DetensorMethod d) :
+        layout(l),
+        detensor(d)
+      {}
+
+      bool TensorStrategy::operator == (TensorStrategy const & other) const
+      {
+        return layout == other.layout && detensor == other.detensor;
+      }
+
+      bool TensorStrategy::operator != (TensorStrategy const & other) const
+      {
+        return !(*this == other);
+      }
+
+      std::ostream & operator << (std::ostream & out, TensorStrategy const & s)
+      {
+        switch(s.layout){
+          case LAYOUT_TENSOR_MAX_AFFINITY: out << "TENSOR_MAX_AFFINITY"; break;
+          case LAYOUT_TENSOR_MIN_AFFINITY: out << "TENSOR_MIN_AFFINITY"; break;
+          case LAYOUT_BASE_MAX_AFFINITY_TENSOR_MIXED: out << "BASE_MAX_AFFINITY_TENSOR_MIXED"; break;
+          case LAYOUT_TENSOR_MATCHED_PAREN: out << "TENSOR_MATCHED_PAREN"; break;
+        }
+        out << " ";
+        switch(s.detensor){
+          case DETENSOR_METHOD_TOGETHER: out << "DETENSOR_TOGETHER"; break;
+          case DETENSOR_METHOD_BIT_BY_BIT: out << "DETENSOR_BIT_BY_BIT"; break;
+          case DETENSOR_METHOD_NWA: out << "NWA_DETENSOR"; break;
+        }
+        return out;
+      }
+
+      static void checkTensorStrategy(TensorStrategy const & s)
+      {
+#if (NWA_DETENSOR == 1)
+        if(s != TensorStrategy()){
+          *waliErr << "[ERROR] The tensor strategy is fixed by NWA_DETENSOR." << endl;
+          assert(false);
+        }
+#else
+        if(s.detensor == DETENSOR_METHOD_NWA){
+          *waliErr << "[ERROR] The Nwa based detensor needs NWA_DETENSOR." << endl;
+          assert(false);
+        }
+#endif
+      }
+
+      /// One of the nine copies of a variable, numbered in the order of
+      /// the fields of BddInfo.
+      static int copyFdd(bddinfo_t varInfo, int copy)
+      {
+        switch(copy){
+          case 0: return varInfo->baseLhs;
+          case 1: return varInfo->baseRhs;
+          case 2: return varInfo->baseExtra;
+          case 3: return varInfo->tensor1Lhs;
+          case 4: return varInfo->tensor1Rhs;
+          case 5: return varInfo->tensor1Extra;
+          case 6: return varInfo->tensor2Lhs;
+          case 7: return varInfo->tensor2Rhs;
+          default: return varInfo->tensor2Extra;
+        }
+      }
+
+      /// What a BDD variable encodes: a bit of one copy of a variable
+      struct CopyKey
+      {
+        CopyKey() : copy(-1), bit(-1) {}
+        CopyKey(std::string const & n, int c, int b) : name(n), copy(c), bit(b) {}
+
+        bool operator < (CopyKey const & other) const
+        {
+          if(name != other.name)
+            return name < other.name;
+          if(copy != other.copy)
+            return copy < other.copy;
+          return bit < other.bit;
+        }
+
+        std::string name;
+        int copy;
+        int bit;
+      };
+
+      /// The keys of the BDD variables of voc. Other variables get copy -1.
+      static std::vector<CopyKey> copyKeys(BddContext const & voc)
+      {
+        std::vector<CopyKey> keys(bdd_varnum());
+        for(BddContext::const_iterator ci = voc.begin(); ci != voc.end(); ++ci){
+          for(int copy = 0; copy < 9; ++copy){
+            int d = copyFdd(ci->second, copy);
+            int const * vars = fdd_vars(d);
+            for(int b = 0; b < fdd_varnum(d); ++b)
+              keys[vars[b]] = CopyKey(ci->first, copy, b);
+          }
+        }
+        return keys;
+      }
+
+      /**
+       * A BDD written out node by node, children first, so that it can be
+       * rebuilt in the BuDDy of another thread. Children are 0 (false), 1
+       * (true) or 2 + the position of their node.
+       **/
+      struct SampleBdd
+      {
+        struct Node
+        {
+          int var;
+          int low;
+          int high;
+        };
+        std::vector<Node> nodes;
+        int root;
+        bool tensored;
+      };
+
+      static int writeNodes(bdd b, std::map<int, int> & written, std::vector<SampleBdd::Node> & nodes)
+      {
+        if(b == bddfalse)
+          return 0;
+        if(b == bddtrue)
+          return 1;
+        std::map<int, int>::const_iterator it = written.find(b.id());
+        if(it != written.end())
+          return it->second;
+        SampleBdd::Node n;
+        n.var = bdd_var(b);
+        n.low = writeNodes(bdd_low(b), written, nodes);
+        n.high = writeNodes(bdd_high(b), written, nodes);
+        nodes.push_back(n);
+        written[b.id()] = (int) nodes.size() + 1;
+        return (int) nodes.size() + 1;
+      }
+
+      /// var maps the BDD variables of the writing thread to this one's
+      static bdd readNodes(SampleBdd const & s, std::vector<int> const & var)
+      {
+        std::vector<bdd> built;
+        built.reserve(s.nodes.size() + 2);
+        built.push_back(bddfalse);
+        built.push_back(bddtrue);
+        for(std::vector<SampleBdd::Node>::const_iterator it = s.nodes.begin(); it != s.nodes.end(); ++it)
+          built.push_back(bdd_ite(bdd_ithvar(var[it->var]), built[it->high], built[it->low]));
+        return built[s.root];
+      }
+
+      /// One candidate of BddContext::tuneTensorStrategy
+      struct TuneRun
+      {
+        TensorStrategy strategy;
+        std::map<std::string, int> vars;
+        std::vector<CopyKey> const * keys;
+        std::vector<SampleBdd> const * sample;
+        int memSize;
+        /// Give up after this many seconds; no limit if negative
+        double limit;
+        double seconds;
+        bool finished;
+      };
+
+      static double secondsSince(std::chrono::steady_clock::time_point start)
+      {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      }
+
+      static void runTuneCandidate(TuneRun * run)
+      {
+        bdd_context_t con = new BddContext(run->memSize);
+        con->setTensorStrategy(run->strategy);
+        con->setIntVars(run->vars);
+
+        std::map<CopyKey, int> mine;
+        for(BddContext::const_iterator ci = con->begin(); ci != con->end(); ++ci){
+          for(int copy = 0; copy < 9; ++copy){
+            int d = copyFdd(ci->second, copy);
+            for(int b = 0; b < fdd_varnum(d); ++b)
+              mine[CopyKey(ci->first, copy, b)] = fdd_vars(d)[b];
+          }
+        }
+        std::vector<int> var(run->keys->size(), -1);
+        for(size_t v = 0; v < var.size(); ++v)
+          if((*run->keys)[v].copy >= 0)
+            var[v] = mine[(*run->keys)[v]];
+
+        std::vector<binrel_t> base, tensored;
+        for(std::vector<SampleBdd>::const_iterator it = run->sample->begin(); it != run->sample->end(); ++it){
+          binrel_t w = new BinRel(con.get_ptr(), readNodes(*it, var), it->tensored);
+          (it->tensored ? tensored : base).push_back(w);
+        }
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        bool over = false;
+        for(size_t i = 0; i < base.size() && !over; ++i){
+          binrel_t a = base[i];
+          binrel_t b = base[(i + 1) % base.size()];
+          a->Compose(b);
+          binrel_t t1 = a->Kronecker(b);
+          binrel_t t2 = b->Kronecker(a);
+          binrel_t t = t1->Compose(t2)->Union(t1);
+          t->Eq23Project();
+          t->Eq13Project();
+          over = (run->limit >= 0 && secondsSince(start) > run->limit);
+        }
+        for(size_t i = 0; i < tensored.size() && !over; ++i){
+          binrel_t t = tensored[i]->Compose(tensored[(i + 1) % tensored.size()]);
+          t->Eq23Project();
+          t->Eq13Project();
+          over = (run->limit >= 0 && secondsSince(start) > run->limit);
+        }
+        run->seconds = secondsSince(start);
+        run->finished = !over;
+      }
+    }
+  }
+}
+
+TensorStrategy BddContext::tuneTensorStrategy(BddContext const & voc,
+    std::vector<binrel_t> const & sample,
+    std::ostream * report)
+{
+#if (NWA_DETENSOR == 1)
+  if(report)
+    *report << "The tensor strategy is fixed by NWA_DETENSOR: " << TensorStrategy() << "\n";
+  (void) voc;
+  (void) sample;
+  return TensorStrategy();
+#else
+  // Write out the sample in terms of the variables of voc. Constants
+  // exercise nothing, and weights over other variables cannot be rebuilt.
+  std::vector<CopyKey> keys = copyKeys(voc);
+  std::vector<SampleBdd> bdds;
+  int nodes = 0;
+  for(std::vector<binrel_t>::const_iterator it = sample.begin(); it != sample.end(); ++it){
+    SampleBdd s;
+    std::map<int, int> written;
+    s.root = writeNodes((*it)->getBdd(), written, s.nodes);
+    s.tensored = false;
+    bool known = !s.nodes.empty();
+    for(std::vector<SampleBdd::Node>::const_iterator n = s.nodes.begin(); n != s.nodes.end() && known; ++n){
+      known = (keys[n->var].copy >= 0);
+      s.tensored = s.tensored || keys[n->var].copy >= 3;
+    }
+    if(known){
+      bdds.push_back(s);
+      nodes += (int) s.nodes.size();
+    }
+  }
+  if(bdds.empty()){
+    if(report)
+      *report << "No usable sample, keeping " << defaultStrategy << "\n";
+    return defaultStrategy;
+  }
+
+  std::map<std::string, int> vars;
+  for(BddContext::const_iterator ci = voc.begin(); ci != voc.end(); ++ci)
+    vars[ci->first] = ci->second->maxVal;
+
+  TensorLayout layouts[] = {
+    LAYOUT_TENSOR_MAX_AFFINITY, LAYOUT_TENSOR_MIN_AFFINITY,
+    LAYOUT_BASE_MAX_AFFINITY_TENSOR_MIXED, LAYOUT_TENSOR_MATCHED_PAREN};
+  DetensorMethod methods[] = {DETENSOR_METHOD_BIT_BY_BIT, DETENSOR_METHOD_TOGETHER};
+  TensorStrategy best = defaultStrategy;
+  double bestSeconds = -1;
+  for(int l = 0; l < 4; ++l){
+    for(int m = 0; m < 2; ++m){
+      TuneRun run;
+      run.strategy = TensorStrategy(layouts[l], methods[m]);
+      run.vars = vars;
+      run.keys = &keys;
+      run.sample = &bdds;
+      // The operations of the sample, not the table, should decide.
+      run.memSize = std::max(BDDMEMSIZE/10, 16 * nodes);
+      run.limit = bestSeconds;
+      std::thread candidate(runTuneCandidate, &run);
+      candidate.join();
+      if(report){
+        *report << run.strategy << " : " << run.seconds << " sec";
+        *report << (run.finished ? "\n" : " (stopped)\n");
+      }
+      if(run.finished && (bestSeconds < 0 || run.seconds < bestSeconds)){
+        best = run.strategy;
+        bestSeconds = run.seconds;
+      }
+    }
+  }
+  return best;
+#endif
+}
+
 // ////////////////////////////
 // Static
 void BinRel::reset()
@@ -1091,15 +1794,17 @@ binrel_t BinRel::Compose( binrel_t that ) const
   if (that->isOne())
     return new BinRel(*this);
 
+  // Shift that->rel right, join on the middle vocabulary and restore the
+  // result, all in one pass of BuDDy.
   bdd c;
   if(!isTensored){
-    bdd temp1 = bdd_replace(that->rel, con->baseRightShift.get());
-    bdd temp2 = bdd_relprod(rel, temp1, con->baseSecBddContextSet);
-    c = bdd_replace(temp2, con->baseRestore.get());
+    c = bdd_relprodreplace(rel, NULL,
+        that->rel, con->baseRightShift.get(),
+        con->baseSecBddContextSet, con->baseRestore.get());
   }else{
-    bdd temp1 = bdd_replace(that->rel, con->tensorRightShift.get());
-    bdd temp2 = bdd_relprod(rel, temp1, con->tensorSecBddContextSet);
-    c = bdd_replace(temp2, con->tensorRestore.get());
+    c = bdd_relprodreplace(rel, NULL,
+        that->rel, con->tensorRightShift.get(),
+        con->tensorSecBddContextSet, con->tensorRestore.get());
   }
 
   binrel_t ret = new BinRel(con,c,isTensored);
@@ -1247,9 +1952,8 @@ binrel_t BinRel::Kronecker(binrel_t that) const
 #if (NWA_DETENSOR == 1)
   bdd c = tensorViaDetensor(that->rel); //nwa_detensor.cpp
 #else
-  bdd rel1 = bdd_replace(rel, con->move2Tensor1.get());
-  bdd rel2 = bdd_replace(that->rel, con->move2Tensor2.get());
-  bdd c = rel1 & rel2;
+  bdd c = bdd_relprodreplace(rel, con->move2Tensor1.get(),
+      that->rel, con->move2Tensor2.get(), bddtrue, NULL);
 #endif
   binrel_t ret = new BinRel(con, c,true);
   if(ret->isZero())
@@ -1270,20 +1974,23 @@ binrel_t BinRel::Eq23Project() const
     return new BinRel(con,bddfalse, false);
   }
 #endif
-#if (DETENSOR_TOGETHER == 1)
-  bdd rel1 = rel & con->commonBddContextId23; 
-  bdd rel2 = bdd_exist(rel1, con->commonBddContextSet23);
-  bdd c = bdd_replace(rel2, con->move2Base.get());
-#else
-  bdd rel1 = rel;
-  for(std::map<const std::string, bddinfo_t>::const_iterator citer = con->begin(); citer != con->end(); ++citer){
-    bddinfo_t varInfo = (*citer).second;
-    bdd id = fdd_equals(varInfo->tensor1Rhs, varInfo->tensor2Lhs);
-    rel1 = rel1 & id;
-    rel1 = bdd_exist(rel1, fdd_ithset(varInfo->tensor1Rhs) & fdd_ithset(varInfo->tensor2Lhs));
+  bdd c = rel;
+  if(con->strategy.detensor == DETENSOR_METHOD_TOGETHER){
+    c = bdd_relprodreplace(rel, NULL, con->commonBddContextId23, NULL,
+        con->commonBddContextSet23, con->move2Base.get());
+  }else{
+    if(con->empty())
+      c = bdd_replace(c, con->move2Base.get());
+    for(std::map<const std::string, bddinfo_t>::const_iterator citer = con->begin(); citer != con->end(); ++citer){
+      bddinfo_t varInfo = (*citer).second;
+      bdd id = fdd_equals(varInfo->tensor1Rhs, varInfo->tensor2Lhs);
+      // The last variable also moves the result to the base levels.
+      std::map<const std::string, bddinfo_t>::const_iterator next = citer;
+      bddPair * move = (++next == con->end()) ? con->move2Base.get() : NULL;
+      c = bdd_relprodreplace(c, NULL, id, NULL,
+          fdd_ithset(varInfo->tensor1Rhs) & fdd_ithset(varInfo->tensor2Lhs), move);
+    }
   }
-  bdd c = bdd_replace(rel1, con->move2Base.get());
-#endif
   binrel_t ret = new BinRel(con,c,false);
   if(ret->isZero())
     return static_cast<BinRel*>(ret->zero().get_ptr());
@@ -1303,20 +2010,23 @@ binrel_t BinRel::Eq13Project() const
     return new BinRel(con,bddfalse, false);
   }
 #endif
-#if (DETENSOR_TOGETHER == 1)
-  bdd rel1 = rel & con->commonBddContextId13; 
-  bdd rel2 = bdd_exist(rel1, con->commonBddContextSet13);
-  bdd c = bdd_replace(rel2, con->move2BaseTwisted.get());
-#else
-  bdd rel1 = rel;
-  for(std::map<const std::string, bddinfo_t>::const_iterator citer = con->begin(); citer != con->end(); ++citer){
-    bddinfo_t varInfo = (*citer).second;
-    bdd id = fdd_equals(varInfo->tensor1Lhs, varInfo->tensor2Lhs);
-    rel1 = rel1 & id;
-    rel1 = bdd_exist(rel1, fdd_ithset(varInfo->tensor1Lhs) & fdd_ithset(varInfo->tensor2Lhs));
+  bdd c = rel;
+  if(con->strategy.detensor == DETENSOR_METHOD_TOGETHER){
+    c = bdd_relprodreplace(rel, NULL, con->commonBddContextId13, NULL,
+        con->commonBddContextSet13, con->move2BaseTwisted.get());
+  }else{
+    if(con->empty())
+      c = bdd_replace(c, con->move2BaseTwisted.get());
+    for(std::map<const std::string, bddinfo_t>::const_iterator citer = con->begin(); citer != con->end(); ++citer){
+      bddinfo_t varInfo = (*citer).second;
+      bdd id = fdd_equals(varInfo->tensor1Lhs, varInfo->tensor2Lhs);
+      // The last variable also moves the result to the base levels.
+      std::map<const std::string, bddinfo_t>::const_iterator next = citer;
+      bddPair * move = (++next == con->end()) ? con->move2BaseTwisted.get() : NULL;
+      c = bdd_relprodreplace(c, NULL, id, NULL,
+          fdd_ithset(varInfo->tensor1Lhs) & fdd_ithset(varInfo->tensor2Lhs), move);
+    }
   }
-  bdd c = bdd_replace(rel1, con->move2BaseTwisted.get());
-#endif
   binrel_t ret = new BinRel(con,c,false);
   if(ret->isZero())
     return static_cast<BinRel*>(ret->zero().get_ptr());
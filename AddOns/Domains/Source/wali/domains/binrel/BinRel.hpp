@@ -85,6 +85,8 @@
  * x1t2 x1t2' x1t2'' y1t2 y1t2' y1t2'' x2t2 x2t2' x2t2'' y2t2 y2t2' y2t2'' z1t2 z1t2' z1t2'' w1t2 w1t2' w1t2'' z2t2 z2t2' z2t2'' w2t2 w2t2' w2t2''
  *
  * The tensor choice is determined by setting **exactly one** macro to 1.
+ * This is only the default: a BddContext can use another arrangement for the
+ * variables it creates, see BddContext::setTensorStrategy.
  **/
 #define TENSOR_MAX_AFFINITY 1
 #define TENSOR_MIN_AFFINITY 0
@@ -110,6 +112,8 @@
  * the detensored bdd.
  *
  * The detensor choice is made by setting **exactly one** macro to 1
+ * As for the tensor choice, DETENSOR_TOGETHER and DETENSOR_BIT_BY_BIT only set
+ * the default. NWA_DETENSOR is fixed at compile time.
  **/
 #define DETENSOR_TOGETHER 0
 #define DETENSOR_BIT_BY_BIT 1
@@ -210,6 +214,84 @@ namespace wali
         
       typedef ref_ptr<BddInfo> bddinfo_t;
 
+      /**
+       * Settings for dynamic variable reordering. See
+       * BddContext::enableReordering.
+       */
+      struct ReorderOptions
+      {
+        ReorderOptions();
+
+        /// BuDDy reordering method, BDD_REORDER_SIFT by default. The time
+        /// limit only applies to the sifting methods.
+        int method;
+        /// Number of automatic reorderings allowed; -1 (default) is no
+        /// limit.
+        int budget;
+        /// Growth of the used nodes, in percent of the count after the
+        /// last reordering, that triggers the next one. Default 100.
+        int growth;
+        /// Wall-clock time one reordering may take, in milliseconds; 0
+        /// (default) is no limit.
+        int timeLimit;
+      };
+
+      /**
+       * What reordering has done on this thread, automatic and explicit
+       * reorderings alike.
+       */
+      struct ReorderStats
+      {
+        ReorderStats();
+
+        unsigned reorderings;
+        /// Wall-clock time spent reordering
+        double seconds;
+        /// Live nodes after the last reordering, and the percentage of
+        /// them it removed (bdd_reorder_gain)
+        int nodes;
+        int gain;
+      };
+
+      std::ostream & operator << (std::ostream & out, ReorderStats const & s);
+
+      /// The level arrangements described at the top of this file
+      enum TensorLayout
+      {
+        LAYOUT_TENSOR_MAX_AFFINITY,
+        LAYOUT_TENSOR_MIN_AFFINITY,
+        LAYOUT_BASE_MAX_AFFINITY_TENSOR_MIXED,
+        LAYOUT_TENSOR_MATCHED_PAREN
+      };
+
+      /// The detensor methods described at the top of this file
+      enum DetensorMethod
+      {
+        DETENSOR_METHOD_TOGETHER,
+        DETENSOR_METHOD_BIT_BY_BIT,
+        DETENSOR_METHOD_NWA
+      };
+
+      /**
+       * How a BddContext lays out the tensor levels and detensors. See
+       * BddContext::setTensorStrategy.
+       */
+      struct TensorStrategy
+      {
+        /// The one chosen by the macros at the top of this file
+        TensorStrategy();
+        TensorStrategy(TensorLayout layout, DetensorMethod detensor);
+
+        bool operator == (TensorStrategy const & other) const;
+        bool operator != (TensorStrategy const & other) const;
+
+        TensorLayout layout;
+        DetensorMethod detensor;
+      };
+
+      /// Writes the names of the macros that select s
+      std::ostream & operator << (std::ostream & out, TensorStrategy const & s);
+
       class BinRel;
       typedef wali::ref_ptr<BinRel> binrel_t;
       /**A BddContext has the binding information for the variables in the
@@ -224,6 +306,21 @@ namespace wali
        *     setIntVars or setBoolVars instead of addBoolVars / addIntVars.
        *     It's better tested and more flexible.
        *  -- Create BinRels and play with them as you like.
+       *
+       * Each thread has a BuDDy of its own (node table, caches and garbage
+       * collection), started by its first BddContext and stopped with its
+       * last one. A BddContext and its BinRels must stay on the thread that
+       * created the context; contexts on separate threads are independent
+       * and can be used concurrently.
+       *
+       * The variable order fixed by the level arrangement of the tensor
+       * strategy is only the starting point if reordering is enabled.
+       * Reordering moves blocks of BDD variables: each block holds one
+       * bit of one variable in all of its copies (base and both tensor
+       * plies, lhs, rhs and extra), in their original order, so the
+       * renamings between the copies keep their cost. As BuDDy, the
+       * reordering settings, the statistics and the order are per thread
+       * and shared by all the contexts of the thread.
        **/
       class BddContext : public std::map<const std::string,bddinfo_t>
       {
@@ -260,6 +357,65 @@ namespace wali
           virtual void setIntVars(const std::map<std::string, int>& vars);
           virtual void setIntVars(const std::vector<std::map<std::string, int> >& vars);
 
+          /**
+           * Turn on automatic reordering. Variables added later are
+           * blocked as they are created. Not for use with NWA_DETENSOR,
+           * which keeps arrays of the levels.
+           **/
+          static void enableReordering(ReorderOptions const & options = ReorderOptions());
+          /** Turn off automatic reordering. The order reached so far stays. **/
+          static void disableReordering();
+          /** Reorder now, with the method of the last enableReordering. **/
+          static void reorder();
+
+          static ReorderStats const & getReorderStats();
+          static void resetReorderStats();
+
+          /**
+           * Write the current variable order, top level first, one BDD
+           * variable per line by the name, copy and bit it encodes.
+           **/
+          static void saveVariableOrder(std::ostream & out);
+          /**
+           * Set the order written by saveVariableOrder in an earlier run
+           * that created the same variables. Variables not in the stream
+           * go below the others, in their current order. Returns true if
+           * every variable was found. An order that would split one of
+           * the reordering blocks is not used, and false is returned.
+           **/
+          static bool loadVariableOrder(std::istream & in);
+
+          /**
+           * Set the level arrangement for the variables that later calls
+           * to setIntVars create, and the detensor method of this
+           * context. Variables that exist keep their levels. (addIntVar
+           * always keeps the three plies of the new variable apart.)
+           * Under NWA_DETENSOR the strategy is fixed at compile time.
+           **/
+          void setTensorStrategy(TensorStrategy const & s);
+          TensorStrategy const & getTensorStrategy() const;
+
+          /**
+           * The strategy of the contexts created later on this thread.
+           * It starts as the one chosen by the macros.
+           **/
+          static void setDefaultTensorStrategy(TensorStrategy const & s);
+          static TensorStrategy const & getDefaultTensorStrategy();
+
+          /**
+           * Time each strategy on a few sample weights over voc and return
+           * the fastest. Every candidate runs on a thread of its own, with
+           * a BuDDy of its own, where setIntVars recreates the variables
+           * of voc (as one group) and the sample is rebuilt. The untensored
+           * weights of the sample are composed and tensored pairwise, the
+           * tensored ones composed, and both are detensored both ways. The
+           * time of each candidate goes to report if it is given. The
+           * BuDDy of the calling thread is not touched.
+           **/
+          static TensorStrategy tuneTensorStrategy(BddContext const & voc,
+              std::vector<binrel_t> const & sample,
+              std::ostream * report = NULL);
+
 #if (NWA_DETENSOR == 1)
           /**
            * These functions are used by an NWA based implementation of detensor.
@@ -277,13 +433,29 @@ namespace wali
            * called in order are the same as calling setIntVars
            **/
           void createIntVars(const std::vector<std::map<std::string, int> >& vars);
+          /** createIntVars for each of the level arrangements **/
+          void createMaxAffinityLevels(const std::vector<std::map<std::string, int> >& vars);
+          void createMinAffinityLevels(const std::vector<std::map<std::string, int> >& vars);
+          void createMatchedParenLevels(const std::vector<std::map<std::string, int> >& vars);
+          void createMixedTensorLevels(const std::vector<std::map<std::string, int> >& vars);
           virtual void setupCachedBdds();
+          /**
+           * Make each bit of the given fdds one block for reordering,
+           * provided its BDD variables are next to each other.
+           **/
+          static void addReorderGroups(int const * fdds, int num);
+          /** The groups of a variable: all of its copies, or each ply. **/
+          static void addReorderGroups(bddinfo_t varInfo);
         public:
           //using wali::Countable::count;
           int count;
         private:
           /** caches zero/one binrel objects for this context **/
           void populateCache();
+          /** The identities used by DETENSOR_METHOD_TOGETHER **/
+          void setupDetensorIds();
+
+          TensorStrategy strategy;
           
         private:
           // ///////////////////////////////
@@ -359,7 +531,9 @@ namespace wali
         private:
           //Initialization of buddy is taken care of opaquely 
           //by keeping track of the number of BddContext objects alive
-          static int numBddContexts;
+          //on this thread
+          static thread_local int numBddContexts;
+          static thread_local TensorStrategy defaultStrategy;
       };
 
       
@@ -0,0 +1,810 @@
+/**
+ * @file BitRel.cpp
+ */
+
+#include "BitRel.hpp"
+
+#include "wali/Common.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <cassert>
+
+using namespace wali::domains::binrel;
+using std::endl;
+using wali::waliErr;
+
+namespace
+{
+  typedef BitMatrix::Word Word;
+
+  inline unsigned lowestBit(Word w)
+  {
+#if defined(__GNUC__)
+    return __builtin_ctzll(w);
+#else
+    unsigned i = 0;
+    while(!(w & 1)){
+      w >>= 1;
+      ++i;
+    }
+    return i;
+#endif
+  }
+
+  inline unsigned popCount(Word w)
+  {
+#if defined(__GNUC__)
+    return __builtin_popcountll(w);
+#else
+    unsigned i = 0;
+    for(; w; w &= w - 1)
+      ++i;
+    return i;
+#endif
+  }
+
+  /// The low n bits set, for 0 < n <= 64
+  inline Word lowMask(unsigned n)
+  {
+    return n >= BitMatrix::WORD_BITS ? ~Word(0) : (Word(1) << n) - 1;
+  }
+
+  /// dst[0..n) |= src[0..n). The loop every kernel below ends up in;
+  /// it is kept this simple so that it is vectorized.
+  inline void orWords(Word * dst, Word const * src, unsigned n)
+  {
+    for(unsigned i = 0; i < n; ++i)
+      dst[i] |= src[i];
+  }
+
+  /// The len <= 64 bits of row starting at bit pos
+  inline Word extractBits(Word const * row, unsigned pos, unsigned len)
+  {
+    unsigned w = pos / BitMatrix::WORD_BITS;
+    unsigned s = pos % BitMatrix::WORD_BITS;
+    Word v = row[w] >> s;
+    if(s != 0 && s + len > BitMatrix::WORD_BITS)
+      v |= row[w + 1] << (BitMatrix::WORD_BITS - s);
+    return v & lowMask(len);
+  }
+
+  /// ORs the len <= 64 low bits of v into row starting at bit pos
+  inline void depositBits(Word * row, unsigned pos, Word v, unsigned len)
+  {
+    unsigned w = pos / BitMatrix::WORD_BITS;
+    unsigned s = pos % BitMatrix::WORD_BITS;
+    row[w] |= v << s;
+    if(s != 0 && s + len > BitMatrix::WORD_BITS)
+      row[w + 1] |= v >> (BitMatrix::WORD_BITS - s);
+  }
+
+  /// Calls f(c) for each set column c of a row of n words
+  template<typename F>
+  inline void forEachBit(Word const * row, unsigned n, F f)
+  {
+    for(unsigned w = 0; w < n; ++w){
+      for(Word x = row[w]; x; x &= x - 1)
+        f(w * BitMatrix::WORD_BITS + lowestBit(x));
+    }
+  }
+
+  // Helper function that converts a SemElem
+  // into a BitRel*
+  BitRel * convert(wali::SemElem * se)
+  {
+    BitRel * br = dynamic_cast<BitRel*>(se);
+    if (br == NULL) {
+      *waliErr << "[ERROR] Cannot cast to class wali::binrel::BitRel.\n";
+      se->print( *waliErr << "    " ) << endl;
+      assert(false);
+    }
+    return br;
+  }
+}
+
+// ////////////////////////////
+// BitMatrix
+
+BitMatrix::BitMatrix() :
+  nrows(0),
+  ncols(0),
+  stride(0)
+{}
+
+BitMatrix::BitMatrix(unsigned rows, unsigned cols) :
+  nrows(rows),
+  ncols(cols),
+  stride((cols + WORD_BITS - 1) / WORD_BITS),
+  bits(size_t(rows) * stride, 0)
+{}
+
+BitMatrix BitMatrix::identity(unsigned n)
+{
+  BitMatrix m(n, n);
+  for(unsigned i = 0; i < n; ++i)
+    m.set(i, i);
+  return m;
+}
+
+void BitMatrix::fill()
+{
+  if(stride == 0)
+    return;
+  Word last = lowMask(ncols - (stride - 1) * WORD_BITS);
+  for(unsigned r = 0; r < nrows; ++r){
+    Word * w = row(r);
+    std::fill(w, w + stride - 1, ~Word(0));
+    w[stride - 1] = last;
+  }
+}
+
+bool BitMatrix::empty() const
+{
+  for(size_t i = 0; i < bits.size(); ++i)
+    if(bits[i])
+      return false;
+  return true;
+}
+
+size_t BitMatrix::count() const
+{
+  size_t n = 0;
+  for(size_t i = 0; i < bits.size(); ++i)
+    n += popCount(bits[i]);
+  return n;
+}
+
+BitMatrix BitMatrix::multiply(BitMatrix const & that) const
+{
+  assert(ncols == that.nrows);
+  // Row i of the product is the union of the rows k of that for which
+  // (i,k) is set. Transformers of programs are close to functions, so the
+  // rows of this are sparse and this beats a blocked product.
+  BitMatrix c(nrows, that.ncols);
+  for(unsigned i = 0; i < nrows; ++i){
+    Word * ci = c.row(i);
+    forEachBit(row(i), stride, [&](unsigned k) {
+      orWords(ci, that.row(k), that.stride);
+    });
+  }
+  return c;
+}
+
+void BitMatrix::unionWith(BitMatrix const & that)
+{
+  assert(nrows == that.nrows && ncols == that.ncols);
+  orWords(bits.data(), that.bits.data(), bits.size());
+}
+
+void BitMatrix::intersectWith(BitMatrix const & that)
+{
+  assert(nrows == that.nrows && ncols == that.ncols);
+  for(size_t i = 0; i < bits.size(); ++i)
+    bits[i] &= that.bits[i];
+}
+
+bool BitMatrix::subsetOf(BitMatrix const & that) const
+{
+  assert(nrows == that.nrows && ncols == that.ncols);
+  Word extra = 0;
+  for(size_t i = 0; i < bits.size(); ++i)
+    extra |= bits[i] & ~that.bits[i];
+  return extra == 0;
+}
+
+BitMatrix BitMatrix::transpose() const
+{
+  BitMatrix t(ncols, nrows);
+  for(unsigned i = 0; i < nrows; ++i)
+    forEachBit(row(i), stride, [&](unsigned j) { t.set(j, i); });
+  return t;
+}
+
+BitMatrix BitMatrix::closure() const
+{
+  assert(nrows == ncols);
+  BitMatrix c(*this);
+  for(unsigned i = 0; i < nrows; ++i)
+    c.set(i, i);
+  for(unsigned k = 0; k < nrows; ++k){
+    Word const * ck = c.row(k);
+    for(unsigned i = 0; i < nrows; ++i){
+      if(i != k && c.get(i, k))
+        orWords(c.row(i), ck, stride);
+    }
+  }
+  return c;
+}
+
+void BitMatrix::orBits(unsigned r, unsigned c,
+                       BitMatrix const & src, unsigned sr, unsigned sc,
+                       unsigned n)
+{
+  assert(c + n <= ncols && sc + n <= src.ncols);
+  Word * dst = row(r);
+  Word const * from = src.row(sr);
+  if(c % WORD_BITS == 0 && sc % WORD_BITS == 0 && n % WORD_BITS == 0){
+    orWords(dst + c / WORD_BITS, from + sc / WORD_BITS, n / WORD_BITS);
+    return;
+  }
+  for(unsigned off = 0; off < n; off += WORD_BITS){
+    unsigned len = std::min(n - off, unsigned(WORD_BITS));
+    Word v = extractBits(from, sc + off, len);
+    if(v)
+      depositBits(dst, c + off, v, len);
+  }
+}
+
+bool BitMatrix::operator==(BitMatrix const & that) const
+{
+  return nrows == that.nrows && ncols == that.ncols && bits == that.bits;
+}
+
+bool BitMatrix::lessThan(BitMatrix const & that) const
+{
+  if(nrows != that.nrows)
+    return nrows < that.nrows;
+  if(ncols != that.ncols)
+    return ncols < that.ncols;
+  return bits < that.bits;
+}
+
+size_t BitMatrix::hash() const
+{
+  size_t h = nrows * 31 + ncols;
+  for(size_t i = 0; i < bits.size(); ++i)
+    h = h * 1099511628211ULL ^ size_t(bits[i] ^ (bits[i] >> 32));
+  return h;
+}
+
+// ////////////////////////////
+// BitRelContext
+
+bool BitRelContext::fits(const std::map<std::string, int>& vars, bool tensored)
+{
+  unsigned long states = 1;
+  for(std::map<std::string, int>::const_iterator it = vars.begin(); it != vars.end(); ++it){
+    if(it->second <= 0)
+      return false;
+    states *= it->second;
+    if(states > MAX_STATES)
+      return false;
+  }
+  return !tensored || states * states <= MAX_STATES;
+}
+
+BitRelContext::BitRelContext() :
+  nstates(1),
+  maxSize(2)
+{
+  setupCachedRels();
+}
+
+BitRelContext::BitRelContext(const std::map<std::string, int>& vars) :
+  nstates(1),
+  maxSize(2)
+{
+  setIntVars(vars);
+}
+
+BitRelContext::~BitRelContext()
+{
+  cachedBaseOne = NULL;
+  cachedBaseZero = NULL;
+  cachedTensorOne = NULL;
+  cachedTensorZero = NULL;
+}
+
+void BitRelContext::addBoolVar(std::string name)
+{
+  addIntVar(name, 2);
+}
+
+void BitRelContext::addIntVar(std::string name, unsigned size)
+{
+  if(index.find(name) != index.end()){
+    *waliErr << "[ERROR] BitRelContext: variable \"" << name << "\" is already defined" << endl;
+    assert(false);
+    return;
+  }
+  if(size == 0 || (unsigned long)nstates * size > MAX_STATES){
+    *waliErr << "[ERROR] BitRelContext: adding \"" << name << "\" of size " << size
+      << " to " << nstates << " states exceeds " << MAX_STATES << " states" << endl;
+    assert(false);
+    return;
+  }
+  VarInfo vi;
+  vi.name = name;
+  vi.size = size;
+  vi.stride = nstates;
+  index[name] = vars.size();
+  vars.push_back(vi);
+  nstates *= size;
+  maxSize = std::max(maxSize, size);
+  setupCachedRels();
+}
+
+void BitRelContext::setIntVars(const std::map<std::string, int>& vars)
+{
+  for(std::map<std::string, int>::const_iterator it = vars.begin(); it != vars.end(); ++it)
+    addIntVar(it->first, it->second);
+}
+
+void BitRelContext::setupCachedRels()
+{
+  cachedBaseOne = new BitRel(this, BitMatrix::identity(nstates), false);
+  cachedBaseZero = new BitRel(this, BitMatrix(nstates, nstates), false);
+  if(canTensor()){
+    cachedTensorOne = new BitRel(this, BitMatrix::identity(nstates * nstates), true);
+    cachedTensorZero = new BitRel(this, BitMatrix(nstates * nstates, nstates * nstates), true);
+  }else{
+    cachedTensorOne = NULL;
+    cachedTensorZero = NULL;
+  }
+}
+
+unsigned BitRelContext::valueOf(unsigned state, std::string var) const
+{
+  std::map<std::string, unsigned>::const_iterator it = index.find(var);
+  if(it == index.end()){
+    *waliErr << "[ERROR] BitRelContext: unknown variable \"" << var << "\"" << endl;
+    assert(false);
+    return 0;
+  }
+  VarInfo const & vi = vars[it->second];
+  return (state / vi.stride) % vi.size;
+}
+
+std::ostream& BitRelContext::print(std::ostream& o) const
+{
+  o << "BitRelContext (" << nstates << " states):";
+  for(std::vector<VarInfo>::const_iterator it = vars.begin(); it != vars.end(); ++it)
+    o << " " << it->name << "[" << it->size << "]";
+  return o << "\n";
+}
+
+std::ostream& BitRelContext::printState(std::ostream& o, unsigned state) const
+{
+  o << "(";
+  for(std::vector<VarInfo>::const_iterator it = vars.begin(); it != vars.end(); ++it){
+    if(it != vars.begin())
+      o << ", ";
+    o << it->name << "=" << (state / it->stride) % it->size;
+  }
+  return o << ")";
+}
+
+void BitRelContext::checkExpr(BitMatrix const & expr) const
+{
+  if(expr.rows() != nstates){
+    *waliErr << "[ERROR] BitRelContext: expression over " << expr.rows()
+      << " states used in a context with " << nstates << " states" << endl;
+    assert(false);
+  }
+}
+
+BitMatrix BitRelContext::From(std::string var) const
+{
+  std::map<std::string, unsigned>::const_iterator it = index.find(var);
+  if(it == index.end()){
+    *waliErr << "[ERROR] attempted From() on \"" << var << "\". i don't recognize this name" << endl;
+    assert(false);
+    return NonDet();
+  }
+  VarInfo const & vi = vars[it->second];
+  BitMatrix ret(nstates, vi.size);
+  for(unsigned s = 0; s < nstates; ++s)
+    ret.set(s, (s / vi.stride) % vi.size);
+  return ret;
+}
+
+BitMatrix BitRelContext::NonDet() const
+{
+  BitMatrix ret(nstates, maxSize);
+  ret.fill();
+  return ret;
+}
+
+BitMatrix BitRelContext::True() const
+{
+  BitMatrix ret(nstates, 2);
+  for(unsigned s = 0; s < nstates; ++s)
+    ret.set(s, 1);
+  return ret;
+}
+
+BitMatrix BitRelContext::False() const
+{
+  BitMatrix ret(nstates, 2);
+  for(unsigned s = 0; s < nstates; ++s)
+    ret.set(s, 0);
+  return ret;
+}
+
+BitMatrix BitRelContext::Const(unsigned val) const
+{
+  if(val >= maxSize){
+    *waliErr << "[ERROR] [Const] Attempted to create a constant value larger "
+      << "than maxVal" << endl;
+    assert(false);
+  }
+  BitMatrix ret(nstates, maxSize);
+  for(unsigned s = 0; s < nstates; ++s)
+    ret.set(s, val);
+  return ret;
+}
+
+BitMatrix BitRelContext::applyBinOp(BitMatrix const & lexpr, BitMatrix const & rexpr, BinOp op) const
+{
+  checkExpr(lexpr);
+  checkExpr(rexpr);
+  // The longer register is clipped, as in ProgramBddContext
+  unsigned size = std::min(lexpr.cols(), rexpr.cols());
+  bool boolOp = (op == OP_AND || op == OP_OR);
+  unsigned in = boolOp ? std::min(size, 2u) : size;
+  BitMatrix ret(nstates, boolOp ? 2 : size);
+  for(unsigned s = 0; s < nstates; ++s){
+    forEachBit(lexpr.row(s), lexpr.wordsPerRow(), [&](unsigned i) {
+      if(i >= in)
+        return;
+      forEachBit(rexpr.row(s), rexpr.wordsPerRow(), [&](unsigned j) {
+        if(j >= in)
+          return;
+        unsigned k = 0;
+        switch(op){
+          case OP_AND:   k = i & j; break;
+          case OP_OR:    k = i | j; break;
+          case OP_PLUS:  k = (i + j) % size; break;
+          case OP_MINUS: k = (i + size - j) % size; break;
+          case OP_TIMES: k = (unsigned long)i * j % size; break;
+          case OP_DIV:   k = (j == 0) ? 0 : i / j; break;
+        }
+        ret.set(s, k);
+      });
+    });
+  }
+  return ret;
+}
+
+BitMatrix BitRelContext::And(BitMatrix const & lexpr, BitMatrix const & rexpr) const
+{
+  return applyBinOp(lexpr, rexpr, OP_AND);
+}
+
+BitMatrix BitRelContext::Or(BitMatrix const & lexpr, BitMatrix const & rexpr) const
+{
+  return applyBinOp(lexpr, rexpr, OP_OR);
+}
+
+BitMatrix BitRelContext::Not(BitMatrix const & expr) const
+{
+  checkExpr(expr);
+  BitMatrix ret(nstates, 2);
+  for(unsigned s = 0; s < nstates; ++s){
+    if(expr.get(s, 0))
+      ret.set(s, 1);
+    if(expr.cols() > 1 && expr.get(s, 1))
+      ret.set(s, 0);
+  }
+  return ret;
+}
+
+BitMatrix BitRelContext::Plus(BitMatrix const & lexpr, BitMatrix const & rexpr) const
+{
+  return applyBinOp(lexpr, rexpr, OP_PLUS);
+}
+
+BitMatrix BitRelContext::Minus(BitMatrix const & lexpr, BitMatrix const & rexpr) const
+{
+  return applyBinOp(lexpr, rexpr, OP_MINUS);
+}
+
+BitMatrix BitRelContext::Times(BitMatrix const & lexpr, BitMatrix const & rexpr) const
+{
+  return applyBinOp(lexpr, rexpr, OP_TIMES);
+}
+
+BitMatrix BitRelContext::Div(BitMatrix const & lexpr, BitMatrix const & rexpr) const
+{
+  return applyBinOp(lexpr, rexpr, OP_DIV);
+}
+
+BitMatrix BitRelContext::Assign(std::string var, BitMatrix const & expr) const
+{
+  checkExpr(expr);
+  std::map<std::string, unsigned>::const_iterator it = index.find(var);
+  if(it == index.end()){
+    *waliErr << "[WARNING] [BitRelContext::Assign] Unknown Variable: " << var << endl;
+    //This is a safe result. We assume that anything can be assigned to anything!
+    BitMatrix ret(nstates, nstates);
+    ret.fill();
+    return ret;
+  }
+  VarInfo const & vi = vars[it->second];
+  // If rhs max size is smaller, only copy the relevant values.
+  unsigned copysize = std::min(vi.size, expr.cols());
+  BitMatrix ret(nstates, nstates);
+  for(unsigned s = 0; s < nstates; ++s){
+    // s with var set to 0; the rest of the state is left alone
+    unsigned base = s - ((s / vi.stride) % vi.size) * vi.stride;
+    forEachBit(expr.row(s), expr.wordsPerRow(), [&](unsigned v) {
+      if(v < copysize)
+        ret.set(s, base + v * vi.stride);
+    });
+  }
+  return ret;
+}
+
+BitMatrix BitRelContext::Assume(BitMatrix const & expr1, BitMatrix const & expr2) const
+{
+  checkExpr(expr1);
+  checkExpr(expr2);
+  // expr1 and expr2 can have different register sizes; only the values
+  // both can hold are compared.
+  unsigned size = std::min(expr1.cols(), expr2.cols());
+  BitMatrix ret(nstates, nstates);
+  if(size == 0)
+    return ret;
+  unsigned words = (size + BitMatrix::WORD_BITS - 1) / BitMatrix::WORD_BITS;
+  Word last = lowMask(size - (words - 1) * BitMatrix::WORD_BITS);
+  for(unsigned s = 0; s < nstates; ++s){
+    Word const * a = expr1.row(s);
+    Word const * b = expr2.row(s);
+    Word common = 0;
+    for(unsigned w = 0; w + 1 < words; ++w)
+      common |= a[w] & b[w];
+    common |= a[words - 1] & b[words - 1] & last;
+    if(common)
+      ret.set(s, s);
+  }
+  return ret;
+}
+
+// ////////////////////////////
+// BitRel
+
+BitRel::BitRel(const BitRel& that) :
+  wali::SemElemTensor(that),
+  con(that.con),
+  mat(that.mat),
+  isTensored(that.isTensored)
+{}
+
+BitRel::BitRel(BitRelContext const * c, BitMatrix const & m, bool it) :
+  con(c),
+  mat(m),
+  isTensored(it)
+{
+  unsigned n = con->numStates();
+  if(isTensored && !con->canTensor()){
+    *waliErr << "[ERROR] BitRel: " << n << " states are too many for a tensored relation" << endl;
+    assert(false);
+  }
+  n = isTensored ? n * n : n;
+  if(mat.rows() != n || mat.cols() != n){
+    *waliErr << "[ERROR] BitRel: a " << mat.rows() << "x" << mat.cols()
+      << " matrix is not a relation over " << n << " states" << endl;
+    assert(false);
+  }
+}
+
+BitRel::~BitRel() {}
+
+bitrel_t BitRel::Compose( bitrel_t that ) const
+{
+  if(isTensored != that->isTensored || con != that->con){
+    *waliErr << "[WARNING] " << "Composing incompatible relations" << endl;
+    that->print(print(*waliErr) << endl) << endl;
+    assert(false);
+    return new BitRel(*this);
+  }
+  return new BitRel(con, mat.multiply(that->mat), isTensored);
+}
+
+bitrel_t BitRel::Union( bitrel_t that ) const
+{
+  if(isTensored != that->isTensored || con != that->con){
+    *waliErr << "[WARNING] " << "Unioning incompatible relations" << endl;
+    that->print(print(*waliErr) << endl) << endl;
+    assert(false);
+    return new BitRel(*this);
+  }
+  bitrel_t ret = new BitRel(*this);
+  ret->mat.unionWith(that->mat);
+  return ret;
+}
+
+bitrel_t BitRel::Intersect( bitrel_t that ) const
+{
+  if(isTensored != that->isTensored || con != that->con){
+    *waliErr << "[WARNING] " << "Intersecting incompatible relations" << endl;
+    that->print(print(*waliErr) << endl) << endl;
+    assert(false);
+    return new BitRel(*this);
+  }
+  bitrel_t ret = new BitRel(*this);
+  ret->mat.intersectWith(that->mat);
+  return ret;
+}
+
+bool BitRel::Equal( bitrel_t that ) const
+{
+  if(isTensored != that->isTensored || con != that->con){
+    *waliErr << "[WARNING] " << "Compared incompatible relations" << endl;
+    that->print(print(*waliErr) << endl) << endl;
+    assert(false);
+    return false;
+  }
+  return mat == that->mat;
+}
+
+bitrel_t BitRel::Transpose() const
+{
+  return new BitRel(con, mat.transpose(), isTensored);
+}
+
+bitrel_t BitRel::Kronecker( bitrel_t that ) const
+{
+  if(isTensored || that->isTensored || con != that->con || !con->canTensor()){
+    *waliErr << "[WARNING] " << "Attempted to tensor two tensored weights, uncompatible relations,"
+      << " or relations with too many states." << endl << "Not supported" << endl;
+    that->print(print(*waliErr) << endl) << endl;
+    assert(false);
+    return static_cast<BitRel*>(con->cachedTensorZero.get_ptr());
+  }
+  unsigned n = con->numStates();
+  BitMatrix t(n * n, n * n);
+  // Row (x1,x2) gets row x2 of that in the block y1 for each y1 in row x1
+  for(unsigned x1 = 0; x1 < n; ++x1){
+    forEachBit(mat.row(x1), mat.wordsPerRow(), [&](unsigned y1) {
+      for(unsigned x2 = 0; x2 < n; ++x2)
+        t.orBits(x1 * n + x2, y1 * n, that->mat, x2, 0, n);
+    });
+  }
+  return new BitRel(con, t, true);
+}
+
+bitrel_t BitRel::Eq23Project() const
+{
+  if(!isTensored){
+    *waliErr << "[WARNING] " << "Attempted to detensor a base relation" << endl;
+    assert(false);
+    return new BitRel(*this);
+  }
+  unsigned n = con->numStates();
+  BitMatrix r(n, n);
+  for(unsigned x1 = 0; x1 < n; ++x1)
+    for(unsigned m = 0; m < n; ++m)
+      r.orBits(x1, 0, mat, x1 * n + m, m * n, n);
+  return new BitRel(con, r, false);
+}
+
+bitrel_t BitRel::Eq13Project() const
+{
+  if(!isTensored){
+    *waliErr << "[WARNING] " << "Attempted to detensor a base relation" << endl;
+    assert(false);
+    return new BitRel(*this);
+  }
+  unsigned n = con->numStates();
+  BitMatrix r(n, n);
+  for(unsigned m = 0; m < n; ++m)
+    for(unsigned y1 = 0; y1 < n; ++y1)
+      r.orBits(y1, 0, mat, m * n + m, y1 * n, n);
+  return new BitRel(con, r, false);
+}
+
+wali::sem_elem_t BitRel::one() const
+{
+  if(!isTensored)
+    return con->cachedBaseOne;
+  else
+    return con->cachedTensorOne;
+}
+
+wali::sem_elem_t BitRel::zero() const
+{
+  if(!isTensored)
+    return con->cachedBaseZero;
+  else
+    return con->cachedTensorZero;
+}
+
+bool BitRel::isOne() const
+{
+  if(isTensored)
+    return mat == con->cachedTensorOne->mat;
+  else
+    return mat == con->cachedBaseOne->mat;
+}
+
+bool BitRel::isZero() const
+{
+  return mat.empty();
+}
+
+wali::sem_elem_t BitRel::combine(wali::SemElem* se)
+{
+  bitrel_t that( convert(se) );
+  return Union(that);
+}
+
+wali::sem_elem_t BitRel::extend(wali::SemElem* se)
+{
+  bitrel_t that( convert(se) );
+  return Compose(that);
+}
+
+wali::sem_elem_t BitRel::star()
+{
+  return new BitRel(con, mat.closure(), isTensored);
+}
+
+bool BitRel::underApproximates(wali::SemElem * se)
+{
+  bitrel_t that( convert(se) );
+  if(isTensored != that->isTensored || con != that->con){
+    *waliErr << "[WARNING] " << "Compared (containment) incompatible relations" << endl;
+    that->print(print(*waliErr) << endl) << endl;
+    assert(false);
+    return false;
+  }
+  return mat.subsetOf(that->mat);
+}
+
+bool BitRel::equal(wali::SemElem* se) const
+{
+  bitrel_t that( convert(se) );
+  return Equal(that);
+}
+
+bool BitRel::containerLessThan(wali::SemElem const * se) const
+{
+  BitRel const * other = dynamic_cast<BitRel const *>(se);
+  return mat.lessThan(other->mat);
+}
+
+std::ostream& BitRel::print( std::ostream& o ) const
+{
+  unsigned n = con->numStates();
+  if(!isTensored)
+    o << "Base relation: {";
+  else
+    o << "Tensored relation: {";
+  for(unsigned i = 0; i < mat.rows(); ++i){
+    forEachBit(mat.row(i), mat.wordsPerRow(), [&](unsigned j) {
+      o << "\n  ";
+      if(isTensored){
+        con->printState(con->printState(o << "(", i / n) << ",", i % n) << ")";
+        o << " -> ";
+        con->printState(con->printState(o << "(", j / n) << ",", j % n) << ")";
+      }else{
+        con->printState(o, i) << " -> ";
+        con->printState(o, j);
+      }
+    });
+  }
+  return o << "\n}";
+}
+
+wali::sem_elem_tensor_t BitRel::transpose()
+{
+  return Transpose();
+}
+
+wali::sem_elem_tensor_t BitRel::tensor(wali::SemElemTensor* se)
+{
+  bitrel_t that( convert(se) );
+  return Kronecker(that);
+}
+
+wali::sem_elem_tensor_t BitRel::detensor()
+{
+  return Eq23Project();
+}
+
+wali::sem_elem_tensor_t BitRel::detensorTranspose()
+{
+  return Eq13Project();
+}
@@ -0,0 +1,351 @@
+#ifndef wN_binrel_BITREL_GUARD
+#define wN_binrel_BITREL_GUARD 1
+
+/**
+ * @file BitRel.hpp
+ *
+ * Binary relations over a small program vocabulary, stored explicitly as
+ * dense bit matrices.
+ *
+ * BinRel pays for pair renamings, relational products and node-table
+ * garbage collection on every operation. When the vocabulary only has a
+ * handful of boolean or small int variables, that overhead dwarfs the
+ * relation itself. BitRel enumerates the states instead: a relation over
+ * N states is an N x N bit matrix, compose is a boolean matrix product,
+ * union is a word-wise OR, and equality is a word-wise compare.
+ *
+ * BitRelContext mirrors the construction API of ProgramBddContext
+ * (addBoolVar/addIntVar/setIntVars, the expression builders, Assign and
+ * Assume), so an analysis can pick between BinRel and BitRel from the size
+ * of its vocabulary (see BitRelContext::fits) and build its transformers
+ * with the same calls.
+ *
+ * Tensored relations are N^2 x N^2 matrices over pairs of states, so they
+ * are only available while N^2 <= BitRelContext::MAX_STATES.
+ *
+ * A relation takes N^2/8 bytes whatever it contains, and every operation
+ * touches all of it. On transformers built from Assign and Assume, BitRel
+ * is several times faster than BinRel up to about a hundred states and
+ * falls behind somewhere in the hundreds; at the 2^12 limit a relation
+ * is 2MB and BinRel is much faster unless the relations are unstructured.
+ */
+
+#include <map>
+#include <vector>
+#include <string>
+#include <iosfwd>
+#include <cstddef>
+#include <stdint.h>
+
+#include "wali/Countable.hpp"
+#include "wali/ref_ptr.hpp"
+#include "wali/SemElemTensor.hpp"
+
+namespace wali
+{
+  namespace domains
+  {
+    namespace binrel
+    {
+      /**
+       * A dense rows x cols matrix of bits, each row packed into 64-bit
+       * words. The rows are padded to a whole number of words and the
+       * padding is always kept clear, so whole rows can be compared and
+       * hashed word by word.
+       *
+       * The kernels only use plain loops over the words of a row, which
+       * the compiler turns into vector code.
+       */
+      class BitMatrix
+      {
+        public:
+          typedef uint64_t Word;
+          static const unsigned WORD_BITS = 64;
+
+          BitMatrix();
+          BitMatrix(unsigned rows, unsigned cols);
+
+          /** The n x n identity */
+          static BitMatrix identity(unsigned n);
+
+          unsigned rows() const { return nrows; }
+          unsigned cols() const { return ncols; }
+          unsigned wordsPerRow() const { return stride; }
+
+          bool get(unsigned r, unsigned c) const {
+            return (bits[r * stride + c / WORD_BITS] >> (c % WORD_BITS)) & 1;
+          }
+
+          void set(unsigned r, unsigned c) {
+            bits[r * stride + c / WORD_BITS] |= Word(1) << (c % WORD_BITS);
+          }
+
+          Word * row(unsigned r) { return bits.data() + r * stride; }
+          Word const * row(unsigned r) const { return bits.data() + r * stride; }
+
+          /** Sets every (r,c) with r < rows and c < cols */
+          void fill();
+
+          /** @return true if no bit is set */
+          bool empty() const;
+
+          /** @return the number of set bits */
+          size_t count() const;
+
+          /** Boolean product: (i,j) is set if (i,k) and (k,j) are for some k */
+          BitMatrix multiply(BitMatrix const & that) const;
+
+          /** this |= that */
+          void unionWith(BitMatrix const & that);
+
+          /** this &= that */
+          void intersectWith(BitMatrix const & that);
+
+          /** @return true if every bit of this is set in that */
+          bool subsetOf(BitMatrix const & that) const;
+
+          BitMatrix transpose() const;
+
+          /**
+           * Reflexive transitive closure, by Warshall's algorithm on whole
+           * rows. Only for square matrices.
+           */
+          BitMatrix closure() const;
+
+          /**
+           * ORs the n bits of row sr of src, starting at column sc, into row
+           * r of this, starting at column c.
+           */
+          void orBits(unsigned r, unsigned c,
+                      BitMatrix const & src, unsigned sr, unsigned sc,
+                      unsigned n);
+
+          bool operator==(BitMatrix const & that) const;
+          bool operator!=(BitMatrix const & that) const { return !(*this == that); }
+
+          /** Orders first by shape, then by contents */
+          bool lessThan(BitMatrix const & that) const;
+
+          size_t hash() const;
+
+        private:
+          unsigned nrows;
+          unsigned ncols;
+          unsigned stride;
+          std::vector<Word> bits;
+      };
+
+
+      class BitRel;
+      typedef ref_ptr<BitRel> bitrel_t;
+
+      class BitRelContext;
+      typedef ref_ptr<BitRelContext> bitrel_context_t;
+
+      /**
+       * The vocabulary of a BitRel and the builders for its transformers.
+       *
+       * A state assigns a value to every variable of the vocabulary; it is
+       * numbered by reading the values as a mixed-radix number, the first
+       * variable added being the least significant digit.
+       *
+       * Expressions are BitMatrix objects with one row per state and one
+       * column per value of the expression register: the set columns of
+       * row s are the values the expression can have in state s, and the
+       * width of the matrix is the size of the register. The builders
+       * follow the semantics of the ProgramBddContext ones: the operands of
+       * a binary operator are clipped to the smaller register, arithmetic
+       * wraps around the register size, division by 0 gives 0, and the
+       * boolean operators only look at the values 0 and 1.
+       *
+       * Add all the variables before building any relation: the states are
+       * renumbered when the vocabulary grows.
+       */
+      class BitRelContext : public wali::Countable
+      {
+        public:
+          /** The largest number of states, base or tensored, a context allows */
+          static const unsigned MAX_STATES = 1u << 12;
+
+          /**
+           * @return true if a vocabulary with variables of the given sizes
+           * can be represented by BitRel; if tensored is set, tensored
+           * relations must fit as well.
+           */
+          static bool fits(const std::map<std::string, int>& vars, bool tensored = false);
+
+          BitRelContext();
+          BitRelContext(const std::map<std::string, int>& vars);
+          ~BitRelContext();
+
+          /** Add a boolean variable to the vocabulary with the name 'name' **/
+          void addBoolVar(std::string name);
+          /** Add a int variable to the vocabulary with the name 'name'. The integer can take values
+           * between 0...size-1. **/
+          void addIntVar(std::string name, unsigned size);
+          /** Add multiple int variables with the given sizes. **/
+          void setIntVars(const std::map<std::string, int>& vars);
+
+          /** @return the number of states of a base relation */
+          unsigned numStates() const { return nstates; }
+
+          /** @return true if tensored relations fit in MAX_STATES */
+          bool canTensor() const { return nstates * nstates <= MAX_STATES; }
+
+          /** @return the value of var in state */
+          unsigned valueOf(unsigned state, std::string var) const;
+
+          std::ostream& print(std::ostream& o) const;
+          std::ostream& printState(std::ostream& o, unsigned state) const;
+
+          // ////////////////Expression builders//////////////////////////////////////////
+          BitMatrix From(std::string var) const;
+          BitMatrix NonDet() const;
+          BitMatrix True() const;
+          BitMatrix False() const;
+          BitMatrix And(BitMatrix const & lexpr, BitMatrix const & rexpr) const;
+          BitMatrix Or(BitMatrix const & lexpr, BitMatrix const & rexpr) const;
+          BitMatrix Not(BitMatrix const & expr) const;
+          BitMatrix Const(unsigned val) const;
+          BitMatrix Plus(BitMatrix const & lexpr, BitMatrix const & rexpr) const;
+          BitMatrix Minus(BitMatrix const & lexpr, BitMatrix const & rexpr) const;
+          BitMatrix Times(BitMatrix const & lexpr, BitMatrix const & rexpr) const;
+          BitMatrix Div(BitMatrix const & lexpr, BitMatrix const & rexpr) const;
+
+          // //////////////Statement Generators/////////////////////////////////////////////
+          // The results are base relations, to be wrapped in a BitRel.
+          BitMatrix Assign(std::string var, BitMatrix const & expr) const;
+          BitMatrix Assume(BitMatrix const & expr1, BitMatrix const & expr2) const;
+
+        private:
+          enum BinOp { OP_AND, OP_OR, OP_PLUS, OP_MINUS, OP_TIMES, OP_DIV };
+
+          BitMatrix applyBinOp(BitMatrix const & lexpr, BitMatrix const & rexpr, BinOp op) const;
+          void checkExpr(BitMatrix const & expr) const;
+          void setupCachedRels();
+
+        private:
+          friend class BitRel;
+
+          struct VarInfo {
+            std::string name;
+            unsigned size;
+            unsigned stride;
+          };
+
+          std::vector<VarInfo> vars;
+          std::map<std::string, unsigned> index;
+          unsigned nstates;
+          // The largest variable size; the size of Const and NonDet
+          unsigned maxSize;
+
+          bitrel_t cachedBaseOne;
+          bitrel_t cachedBaseZero;
+          bitrel_t cachedTensorOne;
+          bitrel_t cachedTensorZero;
+
+          // Not copyable: the relations point back at their context
+          BitRelContext(const BitRelContext&);
+          BitRelContext& operator=(const BitRelContext&);
+      };
+
+
+      /**
+       * A binary relation over the states of a BitRelContext.
+       *
+       * A base relation is a numStates() x numStates() matrix; a tensored
+       * relation relates pairs of states, pair (x1,x2) being numbered
+       * x1 * numStates() + x2. Tensor and detensor follow BinRel:
+       *   Kronecker:   T((x1,x2),(y1,y2)) = a(x1,y1) & b(x2,y2)
+       *   Eq23Project: R(x1,y2) = exists m. T((x1,m),(m,y2))
+       *   Eq13Project: R(y1,y2) = exists m. T((m,m),(y1,y2))
+       */
+      class BitRel : public wali::SemElemTensor
+      {
+        public:
+          BitRel(const BitRel& that);
+          BitRel(BitRelContext const * con, BitMatrix const & m, bool is_tensored = false);
+          virtual ~BitRel();
+
+        public:
+          bitrel_t Compose(bitrel_t that) const;
+          bitrel_t Union(bitrel_t that) const;
+          bitrel_t Intersect(bitrel_t that) const;
+          bool Equal(bitrel_t that) const;
+          bitrel_t Transpose() const;
+          bitrel_t Kronecker(bitrel_t that) const;
+          bitrel_t Eq23Project() const;
+          bitrel_t Eq13Project() const;
+
+        public:
+          // ////////////////////////////////
+          // SemElem methods
+          sem_elem_t one() const;
+          sem_elem_t zero() const;
+
+          bool isOne() const;
+          bool isZero() const;
+
+          /** @return [this]->Union( cast<BitRel*>(se) ) */
+          sem_elem_t combine(SemElem* se);
+
+          /** @return [this]->Compose( cast<BitRel*>(se) ) */
+          sem_elem_t extend(SemElem* se);
+
+          /** The reflexive transitive closure, computed directly */
+          sem_elem_t star();
+
+          bool underApproximates(SemElem * other);
+
+          /** @return [this]->Equal( cast<BitRel*>(se) ) */
+          bool equal(SemElem* se) const;
+
+          std::ostream& print(std::ostream& o) const;
+
+          virtual bool containerLessThan(SemElem const * other) const;
+
+          virtual size_t hash() const {
+            return mat.hash();
+          }
+
+          // ////////////////////////////////
+          // SemElemTensor methods
+
+          /** @return [this]->Transpose() */
+          sem_elem_tensor_t transpose();
+
+          /** @return [this]->Kronecker( cast<BitRel*>(se) ) */
+          sem_elem_tensor_t tensor(SemElemTensor* se);
+
+          /** @return [this]->Eq23Project() */
+          sem_elem_tensor_t detensor();
+
+          /** @return [this]->Eq13Project() */
+          sem_elem_tensor_t detensorTranspose();
+
+          /** @return The backing matrix */
+          BitMatrix const & getMatrix() const {
+            return mat;
+          }
+
+          BitRelContext const & getVocabulary() const {
+            return *con;
+          }
+
+          bool tensored() const {
+            return isTensored;
+          }
+
+        protected:
+          //This has to be a raw/weak pointer: BitRelContext caches some
+          //BitRel objects.
+          BitRelContext const * con;
+          BitMatrix mat;
+          bool isTensored;
+      };
+
+    } // namespace binrel
+  } // namespace domains
+} // namespace wali
+
+#endif  // wN_binrel_BITREL_GUARD
@@ -30,7 +30,7 @@ namespace wali
   {
     namespace binrel
     {
-      extern RevBddContext idx2Name;
+      extern thread_local RevBddContext idx2Name;
     }
   }
 }
@@ -326,6 +326,12 @@ void ProgramBddContext::createExtraVars()
   regBInfo->baseLhs = (unsigned) base++;
   regBInfo->baseRhs = (unsigned) base++;
   regBInfo->baseExtra = (unsigned) base++;
+
+  // Reordering keeps the copies of each register bit together
+  int regA[3] = {(int) regAInfo->baseLhs, (int) regAInfo->baseRhs, (int) regAInfo->baseExtra};
+  int regB[3] = {(int) regBInfo->baseLhs, (int) regBInfo->baseRhs, (int) regBInfo->baseExtra};
+  addReorderGroups(regA, 3);
+  addReorderGroups(regB, 3);
   
   //To pretty print during testing, we add some names for this extra register
   //Currently, idx2Name is a global variable in wali::domains::binrel
@@ -396,6 +402,8 @@ void ProgramBddContext::addIntVar(std::string name, unsigned siz)
         regAInfo->baseLhs = (unsigned) base;
         regAInfo->baseRhs = (unsigned) base + 1;
         regAInfo->baseExtra = (unsigned) base + 2;
+        int reg[3] = {base, base + 1, base + 2};
+        addReorderGroups(reg, 3);
 
         //To pretty print during testing, we add some names for this extra register
         //Currently, idx2Name is a global variable in wali::domains::binrel
@@ -414,6 +422,8 @@ void ProgramBddContext::addIntVar(std::string name, unsigned siz)
         regBInfo->baseLhs = (unsigned) base;
         regBInfo->baseRhs = (unsigned )base + 1;
         regBInfo->baseExtra = (unsigned) base + 2;
+        int reg[3] = {base, base + 1, base + 2};
+        addReorderGroups(reg, 3);
 
         //To pretty print during testing, we add some names for this extra register
         //Currently, idx2Name is a global variable in wali::domains::binrel
@@ -449,6 +459,8 @@ void ProgramBddContext::addIntVar(std::string name, unsigned siz)
         if (base < 0)
           LOG(ERROR) << "[ERROR-BuDDy initialization] \"" << bdd_errstring(base) << "\"" << endl
             << "    Aborting." << endl;
+        int reg[3] = {base, base + 1, base + 2};
+        addReorderGroups(reg, 3);
         int retbase;
         retbase = fdd_overlapdomain(regAInfo->baseLhs,base);
         regAInfo->baseLhs = retbase;
@@ -478,6 +490,8 @@ void ProgramBddContext::addIntVar(std::string name, unsigned siz)
         if (base < 0)
           LOG(ERROR) << "[ERROR-BuDDy initialization] \"" << bdd_errstring(base) << "\"" << endl
             << "    Aborting." << endl;
+        int reg[3] = {base, base + 1, base + 2};
+        addReorderGroups(reg, 3);
         int retbase;
         retbase = fdd_overlapdomain(regBInfo->baseLhs,base);
         regBInfo->baseLhs = retbase;
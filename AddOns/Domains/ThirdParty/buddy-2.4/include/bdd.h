@@ -235,6 +235,7 @@ extern int      bdd_isrunning(void);
 extern int      bdd_setmaxnodenum(int);
 extern int      bdd_setmaxincrease(int);
 extern int      bdd_setminfreenodes(int);
+extern int      bdd_setreordergrowth(int);
 extern int      bdd_getnodenum(void);
 extern int      bdd_getallocnum(void);
 extern char*    bdd_versionstr(void);
@@ -296,6 +297,7 @@ extern BDD      bdd_unique(BDD, BDD);
 extern BDD      bdd_appex(BDD, BDD, int, BDD);
 extern BDD      bdd_appall(BDD, BDD, int, BDD);
 extern BDD      bdd_appuni(BDD, BDD, int, BDD);
+extern BDD      bdd_relprodreplace(BDD, bddPair*, BDD, bddPair*, BDD, bddPair*);
 extern BDD      bdd_support(BDD);
 extern BDD      bdd_satone(BDD);
 extern BDD      bdd_satoneset(BDD, BDD, BDD);
@@ -348,6 +350,7 @@ extern int      bdd_getreorder_method(void);
 extern void     bdd_enable_reorder(void);
 extern void     bdd_disable_reorder(void);
 extern int      bdd_reorder_verbose(int);
+extern int      bdd_reorder_timelimit(int);
 extern void     bdd_setvarorder(int *);
 extern void     bdd_printorder(void);
 extern void     bdd_fprintorder(FILE *);
@@ -490,6 +493,8 @@ private:
    friend bdd      bdd_appex(const bdd &, const bdd &, int, const bdd &);
    friend bdd      bdd_appall(const bdd &, const bdd &, int, const bdd &);
    friend bdd      bdd_appuni(const bdd &, const bdd &, int, const bdd &);
+   friend bdd      bdd_relprodreplace(const bdd &, bddPair*, const bdd &, bddPair*,
+				      const bdd &, bddPair*);
    friend bdd      bdd_replace(const bdd &, bddPair*);
    friend bdd      bdd_compose(const bdd &, const bdd &, int);
    friend bdd      bdd_veccompose(const bdd &, bddPair*);
@@ -652,6 +657,10 @@ inline bdd bdd_appall(const bdd &l, const bdd &r, int op, const bdd &var)
 inline bdd bdd_appuni(const bdd &l, const bdd &r, int op, const bdd &var)
 { return bdd_appuni(l.root, r.root, op, var.root); }
 
+inline bdd bdd_relprodreplace(const bdd &l, bddPair *lp, const bdd &r,
+			      bddPair *rp, const bdd &var, bddPair *op)
+{ return bdd_relprodreplace(l.root, lp, r.root, rp, var.root, op); }
+
 inline bdd bdd_support(const bdd &r)
 { return bdd_support(r.root); }
 
@@ -807,7 +816,6 @@ class bdd_ioformat
  private:
    bdd_ioformat(void)  { }
    int format;
-   static int curformat;
 
    friend std::ostream &operator<<(std::ostream &, const bdd_ioformat &);
    friend std::ostream &operator<<(std::ostream &, const bdd &);
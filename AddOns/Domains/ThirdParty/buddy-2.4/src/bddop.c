@@ -63,6 +63,10 @@
 #define CACHEID_APPAL        0x4
 #define CACHEID_APPUN        0x5
 
+   /* Number of recent bdd_relprodreplace() arguments that keep their
+      cache id (see relprodrep_signature()) */
+#define RELPRODREP_SIGNUM    8
+
 
    /* Number of boolean operators */
 #define OPERATOR_NUM    11
@@ -84,39 +88,58 @@ static int oprres[OPERATOR_NUM][4] =
 
 
    /* Variables needed for the operators */
-static int applyop;                 /* Current operator for apply */
-static int appexop;                 /* Current operator for appex */
-static int appexid;                 /* Current cache id for appex */
-static int quantid;                 /* Current cache id for quantifications */
-static int *quantvarset;            /* Current variable set for quant. */
-static int quantvarsetID;           /* Current id used in quantvarset */
-static int quantlast;               /* Current last variable to be quant. */
-static int replaceid;               /* Current cache id for replace */
-static int *replacepair;            /* Current replace pair */
-static int replacelast;             /* Current last var. level to replace */
-static int composelevel;            /* Current variable used for compose */
-static int miscid;                  /* Current cache id for other results */
-static int *varprofile;             /* Current variable profile */
-static int supportID;               /* Current ID (true value) for support */
-static int supportMin;              /* Min. used level in support calc. */
-static int supportMax;              /* Max. used level in support calc. */
-static int* supportSet;             /* The found support set */
-static BddCache applycache;         /* Cache for apply results */
-static BddCache itecache;           /* Cache for ITE results */
-static BddCache quantcache;         /* Cache for exist/forall results */
-static BddCache appexcache;         /* Cache for appex/appall results */
-static BddCache replacecache;       /* Cache for replace results */
-static BddCache misccache;          /* Cache for other results */
-static int cacheratio;
-static BDD satPolarity;
-static int firstReorder;            /* Used instead of local variable in order
+static BDD_THREAD_LOCAL int applyop;                 /* Current operator for apply */
+static BDD_THREAD_LOCAL int appexop;                 /* Current operator for appex */
+static BDD_THREAD_LOCAL int appexid;                 /* Current cache id for appex */
+static BDD_THREAD_LOCAL int quantid;                 /* Current cache id for quantifications */
+static BDD_THREAD_LOCAL int *quantvarset;            /* Current variable set for quant. */
+static BDD_THREAD_LOCAL int quantvarsetID;           /* Current id used in quantvarset */
+static BDD_THREAD_LOCAL int quantlast;               /* Current last variable to be quant. */
+static BDD_THREAD_LOCAL int replaceid;               /* Current cache id for replace */
+static BDD_THREAD_LOCAL int *replacepair;            /* Current replace pair */
+static BDD_THREAD_LOCAL int replacelast;             /* Current last var. level to replace */
+static BDD_THREAD_LOCAL int composelevel;            /* Current variable used for compose */
+static BDD_THREAD_LOCAL int miscid;                  /* Current cache id for other results */
+static BDD_THREAD_LOCAL int *varprofile;             /* Current variable profile */
+static BDD_THREAD_LOCAL int supportID;               /* Current ID (true value) for support */
+static BDD_THREAD_LOCAL int supportMin;              /* Min. used level in support calc. */
+static BDD_THREAD_LOCAL int supportMax;              /* Max. used level in support calc. */
+static BDD_THREAD_LOCAL int* supportSet;             /* The found support set */
+static BDD_THREAD_LOCAL BddCache applycache;         /* Cache for apply results */
+static BDD_THREAD_LOCAL BddCache itecache;           /* Cache for ITE results */
+static BDD_THREAD_LOCAL BddCache quantcache;         /* Cache for exist/forall results */
+static BDD_THREAD_LOCAL BddCache appexcache;         /* Cache for appex/appall results */
+static BDD_THREAD_LOCAL BddCache replacecache;       /* Cache for replace results */
+static BDD_THREAD_LOCAL BddCache misccache;          /* Cache for other results */
+static BDD_THREAD_LOCAL BddCache relprodrepcache;    /* Cache for relprodreplace results */
+static BDD_THREAD_LOCAL int relprodrepid;            /* Current cache id for relprodreplace */
+static BDD_THREAD_LOCAL int *relprodrepleft;         /* Current pair for the left argument */
+static BDD_THREAD_LOCAL int relprodrepleftlast;      /* ... and its last var. level */
+static BDD_THREAD_LOCAL int *relprodrepright;        /* Current pair for the right argument */
+static BDD_THREAD_LOCAL int relprodreprightlast;     /* ... and its last var. level */
+static BDD_THREAD_LOCAL int *relprodrepout;          /* Current pair for the result */
+static BDD_THREAD_LOCAL int relprodrepoutlast;       /* ... and its last var. level */
+static BDD_THREAD_LOCAL int relprodrepquant;         /* Quantify over quantvarset? */
+static BDD_THREAD_LOCAL int relprodrepfailed;        /* Met a pair that breaks the order */
+static BDD_THREAD_LOCAL int relprodrepnextid;        /* Next unused relprodreplace cache id */
+static BDD_THREAD_LOCAL int relprodrepsignum;        /* Used entries in relprodrepsig */
+static BDD_THREAD_LOCAL int relprodrepsignext;       /* Entry to reuse when it is full */
+static BDD_THREAD_LOCAL struct
+{
+   int lpair, rpair, var, opair;    /* Pair ids and variable set */
+   int id;                          /* Cache id for these arguments */
+   int failed;                      /* Fall back without trying again */
+} relprodrepsig[RELPRODREP_SIGNUM];
+static BDD_THREAD_LOCAL int cacheratio;
+static BDD_THREAD_LOCAL BDD satPolarity;
+static BDD_THREAD_LOCAL int firstReorder;            /* Used instead of local variable in order
 				       to avoid compiler warning about 'first'
 				       being clobbered by setjmp */
 
-static char*            allsatProfile; /* Variable profile for bdd_allsat() */
-static bddallsathandler allsatHandler; /* Callback handler for bdd_allsat() */
+static BDD_THREAD_LOCAL char*            allsatProfile; /* Variable profile for bdd_allsat() */
+static BDD_THREAD_LOCAL bddallsathandler allsatHandler; /* Callback handler for bdd_allsat() */
 
-extern bddCacheStat bddcachestats;
+extern BDD_THREAD_LOCAL bddCacheStat bddcachestats;
 
    /* Internal prototypes */
 static BDD    not_rec(BDD);
@@ -125,6 +148,7 @@ static BDD    ite_rec(BDD, BDD, BDD);
 static int    simplify_rec(BDD, BDD);
 static int    quant_rec(int);
 static int    appquant_rec(int, int);
+static BDD    relprodrep_rec(BDD, BDD);
 static int    restrict_rec(int);
 static BDD    constrain_rec(BDD, BDD);
 static BDD    replace_rec(BDD);
@@ -157,6 +181,7 @@ static int    varset2svartable(BDD);
 #define SATCOUHASH(r)        (r)
 #define PATHCOUHASH(r)       (r)
 #define APPEXHASH(l,r,op)    (PAIR(l,r))
+#define RELPRODREPHASH(l,r)  (PAIR(l,r))
 
 #ifndef M_LN2
 #define M_LN2 0.69314718055994530942
@@ -191,10 +216,16 @@ int bdd_operator_init(int cachesize)
    if (BddCache_init(&misccache,cachesize) < 0)
       return bdd_error(BDD_MEMORY);
 
+   if (BddCache_init(&relprodrepcache,cachesize) < 0)
+      return bdd_error(BDD_MEMORY);
+
    quantvarsetID = 0;
    quantvarset = NULL;
    cacheratio = 0;
    supportSet = NULL;
+   relprodrepnextid = 0;
+   relprodrepsignum = 0;
+   relprodrepsignext = 0;
    
    return 0;
 }
@@ -211,6 +242,7 @@ void bdd_operator_done(void)
    BddCache_done(&appexcache);
    BddCache_done(&replacecache);
    BddCache_done(&misccache);
+   BddCache_done(&relprodrepcache);
 
    if (supportSet != NULL)
      free(supportSet);
@@ -225,6 +257,12 @@ void bdd_operator_reset(void)
    BddCache_reset(&appexcache);
    BddCache_reset(&replacecache);
    BddCache_reset(&misccache);
+   BddCache_reset(&relprodrepcache);
+
+      /* Node numbers of variable sets may be reused and levels may
+	 have changed, so forget the known arguments as well */
+   relprodrepsignum = 0;
+   relprodrepsignext = 0;
 }
 
 
@@ -253,6 +291,7 @@ static void bdd_operator_noderesize(void)
       BddCache_resize(&appexcache, newcachesize);
       BddCache_resize(&replacecache, newcachesize);
       BddCache_resize(&misccache, newcachesize);
+      BddCache_resize(&relprodrepcache, newcachesize);
    }
 }
 
@@ -2038,6 +2077,231 @@ static int appquant_rec(int l, int r)
 }
 
 
+/*=== RELATIONAL PRODUCT WITH REPLACE ==================================*/
+
+   /* Index in relprodrepsig of the arguments of bdd_relprodreplace() */
+static int relprodrep_signature(bddPair *lpair, bddPair *rpair, BDD var,
+				bddPair *opair)
+{
+   int lid = (lpair != NULL ? lpair->id : -1);
+   int rid = (rpair != NULL ? rpair->id : -1);
+   int oid = (opair != NULL ? opair->id : -1);
+   int n;
+
+   for (n=0 ; n<relprodrepsignum ; n++)
+      if (relprodrepsig[n].lpair == lid  &&  relprodrepsig[n].rpair == rid
+	  &&  relprodrepsig[n].var == var  &&  relprodrepsig[n].opair == oid)
+	 return n;
+
+   if (relprodrepnextid == INT_MAX)
+   {
+      BddCache_reset(&relprodrepcache);
+      relprodrepnextid = 0;
+      relprodrepsignum = 0;
+      relprodrepsignext = 0;
+   }
+
+      /* A fresh id, so the entries of the replaced arguments never hit */
+   if (relprodrepsignum < RELPRODREP_SIGNUM)
+      n = relprodrepsignum++;
+   else
+   {
+      n = relprodrepsignext;
+      relprodrepsignext = (relprodrepsignext+1) % RELPRODREP_SIGNUM;
+   }
+
+   relprodrepsig[n].lpair = lid;
+   relprodrepsig[n].rpair = rid;
+   relprodrepsig[n].var = var;
+   relprodrepsig[n].opair = oid;
+   relprodrepsig[n].id = relprodrepnextid++;
+   relprodrepsig[n].failed = 0;
+   return n;
+}
+
+
+   /* The same result, one operation after the other */
+static BDD relprodrep_separate(BDD l, bddPair *lpair, BDD r, bddPair *rpair,
+			       BDD var, bddPair *opair)
+{
+   BDD tl, tr, t, res;
+
+   tl = bdd_addref(lpair != NULL ? bdd_replace(l, lpair) : l);
+   tr = bdd_addref(rpair != NULL ? bdd_replace(r, rpair) : r);
+   if (var < 2)
+      t = bdd_addref(bdd_apply(tl, tr, bddop_and));
+   else
+      t = bdd_addref(bdd_appex(tl, tr, bddop_and, var));
+   bdd_delref(tl);
+   bdd_delref(tr);
+
+   res = (opair != NULL ? bdd_replace(t, opair) : t);
+   bdd_delref(t);
+   return res;
+}
+
+
+/*
+NAME    {* bdd\_relprodreplace *}
+SECTION {* operator *}
+SHORT   {* relational product of renamed arguments, renamed *}
+PROTO   {* BDD bdd_relprodreplace(BDD l, bddPair *lpair, BDD r, bddPair *rpair, BDD var, bddPair *opair) *}
+DESCR   {* Computes the same BDD as
+           {\tt bdd\_replace(bdd\_relprod(bdd\_replace(l,lpair),
+	   bdd\_replace(r,rpair), var), opair)}, but in a single bottom up
+	   pass over {\tt l} and {\tt r} that does not build the renamed
+	   arguments or the product before the last replace. Any of the
+	   pairs may be NULL, which means no replacement, and {\tt var} may
+	   be {\tt bddtrue}, which means no quantification; the variables
+	   of {\tt var} are those of the renamed arguments.
+
+	   The arguments are renamed as they are traversed, which requires
+	   {\tt lpair} and {\tt rpair} to keep the order of the variables
+	   that occur in {\tt l} and {\tt r}. When they do not, the function
+	   falls back to the separate operations, and does so right away on
+	   later calls with the same pairs and variable set. The pair
+	   {\tt opair} may reorder variables, as in {\tt bdd\_replace}. *}
+ALSO    {* bdd\_appex, bdd\_replace, bdd\_newpair *}
+RETURN  {* The result of the operation. *}
+*/
+BDD bdd_relprodreplace(BDD l, bddPair *lpair, BDD r, bddPair *rpair,
+		       BDD var, bddPair *opair)
+{
+   BDD res;
+   volatile BDD quant;  /* Assigned before setjmp */
+   int sig;
+   firstReorder = 1;
+
+   CHECKa(l, bddfalse);
+   CHECKa(r, bddfalse);
+   CHECKa(var, bddfalse);
+
+   quant = (var < 2 ? bddtrue : var);  /* var < 2 is the empty set */
+
+   sig = relprodrep_signature(lpair, rpair, quant, opair);
+   if (relprodrepsig[sig].failed)
+      return relprodrep_separate(l, lpair, r, rpair, quant, opair);
+
+ again:
+   if (setjmp(bddexception) == 0)
+   {
+      relprodrepquant = (quant > 1);
+      if (relprodrepquant  &&  varset2vartable(quant) < 0)
+	 return bddfalse;
+
+      INITREF;
+      applyop = bddop_or;
+      relprodrepid = relprodrepsig[sig].id;
+      relprodrepleft = (lpair != NULL ? lpair->result : NULL);
+      relprodrepleftlast = (lpair != NULL ? lpair->last : -1);
+      relprodrepright = (rpair != NULL ? rpair->result : NULL);
+      relprodreprightlast = (rpair != NULL ? rpair->last : -1);
+      relprodrepout = (opair != NULL ? opair->result : NULL);
+      relprodrepoutlast = (opair != NULL ? opair->last : -1);
+      relprodrepfailed = 0;
+
+      if (!firstReorder)
+	 bdd_disable_reorder();
+      res = relprodrep_rec(l, r);
+      if (!firstReorder)
+	 bdd_enable_reorder();
+   }
+   else
+   {
+      bdd_checkreorder();
+
+      if (firstReorder-- == 1)
+	 goto again;
+      res = BDDZERO;  /* avoid warning about res being uninitialized */
+   }
+
+   checkresize();
+
+   if (relprodrepfailed)
+   {
+	 /* A garbage collection may have dropped the entry meanwhile */
+      sig = relprodrep_signature(lpair, rpair, quant, opair);
+      relprodrepsig[sig].failed = 1;
+      res = relprodrep_separate(l, lpair, r, rpair, quant, opair);
+   }
+
+   return res;
+}
+
+
+   /* Level of node n after replacing with the pair p (last level l) */
+#define RENAMEDLEVEL(p,l,n) \
+   ((p) != NULL  &&  LEVEL(n) <= (l) ? LEVEL((p)[LEVEL(n)]) : LEVEL(n))
+
+static BDD relprodrep_rec(BDD l, BDD r)
+{
+   BddCacheData *entry;
+   BDD res;
+   int levell, levelr, level;
+
+   if (l == 0  ||  r == 0  ||  relprodrepfailed)
+      return 0;
+   if (ISCONST(l)  &&  ISCONST(r))
+      return 1;
+
+   entry = BddCache_lookup(&relprodrepcache, RELPRODREPHASH(l,r));
+   if (entry->a == l  &&  entry->b == r  &&  entry->c == relprodrepid)
+   {
+#ifdef CACHESTATS
+      bddcachestats.opHit++;
+#endif
+      return entry->r.res;
+   }
+#ifdef CACHESTATS
+   bddcachestats.opMiss++;
+#endif
+
+   levell = RENAMEDLEVEL(relprodrepleft, relprodrepleftlast, l);
+   levelr = RENAMEDLEVEL(relprodrepright, relprodreprightlast, r);
+   level = MIN(levell, levelr);
+
+      /* The renamed children must still come after the renamed node */
+   if (levell == level  &&
+       (RENAMEDLEVEL(relprodrepleft, relprodrepleftlast, LOW(l)) <= level  ||
+	RENAMEDLEVEL(relprodrepleft, relprodrepleftlast, HIGH(l)) <= level))
+      relprodrepfailed = 1;
+   if (levelr == level  &&
+       (RENAMEDLEVEL(relprodrepright, relprodreprightlast, LOW(r)) <= level  ||
+	RENAMEDLEVEL(relprodrepright, relprodreprightlast, HIGH(r)) <= level))
+      relprodrepfailed = 1;
+   if (relprodrepfailed)
+      return 0;
+
+   PUSHREF( relprodrep_rec(levell == level ? LOW(l) : l,
+			   levelr == level ? LOW(r) : r) );
+   PUSHREF( relprodrep_rec(levell == level ? HIGH(l) : l,
+			   levelr == level ? HIGH(r) : r) );
+   if (relprodrepfailed)
+   {
+      POPREF(2);
+      return 0;
+   }
+
+   if (relprodrepquant  &&  INVARSET(level))
+      res = apply_rec(READREF(2), READREF(1));
+   else
+   if (relprodrepout != NULL)
+      res = bdd_correctify(level <= relprodrepoutlast ?
+			   LEVEL(relprodrepout[level]) : level,
+			   READREF(2), READREF(1));
+   else
+      res = bdd_makenode(level, READREF(2), READREF(1));
+   POPREF(2);
+
+   entry->a = l;
+   entry->b = r;
+   entry->c = relprodrepid;
+   entry->r.res = res;
+
+   return res;
+}
+
+
 /*************************************************************************
   Informational functions
 *************************************************************************/
@@ -2056,7 +2320,7 @@ RETURN  {* A BDD variable set. *}
 */
 BDD bdd_support(BDD r)
 {
-   static int  supportSize = 0;
+   static BDD_THREAD_LOCAL int supportSize = 0;
    int n;
    int res=1;
 
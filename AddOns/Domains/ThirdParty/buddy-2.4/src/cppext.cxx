@@ -49,7 +49,6 @@ using namespace std;
 #define IOFORMAT_ALL    3
 #define IOFORMAT_FDDSET 4
 
-int bdd_ioformat::curformat = IOFORMAT_SET;
 bdd_ioformat bddset(IOFORMAT_SET);
 bdd_ioformat bddtable(IOFORMAT_TABLE);
 bdd_ioformat bdddot(IOFORMAT_DOT);
@@ -66,8 +65,11 @@ static void bdd_printdot_rec(ostream&, int);
 static void fdd_printset_rec(ostream &, int, int *);
 
 
-static bddstrmhandler strmhandler_bdd;
-static bddstrmhandler strmhandler_fdd;
+static BDD_THREAD_LOCAL bddstrmhandler strmhandler_bdd;
+static BDD_THREAD_LOCAL bddstrmhandler strmhandler_fdd;
+
+   /* The format selected by the last format object sent to a stream */
+static BDD_THREAD_LOCAL int curformat = IOFORMAT_SET;
 
    // Avoid calling C++ version of anodecount
 #undef bdd_anodecount
@@ -209,7 +211,7 @@ bddstrmhandler bdd_strm_hook(bddstrmhandler handler)
 
 ostream &operator<<(ostream &o, const bdd &r)
 {
-   if (bdd_ioformat::curformat == IOFORMAT_SET)
+   if (curformat == IOFORMAT_SET)
    {
       if (r.root < 2)
       {
@@ -229,7 +231,7 @@ ostream &operator<<(ostream &o, const bdd &r)
       delete[] set;
    }
    else
-   if (bdd_ioformat::curformat == IOFORMAT_TABLE)
+   if (curformat == IOFORMAT_TABLE)
    {
       o << "ROOT: " << r.root << "\n";
       if (r.root < 2)
@@ -258,7 +260,7 @@ ostream &operator<<(ostream &o, const bdd &r)
       }
    }
    else
-   if (bdd_ioformat::curformat == IOFORMAT_DOT)
+   if (curformat == IOFORMAT_DOT)
    {
       o << "digraph G {\n";
       o << "0 [shape=box, label=\"0\", style=filled, shape=box, height=0.3, width=0.3];\n";
@@ -271,7 +273,7 @@ ostream &operator<<(ostream &o, const bdd &r)
       bdd_unmark(r.root);
    }
    else
-   if (bdd_ioformat::curformat == IOFORMAT_FDDSET)
+   if (curformat == IOFORMAT_FDDSET)
    {
       if (ISCONST(r.root))
       {
@@ -326,7 +328,7 @@ ostream &operator<<(ostream &o, const bdd_ioformat &f)
 {
    if (f.format == IOFORMAT_SET  ||  f.format == IOFORMAT_TABLE  ||
        f.format == IOFORMAT_DOT  ||  f.format == IOFORMAT_FDDSET)
-      bdd_ioformat::curformat = f.format;
+      curformat = f.format;
    else
    if (f.format == IOFORMAT_ALL)
    {
@@ -81,41 +81,45 @@ const BDD bddfalse=0;                    /* The constant false bdd */
 
 /* Min. number of nodes (%) that has to be left after a garbage collect
    unless a resize should be done. */
-static int minfreenodes=20;
+static BDD_THREAD_LOCAL int minfreenodes=20;
+
+/* Growth (%) of the number of used nodes since the last automatic
+   reordering that triggers the next one. */
+static BDD_THREAD_LOCAL int reordergrowth=100;
 
 
 /*=== GLOBAL KERNEL VARIABLES ==========================================*/
 
-int          bddrunning;            /* Flag - package initialized */
-int          bdderrorcond;          /* Some error condition */
-int          bddnodesize;           /* Number of allocated nodes */
-int          bddmaxnodesize;        /* Maximum allowed number of nodes */
-int          bddmaxnodeincrease;    /* Max. # of nodes used to inc. table */
-BddNode*     bddnodes;          /* All of the bdd nodes */
-int          bddfreepos;        /* First free node */
-int          bddfreenum;        /* Number of free nodes */
-long int     bddproduced;       /* Number of new nodes ever produced */
-int          bddvarnum;         /* Number of defined BDD variables */
-int*         bddrefstack;       /* Internal node reference stack */
-int*         bddrefstacktop;    /* Internal node reference stack top */
-int*         bddvar2level;      /* Variable -> level table */
-int*         bddlevel2var;      /* Level -> variable table */
-jmp_buf      bddexception;      /* Long-jump point for interrupting calc. */
-int          bddresized;        /* Flag indicating a resize of the nodetable */
-
-bddCacheStat bddcachestats;
+BDD_THREAD_LOCAL int          bddrunning;            /* Flag - package initialized */
+BDD_THREAD_LOCAL int          bdderrorcond;          /* Some error condition */
+BDD_THREAD_LOCAL int          bddnodesize;           /* Number of allocated nodes */
+BDD_THREAD_LOCAL int          bddmaxnodesize;        /* Maximum allowed number of nodes */
+BDD_THREAD_LOCAL int          bddmaxnodeincrease;    /* Max. # of nodes used to inc. table */
+BDD_THREAD_LOCAL BddNode*     bddnodes;          /* All of the bdd nodes */
+BDD_THREAD_LOCAL int          bddfreepos;        /* First free node */
+BDD_THREAD_LOCAL int          bddfreenum;        /* Number of free nodes */
+BDD_THREAD_LOCAL long int bddproduced;       /* Number of new nodes ever produced */
+BDD_THREAD_LOCAL int          bddvarnum;         /* Number of defined BDD variables */
+BDD_THREAD_LOCAL int*         bddrefstack;       /* Internal node reference stack */
+BDD_THREAD_LOCAL int*         bddrefstacktop;    /* Internal node reference stack top */
+BDD_THREAD_LOCAL int*         bddvar2level;      /* Variable -> level table */
+BDD_THREAD_LOCAL int*         bddlevel2var;      /* Level -> variable table */
+BDD_THREAD_LOCAL jmp_buf      bddexception;      /* Long-jump point for interrupting calc. */
+BDD_THREAD_LOCAL int          bddresized;        /* Flag indicating a resize of the nodetable */
+
+BDD_THREAD_LOCAL bddCacheStat bddcachestats;
 
 
 /*=== PRIVATE KERNEL VARIABLES =========================================*/
 
-static BDD*     bddvarset;             /* Set of defined BDD variables */
-static int      gbcollectnum;          /* Number of garbage collections */
-static int      cachesize;             /* Size of the operator caches */
-static long int gbcclock;              /* Clock ticks used in GBC */
-static int      usednodes_nextreorder; /* When to do reorder next time */
-static bddinthandler  err_handler;     /* Error handler */
-static bddgbchandler  gbc_handler;     /* Garbage collection handler */
-static bdd2inthandler resize_handler;  /* Node-table-resize handler */
+static BDD_THREAD_LOCAL BDD*     bddvarset;             /* Set of defined BDD variables */
+static BDD_THREAD_LOCAL int      gbcollectnum;          /* Number of garbage collections */
+static BDD_THREAD_LOCAL int      cachesize;             /* Size of the operator caches */
+static BDD_THREAD_LOCAL long int gbcclock;             /* Clock ticks used in GBC */
+static BDD_THREAD_LOCAL int      usednodes_nextreorder; /* When to do reorder next time */
+static BDD_THREAD_LOCAL bddinthandler  err_handler;     /* Error handler */
+static BDD_THREAD_LOCAL bddgbchandler  gbc_handler;     /* Garbage collection handler */
+static BDD_THREAD_LOCAL bdd2inthandler resize_handler;  /* Node-table-resize handler */
 
 
    /* Strings for all error mesages */
@@ -614,6 +618,32 @@ int bdd_setminfreenodes(int mf)
 }
 
 
+/*
+NAME    {* bdd\_setreordergrowth *}
+SECTION {* kernel *}
+SHORT   {* set the node growth that triggers automatic reordering *}
+PROTO   {* int bdd_setreordergrowth(int n) *}
+DESCR   {* Automatic reordering is done when a garbage collection finds
+           that the number of used nodes has grown by {\tt n} percent
+	   since the last reordering (plus a little more if the last
+	   reordering gained less than 20\%). A low number reorders more
+	   often, which costs time but keeps the node table small. The
+	   default value is 100, that is, twice as many nodes. *}
+RETURN  {* The old growth on succes, otherwise a negative error code. *}
+ALSO    {* bdd\_autoreorder, bdd\_setminfreenodes *}
+*/
+int bdd_setreordergrowth(int n)
+{
+   int old = reordergrowth;
+
+   if (n < 0)
+      return bdd_error(BDD_RANGE);
+
+   reordergrowth = n;
+   return old;
+}
+
+
 /*
 NAME    {* bdd\_getnodenum *}
 SECTION {* kernel *}
@@ -1412,8 +1442,10 @@ void bdd_checkreorder(void)
 {
    bdd_reorder_auto();
 
-      /* Do not reorder before twice as many nodes have been used */
-   usednodes_nextreorder = 2 * (bddnodesize - bddfreenum);
+      /* Do not reorder before the used nodes have grown by reordergrowth
+       * percent (twice as many nodes by default) */
+   usednodes_nextreorder = (bddnodesize - bddfreenum)
+      + (int)(((long)(bddnodesize - bddfreenum) * reordergrowth) / 100);
    
       /* And if very little was gained this time (< 20%) then wait until
        * even more nodes (upto twice as many again) have been used */
@@ -89,25 +89,37 @@ typedef struct s_BddNode /* Node table entry */
 
 /*=== KERNEL VARIABLES =================================================*/
 
+   /* All of the package state, the node table and the caches included,
+      is kept per thread. A thread that calls bdd_init gets a package of
+      its own, and BDDs must stay on the thread that made them. Define
+      BDD_THREAD_LOCAL as empty for one package shared by all threads. */
+#ifndef BDD_THREAD_LOCAL
+#ifdef _MSC_VER
+#define BDD_THREAD_LOCAL __declspec(thread)
+#else
+#define BDD_THREAD_LOCAL __thread
+#endif
+#endif
+
 #ifdef CPLUSPLUS
 extern "C" {
 #endif
 
-extern int       bddrunning;         /* Flag - package initialized */
-extern int       bdderrorcond;       /* Some error condition was met */
-extern int       bddnodesize;        /* Number of allocated nodes */
-extern int       bddmaxnodesize;     /* Maximum allowed number of nodes */
-extern int       bddmaxnodeincrease; /* Max. # of nodes used to inc. table */
-extern BddNode*  bddnodes;           /* All of the bdd nodes */
-extern int       bddvarnum;          /* Number of defined BDD variables */
-extern int*      bddrefstack;        /* Internal node reference stack */
-extern int*      bddrefstacktop;     /* Internal node reference stack top */
-extern int*      bddvar2level;
-extern int*      bddlevel2var;
-extern jmp_buf   bddexception;
-extern int       bddreorderdisabled;
-extern int       bddresized;
-extern bddCacheStat bddcachestats;
+extern BDD_THREAD_LOCAL int       bddrunning;         /* Flag - package initialized */
+extern BDD_THREAD_LOCAL int       bdderrorcond;       /* Some error condition was met */
+extern BDD_THREAD_LOCAL int       bddnodesize;        /* Number of allocated nodes */
+extern BDD_THREAD_LOCAL int       bddmaxnodesize;     /* Maximum allowed number of nodes */
+extern BDD_THREAD_LOCAL int       bddmaxnodeincrease; /* Max. # of nodes used to inc. table */
+extern BDD_THREAD_LOCAL BddNode*  bddnodes;           /* All of the bdd nodes */
+extern BDD_THREAD_LOCAL int       bddvarnum;          /* Number of defined BDD variables */
+extern BDD_THREAD_LOCAL int*      bddrefstack;        /* Internal node reference stack */
+extern BDD_THREAD_LOCAL int*      bddrefstacktop;     /* Internal node reference stack top */
+extern BDD_THREAD_LOCAL int*      bddvar2level;
+extern BDD_THREAD_LOCAL int*      bddlevel2var;
+extern BDD_THREAD_LOCAL jmp_buf   bddexception;
+extern BDD_THREAD_LOCAL int       bddreorderdisabled;
+extern BDD_THREAD_LOCAL int       bddresized;
+extern BDD_THREAD_LOCAL bddCacheStat bddcachestats;
 
 #ifdef CPLUSPLUS
 }
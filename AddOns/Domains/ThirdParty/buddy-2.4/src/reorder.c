@@ -34,9 +34,15 @@
   AUTH:  Jorn Lind
   DATE:  (C) january 1998
 *************************************************************************/
+#if !defined(_MSC_VER)  &&  !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 199309L   /* clock_gettime */
+#endif
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#ifdef _MSC_VER
+#include <windows.h>
+#endif
 #include <math.h>
 #include <assert.h>
 #include "kernel.h"
@@ -63,19 +69,19 @@
 #define __USERESIZE /* FIXME */
 
    /* Current auto reord. method and number of automatic reorderings left */
-static int bddreordermethod;
-static int bddreordertimes;
+static BDD_THREAD_LOCAL int bddreordermethod;
+static BDD_THREAD_LOCAL int bddreordertimes;
 
    /* Flag for disabling reordering temporarily */
-static int reorderdisabled;
+static BDD_THREAD_LOCAL int reorderdisabled;
 
    /* Store for the variable relationships */
-static BddTree *vartree;
-static int blockid;
+static BDD_THREAD_LOCAL BddTree *vartree;
+static BDD_THREAD_LOCAL int blockid;
 
    /* Store for the ref.cou. of the external roots */
-static int *extroots;
-static int extrootsize;
+static BDD_THREAD_LOCAL int *extroots;
+static BDD_THREAD_LOCAL int extrootsize;
 
 /* Level data */
 typedef struct _levelData
@@ -86,28 +92,34 @@ typedef struct _levelData
    int nodenum;  /* Number of nodes in this level */
 } levelData;
 
-static levelData *levels; /* Indexed by variable! */
+static BDD_THREAD_LOCAL levelData *levels; /* Indexed by variable! */
 
    /* Interaction matrix */
-static imatrix *iactmtx;
+static BDD_THREAD_LOCAL imatrix *iactmtx;
 
    /* Reordering information for the user */
-static int verbose;
-static bddinthandler reorder_handler;
-static bddfilehandler reorder_filehandler;
-static bddsizehandler reorder_nodenum;
+static BDD_THREAD_LOCAL int verbose;
+static BDD_THREAD_LOCAL bddinthandler reorder_handler;
+static BDD_THREAD_LOCAL bddfilehandler reorder_filehandler;
+static BDD_THREAD_LOCAL bddsizehandler reorder_nodenum;
 
    /* Number of live nodes before and after a reordering session */
-static int usednum_before;
-static int usednum_after;
+static BDD_THREAD_LOCAL int usednum_before;
+static BDD_THREAD_LOCAL int usednum_after;
+
+   /* Time limit (msec) of one reordering session and the time, on
+      reorder_msec's clock, at which the current one must stop sifting
+      (zero for no limit) */
+static BDD_THREAD_LOCAL int reorder_timelimit;
+static BDD_THREAD_LOCAL long reorder_deadline;
 	    
    /* Kernel variables needed for reordering */
-extern int bddfreepos;
-extern int bddfreenum;
-extern int bddproduced;
+extern BDD_THREAD_LOCAL int bddfreepos;
+extern BDD_THREAD_LOCAL int bddfreenum;
+extern BDD_THREAD_LOCAL int bddproduced;
 
    /* Flag telling us when a node table resize is done */
-static int resizedInMakenode;
+static BDD_THREAD_LOCAL int resizedInMakenode;
 
    /* New node hashing function for use with reordering */
 #define NODEHASH(var,l,h) ((PAIR((l),(h))%levels[var].size)+levels[var].start)
@@ -122,6 +134,10 @@ static int  reorder_varup(int);
 static int  reorder_vardown(int);
 static int  reorder_init(void);
 static void reorder_done(void);
+static BddTree *reorder_sortblocks(BddTree *);
+static long reorder_msec(void);
+static int  reorder_outoftime(void);
+static int  varseqCmp(const void *, const void *);
 
 #define random(a) (rand() % (a))
 
@@ -148,6 +164,7 @@ void bdd_reorder_init(void)
    bdd_autoreorder_times(BDD_REORDER_NONE, 0);
    reorder_nodenum = bdd_getnodenum;
    usednum_before = usednum_after = 0;
+   reorder_timelimit = 0;
    blockid = 0;
 }
 
@@ -581,6 +598,10 @@ static BddTree *reorder_sift_seq(BddTree *t, BddTree **seq, int num)
    for (n=0 ; n<num ; n++)
    {
       long c2, c1 = clock();
+
+         /* Out of time, keep the blocks where they are now */
+      if (reorder_outoftime())
+	 break;
    
       if (verbose > 1)
       {
@@ -692,7 +713,8 @@ static BddTree *reorder_siftite(BddTree *t)
       lastsize = reorder_nodenum();
       first = reorder_sift(first);
    }
-   while (reorder_nodenum() != lastsize);
+   while (reorder_nodenum() != lastsize  &&
+	  !reorder_outoftime());
 
    return first;
 }
@@ -738,6 +760,76 @@ static BddTree *reorder_random(BddTree *t)
   Swapping adjacent blocks
 *************************************************************************/
 
+static int blockCmp(const void *aa, const void *bb)
+{
+   BddTree *a = *((BddTree**)aa);
+   BddTree *b = *((BddTree**)bb);
+
+   return bddvar2level[a->seq[0]] - bddvar2level[b->seq[0]];
+}
+
+
+/* The swapping below expects the blocks of each list in the order of
+   their levels. The lists are kept in this order while reordering, but
+   they are built in the order of the variable numbers, which differs
+   when blocks are added after the variable order has changed. This
+   sorts each list and each block sequence on the current levels.
+*/
+static BddTree *reorder_sortblocks(BddTree *t)
+{
+   BddTree *this, **seq;
+   int n, num;
+
+   if (t == NULL)
+      return t;
+
+   for (this=t,num=0 ; this!=NULL ; this=this->next,num++)
+   {
+      qsort(this->seq, this->last-this->first+1, sizeof(int), varseqCmp);
+      this->nextlevel = reorder_sortblocks(this->nextlevel);
+   }
+
+   if ((seq=NEW(BddTree*,num)) == NULL)
+      return t;
+   for (this=t,n=0 ; this!=NULL ; this=this->next)
+      seq[n++] = this;
+
+   qsort(seq, num, sizeof(BddTree*), blockCmp);
+
+   for (n=0 ; n<num ; n++)
+   {
+      seq[n]->prev = (n > 0 ? seq[n-1] : NULL);
+      seq[n]->next = (n < num-1 ? seq[n+1] : NULL);
+   }
+
+   t = seq[0];
+   free(seq);
+   return t;
+}
+
+
+/* Milliseconds on a clock that only moves forward. The time limit is
+   wall-clock time: processor time (clock) counts every thread of the
+   process, and each thread may have a BuDDy of its own.
+*/
+static long reorder_msec(void)
+{
+#ifdef _MSC_VER
+   return (long)GetTickCount();
+#else
+   struct timespec now;
+   clock_gettime(CLOCK_MONOTONIC, &now);
+   return (long)now.tv_sec*1000 + now.tv_nsec/1000000;
+#endif
+}
+
+
+static int reorder_outoftime(void)
+{
+   return reorder_deadline != 0  &&  reorder_msec() > reorder_deadline;
+}
+
+
 static void blockdown(BddTree *left)
 {
    BddTree *right = left->next;
@@ -1566,7 +1658,7 @@ int bdd_swapvar(int v1, int v2)
 
 void bdd_default_reohandler(int prestate)
 {
-   static long c1;
+   static BDD_THREAD_LOCAL long c1;
 
    if (verbose > 0)
    {
@@ -1813,12 +1905,15 @@ void bdd_reorder(int method)
       return;
 
    usednum_before = bddnodesize - bddfreenum;
+   reorder_deadline = 0;
+   if (reorder_timelimit > 0)
+      reorder_deadline = reorder_msec() + reorder_timelimit;
    
    top->first = 0;
    top->last = bdd_varnum()-1;
    top->fixed = 0;
    top->next = NULL;
-   top->nextlevel = vartree;
+   top->nextlevel = reorder_sortblocks(vartree);
 
    reorder_block(top, method);
    vartree = top->nextlevel;
@@ -2049,6 +2144,27 @@ int bdd_reorder_verbose(int v)
 }
 
 
+/*
+NAME    {* bdd\_reorder\_timelimit *}
+SECTION {* reorder *}
+SHORT   {* limits the time of one reordering *}
+PROTO   {* int bdd_reorder_timelimit(int msec) *}
+DESCR   {* Sets the wall-clock time, in milliseconds, that one
+	   reordering may spend sifting. When it runs out, the blocks stay
+	   where they are and the reordering ends, so that the order is as good
+	   as the sifting got. Only the sifting methods look at the limit.
+	   A value of zero, the default, means no limit. *}
+RETURN  {* The old limit *}
+ALSO    {* bdd\_reorder, bdd\_autoreorder *}
+*/
+int bdd_reorder_timelimit(int msec)
+{
+   int tmp = reorder_timelimit;
+   reorder_timelimit = (msec > 0 ? msec : 0);
+   return tmp;
+}
+
+
 /*
 NAME    {* bdd\_reorder\_probe *}
 SECTION {* reorder *}
@@ -0,0 +1,68 @@
+#ifndef wali_ATOMIC_COUNT_GUARD
+#define wali_ATOMIC_COUNT_GUARD 1
+
+/**
+ * @file AtomicCount.hpp
+ */
+
+#include <atomic>
+
+namespace wali
+{
+  /**
+   * @class AtomicCount
+   * @brief A reference count that may be shared between threads
+   *
+   * Drop-in replacement for the unsigned int count used by ref_ptr.
+   * Increments are relaxed, because a thread can only take a new
+   * reference through one it already holds. Decrements are acq_rel, so
+   * that the thread which drops the count to zero sees every write made
+   * through the other references before it deletes the object.
+   *
+   * @see ref_ptr
+   * @see AtomicCountable
+   */
+  class AtomicCount
+  {
+    public:
+      typedef unsigned int value_type;
+
+      AtomicCount( value_type v = 0 ) : value(v) {}
+
+      /** Resets the count; only safe while no ref_ptr refers to the owner. */
+      AtomicCount & operator=( value_type v ) {
+        value.store(v, std::memory_order_relaxed);
+        return *this;
+      }
+
+      /** @return the new count */
+      value_type operator++() {
+        return value.fetch_add(1, std::memory_order_relaxed) + 1;
+      }
+
+      /** @return the new count */
+      value_type operator--() {
+        return value.fetch_sub(1, std::memory_order_acq_rel) - 1;
+      }
+
+      /**
+       * Only meaningful when no other thread can change the count,
+       * e.g., for printing or asserting.
+       */
+      operator value_type() const {
+        return value.load(std::memory_order_relaxed);
+      }
+
+    private:
+      std::atomic<value_type> value;
+
+      // Counts belong to one object; see Countable's copy constructor.
+      AtomicCount( AtomicCount const & );
+      AtomicCount & operator=( AtomicCount const & );
+
+  }; // class AtomicCount
+
+} // namespace wali
+
+#endif // wali_ATOMIC_COUNT_GUARD
+
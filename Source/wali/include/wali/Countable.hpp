@@ -7,13 +7,32 @@
 
 #include "wali/Common.hpp"
 #include "wali/ref_ptr.hpp"
+#include "wali/AtomicCount.hpp"
 
 namespace wali
 {
+  /**
+   * Mixin that gives a class the count ref_ptr needs.
+   *
+   * By default the count is a plain unsigned int, and objects must not be
+   * shared between threads (see ref_ptr). Building WALi -- and everything
+   * linked against it -- with WALI_ATOMIC_REFCOUNT defined makes the count
+   * an AtomicCount instead, so that sem_elem_ts and all other Countables
+   * may be shared. Both builds have a switch for it: the CMake option
+   * WALI_ATOMIC_REFCOUNT and 'scons atomic_refcount=1'.
+   *
+   * @see AtomicCountable for an always-atomic count on individual types
+   */
   class Countable
   {
     public:
-      ref_ptr<Countable>::count_t count;
+#ifdef WALI_ATOMIC_REFCOUNT
+      typedef AtomicCount count_t;
+#else
+      typedef ref_ptr<Countable>::count_t count_t;
+#endif
+
+      count_t count;
 
     public:
       /**
@@ -49,6 +68,38 @@ namespace wali
 
   }; // class Countable
 
+
+  /**
+   * Same as Countable, except that the count is always an AtomicCount,
+   * whatever WALI_ATOMIC_REFCOUNT says. Use this for types that are
+   * shared between threads when the rest of WALi is built without atomic
+   * counts.
+   */
+  class AtomicCountable
+  {
+    public:
+      typedef AtomicCount count_t;
+
+      count_t count;
+
+    public:
+      AtomicCountable() : count(0) {}
+
+      AtomicCountable( const AtomicCountable& c ATTR_UNUSED ) : count(0)
+      {
+        (void) c;
+      }
+
+      AtomicCountable& operator=( const AtomicCountable& c ATTR_UNUSED ) throw()
+      {
+        (void) c;
+        return *this;
+      }
+
+      virtual ~AtomicCountable() {}
+
+  }; // class AtomicCountable
+
 } // namespace wali
 
 #endif // wali_COUNTABLE_GUARD
@@ -14,8 +14,11 @@ namespace wali
 {
   /**
    * @class KeySource
+   *
+   * KeySources are shared between all threads that look keys up in the
+   * KeySpace, so they always use atomic reference counts.
    */
-  class KeySource : public Printable, public Countable
+  class KeySource : public Printable, public AtomicCountable
   {
   public:
     KeySource() {}
@@ -6,8 +6,12 @@
  */
 
 #include "wali/Common.hpp"
-#include "wali/HashMap.hpp"
+#include "wali/RobinHoodHashMap.hpp"
 #include "wali/KeySource.hpp"   //! defines hm_hash<wali::KeySource*>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <utility>
 #include <vector>
 
 namespace llvm {
@@ -18,10 +22,33 @@ namespace wali
 {
   /**
    * @class KeySpace
+   *
+   * Interning of KeySources is safe to call from several threads at once.
+   * The source -> Key map is split into NUM_SHARDS shards by hash, each
+   * with its own lock, so threads interning different sources rarely
+   * wait on each other. The Key -> source table is never moved once
+   * written, so getKeySource, key2str and printKey take no lock at all.
+   *
+   * Strings, ints and key pairs -- nearly every key in practice -- are
+   * not stored as KeySource objects. Their contents live directly in the
+   * Key table (string bytes in a per-shard arena), and each shard finds
+   * them through flat open-addressed tables of Keys. getKey( Key, Key )
+   * and getKey( int ) allocate nothing. getKeySource creates the
+   * StringSource, IntSource or KeyPairSource for such a key the first
+   * time it is asked for and keeps it. Any other KeySource is stored as
+   * before.
+   *
+   * Keys are still handed out densely from 0 in the order in which new
+   * sources are interned, so single-threaded clients see exactly the keys
+   * they always did.
+   *
+   * clear() is the exception: it must not race with anything.
    */
   class KeySpace
   {
   public:
+    typedef std::pair< wali::Key, wali::Key > key_pair_t;
+
     KeySpace();
 
     ~KeySpace();
@@ -82,9 +109,45 @@ namespace wali
      */
     key_src_t getKeySource( wali::Key key );
 
+    /**
+     * If key was created for a pair of keys (by getKey( Key, Key ) or
+     * from a KeyPairSource), stores the pair in kp and returns true.
+     * Does not allocate.
+     */
+    bool getKeyPair( wali::Key key, key_pair_t & kp );
+
+    /**
+     * Interns every element of sources, and stores the corresponding
+     * keys in keys (in the same order, replacing its contents).
+     *
+     * Each shard is locked once for the whole batch rather than once per
+     * source. Newly created keys are numbered shard by shard, so they are
+     * not necessarily increasing in the order of sources.
+     */
+    void getKeys( std::vector< key_src_t > const & sources,
+                  std::vector< wali::Key > & keys );
+
+    /**
+     * Batched version of getKey( const std::string& )
+     */
+    void getKeys( std::vector< std::string > const & strs,
+                  std::vector< wali::Key > & keys );
+
+    /**
+     * Batched version of getKey( wali::Key, wali::Key )
+     */
+    void getKeys( std::vector< key_pair_t > const & pairs,
+                  std::vector< wali::Key > & keys );
+
+    /**
+     * Preallocates room for a total of n keys, so that interning them
+     * later does not have to stop to grow the key table.
+     */
+    void reserve( size_t n );
+
     /**
      * Reset the KeySpace. Clears all keys and deletes
-     * all KeySources
+     * all KeySources. Not thread safe.
      */
     void clear();
 
@@ -120,21 +183,147 @@ namespace wali
     std::string key2str( wali::Key key );
 
   protected:
-    typedef wali::HashMap< key_src_t, wali::Key > ks_hash_map_t;
-    typedef std::vector< key_src_t > ks_vector_t;
+    typedef wali::RobinHoodHashMap< key_src_t, wali::Key > ks_hash_map_t;
+
+    /**
+     * How an Entry of the key table stores its source.
+     */
+    enum Kind {
+      EMPTY = 0,  //!< not yet published
+      POLY,       //!< source holds an arbitrary KeySource
+      STRING,     //!< first: pointer to the bytes, second: length
+      INT,        //!< first: the int
+      PAIR        //!< first, second: the two keys
+    };
+
+    /**
+     * One key. kind is written last (with release) when a key is
+     * created; a reader that sees EMPTY must treat the key as unknown.
+     */
+    struct Entry
+    {
+      std::atomic< KeySource* > source; //!< POLY, or materialized copy
+      size_t first;
+      size_t second;
+      std::atomic< unsigned char > kind;
+
+      Entry() : source(0), first(0), second(0), kind(EMPTY) {}
+    };
+
+    /**
+     * Open-addressed set of Keys with linear probing; equality and
+     * hashing go through the Entry of each key. INVALID marks an empty
+     * slot.
+     */
+    struct KeyTable
+    {
+      std::vector< wali::Key > slots;
+      size_t used;
+
+      KeyTable() : used(0) {}
+    };
+
+    static const wali::Key INVALID = ~wali::Key(0);
+
+    /**
+     * Bump allocator for string bytes. Blocks are never moved or freed
+     * until clear().
+     */
+    struct StringArena
+    {
+      std::vector< char* > blocks;
+      size_t left;  //!< bytes free at the end of blocks.back()
+
+      StringArena() : left(0) {}
+    };
+
+    /**
+     * One lock-protected piece of the source -> wali::Key map.
+     */
+    struct Shard
+    {
+      std::mutex lock;
+      ks_hash_map_t keymap;  //!< POLY sources
+      KeyTable strings;
+      KeyTable ints;
+      KeyTable pairs;
+      StringArena arena;
+    };
+
+    /**
+     * Number of shards. A power of two.
+     */
+    static const size_t NUM_SHARDS = 64;
 
     /**
-     * keymap maps key_src_t to wali::Key. The wali::Key is
-     * an index into the vector values
+     * The key table is stored in chunks; chunk i holds
+     * FIRST_CHUNK_SIZE << i entries, so MAX_CHUNKS chunks are more than
+     * enough for any wali::Key.
      */
-    ks_hash_map_t keymap;
+    static const size_t FIRST_CHUNK_SIZE = 1024;
+    static const size_t MAX_CHUNKS = 48;
+
+    static const size_t ARENA_BLOCK_SIZE = 64 * 1024;
+
+    static size_t hashString( const char* s, size_t len );
+    static size_t hashInt( int i );
+    static size_t hashPair( wali::Key k1, wali::Key k2 );
+
+    /** @return the hash a compact entry was filed under */
+    static size_t hashEntry( Entry const & e, Kind kind );
+
+    /**
+     * Finds the key whose entry has the given kind and contents in
+     * table, or creates one. For STRING, first points at bytes that are
+     * copied into the shard's arena if the key is new. The caller must
+     * hold shard.lock.
+     */
+    wali::Key internCompact( Shard & shard, KeyTable & table, Kind kind,
+                             size_t hash, size_t first, size_t second );
+
+    wali::Key internString( const char* s, size_t len );
+
+    /**
+     * Look ks up in shard, and give it the next key if it is new.
+     * The caller must hold shard.lock.
+     */
+    wali::Key internPoly( Shard & shard, key_src_t const & ks );
+
+    /** @return a new key whose entry is filled in by the caller */
+    wali::Key newKey( Entry * & entry );
+
+    /** @return the entry for key, allocating its chunk if asked to */
+    Entry * entry( wali::Key key, bool allocate );
+
+    /** @return the entry for key if it has been published, else NULL */
+    Entry * publishedEntry( wali::Key key, Kind & kind );
+
+    static void locate( wali::Key key, size_t & chunk, size_t & offset );
+
+    void growTable( KeyTable & table, Kind kind );
+
+    /** Prints the key (which must be published) the way its source would */
+    void printEntry( std::ostream& o, Entry const & e, Kind kind );
+
+    Shard shards[NUM_SHARDS];
 
     /**
      * wali::Key's are guaranteed to be unique w.r.t. this KeySpace
-     * because they are indexes into the vector values. KeySource's
-     * are retrieved by a lookup into values
+     * because they are indexes into the table values. Chunks are
+     * allocated on demand and never move.
+     */
+    std::atomic< Entry* > values[MAX_CHUNKS];
+
+    /**
+     * The next key to hand out, i.e., the number of keys.
+     */
+    std::atomic< size_t > numKeys;
+
+    /**
+     * Owns the KeySources that getKeySource created for compact keys.
      */
-    ks_vector_t values;
+    std::mutex materializedLock;
+    std::vector< key_src_t > materialized;
 
   }; // class KeySpace
 
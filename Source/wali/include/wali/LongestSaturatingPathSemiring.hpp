@@ -28,6 +28,10 @@ namespace wali {
 
     sem_elem_t zero() const;
 
+    bool isZero() const;
+
+    bool isOne() const;
+
     //---------------------------------
     // semiring operations
     //---------------------------------
@@ -44,6 +48,10 @@ namespace wali {
     //------------------------------------
     std::ostream & print(std::ostream &out) const;
 
+    bool serialize(std::ostream &out) const;
+
+    sem_elem_t deserialize(char const * data, size_t size) const;
+
     unsigned int getNum() const;
 
     size_t hash() const;      
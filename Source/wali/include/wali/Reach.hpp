@@ -22,6 +22,10 @@ class Reach : public SemElem
 
     sem_elem_t zero() const;
 
+    bool isZero() const;
+
+    bool isOne() const;
+
     // zero is the annihilator for extend
     sem_elem_t extend( SemElem* rhs );
 
@@ -34,6 +38,10 @@ class Reach : public SemElem
 
     sem_elem_t from_string( const std::string& s ) const;
 
+    bool serialize( std::ostream & o ) const;
+
+    sem_elem_t deserialize( char const * data, size_t size ) const;
+
     static int numReaches;
 
   protected:
@@ -0,0 +1,487 @@
+#ifndef wali_ROBIN_HOOD_HASH_MAP_GUARD
+#define wali_ROBIN_HOOD_HASH_MAP_GUARD 1
+
+/**
+ * @file RobinHoodHashMap.hpp
+ *
+ * An open-addressing alternative to wali::HashMap.
+ */
+
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <utility>  // std::pair
+#include "wali/hm_hash.hpp"
+
+namespace wali
+{
+  template< typename Key,
+    typename Data,
+    typename HashFunc,
+    typename EqualFunc > class RobinHoodHashMap;
+
+  /**
+   * Iterator over a RobinHoodHashMap. Map is the (possibly const) map
+   * type and Value the (possibly const) value_type.
+   */
+  template< typename Map, typename Value >
+    class RobinHoodIterator
+    {
+      public:
+        typedef Value value_type;
+        typedef size_t size_type;
+
+        RobinHoodIterator() : index(0),hashMap(0) {}
+
+        RobinHoodIterator( size_type i, Map *hmap )
+          : index(i),hashMap(hmap) {}
+
+        /** iterator -> const_iterator */
+        template< typename M, typename V >
+          RobinHoodIterator( const RobinHoodIterator<M,V>& it )
+          : index(it.index),hashMap(it.hashMap) {}
+
+        inline value_type *operator->() const
+        {
+          return &hashMap->slots[index];
+        }
+
+        inline value_type& operator*() const
+        {
+          return hashMap->slots[index];
+        }
+
+        inline bool operator==( const RobinHoodIterator& right ) const
+        {
+          return right.index == index;
+        }
+
+        inline bool operator!=( const RobinHoodIterator& right ) const
+        {
+          return right.index != index;
+        }
+
+        inline RobinHoodIterator& operator++()
+        {
+          index = hashMap->nextOccupied(index + 1);
+          return *this;
+        }
+
+        RobinHoodIterator operator++( int )
+        {
+          RobinHoodIterator old = *this;
+          ++(*this);
+          return old;
+        }
+
+      private:
+        template< typename M, typename V > friend class RobinHoodIterator;
+        template< typename K, typename D, typename H, typename E >
+          friend class RobinHoodHashMap;
+
+        size_type index;
+        Map *hashMap;
+    };
+
+
+  /**
+   * class RobinHoodHashMap
+   *
+   * Drop-in replacement for wali::HashMap (same typedefs, constructors and
+   * methods) that stores its values in one flat array instead of a
+   * heap-allocated Bucket per value. Collisions are resolved by linear
+   * probing with Robin Hood ordering, and erase shifts the following
+   * values back rather than leaving tombstones, so lookups stay short even
+   * after many erasures. The hash is remixed before use, so weak hashes
+   * such as the identity on Keys are fine.
+   *
+   * The difference to HashMap is iterator and reference stability:
+   * insert may move every value, and erase may move values after the
+   * erased one. Any insert or erase invalidates all iterators, pointers
+   * and references into the map, except for the iterator returned by
+   * erase( iterator ), which refers to the next value. (Use
+   * "it = m.erase(it)" rather than "m.erase(it++)" to erase while
+   * iterating.) Choose it per instantiation, where the map is used for
+   * lookups and does not hand out references that outlive a later
+   * insert.
+   *
+   * Probe sequences are bounded by log2(capacity()), and the table grows
+   * when an insert would exceed that, so HashFunc must not map more
+   * than a handful of distinct keys to the same value.
+   */
+  template< typename Key,
+    typename Data,
+    typename HashFunc = hm_hash< Key >,
+    typename EqualFunc = hm_equal< Key > >
+      class RobinHoodHashMap
+      {
+        public:     // typedef
+          typedef RobinHoodHashMap< Key,Data,HashFunc,EqualFunc >     hashmap_type;
+          typedef std::pair< Key,Data >                               pair_type;
+          typedef pair_type                                           value_type;
+          typedef size_t                                              size_type;
+          typedef RobinHoodIterator< hashmap_type, value_type >       iterator;
+          typedef RobinHoodIterator< const hashmap_type, const value_type > const_iterator;
+
+          typedef Key   key_type;
+          typedef Data  mapped_type;
+
+          template< typename M, typename V > friend class RobinHoodIterator;
+
+        public:     // con/destructor
+          /**
+           * @param the_size number of values to make room for
+           */
+          RobinHoodHashMap( size_type the_size=47 )
+            : slots(0),dist(0),numValues(0),numSlots(0),maxProbe(0)
+          {
+            allocate( slotsFor(the_size) );
+          }
+
+          RobinHoodHashMap( const RobinHoodHashMap& hm )
+            : slots(0),dist(0),numValues(0),numSlots(0),maxProbe(0)
+          {
+            allocate( slotsFor(hm.size()) );
+            for( const_iterator it = hm.begin() ; it != hm.end() ; it++ )
+              insert( *it );
+          }
+
+          RobinHoodHashMap& operator=( const RobinHoodHashMap& hm ) {
+            if( this != &hm ) {
+              clear();
+              for( const_iterator it = hm.begin() ; it != hm.end() ; it++ )
+                insert( *it );
+            }
+            return *this;
+          }
+
+          ~RobinHoodHashMap() {
+            clear();
+            release();
+          }
+
+        public:        // inline methods
+          void clear()
+          {
+            for( size_type i = 0 ; i < totalSlots() ; i++ ) {
+              if( dist[i] ) {
+                slots[i].~value_type();
+                dist[i] = 0;
+              }
+            }
+            numValues = 0;
+          }
+
+          inline size_type size() const
+          {
+            return numValues;
+          }
+
+          inline size_type capacity() const
+          {
+            return numSlots;
+          }
+
+          inline std::pair<iterator,bool> insert( const Key& k, const Data& d )
+          {
+            return insert( pair_type(k,d) );
+          }
+
+          void erase( const Key& key_to_erase )
+          {
+            iterator it = find( key_to_erase );
+            if( it != end() )
+              erase( it );
+          }
+
+          iterator begin()
+          {
+            return iterator( nextOccupied(0),this );
+          }
+
+          inline iterator end()
+          {
+            return iterator( totalSlots(),this );
+          }
+
+          const_iterator begin() const
+          {
+            return const_iterator( nextOccupied(0),this );
+          }
+
+          inline const_iterator end() const
+          {
+            return const_iterator( totalSlots(),this );
+          }
+
+          Key & key( iterator & it )
+          {
+            return it->first;
+          }
+
+          const Key & key( const_iterator & it ) const
+          {
+            return it->first;
+          }
+
+          Data & value( iterator & it )
+          {
+            return it->second;
+          }
+
+          const Data & value( const_iterator & it ) const
+          {
+            return it->second;
+          }
+
+          Data & data( iterator & it )
+          {
+            return it->second;
+          }
+
+          const Data & data( const_iterator & it ) const
+          {
+            return it->second;
+          }
+
+          void print_stats( std::ostream & o = std::cout ) const
+          {
+            size_type longest = 0;
+            size_type total = 0;
+            for( size_type i = 0 ; i < totalSlots() ; i++ ) {
+              if( dist[i] ) {
+                total += dist[i];
+                if( dist[i] > longest )
+                  longest = dist[i];
+              }
+            }
+            o << "Stats:\n";
+            o << "\tNumber of Values   : " << numValues << std::endl;
+            o << "\tNumber of Slots    : " << numSlots << std::endl;
+            o << "\tAverage probe count: "
+              << (numValues ? static_cast<double>(total) / numValues : 0.0) << std::endl;
+            o << "\tMax probe count    : " << longest << std::endl;
+          }
+
+        public:        // methods
+          std::pair<iterator,bool> insert( const value_type& );
+
+          iterator find( const Key& the_key )
+          {
+            return iterator( findIndex(the_key),this );
+          }
+
+          const_iterator find( const Key& the_key ) const
+          {
+            return const_iterator( findIndex(the_key),this );
+          }
+
+          /**
+           * @return iterator to the value after it
+           */
+          iterator erase( iterator it );
+
+          Data & operator[](const Key & k) {
+            return (*((insert(value_type(k, Data()))).first)).second;
+          }
+
+        private:    // inline methods
+          /**
+           * Fibonacci hashing: the top bits of hash * 2^64/phi, so that
+           * every bit of the hash affects the home slot.
+           */
+          inline size_type homeSlot( const Key& the_key ) const
+          {
+            unsigned long long h = static_cast<unsigned long long>(hashFunc(the_key));
+            h *= 11400714819323198485ULL;
+            return static_cast<size_type>(h >> shift);
+          }
+
+          /**
+           * The table has maxProbe extra slots past numSlots instead of
+           * wrapping around, so iteration order is index order and
+           * erase only ever moves values towards the front.
+           */
+          inline size_type totalSlots() const
+          {
+            return numSlots + maxProbe;
+          }
+
+          size_type nextOccupied( size_type i ) const
+          {
+            while( i < totalSlots() && !dist[i] )
+              i++;
+            return i;
+          }
+
+          static size_type slotsFor( size_type values )
+          {
+            // keep the load factor at or below 7/8
+            size_type n = 8;
+            while( n - n / 8 < values )
+              n *= 2;
+            return n;
+          }
+
+          size_type findIndex( const Key& the_key ) const
+          {
+            size_type i = homeSlot(the_key);
+            // dist[i] is one more than the distance of slots[i] from its
+            // home, or 0 if the slot is empty. A value that is further
+            // along than its home distance would be means the_key is absent.
+            for( unsigned char d = 1 ; d <= dist[i] ; d++, i++ ) {
+              if( equalFunc( the_key,slots[i].first ) )
+                return i;
+            }
+            return totalSlots();
+          }
+
+          void allocate( size_type n );
+
+          void release()
+          {
+            std::allocator< value_type >().deallocate( slots,totalSlots() );
+            delete[] dist;
+            slots = 0;
+            dist = 0;
+          }
+
+          void grow();
+
+        private:    // variables
+          value_type *slots;
+          unsigned char *dist;
+          size_type numValues;
+          size_type numSlots;   //!< a power of 2
+          size_type maxProbe;   //!< longest allowed probe; log2(numSlots)
+          unsigned shift;       //!< 64 - log2(numSlots)
+          HashFunc hashFunc;
+          EqualFunc equalFunc;
+      };
+
+  template< typename Key,
+    typename Data,
+    typename HashFunc,
+    typename EqualFunc >
+      void RobinHoodHashMap<Key,Data,HashFunc,EqualFunc>::allocate( size_type n )
+      {
+        numSlots = n;
+        maxProbe = 0;
+        while( (size_type(1) << maxProbe) < n )
+          maxProbe++;
+        shift = 64 - maxProbe;
+        slots = std::allocator< value_type >().allocate( totalSlots() );
+        // one extra, always empty, byte ends every probe sequence
+        dist = new unsigned char[totalSlots() + 1];
+        memset( dist,0,totalSlots() + 1 );
+      }
+
+  template< typename Key,
+    typename Data,
+    typename HashFunc,
+    typename EqualFunc >
+      void RobinHoodHashMap<Key,Data,HashFunc,EqualFunc>::grow()
+      {
+        value_type *oldSlots = slots;
+        unsigned char *oldDist = dist;
+        size_type oldTotal = totalSlots();
+
+        allocate( numSlots * 2 );
+        numValues = 0;
+        for( size_type i = 0 ; i < oldTotal ; i++ ) {
+          if( oldDist[i] ) {
+            insert( oldSlots[i] );
+            oldSlots[i].~value_type();
+          }
+        }
+        std::allocator< value_type >().deallocate( oldSlots,oldTotal );
+        delete[] oldDist;
+      }
+
+  template< typename Key,
+    typename Data,
+    typename HashFunc,
+    typename EqualFunc >
+      std::pair< typename RobinHoodHashMap< Key,Data,HashFunc,EqualFunc >::iterator,bool >
+      RobinHoodHashMap<Key,Data,HashFunc,EqualFunc>::insert( const value_type& the_value )
+      {
+        typedef std::pair< iterator,bool > RPair;
+
+        size_type found = findIndex( the_value.first );
+        if( found != totalSlots() )
+          return RPair( iterator(found,this),false );
+
+        if( numValues + 1 > numSlots - numSlots / 8 ) {
+          grow();
+        }
+
+        while( true ) {
+          // Walk from the home slot, swapping the carried value with any
+          // value that is closer to its own home ("richer") than the
+          // carried one is, until an empty slot turns up.
+          value_type carried( the_value );
+          size_type placed = totalSlots();
+          size_type i = homeSlot( the_value.first );
+          unsigned char d = 1;
+          for( ; i < totalSlots() && d <= maxProbe + 1 ; i++, d++ ) {
+            if( !dist[i] ) {
+              new (&slots[i]) value_type( carried );
+              dist[i] = d;
+              if( placed == totalSlots() )
+                placed = i;
+              numValues++;
+              return RPair( iterator(placed,this),true );
+            }
+            if( dist[i] < d ) {
+              std::swap( carried,slots[i] );
+              std::swap( d,dist[i] );
+              if( placed == totalSlots() )
+                placed = i;
+            }
+          }
+
+          // Ran out of probe length. If the_value already went in,
+          // carried is a value it displaced; grow and reinsert that one.
+          if( placed != totalSlots() ) {
+            grow();
+            insert( carried );
+            return RPair( find(the_value.first),true );
+          }
+          grow();
+        }
+      }
+
+  template< typename Key,
+    typename Data,
+    typename HashFunc,
+    typename EqualFunc >
+      typename RobinHoodHashMap< Key,Data,HashFunc,EqualFunc >::iterator
+      RobinHoodHashMap<Key,Data,HashFunc,EqualFunc>::erase( iterator it )
+      {
+        size_type i = it.index;
+        if( i >= totalSlots() || !dist[i] )
+          return end();
+
+        // Backward-shift deletion: pull every following value that is
+        // not at its home slot one step closer to it.
+        size_type j = i + 1;
+        while( j < totalSlots() && dist[j] > 1 ) {
+          slots[i] = slots[j];
+          dist[i] = dist[j] - 1;
+          i = j;
+          j++;
+        }
+        slots[i].~value_type();
+        dist[i] = 0;
+        numValues--;
+
+        // The value after the erased one is now at it.index, unless
+        // nothing was shifted.
+        return iterator( nextOccupied(it.index),this );
+      }
+
+} // namespace wali
+
+#endif  // wali_ROBIN_HOOD_HASH_MAP_GUARD
+
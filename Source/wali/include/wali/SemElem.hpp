@@ -99,6 +99,22 @@ namespace wali
        */
       virtual bool equal( SemElem * se ) const = 0;
 
+      /**
+       *  @return true if this is the Zero element of the semiring
+       *
+       *  The default implementation compares against zero(). Domains
+       *  that can tell from their own representation (or whose zero()
+       *  allocates) should override it; the saturation procedures ask
+       *  this of nearly every weight they produce.
+       */
+      virtual bool isZero() const;
+
+      /**
+       *  @return true if this is the One element of the semiring
+       *  @see isZero
+       */
+      virtual bool isOne() const;
+
       /**
        *  Determines whether 'this' underapproximates 'that'
        *
@@ -130,6 +146,25 @@ namespace wali
        */
       std::ostream& marshallWeight( std::ostream& o ) const;
 
+      /**
+       *  Writes a binary form of this weight to o that deserialize
+       *  reads back, for saving solved summaries to disk (see
+       *  wpds::fwpds::FwpdsSummaryCache::save). The default
+       *  implementation writes nothing and returns false, meaning
+       *  the domain does not support it.
+       */
+      virtual bool serialize( std::ostream & o ) const;
+
+      /**
+       *  Reads back a weight of this weight's domain from the size
+       *  bytes at data, which serialize wrote. The bytes need not be
+       *  aligned, so that they can be read straight from a mapped
+       *  file.
+       *
+       *  @return NULL if the bytes are not such a weight
+       */
+      virtual sem_elem_t deserialize( char const * data, size_t size ) const;
+
       /**
        *  Perfrom the diff operation
        *   NOTE: This method performs (this - se).  This is very
@@ -188,6 +223,10 @@ namespace wali
        */
       bool equal( sem_elem_t se ) const
       {
+        // Every weight equals itself; interned weights (see
+        // SemElemInterner) that are equal are the same object
+        if( se.get_ptr() == this )
+          return true;
         return equal( se.get_ptr() );
       }
 
@@ -311,7 +350,7 @@ namespace wali
     bool
     operator() (sem_elem_t left, sem_elem_t right) const
     {
-      return left->equal(right);
+      return left.get_ptr() == right.get_ptr() || left->equal(right);
     }
   };
 
@@ -0,0 +1,92 @@
+#ifndef wali_SEM_ELEM_INTERNER_GUARD
+#define wali_SEM_ELEM_INTERNER_GUARD 1
+
+/**
+ * @file SemElemInterner.hpp
+ *
+ * Hash-consing for weights of one domain.
+ */
+
+#include "wali/Common.hpp"
+#include "wali/SemElem.hpp"
+#include "wali/util/unordered_set.hpp"
+
+namespace wali
+{
+  /**
+   * @class SemElemInterner
+   *
+   * Maps every weight to a canonical representative, so that equal
+   * interned weights are the same object. Comparing two interned
+   * weights with SemElem::equal(sem_elem_t) then stops at the pointer
+   * test, and duplicate weights are freed as soon as they are
+   * interned.
+   *
+   * The canonical zero and one are taken from the weight passed to
+   * the constructor, and intern() returns them for any weight that
+   * isZero() or isOne(). Other weights are looked up with hash() and
+   * equal(), so the domain must implement hash() consistently with
+   * equal().
+   *
+   * Interning is opt-in: a client interns the weights it builds (e.g.
+   * rule weights, or the results of extend and combine in its own
+   * domain), or hands the interner to wpds::WPDS::setInterner to have
+   * saturation intern the weights it stores on transitions, and keeps
+   * the interner alive as long as it wants them shared. The interner
+   * is not thread-safe.
+   */
+  class SemElemInterner
+  {
+    public:
+      struct Stats
+      {
+        size_t hits;
+        size_t misses;
+
+        Stats() : hits(0), misses(0) {}
+      };
+
+      explicit SemElemInterner( sem_elem_t some_weight );
+
+      /** @return the canonical weight equal to se */
+      sem_elem_t intern( sem_elem_t se );
+
+      sem_elem_t zero() const {
+        return theZero;
+      }
+
+      sem_elem_t one() const {
+        return theOne;
+      }
+
+      /** @return the number of canonical weights besides zero and one */
+      size_t size() const {
+        return table.size();
+      }
+
+      Stats const & getStats() const {
+        return stats;
+      }
+
+      /**
+       * Forgets every canonical weight but zero and one. Weights
+       * interned before and after the call may then be distinct
+       * objects.
+       */
+      void clear();
+
+    private:
+      typedef util::unordered_set< sem_elem_t, SemElemRefPtrHash, SemElemRefPtrEqual > table_t;
+
+      sem_elem_t theZero;
+      sem_elem_t theOne;
+      table_t table;
+      Stats stats;
+
+      SemElemInterner( SemElemInterner const & );
+      SemElemInterner & operator=( SemElemInterner const & );
+  };
+
+} // namespace wali
+
+#endif  // wali_SEM_ELEM_INTERNER_GUARD
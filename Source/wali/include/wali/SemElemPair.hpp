@@ -25,6 +25,12 @@ namespace wali
       /** @brief return the Zero element of the semiring */
       virtual sem_elem_t zero() const;
 
+      /** @brief Test for Zero without building zero() */
+      virtual bool isZero() const;
+
+      /** @brief Test for One without building one() */
+      virtual bool isOne() const;
+
       /** @brief Perform the extend operation */
       virtual sem_elem_t extend( SemElem * se );
 
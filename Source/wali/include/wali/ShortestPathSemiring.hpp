@@ -22,6 +22,10 @@ namespace wali {
 
     sem_elem_t zero() const;
 
+    bool isZero() const;
+
+    bool isOne() const;
+
     //---------------------------------
     // semiring operations
     //---------------------------------
@@ -40,6 +44,10 @@ namespace wali {
     //------------------------------------
     std::ostream & print(std::ostream &out) const;
 
+    bool serialize(std::ostream &out) const;
+
+    sem_elem_t deserialize(char const * data, size_t size) const;
+
     unsigned int getNum() const;
 
   private:
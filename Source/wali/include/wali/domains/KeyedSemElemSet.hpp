@@ -97,8 +97,8 @@ namespace wali
           sem_elem_t guard = it->first;
           sem_elem_t weight = it->second;
 
-          if (guard->equal(guard->zero())
-              || weight->equal(weight->zero()))
+          if (guard->isZero()
+              || weight->isZero())
           {
             it = m.erase(it);
           }
@@ -172,7 +172,7 @@ namespace wali
           {
             sem_elem_t new_guard = this_guard->first->extend(that_guard->first);
 
-            if (!new_guard->equal(new_guard->zero())) {
+            if (!new_guard->isZero()) {
               sem_elem_t new_weight =
                 this_guard->second->extend(that_guard->second);
 
@@ -0,0 +1,169 @@
+#ifndef WALI_DOMAINS_MEMO_SEM_ELEM_HPP
+#define WALI_DOMAINS_MEMO_SEM_ELEM_HPP
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+
+#include "wali/SemElem.hpp"
+
+namespace wali
+{
+  namespace domains
+  {
+
+    /// A bounded, lossy memo table for extend and combine of one weight
+    /// domain.
+    ///
+    /// The table is direct-mapped: each (operation, left, right) triple
+    /// hashes to one slot, and a new result simply replaces whatever was
+    /// there. Lookups either compare operands by identity (the default,
+    /// which works for any domain) or, with ByValue, by hash() and
+    /// equal(), which also catches equal weights that are distinct
+    /// objects but requires the domain to implement hash().
+    ///
+    /// A slot holds references to its operands and result, so an
+    /// operand address cannot be reused by a different weight while it
+    /// is in the table; memory use is bounded by the number of slots.
+    ///
+    /// The table may be shared by threads (e.g. a WPDS with
+    /// setParallelism); slots are guarded by a set of striped locks, and
+    /// extend/combine of the backing domain run outside of them.
+    class OperationCache
+    {
+    public:
+      enum KeyMode { ByIdentity, ByValue };
+
+      struct Stats
+      {
+        size_t hits;
+        size_t misses;
+        size_t evictions;
+
+        Stats() : hits(0), misses(0), evictions(0) {}
+      };
+
+      /// @param slots is rounded up to a power of two
+      explicit OperationCache(size_t slots = 1 << 14, KeyMode mode = ByIdentity);
+
+      sem_elem_t extend(sem_elem_t left, sem_elem_t right);
+
+      sem_elem_t combine(sem_elem_t left, sem_elem_t right);
+
+      Stats getStats() const;
+
+      /// Drops every cached result (and the statistics)
+      void clear();
+
+      size_t numSlots() const {
+        return slots_.size();
+      }
+
+    private:
+      enum Op { NoOp, ExtendOp, CombineOp };
+
+      struct Slot
+      {
+        Op op;
+        sem_elem_t left;
+        sem_elem_t right;
+        sem_elem_t result;
+
+        Slot() : op(NoOp) {}
+      };
+
+      static const size_t NumStripes = 64;
+
+      sem_elem_t apply(Op op, sem_elem_t left, sem_elem_t right);
+      size_t slotOf(Op op, SemElem * left, SemElem * right) const;
+      bool matches(Slot const & slot, Op op, SemElem * left, SemElem * right) const;
+
+      KeyMode mode_;
+      std::vector<Slot> slots_;
+      mutable std::mutex stripes_[NumStripes];
+
+      std::atomic<size_t> hits_;
+      std::atomic<size_t> misses_;
+      std::atomic<size_t> evictions_;
+
+      OperationCache(OperationCache const &);
+      OperationCache & operator=(OperationCache const &);
+    };
+
+
+    /// Decorates the weights of any domain so that extend and combine go
+    /// through an OperationCache. Wrap every weight given to the library
+    /// (rule weights, query weights) with the same cache; the results
+    /// the library computes then stay wrapped and share it as well.
+    ///
+    /// Everything else is forwarded to the backing weight.
+    class MemoSemElem
+      : public SemElem
+    {
+    public:
+      typedef boost::shared_ptr<OperationCache> cache_t;
+
+      MemoSemElem(sem_elem_t backing, cache_t cache);
+
+      sem_elem_t backingSemElem() const {
+        return backing_elem_;
+      }
+
+      cache_t cache() const {
+        return cache_;
+      }
+
+      sem_elem_t one() const;
+      sem_elem_t zero() const;
+      bool isZero() const;
+      bool isOne() const;
+
+      sem_elem_t extend(SemElem * se);
+      sem_elem_t combine(SemElem * se);
+      bool equal(SemElem * se) const;
+      bool underApproximates(SemElem * se);
+
+      std::ostream & print(std::ostream & o) const;
+      std::ostream & marshall(std::ostream & o) const;
+
+      bool serialize(std::ostream & o) const;
+      sem_elem_t deserialize(char const * data, size_t size) const;
+
+      sem_elem_t diff(SemElem * se);
+      sem_elem_t quasi_one() const;
+      std::pair<sem_elem_t, sem_elem_t> delta(SemElem * se);
+      sem_elem_t star();
+
+      bool containerLessThan(SemElem const * other) const;
+      size_t hash() const;
+      std::ostream & print_typename(std::ostream & os) const;
+
+    private:
+      sem_elem_t wrap(sem_elem_t se) const;
+
+      sem_elem_t backing_elem_;
+      cache_t cache_;
+    };
+
+
+    inline
+    sem_elem_t
+    wrapToMemoSemElem(sem_elem_t se, MemoSemElem::cache_t cache)
+    {
+      return new MemoSemElem(se, cache);
+    }
+
+  }
+}
+
+
+// Yo emacs!
+// Local Variables:
+//     c-file-style: "ellemtel"
+//     c-basic-offset: 2
+//     indent-tabs-mode: nil
+// End:
+
+#endif
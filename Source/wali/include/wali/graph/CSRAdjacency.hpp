@@ -0,0 +1,128 @@
+#ifndef wali_graph_CSR_ADJACENCY_GUARD
+#define wali_graph_CSR_ADJACENCY_GUARD 1
+
+/**
+ * @file CSRAdjacency.hpp
+ *
+ * Compressed-sparse-row adjacency of an edge array.
+ */
+
+#include <vector>
+#include <cassert>
+
+namespace wali
+{
+  namespace graph
+  {
+    /**
+     * @class CSRAdjacency
+     * @brief The outgoing and incoming edges of every node, frozen into
+     * two flat arrays.
+     *
+     * build() takes any vector of edges with int src and tgt members
+     * (IntraGraphEdge) and buckets the edge numbers by source and by
+     * target. The edges of a node are contiguous and in increasing edge
+     * number, i.e. in the order in which they were added, so walking them
+     * visits the same edges in the same order as walking the per-node
+     * lists the graphs used to keep.
+     *
+     * The adjacency does not follow the edges: build it again after
+     * adding some.
+     **/
+    class CSRAdjacency
+    {
+      public:
+        typedef std::vector<int>::const_iterator iterator;
+
+        CSRAdjacency() : nedges(0) {}
+
+        template< typename EdgeVector >
+        CSRAdjacency(int nnodes, EdgeVector const & edges, int nedges)
+        {
+          build(nnodes, edges, nedges);
+        }
+
+        template< typename EdgeVector >
+        void build(int nnodes, EdgeVector const & edges, int m)
+        {
+          nedges = m;
+          bucket(nnodes, edges, m, true, out_start, out_edges);
+          bucket(nnodes, edges, m, false, in_start, in_edges);
+        }
+
+        void clear()
+        {
+          nedges = 0;
+          out_start.clear();
+          out_edges.clear();
+          in_start.clear();
+          in_edges.clear();
+        }
+
+        int num_nodes() const {
+          return out_start.empty() ? 0 : (int)out_start.size() - 1;
+        }
+
+        int num_edges() const {
+          return nedges;
+        }
+
+        iterator out_begin(int v) const {
+          return out_edges.begin() + out_start[v];
+        }
+
+        iterator out_end(int v) const {
+          return out_edges.begin() + out_start[v+1];
+        }
+
+        iterator in_begin(int v) const {
+          return in_edges.begin() + in_start[v];
+        }
+
+        iterator in_end(int v) const {
+          return in_edges.begin() + in_start[v+1];
+        }
+
+        int out_degree(int v) const {
+          return out_start[v+1] - out_start[v];
+        }
+
+        int in_degree(int v) const {
+          return in_start[v+1] - in_start[v];
+        }
+
+      private:
+        // Counting sort of the edge numbers on their source (or target)
+        template< typename EdgeVector >
+        static void bucket(int nnodes, EdgeVector const & edges, int m, bool by_src,
+                           std::vector<int> & start, std::vector<int> & out)
+        {
+          start.assign(nnodes + 1, 0);
+          for(int e = 0; e < m; e++) {
+            int v = by_src ? edges[e].src : edges[e].tgt;
+            assert(v >= 0 && v < nnodes);
+            start[v+1]++;
+          }
+          for(int v = 0; v < nnodes; v++) {
+            start[v+1] += start[v];
+          }
+          out.resize(m);
+          std::vector<int> next(start.begin(), start.end() - 1);
+          for(int e = 0; e < m; e++) {
+            int v = by_src ? edges[e].src : edges[e].tgt;
+            out[next[v]++] = e;
+          }
+        }
+
+        int nedges;
+        std::vector<int> out_start;
+        std::vector<int> out_edges;
+        std::vector<int> in_start;
+        std::vector<int> in_edges;
+    };
+
+  } // namespace graph
+
+} // namespace wali
+
+#endif // wali_graph_CSR_ADJACENCY_GUARD
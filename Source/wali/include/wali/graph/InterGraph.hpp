@@ -6,7 +6,9 @@
 #include "wali/MergeFn.hpp"
 
 #include "wali/graph/GraphCommon.hpp"
+#include "wali/graph/NewtonSolver.hpp"
 
+#include <boost/shared_ptr.hpp>
 
 #include <list>
 #include <vector>
@@ -16,6 +18,10 @@
 
 namespace wali {
 
+    namespace util {
+        class WorkStealingPool;
+    }
+
     namespace graph {
 
         class IntraGraph;
@@ -167,8 +173,8 @@ namespace wali {
                 sem_elem_t weight;
                 IntraGraph *gr;
                 scc_graph_t sccgr;
-                std::list<int> outgoing;
-                std::list<int> incoming;
+                std::vector<int> outgoing;
+                std::vector<int> incoming;
                 std::list<int> out_hyper_edges;
                 std::list<int> out1_hyper_edges;
                 bool visited;
@@ -195,6 +201,7 @@ namespace wali {
             RegExpDag * dag;
 
           private:
+            bool ownsDag;
 
 
             friend class SummaryGraph;
@@ -235,6 +242,17 @@ namespace wali {
             bool running_prestar;
             InterGraphStats stats;
 
+            // @see setThreadPool
+            boost::shared_ptr<util::WorkStealingPool> pool;
+
+            // @see setNewtonSolver
+            boost::shared_ptr<NewtonSolver> newtonSolver;
+            NewtonStats newtonStats;
+
+            // @see saturateInWaves
+            struct DeferredUpdate;
+            struct SCCTask;
+
             static std::ostream &defaultPrintOp(std::ostream &out, int a) {
               out << a;
               return out;
@@ -247,7 +265,12 @@ namespace wali {
             }
 
           public:
-            InterGraph(wali::sem_elem_t s, bool e, bool pre, bool n = false);
+            /**
+             * With a shared dag, the InterGraph puts its regular
+             * expressions there instead of in one of its own; the dag
+             * must outlive it.
+             */
+            InterGraph(wali::sem_elem_t s, bool e, bool pre, bool n = false, RegExpDag * shared = NULL);
             ~InterGraph();
             void addEdge(Transition src, Transition tgt, wali::sem_elem_t se);
             void addEdge(Transition src1, Transition src2, Transition tgt, wali::sem_elem_t se);
@@ -261,6 +284,24 @@ namespace wali {
 
             void setupInterSolution(std::list<Transition> *wt_required = NULL);
 
+            /**
+             * Have setupInterSolution saturate on the threads of p. SCCs
+             * of IntraGraphs that do not depend on each other (those in the
+             * same topological wave of the SCC graph) are then saturated
+             * concurrently; an empty pointer goes back to saturating them
+             * one at a time. The summaries are the same either way.
+             *
+             * The weights' extend, combine and equal, and the merge
+             * functions must be safe to use concurrently. The reference
+             * counts on shared weights and RegExp nodes are only safe in a
+             * build with WALI_ATOMIC_REFCOUNT; without it a pool of more
+             * than one thread is refused and saturation stays sequential.
+             * setupNewtonSolution is always sequential.
+             *
+             * @return false if p was refused
+             */
+            bool setThreadPool(boost::shared_ptr<util::WorkStealingPool> p);
+
             /**
              * @brief From the given TDG (The original InterGraph), create linearized TDGs corresponding
              * to each step of Newton. Then, solve the poststar problem by executing steps of the newton's 
@@ -275,6 +316,20 @@ namespace wali {
              **/
             void setupNewtonSolution();
 
+            /**
+             * Have setupNewtonSolution solve the linear system of each
+             * round with s; an empty pointer goes back to the default,
+             * RegExpNewtonSolver.
+             */
+            void setNewtonSolver(boost::shared_ptr<NewtonSolver> s) {
+              newtonSolver = s;
+            }
+
+            /// What the last setupNewtonSolution did
+            NewtonStats const & getNewtonStats() const {
+              return newtonStats;
+            }
+
             sem_elem_t get_weight(Transition t);
             sem_elem_t get_call_weight(Transition t);
 
@@ -335,6 +390,12 @@ namespace wali {
 
 
             int saturate(std::multiset<tup> &worklist, unsigned scc_n);
+            int saturate(std::multiset<tup> &worklist, unsigned scc_n,
+                InterGraphStats &st, std::vector<DeferredUpdate> *later);
+
+            int saturateInWaves(std::list<IntraGraph *> &gr_sorted, unsigned max_scc);
+            void saturateSCC(std::vector<SCCTask> &tasks, std::list<IntraGraph *> &gr_sorted, size_t i);
+            void applyDeferred(std::vector<DeferredUpdate> &updates);
 
             void setup_worklist(std::list<IntraGraph *> &gr_sorted, 
                 std::list<IntraGraph *>::iterator &gr_it, 
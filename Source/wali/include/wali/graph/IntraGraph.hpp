@@ -6,8 +6,12 @@
 #include "wali/graph/RegExp.hpp"
 #include "wali/graph/Functional.hpp"
 #include "wali/graph/GraphCommon.hpp"
+#include "wali/graph/NewtonSolver.hpp"
+#include "wali/graph/CSRAdjacency.hpp"
+#include "wali/util/unordered_map.hpp"
 
 #include <map>
+#include <algorithm>
 
 namespace wali {
 
@@ -114,15 +118,13 @@ namespace wali {
                 Transition trans;
                 int node_no; // Node number in the IntraGraph node array (-1 if not in the array)
                 node_type type;
-                list<int> outgoing;
-                list<int> incoming;
                 reg_exp_t regexp;
 
                 bool iscutset;
                 int visited;
                 int scc_number;
                 sem_elem_t weight;
-                std::set<int> dependentEdges;
+                std::vector<int> dependentEdges; // sorted
 
                 IntraGraphNode(RegExpDag * d) : dag(d), trans(0,0,0), node_no(-1), type(None), weight(NULL){ } // creates a fake node
                 IntraGraphNode(RegExpDag * d, int nno, node_type ty = None) : dag(d), trans(0,0,0), node_no(nno), type(ty), iscutset(false), visited(0), scc_number(0), weight(NULL) {}
@@ -138,7 +140,9 @@ namespace wali {
                 }
                 void addDependentEdge(int e)
                 {
-                  dependentEdges.insert(e);
+                  std::vector<int>::iterator it = std::lower_bound(dependentEdges.begin(), dependentEdges.end(), e);
+                  if(it == dependentEdges.end() || *it != e)
+                    dependentEdges.insert(it, e);
                 }
                 // This marks the currently held regexp as labelling a node.
                 // Used by RegExpDag to collect the set of regexp nodes that label nodes.
@@ -170,6 +174,8 @@ namespace wali {
         class IntraGraph {
             friend class InterGraph;
             friend class SummaryGraph;
+            friend class RegExpNewtonSolver;
+            friend class IterativeNewtonSolver;
             private:
 
             /**
@@ -178,6 +184,13 @@ namespace wali {
              **/
             bool hasTensoredWeights;
 
+            /**
+             * Are the weights of the nodes the values of their RegExps? A
+             * NewtonSolver that builds no RegExps leaves the solution in
+             * the nodes instead.
+             **/
+            bool regexpWeights;
+
             /**
              * The context in which all regular expressions are to be created.
              * This is usually shared by all IntraGraphs. Allocation/Deallocation is
@@ -191,6 +204,21 @@ namespace wali {
             vector<IntraGraphEdge> edges;
             int nnodes; // Keep these counts because the vectors might be bigger than whats required
             int nedges;
+
+            /**
+             * The edges into and out of every node. Edges are only ever
+             * added, so the adjacency is frozen the first time an algorithm
+             * asks for it after the last edge was added.
+             * @see adjacency
+             **/
+            CSRAdjacency csr;
+
+            /**
+             * (src,tgt) -> the first edge between them, for finding the
+             * edge to merge a new one into.
+             **/
+            typedef util::unordered_map< std::pair<int,int>, int > edge_index_t;
+            edge_index_t edge_index;
             list<int> *out_nodes_intra; // out nodes numbered as in this IntraGraph
             list<int> *out_nodes_inter; // out nodes numbered as in the InterGraph
             //transition_map_t node_number;
@@ -202,7 +230,6 @@ namespace wali {
             list<update_t> updates;
             vector<sem_elem_t> node_weight; // To avoid memory allocation on the critical path
             vector<sem_elem_t> node_pop_weight; // To avoid memory allocation on the critical path
-            sem_elem_t **apsp;
 
             list<int> topsort_list;
             vector<int> cutset_list;
@@ -254,6 +281,7 @@ namespace wali {
             public:
             IntraGraph(RegExpDag * d, bool pre, sem_elem_t _se, SharedMemBuffer * m = NULL) :
               hasTensoredWeights(false),
+              regexpWeights(true),
               dag(d),
               nodes(50, IntraGraphNode(dag)),
               edges(50, IntraGraphEdge(dag)),
@@ -269,7 +297,6 @@ namespace wali {
                 out_nodes_inter = new list<int>;
                 running_prestar = pre;
                 se = _se;
-                apsp = NULL;
             }
 
             ~IntraGraph() {
@@ -277,13 +304,6 @@ namespace wali {
                 delete out_nodes_inter;
                 //It is not my responsibility to delete sharedMem. Whoever constructed it must delete it.
                 //delete sharedMem;
-                if(apsp != NULL) {
-                    int i;
-                    for(i=0;i<nnodes;i++)
-                        delete [] apsp[i];
-                    delete [] apsp;
-                    apsp = NULL;
-                }
             }
             list<int> *getOutTransitions() {
                 return out_nodes_inter;
@@ -330,9 +350,10 @@ namespace wali {
              * Newton saturation.
              * @see setupNewtonSolution.
              * When using Newton's method for poststar, each IntraGraph corresponds to a linearized system of equations.
-             * Solve this system by iterating through Newton rounds.
+             * Solve this system by iterating through Newton rounds, each of which
+             * solver solves; the rounds are added to newtonStats.
              **/
-            void saturate(unsigned& numRounds);
+            void saturate(NewtonSolver & solver, NewtonStats & newtonStats);
 
             sem_elem_t getWeight(int nno) const ;
             string toDot();
@@ -342,12 +363,13 @@ namespace wali {
             void create_node(Transition &t, int n);
             void create_node(int n);
             int edgeno(int s, int t);
+            CSRAdjacency const & adjacency();
             sem_elem_t extend(sem_elem_t w1, sem_elem_t w2);
             void dfs(int v, set<int> &, set<int> &, set<int> &);
-            void topSort(vector<IntraGraphNode> &cnodes, int, vector<IntraGraphEdge> &cedges, int,
+            void topSort(vector<IntraGraphNode> &cnodes, int, vector<IntraGraphEdge> &cedges, int, CSRAdjacency const &adj,
                     list<int> &ts, vector<int> &cs, bool no_outgoing, bool no_updatable);
-            int SCC(vector<IntraGraphNode> &cnodes, int, vector<IntraGraphEdge> &cedges, int);
-            void buildCutsetRegExp(list<int> &ts, vector<int> &cs, vector<IntraGraphNode> &cnodes, int, vector<IntraGraphEdge> &cedges, int);
+            int SCC(vector<IntraGraphNode> &cnodes, int, vector<IntraGraphEdge> &cedges, int, CSRAdjacency const &adj);
+            void buildCutsetRegExp(list<int> &ts, vector<int> &cs, vector<IntraGraphNode> &cnodes, int, vector<IntraGraphEdge> &cedges, int, CSRAdjacency const &adj);
             void compressGraph(list<int> &ts, vector<int> &cs, list<int> &nts, vector<int> &ncs,
                     vector<IntraGraphNode> &cnodes, vector<IntraGraphEdge> &cedges,
                     map<int,int> &orig_to_compress);
@@ -355,8 +377,8 @@ namespace wali {
                     vector<IntraGraphNode> &cnodes, vector<IntraGraphEdge> &cedges,
                     map<int,int> &orig_to_compress);
             void basicRegExp(bool compress_regexp);
-            int *computeDominators(vector<IntraGraphNode> &cnodes, int, vector<IntraGraphEdge> &cedges, int, int *buffer, set<int> *bucket_buffer);
-            void dfsDominators(vector<IntraGraphNode> &cnodes, vector<IntraGraphEdge> &cedges, int v, int *parent, int *semi, int *vertex, int &n);
+            int *computeDominators(vector<IntraGraphNode> &cnodes, int, vector<IntraGraphEdge> &cedges, int, CSRAdjacency const &adj, int *buffer, set<int> *bucket_buffer);
+            void dfsDominators(vector<IntraGraphNode> &cnodes, vector<IntraGraphEdge> &cedges, CSRAdjacency const &adj, int v, int *parent, int *semi, int *vertex, int &n);
             void setupDomRegExp(vector<IntraGraphNode> &cnodes, int, vector<IntraGraphEdge> &cedges, int,
                     int *dom, int *number, int *vertex, int *tree, set<int> *children);
             void numberNodes(int v, int *number, int *vertex, set<int> *children, int &count);
@@ -364,10 +386,10 @@ namespace wali {
                     int h, int *ancestor, vector<PathSequence> &sequence);
             reg_exp_t eval_and_sequence(vector<IntraGraphNode> &cnodes, vector<IntraGraphEdge> &cedges,
                     int e, int *ancestor, vector<PathSequence> &sequence);
-            void domRegExp(vector<IntraGraphNode> &cnodes, int, vector<IntraGraphEdge> &cedges, int, vector<PathSequence> &seq);
+            void domRegExp(vector<IntraGraphNode> &cnodes, int, vector<IntraGraphEdge> &cedges, int, CSRAdjacency const &adj, vector<PathSequence> &seq);
             void buildRegExp(vector<PathSequence> &seq);
-            void computePathSequence(vector<IntraGraphNode> &cnodes, int, vector<IntraGraphEdge> &cedges, int, vector<PathSequence> &sequence, bool use_cutset = false);
-            void computePathSequenceCutset(vector<IntraGraphNode> &cnodes, int, vector<IntraGraphEdge> &cedges, int, vector<PathSequence> &sequence);
+            void computePathSequence(vector<IntraGraphNode> &cnodes, int, vector<IntraGraphEdge> &cedges, int, CSRAdjacency const &adj, vector<PathSequence> &sequence, bool use_cutset = false);
+            void computePathSequenceCutset(vector<IntraGraphNode> &cnodes, int, vector<IntraGraphEdge> &cedges, int, CSRAdjacency const &adj, vector<PathSequence> &sequence);
 
             sem_elem_t popWeight(int nno);
             void calculatePopWeights(int eps_nno);
@@ -0,0 +1,162 @@
+#ifndef wali_graph_NEWTON_SOLVER_GUARD
+#define wali_graph_NEWTON_SOLVER_GUARD 1
+
+/**
+ * @file NewtonSolver.hpp
+ *
+ * Backends that solve the linearized equation systems of Newton's
+ * method for FWPDS.
+ */
+
+#include "wali/SemElem.hpp"
+
+#include <vector>
+#include <list>
+
+namespace wali
+{
+  namespace graph
+  {
+    class IntraGraph;
+
+    /**
+     * @class NewtonStats
+     * @brief What the last setupNewtonSolution did.
+     * @see InterGraph::getNewtonStats
+     **/
+    struct NewtonStats
+    {
+      /// IntraGraphs solved, one per SCC of the call graph
+      unsigned systems;
+      /// Newton rounds over all systems
+      unsigned rounds;
+      /// Most rounds that any one system needed
+      unsigned maxRounds;
+      /// Wall-clock time of every round, in seconds, in the order the
+      /// rounds ran
+      std::vector<double> roundSeconds;
+
+      NewtonStats() : systems(0), rounds(0), maxRounds(0) {}
+
+      void clear() {
+        *this = NewtonStats();
+      }
+
+      double totalSeconds() const;
+    };
+
+    std::ostream & operator << (std::ostream & out, NewtonStats const & s);
+
+    /**
+     * @class NewtonSolver
+     * @brief Solves the linear system of one IntraGraph in each Newton round.
+     * @see IntraGraph::saturate
+     * @see InterGraph::setupNewtonSolution
+     *
+     * IntraGraph::saturate keeps the linearized system for all of its
+     * rounds and drives the backend:
+     *   prepare(g)                  -- once, before the first round
+     *   solve(g)                    -- once per round
+     *   weight(g, n)                -- the solution for node n
+     *   updateCoefficients(g, ...)  -- the mutable edges whose functionals
+     *                                  changed between two rounds
+     *   finish(g)                   -- once, after the last round
+     *
+     * A backend only sees one IntraGraph at a time, so it may keep the
+     * state of the current system in itself.
+     **/
+    class NewtonSolver
+    {
+      public:
+        virtual ~NewtonSolver();
+
+        virtual char const * name() const = 0;
+
+        virtual void prepare(IntraGraph & g) = 0;
+
+        virtual void solve(IntraGraph & g) = 0;
+
+        virtual sem_elem_t weight(IntraGraph & g, int node) = 0;
+
+        /**
+         * @param edges the (updatable) edges whose functionals were
+         * evaluated again
+         * @param weights the new value of each functional, i.e. the new
+         * mutable part of the edge's coefficient
+         **/
+        virtual void updateCoefficients(
+            IntraGraph & g,
+            std::vector<int> const & edges,
+            std::vector<sem_elem_t> const & weights) = 0;
+
+        virtual void finish(IntraGraph & g);
+    };
+
+    /**
+     * @class RegExpNewtonSolver
+     * @brief Path expressions, evaluated again in every round.
+     *
+     * The default backend. Tarjan's path expressions for the graph are
+     * built once; every mutable edge is an updatable RegExp node, so
+     * between rounds RegExpDag::update re-evaluates only the part of
+     * the dag above the changed coefficients. Loops are summarized by
+     * the star of the (tensored) weights.
+     **/
+    class RegExpNewtonSolver : public NewtonSolver
+    {
+      public:
+        char const * name() const;
+        void prepare(IntraGraph & g);
+        void solve(IntraGraph & g);
+        sem_elem_t weight(IntraGraph & g, int node);
+        void updateCoefficients(
+            IntraGraph & g,
+            std::vector<int> const & edges,
+            std::vector<sem_elem_t> const & weights);
+    };
+
+    /**
+     * @class IterativeNewtonSolver
+     * @brief Chaotic (Kleene) iteration over the edges of the graph.
+     *
+     * No path expressions are built: each round propagates weights
+     * along the edges with a worklist until nothing changes. A round
+     * starts from the solution of the previous one, which never
+     * exceeds the solution of the next system, so it only has to
+     * propagate what the changed coefficients add.
+     *
+     * This pays off when star is no cheaper than iterating anyway --
+     * domains of small height such as LongestSaturatingPathSemiring --
+     * or when the graphs are too large for path expressions. It
+     * terminates only on domains without infinite ascending chains.
+     **/
+    class IterativeNewtonSolver : public NewtonSolver
+    {
+      public:
+        char const * name() const;
+        void prepare(IntraGraph & g);
+        void solve(IntraGraph & g);
+        sem_elem_t weight(IntraGraph & g, int node);
+        void updateCoefficients(
+            IntraGraph & g,
+            std::vector<int> const & edges,
+            std::vector<sem_elem_t> const & weights);
+        void finish(IntraGraph & g);
+
+      private:
+        void propagateFrom(IntraGraph & g, int node);
+
+        /// The coefficient of each edge
+        std::vector<sem_elem_t> coefficient;
+        /// The current solution for each node
+        std::vector<sem_elem_t> value;
+        /// Nodes to propagate from
+        std::list<int> worklist;
+        std::vector<bool> onWorklist;
+    };
+
+  } // namespace graph
+
+} // namespace wali
+
+#endif // wali_graph_NEWTON_SOLVER_GUARD
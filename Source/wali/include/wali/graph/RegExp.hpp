@@ -1,6 +1,7 @@
 #ifndef wali_graph__REGEXP_H_
 #define wali_graph__REGEXP_H_
 
+#include <atomic>
 #include <iostream>
 #include <list>
 #include <vector>
@@ -11,6 +12,8 @@
 #include "wali/SemElem.hpp"
 #include "wali/ref_ptr.hpp"
 #include "wali/HashMap.hpp"
+#include "wali/RobinHoodHashMap.hpp"
+#include "wali/util/Arena.hpp"
 
 #include "wali/graph/GraphCommon.hpp"
 
@@ -87,7 +90,10 @@ namespace wali {
 
         struct hash_reg_exp_key {
             size_t operator() (const reg_exp_key_t &k) const {
-                return ((size_t)k.type ^ (size_t)k.c1.get_ptr() ^ (size_t)k.c2.get_ptr());
+                // Not a plain xor: that sends every (t, r, r) to t.
+                size_t h = (size_t)k.c1.get_ptr();
+                h = h * 1000003 ^ (size_t)k.c2.get_ptr();
+                return h * 1000003 ^ (size_t)k.type;
             }
         };
 
@@ -135,6 +141,16 @@ namespace wali {
                 hashmap_misses = 0;
                 height = lnd = out_nodes = 0;
             }
+            void add(const RegExpStats &s) {
+                nstar += s.nstar;
+                nextend += s.nextend;
+                ncombine += s.ncombine;
+                hashmap_hits += s.hashmap_hits;
+                hashmap_misses += s.hashmap_misses;
+                height += s.height;
+                out_nodes += s.out_nodes;
+                lnd += s.lnd;
+            }
         };
 
         ostream &operator << (ostream &out, const RegExpStats &s);
@@ -145,17 +161,126 @@ namespace wali {
 
 
         typedef wali::HashMap<reg_exp_key_t, reg_exp_t, hash_reg_exp_key, reg_exp_key_t> reg_exp_hash_t;
-        typedef wali::HashMap<sem_elem_t, reg_exp_t, hash_sem_elem, sem_elem_equal> const_reg_exp_hash_t;
+
+        // The hash-consing tables only ever do find-then-insert, so they
+        // can use the open-addressing map.
+        typedef wali::RobinHoodHashMap<reg_exp_key_t, reg_exp_t, hash_reg_exp_key, reg_exp_key_t> reg_exp_cons_hash_t;
+        typedef wali::RobinHoodHashMap<sem_elem_t, reg_exp_t, hash_sem_elem, sem_elem_equal> const_reg_exp_hash_t;
 
         class RegExpSatProcess {
           public:
-          unsigned int update_count;
+          // Atomic so that the SCCs of an InterGraph can be saturated
+          // concurrently. @see RegExpDag::evaluatingInParallel
+          std::atomic<unsigned int> update_count;
           RegExpSatProcess() : update_count(1) { }
+          RegExpSatProcess(const RegExpSatProcess &p) : update_count(p.update_count.load()) { }
+          RegExpSatProcess &operator=(const RegExpSatProcess &p) {
+            update_count = p.update_count.load();
+            return *this;
+          }
         };
 
         class RegExpDag;
 
-        class RegExp {
+        /**
+         * The children of a RegExp. Star has one child and the Extend
+         * and Combine nodes that RegExpDag builds have two, so two are
+         * kept inline; only the n-ary nodes made by compress() spill to
+         * the heap.
+         */
+        class RegExpChildren {
+            public:
+                typedef reg_exp_t * iterator;
+                typedef std::reverse_iterator<iterator> reverse_iterator;
+
+                RegExpChildren() : spill(0), n(0), cap(INLINE) {}
+                ~RegExpChildren();
+
+                iterator begin() { return spill ? spill : inl; }
+                iterator end() { return begin() + n; }
+                reverse_iterator rbegin() { return reverse_iterator(end()); }
+                reverse_iterator rend() { return reverse_iterator(begin()); }
+
+                size_t size() const { return n; }
+                reg_exp_t & front() { return *begin(); }
+                reg_exp_t & back() { return *(end() - 1); }
+
+                void push_back(reg_exp_t const & r);
+                void push_front(reg_exp_t const & r);
+                /** Appends [first, last); pos must be end() */
+                void insert(iterator pos, iterator first, iterator last);
+
+            private:
+                static const unsigned INLINE = 2;
+
+                RegExpChildren(RegExpChildren const &);
+                RegExpChildren & operator=(RegExpChildren const &);
+                void reserve(unsigned c);
+
+                reg_exp_t inl[INLINE];
+                reg_exp_t * spill;
+                unsigned n;
+                unsigned cap;
+        };
+
+        /**
+         * The parents of a RegExp, for PUSH_EVAL. Most nodes have one, so
+         * it is kept inline and a set is made for the second.
+         */
+        class RegExpParents {
+            public:
+                typedef wali::util::unordered_set<RegExp*> rest_t;
+
+                RegExpParents() : first(0), rest(0) {}
+                ~RegExpParents() { delete rest; }
+
+                void insert(RegExp * p) {
+                    if(p == first || (rest != 0 && rest->count(p) != 0))
+                        return;
+                    if(first == 0)
+                        first = p;
+                    else {
+                        if(rest == 0)
+                            rest = new rest_t();
+                        rest->insert(p);
+                    }
+                }
+
+                void erase(RegExp * p) {
+                    if(p == first)
+                        first = 0;
+                    else if(rest != 0)
+                        rest->erase(p);
+                }
+
+                RegExp * first;
+                rest_t * rest;
+
+            private:
+                RegExpParents(RegExpParents const &);
+                RegExpParents & operator=(RegExpParents const &);
+        };
+
+        /**
+         * Bookkeeping that few RegExp nodes need, allocated on first use:
+         * the cache of evaluate(w), used by top-down evaluation, and the
+         * out-node sets of minimize_height() and out_node_height().
+         * DWPDS deltas and the PPP_DBG history also live here.
+         */
+        struct RegExpAux {
+            set<long int> outnodes; // set of out-nodes contained in this RegExp
+            out_node_stat_t outnode_height;
+            map<sem_elem_t, sem_elem_t, sem_elem_less> eval_map; // value under certain contexts
+#ifdef DWPDS
+            delta_map_t delta;
+#endif
+#if defined(PPP_DBG) && PPP_DBG >= 0
+            std::vector<unsigned int> updates;
+            std::vector<unsigned int> evaluations;
+#endif
+        };
+
+        class RegExp : public wali::util::ArenaAllocated {
             public:
               friend class RegExpDag; 
             public:
@@ -169,11 +294,8 @@ namespace wali {
                 RegExpDag * dag;
                 reg_exp_type type;
                 sem_elem_t value;
-#ifdef DWPDS
-                delta_map_t delta;
-#endif
                 node_no_t updatable_node_no;
-                list<reg_exp_t> children;
+                RegExpChildren children;
 #if defined(PUSH_EVAL)
                 /*
                    In push based evaluation of the RegExp graph, an updatable regular expression
@@ -185,24 +307,35 @@ namespace wali {
                 /* When set, points to the ancestors in the RegExp dag. */
                 /* Must be a weak pointer because parents have reference to the child */
                 /* I don't know what will happen if I mix boost smart pointers and ref_ptr, so use raw */
-                wali::util::unordered_set<RegExp*> parents;
+                RegExpParents parents;
 #endif
                 unsigned int last_change;
                 unsigned int last_seen;
 
-                set<long int> outnodes; // set of out-nodes contained in this RegExp
-                out_node_stat_t outnode_height;
-                int samechange,differentchange,lastchange;
+                // Held by the thread evaluating this node when the dag is
+                // evaluating in parallel.
+                std::atomic<bool> busy;
 
-                map<sem_elem_t, sem_elem_t, sem_elem_less> eval_map; // value under certain contexts
+                int samechange,differentchange,lastchange;
                 int nevals; // for gathering stats: no of times eval was called on this regexp
 
                 long unsigned int satProcess;
 
                 // For debugging
                 bool uptodate;
-                std::vector<unsigned int> updates;
-                std::vector<unsigned int> evaluations;
+
+                RegExpAux * aux_data;
+
+                RegExpAux & aux() {
+                    if(aux_data == 0)
+                        aux_data = new RegExpAux();
+                    return *aux_data;
+                }
+
+                void clear_eval_map() {
+                    if(aux_data != 0)
+                        aux_data->eval_map.clear();
+                }
 
                 RegExp(long unsigned int currentSatProcess, RegExpDag * d, node_no_t nno, sem_elem_t se) {
                     type = Updatable;
@@ -220,6 +353,8 @@ namespace wali {
                     lastchange=-1;
                     satProcess = currentSatProcess;
                     dag = d;
+                    aux_data = 0;
+                    busy = false;
                 }
                 RegExp(long unsigned int currentSatProcess, RegExpDag * d, reg_exp_type t, reg_exp_t r1, reg_exp_t r2 = 0) {
                     count = 0;
@@ -255,6 +390,8 @@ namespace wali {
                     lastchange=-1;
                     satProcess = currentSatProcess;
                     dag = d;
+                    aux_data = 0;
+                    busy = false;
                 }
                 RegExp(long unsigned int currentSatProcess, RegExpDag * d, sem_elem_t se) {
                     type = Constant;
@@ -272,14 +409,19 @@ namespace wali {
                     lastchange=-1;
                     satProcess = currentSatProcess;
                     dag = d;
+                    aux_data = 0;
+                    busy = false;
                 }
 
             public:
 
                 ~RegExp()
                 {
-                  for(list<reg_exp_t>::iterator it = children.begin(); it != children.end(); ++it)
+#if defined(PUSH_EVAL)
+                  for(RegExpChildren::iterator it = children.begin(); it != children.end(); ++it)
                     (*it)->parents.erase(this);
+#endif
+                  delete aux_data;
                 }
 
                 ostream &print(ostream &out);
@@ -295,11 +437,11 @@ namespace wali {
                 }
 
                 bool isZero() {
-                    return (type == Constant && value->equal(value->zero()));
+                    return (type == Constant && value->isZero());
                 }
 
                 bool isOne() {
-                    return (type == Constant && value->equal(value->one()));
+                    return (type == Constant && value->isOne());
                 }
 
                 bool isCyclic();
@@ -317,6 +459,7 @@ namespace wali {
                 void setDirty();
 #endif
                 void evaluate();
+                void evaluateNode();
                 void evaluate_iteratively();
                 sem_elem_t evaluate(sem_elem_t w);
                 sem_elem_t evaluateRev(sem_elem_t w);
@@ -475,6 +618,8 @@ namespace wali {
 
             ostream &print_stats(ostream & out) {
               out << stats;
+              out << "RegExp nodes : " << nodeArena->numLive() << "\n";
+              out << "RegExp node bytes : " << nodeArena->bytesLive() << "\n";
               return out;
             }
 
@@ -498,6 +643,34 @@ namespace wali {
               return stats;
             }
 
+            /**
+             * While set, RegExp evaluation may happen on several threads at
+             * once, as long as no two threads evaluate nodes that depend on
+             * the same updatable node. Every node is then evaluated under
+             * its own lock, so nodes shared by the threads (those built
+             * only from constants) are memoized safely. No updatable node
+             * may be created while it is set: updatable_nodes and the
+             * node arena are not locked.
+             *
+             * @see InterGraph::setThreadPool
+             */
+            void evaluatingInParallel(bool f) {
+              parallel_eval = f;
+            }
+
+            /**
+             * Sends the evaluation counters of the calling thread to s
+             * instead of to this dag's stats, until called with NULL.
+             * Used while evaluating in parallel.
+             */
+            static void collectThreadStats(RegExpStats * s) {
+              thread_stats = s;
+            }
+
+            void addStats(const RegExpStats &s) {
+              stats.add(s);
+            }
+
           private:
             reg_exp_hash_t visited;
             reg_exp_hash_t spline;
@@ -511,6 +684,7 @@ namespace wali {
             bool executing_poststar;
             bool initialized;
             bool top_down_eval;
+            bool parallel_eval;
 
             vector<reg_exp_t> updatable_nodes;
 
@@ -518,7 +692,7 @@ namespace wali {
             long unsigned int currentSatProcess;
 
             bool extend_backwards;
-            reg_exp_hash_t reg_exp_hash;
+            reg_exp_cons_hash_t reg_exp_hash;
             const_reg_exp_hash_t const_reg_exp_hash;
 #if defined(PPP_DBG) && PPP_DBG >= 0
             // Remember what Regular Experessions are the root of the tree
@@ -537,7 +711,17 @@ namespace wali {
             reg_exp_hash_t graphLabelsAcrossSatProcesses;
 
             RegExpStats stats;
+            static thread_local RegExpStats * thread_stats;
+
+            RegExpStats &eval_stats() {
+              return (thread_stats != NULL) ? *thread_stats : stats;
+            }
+
             reg_exp_t reg_exp_zero, reg_exp_one;
+
+            // Every RegExp of this dag is allocated here. Nodes that
+            // outlive the dag keep the arena alive.
+            wali::util::ArenaHandle nodeArena;
         };
 
     } // namespace graph
@@ -47,22 +47,50 @@ namespace wali {
 
               /**
                * The context in which all regular expression are to be generated.
-               * Grab this from the InterGraph passed in to the constructor.
+               * Grab this from the InterGraph passed in to the constructor,
+               * or, when procedures are added separately, one that all
+               * their InterGraphs share.
                **/              
                 RegExpDag * dag;
-
-                typedef wali::HashMap<int, int> StackGraphMap;
+                bool ownsDag;
+                sem_elem_t sem;
+
+                /// The node of a stack in the InterGraph of its procedure
+                struct Location {
+                    InterGraph * igr;
+                    int nno;
+                    Location(InterGraph * g, int n) : igr(g), nno(n) { }
+                };
+
+                /// Procedures solved together in one InterGraph
+                struct Unit {
+                    InterGraphPtr igr;
+                    std::vector<Key> stacks; // stacks it located
+                    std::vector<Transition> erules; // keys it added to eruleMap
+                };
+
+                // One location per procedure the stack is in
+                typedef wali::HashMap<int, std::vector<Location> > StackGraphMap;
                 typedef std::map<Transition, int, TransitionCmp> TransMap;
 
-                InterGraphPtr post_igr;
                 Key init_state;
 
-                // The set of procedure entry nodes
-                set<Key> procEntries;
+                // The units, by the entries of their procedures
+                std::map< std::set<Key>, Unit > units;
 
                 // IntraGraph to Key for procedure entry of the procedure
                 // represented by the InraGraph
                 std::map<IntraGraph *, Key> procEntryMap;
+
+                // The IntraGraph of each procedure entry
+                std::map<Key, IntraGraph *> procGraph;
+
+                // The IntraGraphs that stand for procedures of other
+                // units, to the entries of those procedures
+                std::map<IntraGraph *, Key> stubEntry;
+
+                // IntraGraph to the InterGraph it is in
+                std::map<IntraGraph *, InterGraph *> graphOwner;
       
                 // Map to cache [k -> MOP(k,\epsilon)]
                 std::map<Key, sem_elem_t> popWeightMap;
@@ -90,7 +118,36 @@ namespace wali {
                              wfa::WFA &Agrow, 
                              InterGraph::PRINT_OP pop = InterGraph::defaultPrintOp);
 
+                /**
+                 * A SummaryGraph without procedures, which addProcedures
+                 * then adds. Their InterGraphs must be built on getDag().
+                 */
+                SummaryGraph(wali::Key ss,
+                             sem_elem_t s,
+                             InterGraph::PRINT_OP pop = InterGraph::defaultPrintOp);
+
                 ~SummaryGraph();
+
+                /// The dag that the InterGraphs given to addProcedures use
+                RegExpDag * getDag() const { return dag; }
+
+                /**
+                 * Adds the procedures with entries pe, solved by a post*
+                 * of Agrow into gr. A procedure they call that is not in
+                 * pe must already have been added; in gr, it is only
+                 * its summary: a pop from its entry.
+                 */
+                void addProcedures(InterGraphPtr gr, set<Key> const & pe, wfa::WFA &Agrow);
+
+                /// Removes the procedures that one addProcedures added
+                void removeProcedures(set<Key> const & pe);
+
+                /**
+                 * MOP(entry, \epsilon) of the procedure with entry e, or
+                 * NULL if it cannot return
+                 */
+                sem_elem_t summary(Key e);
+
                 void preAddUpdate(Transition &t, sem_elem_t se);
                 void getUpdatedTransitions(std::list<WTransition> &ls);
                 void preGetUpdatedTransitions(std::list<WTransition> &ls);
@@ -106,10 +163,13 @@ namespace wali {
                 ostream &printStats(ostream &out);
 
             private:
-                int stk2nodeno(int stk);
-                int trans2nodeno(Transition &tr);
+                Location const * stk2nodeno(int stk);
+                Location const * locate(int stk, IntraGraph *gr);
+                InterGraph * owner(Transition &tr);
                 int getIntraNodeNumber(Transition &tr);
-                void calculatePopWeights();
+                int trans2nodeno(Transition &tr);
+                void calculatePopWeights(InterGraph * igr);
+                void clearVisited();
 
                 void addIntraTrans(Transition &tr, sem_elem_t wt, wfa::WFA &ca_out);
                 void addMiddleTrans(Transition &tr, sem_elem_t wt, wfa::WFA &ca_out);
@@ -17,7 +17,12 @@ namespace wali
   /**
    * @class ref_ptr
    * @brief A reference counting pointer class
-   * @warning This class is *NOT* thread safe.
+   * @warning A ref_ptr is only as thread safe as the count of the object it
+   * points to. With a plain unsigned count (the default for Countable), two
+   * threads must never hold references to the same object. Objects whose
+   * count is an AtomicCount -- AtomicCountable, or every Countable if WALi
+   * is built with WALI_ATOMIC_REFCOUNT -- may be shared freely, though the
+   * ref_ptr objects themselves still must not be written concurrently.
    *
    * The templated class should use the mixin Countable. When using Countable
    * simply pass a boolean true or false to the rcmix constructor.  The default
@@ -28,7 +33,8 @@ namespace wali
    * If you prefer not to inherit from Countable, then the templated class 
    * must have a member variable named count that can be accessed from 
    * ref_ptr and modified by ref_ptr. the count variable should have
-   * operator++(),operator--(), and operator==( int ) defined.  As a 
+   * operator++() and operator--() defined, with operator--() returning
+   * something comparable to 0 that is the decremented count.  As a 
    * note, this class was designed with count being an unsigned integer.
    *
    * Count should be initialized to 0 for proper reference
@@ -126,12 +132,14 @@ namespace wali
       static void release( T * old_ptr )
       {
         if( old_ptr ) {
-          --old_ptr->count;
+          // Decrement and test in one step; with a shared count, reading
+          // it back afterwards could see another thread's decrement too.
+          bool last = (--old_ptr->count == 0);
 #ifdef DBGREFPTR
           std::cout << "Released " << *old_ptr << " with count = "
             << old_ptr->count << std::endl;
 #endif
-          if( old_ptr->count == 0 ) {
+          if( last ) {
 #ifdef DBGREFPTR
             std::cout << "Deleting ptr: " << *old_ptr << std::endl;
 #endif
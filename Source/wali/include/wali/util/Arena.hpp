@@ -0,0 +1,186 @@
+#ifndef wali_util_ARENA_GUARD
+#define wali_util_ARENA_GUARD 1
+
+/**
+ * @file Arena.hpp
+ *
+ * A chunked allocator for the many small objects a saturation creates.
+ */
+
+#include "wali/Common.hpp"
+
+#include <cstddef>
+#include <vector>
+
+namespace wali
+{
+  namespace util
+  {
+    /**
+     * @class Arena
+     *
+     * Hands out memory from 64KB chunks, with a free list per 16-byte
+     * size class so that freed objects are reused. Every block carries a
+     * small header naming the Arena it came from, so objects can be
+     * deleted with plain delete (see ArenaAllocated) no matter who ends
+     * up owning them.
+     *
+     * The owner of an Arena (see ArenaHandle) calls reset() when it has
+     * deleted everything it allocated, which hands all chunks back at
+     * once. An Arena outlives its owner for as long as any object from it
+     * is still alive.
+     *
+     * An Arena is not thread safe. Objects from one Arena must be
+     * allocated and freed by one thread at a time, which is already the
+     * rule for the WFA or WPDS that owns it.
+     */
+    class Arena
+    {
+      public:
+        explicit Arena( size_t chunk_bytes = 64 * 1024 );
+
+        /**
+         * Allocates bytes from arena, or from the heap if arena is NULL.
+         * Either way the result must be freed with deallocate().
+         */
+        static void * allocate( Arena * arena, size_t bytes );
+
+        /** Frees a block returned by allocate() */
+        static void deallocate( void * p );
+
+        /**
+         * Releases every chunk if no object from this Arena is still
+         * alive; otherwise does nothing.
+         */
+        void reset();
+
+        /**
+         * Called by the owner instead of delete. The Arena deletes itself
+         * now, or when its last object is freed.
+         */
+        void detach();
+
+        /** @return number of blocks ever allocated */
+        size_t numAllocations() const {
+          return allocations;
+        }
+
+        /** @return number of blocks not yet freed */
+        size_t numLive() const {
+          return live;
+        }
+
+        /** @return bytes in blocks not yet freed, headers included */
+        size_t bytesLive() const {
+          return liveBytes;
+        }
+
+        /** @return bytes held in chunks */
+        size_t bytesReserved() const {
+          return reserved;
+        }
+
+      private:
+        struct Header
+        {
+          Arena * arena;
+          size_t size;    //!< rounded size, header included
+        };
+
+        struct FreeNode
+        {
+          FreeNode * next;
+        };
+
+        static const size_t ALIGN = 16;
+        static const size_t MAX_BLOCK = 512;
+        static const size_t NUM_CLASSES = MAX_BLOCK / ALIGN + 1;
+
+        ~Arena();
+        Arena( const Arena& );
+        Arena& operator=( const Arena& );
+
+        void * take( size_t size );
+        void give( Header * h );
+        void releaseChunks();
+
+        std::vector< char * > chunks;
+        char * cur;
+        char * end;
+        size_t chunkBytes;
+        FreeNode * freeLists[NUM_CLASSES];
+
+        size_t allocations;
+        size_t live;
+        size_t liveBytes;
+        size_t reserved;
+        bool detached;
+    };
+
+    /**
+     * @class ArenaHandle
+     *
+     * Owns an Arena for a containing object. Copying the container
+     * gives the copy a fresh Arena; the two never share one.
+     */
+    class ArenaHandle
+    {
+      public:
+        ArenaHandle() : arena( new Arena() ) {}
+
+        ArenaHandle( const ArenaHandle& ) : arena( new Arena() ) {}
+
+        ArenaHandle& operator=( const ArenaHandle& ) {
+          return *this;
+        }
+
+        ~ArenaHandle() {
+          arena->detach();
+        }
+
+        Arena * get() const {
+          return arena;
+        }
+
+        Arena * operator->() const {
+          return arena;
+        }
+
+      private:
+        Arena * arena;
+    };
+
+    /**
+     * @class ArenaAllocated
+     *
+     * Base class that routes new and delete through Arena. Plain "new T"
+     * still uses the heap; "new (arena) T" takes the memory from arena.
+     * Either kind is freed with plain delete.
+     */
+    class ArenaAllocated
+    {
+      public:
+        static void * operator new( size_t bytes ) {
+          return Arena::allocate( 0,bytes );
+        }
+
+        static void * operator new( size_t bytes, Arena * arena ) {
+          return Arena::allocate( arena,bytes );
+        }
+
+        static void operator delete( void * p ) {
+          Arena::deallocate( p );
+        }
+
+        /** Used if a constructor throws after new (arena) */
+        static void operator delete( void * p, Arena * ) {
+          Arena::deallocate( p );
+        }
+    };
+
+  } // namespace util
+
+} // namespace wali
+
+#endif  // wali_util_ARENA_GUARD
+
@@ -0,0 +1,62 @@
+#ifndef wali_util_MAPPED_FILE_GUARD
+#define wali_util_MAPPED_FILE_GUARD 1
+
+/**
+ * @file MappedFile.hpp
+ *
+ * Read-only access to the bytes of a file.
+ */
+
+#include "wali/Common.hpp"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace wali
+{
+  namespace util
+  {
+    /**
+     * @class MappedFile
+     *
+     * Maps a file into memory read-only, so that its pages are read
+     * only when touched. Where mmap is not available the whole file is
+     * read instead; either way data() stays valid for the lifetime of
+     * the MappedFile.
+     */
+    class MappedFile
+    {
+      public:
+        explicit MappedFile( std::string const & path );
+        ~MappedFile();
+
+        /** @return false if the file could not be read */
+        bool is_open() const {
+          return ok;
+        }
+
+        char const * data() const {
+          return bytes;
+        }
+
+        size_t size() const {
+          return length;
+        }
+
+      private:
+        bool ok;
+        bool mapped;
+        char const * bytes;
+        size_t length;
+        std::vector< char > copy;
+
+        MappedFile( MappedFile const & );
+        MappedFile & operator=( MappedFile const & );
+    };
+
+  } // namespace util
+
+} // namespace wali
+
+#endif  // wali_util_MAPPED_FILE_GUARD
@@ -0,0 +1,101 @@
+#ifndef wali_util_WORK_STEALING_POOL_GUARD
+#define wali_util_WORK_STEALING_POOL_GUARD 1
+
+/**
+ * @file WorkStealingPool.hpp
+ *
+ * A small fork/join thread pool whose workers steal from each other.
+ */
+
+#include "wali/Common.hpp"
+
+#include <boost/function.hpp>
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace wali
+{
+  namespace util
+  {
+    /**
+     * @class WorkStealingPool
+     *
+     * Runs batches of independent tasks on a fixed set of threads. Each
+     * call to run() hands out the task indices [0, num_tasks) round-robin
+     * to per-worker queues. A worker pops from the back of its own queue,
+     * and once that is empty it steals from the front of the others. The
+     * thread that calls run() acts as worker 0, so a pool of size n starts
+     * n-1 extra threads.
+     *
+     * run() returns only when every task of the batch has finished. If a
+     * task throws, the first exception is rethrown from run() once the
+     * batch has drained.
+     *
+     * The pool itself is not reentrant. Do not call run() from inside a
+     * task, and do not call run() on one pool from two threads at once.
+     */
+    class WorkStealingPool
+    {
+      public:
+        typedef boost::function<void (size_t)> task_t;
+
+        /**
+         * @param num_threads total number of workers, including the
+         * caller of run(). Values smaller than one are treated as one.
+         */
+        explicit WorkStealingPool( size_t num_threads );
+
+        ~WorkStealingPool();
+
+        /** @return the number of workers, including the calling thread */
+        size_t numThreads() const {
+          return queues.size();
+        }
+
+        /**
+         * Invoke task(i) once for each i in [0, num_tasks) and wait for
+         * all of them to finish.
+         */
+        void run( size_t num_tasks, task_t const & task );
+
+      private:
+        struct Queue
+        {
+          std::mutex lock;
+          std::deque<size_t> tasks;
+        };
+
+        void workerLoop( size_t self );
+        void drain( size_t self );
+        bool pop( size_t self, size_t & task );
+        bool steal( size_t self, size_t & task );
+
+        // Copying a pool makes no sense.
+        WorkStealingPool( WorkStealingPool const & );
+        WorkStealingPool & operator=( WorkStealingPool const & );
+
+      private:
+        std::vector<Queue*> queues;       //!< queues[0] belongs to run()'s caller
+        std::vector<std::thread> threads; //!< workers 1..n-1
+
+        std::mutex control;
+        std::condition_variable batchStarted;
+        std::condition_variable batchFinished;
+        task_t const * current;           //!< task of the running batch
+        size_t batch;                     //!< bumped once per run()
+        size_t active;                    //!< helper threads still draining
+        bool stopping;
+        std::exception_ptr failure;       //!< first exception of the batch
+    };
+
+  } // namespace util
+
+} // namespace wali
+
+#endif // wali_util_WORK_STEALING_POOL_GUARD
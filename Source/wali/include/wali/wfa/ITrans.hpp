@@ -14,6 +14,7 @@
 
 #include "wali/TaggedWeight.hpp"
 #include "wali/util/WeightChanger.hpp"
+#include "wali/util/Arena.hpp"
 
 namespace wali
 {
@@ -52,6 +53,10 @@ namespace wali
      *
      * IMarkable is to make a ITrans able to be placed in a Worklist.
      *
+     * Transitions are ArenaAllocated: a WFA creates the ones it owns with
+     * "new (getTransArena()) Trans(...)", and they may be deleted like
+     * any other.
+     *
      * @see Printable
      * @see Markable
      * @see Worklist
@@ -60,7 +65,7 @@ namespace wali
      * @see ref_ptr
      */
 
-    class ITrans : public Printable, public virtual IMarkable
+    class ITrans : public Printable, public virtual IMarkable, public util::ArenaAllocated
     {
       //
       // Types
@@ -7,17 +7,14 @@
 
 #include "wali/Common.hpp"
 #include "wali/Printable.hpp"
+#include "wali/KeyContainer.hpp"
+#include "wali/RobinHoodHashMap.hpp"
 #include "wali/wfa/ITrans.hpp"
 
 #include <boost/function.hpp>
 
-#define IMPL_LIST 0
-
-#if IMPL_LIST
-#   include <list>
-#else
-#   include <set>
-#endif
+#include <cstddef>
+#include <iterator>
 
 
 namespace wali
@@ -26,41 +23,104 @@ namespace wali
   {
     class TransFunctor;
     class ConstTransFunctor;
+    class TransSet;
+
+    /*!
+     * @class TransSetIterator
+     *
+     * Iterator over a TransSet. It is a position in the set's slot
+     * array, so it stays valid across inserts (which may reallocate
+     * the array) and erases (which leave a hole). As with std::set,
+     * iterator and const_iterator are the same type.
+     */
+    class TransSetIterator
+    {
+      public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef ITrans* value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef ITrans* const * pointer;
+        typedef ITrans* const & reference;
+
+        TransSetIterator() : set(0),pos(0) {}
+
+        TransSetIterator( const TransSet * s, size_t p ) : set(s),pos(p) {}
+
+        inline reference operator*() const;
+
+        inline pointer operator->() const;
+
+        inline TransSetIterator& operator++();
+
+        TransSetIterator operator++( int ) {
+          TransSetIterator old = *this;
+          ++(*this);
+          return old;
+        }
+
+        bool operator==( const TransSetIterator& rhs ) const {
+          return pos == rhs.pos;
+        }
+
+        bool operator!=( const TransSetIterator& rhs ) const {
+          return pos != rhs.pos;
+        }
+
+      private:
+        friend class TransSet;
+
+        const TransSet * set;
+        size_t pos;
+    };
 
     /*!
      * @class TransSet
      *
-     * This class basically wraps the std::set implementation
-     * to provide a "wali::Key friendly" interface.
+     * A set of ITrans*, keyed on (from,stack,to).
+     *
+     * The transitions are kept in one array in insertion order, with the
+     * first few stored inline, since most sets hold only 1-4 of them.
+     * Once a set grows past SMALL_SIZE, an index from (from,stack,to) to
+     * position keeps find() constant time.
+     *
+     * Iterators are positions in the array and stay valid as long as the
+     * set does, so a loop may insert into the set it is walking (the new
+     * transitions are visited too) or erase from it. Erasing leaves a
+     * hole. Holes are squeezed out by insert() once they outnumber the
+     * transitions, which does move transitions, so do not insert while
+     * iterating over a set you have erased from.
      */
     class TransSet : public Printable
     {
       public:
-#if IMPL_LIST
-        typedef std::list< ITrans* > impl_t;
-#else
-        typedef std::set< ITrans*,ITransLT > impl_t;
-#endif
-        typedef impl_t::iterator iterator;
-        typedef impl_t::const_iterator const_iterator;
+        typedef TransSetIterator iterator;
+        typedef TransSetIterator const_iterator;
+
+        friend class TransSetIterator;
+
+        /// Transitions stored without a heap allocation
+        static const size_t INLINE_SIZE = 4;
+
+        /// Size above which find() uses an index
+        static const size_t SMALL_SIZE = 8;
 
       public:
-        TransSet() {}
+        TransSet();
 
-        ~TransSet() {}
+        TransSet( const TransSet& other );
+
+        TransSet& operator=( const TransSet& other );
+
+        ~TransSet();
 
       public:
         ITrans* erase( ITrans* t );
 
         ITrans* erase( Key from, Key stack, Key to );
 
-        iterator find( Key from, Key stack, Key to );
-
-        iterator find( ITrans* t );
+        iterator find( Key from, Key stack, Key to ) const;
 
-        const_iterator find( Key from, Key stack, Key to ) const;
-
-        const_iterator find( ITrans* t ) const;
+        iterator find( ITrans* t ) const;
 
         void each( TransFunctor& tf );
 
@@ -74,46 +134,78 @@ namespace wali
 
         std::ostream& print( std::ostream& o ) const;
 
-        void erase( iterator it ) {
-          impl.erase( it );
-        }
+        void erase( iterator it );
 
-        void clear() {
-          impl.clear();
-        }
+        void clear();
 
         bool empty() const {
-          return impl.empty();
+          return live == 0;
         }
 
         void clearAndReleaseResources() {
-          impl_t tmp;
-          tmp.swap(impl);
+          TransSet tmp;
+          swap(tmp);
+        }
+
+        void swap( TransSet& other );
+
+        iterator begin() const {
+          return iterator( this,nextUsed(0) );
         }
 
-        iterator begin() {
-          return impl.begin();
+        iterator end() const {
+          return iterator( this,used );
         }
 
-        iterator end() {
-          return impl.end();
+        size_t size() const;
+
+      protected:
+        typedef RobinHoodHashMap< KeyTriple,size_t > index_t;
+
+        ITrans** slots() {
+          return heap ? heap : inlined;
         }
 
-        const_iterator begin() const {
-          return impl.begin();
+        ITrans* const* slots() const {
+          return heap ? heap : inlined;
         }
 
-        const_iterator end() const {
-          return impl.end();
+        size_t nextUsed( size_t p ) const {
+          ITrans* const* s = slots();
+          while( p < used && s[p] == 0 )
+            p++;
+          return p;
         }
 
-        size_t size() const;
+        size_t findPos( Key from, Key stack, Key to ) const;
+
+        void compact();
+
+        void buildIndex();
 
       protected:
-        impl_t impl;
+        ITrans* inlined[INLINE_SIZE];
+        ITrans** heap;    //!< the slots, once there are more than INLINE_SIZE
+        size_t capacity;  //!< number of slots
+        size_t used;      //!< slots in use, holes included
+        size_t live;      //!< transitions in the set
+        index_t* index;   //!< (from,stack,to) -> slot, once live > SMALL_SIZE
 
     }; // class TransSet
 
+    TransSetIterator::reference TransSetIterator::operator*() const {
+      return set->slots()[pos];
+    }
+
+    TransSetIterator::pointer TransSetIterator::operator->() const {
+      return &set->slots()[pos];
+    }
+
+    TransSetIterator& TransSetIterator::operator++() {
+      pos = set->nextUsed(pos + 1);
+      return *this;
+    }
+
   } // namespace wfa
 
 } // namespace wali
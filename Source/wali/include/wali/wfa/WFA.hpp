@@ -17,6 +17,7 @@
 #include "wali/HashMap.hpp"
 #include "wali/KeyContainer.hpp"
 #include "wali/Progress.hpp"
+#include "wali/util/Arena.hpp"
 #include "wali/domains/SemElemSet.hpp"
 
 // ::wali::wfa
@@ -277,6 +278,19 @@ namespace wali
          */
         void setGeneration(size_t g);
 
+        /**
+         * @return A count of the changes made to the WFA
+         *
+         * Adding, combining into or erasing a transition, erasing a
+         * state, pruning and clearing the WFA all bump it, so two
+         * equal versions mean the transitions were not changed in
+         * between. Weights changed in place through an ITrans are
+         * not seen.
+         */
+        size_t getVersion() const {
+          return version;
+        }
+
         /** @brief Get a weight from the WFA. This is to get hold
          * of the weight domain class
          *
@@ -733,10 +747,13 @@ namespace wali
         std::set< Key > Q;       //! < set of all states
         query_t query;           //! < determine the extend order for path_summary
         size_t generation;       //! < Each WPDS query increments the generation count.
+        size_t version;          //! < Bumped by every change to the transitions
         progress_t progress;     //! < Provides indication of progress to client.
 
         std::set<State*> deleted_states;
 
+        util::ArenaHandle transArena; //! < memory for the trans; released by clear()
+
         PathSummaryImplementation defaultPathSummaryImplementation;
         PathSummaryDirection defaultPathSummaryFwpdsDirection;
 
@@ -904,6 +921,14 @@ namespace wali
         //// Prints to 'os' statistics about this WFA. 
         void printStatistics(std::ostream & os) const;
 
+        /// The Arena that transitions added to this WFA should come from,
+        /// as in "new (wfa.getTransArena()) Trans(...)". Transitions from
+        /// the heap or another WFA's Arena work too, just without the
+        /// locality and the bulk release on clear().
+        util::Arena * getTransArena() const {
+          return transArena.get();
+        }
+
 
         /// "Converts" the automaton to a WPDS.
         ///
@@ -46,12 +46,12 @@ namespace wali
         /*!
          * Test if the Witness has user weight ZERO
          */
-        bool isZero();
+        virtual bool isZero() const;
 
         /*!
          * Test if the Witness has user weight ONE
          */
-        bool isOne();
+        virtual bool isOne() const;
 
         /*!
          * Returns a new Witness whose user_se is a sem_elem_t ONE
@@ -10,6 +10,7 @@
 #include "wali/Common.hpp"
 #include "wali/Printable.hpp"
 #include "wali/KeyContainer.hpp"
+#include "wali/util/Arena.hpp"
 #include "wali/wpds/Rule.hpp"
 
 namespace wali
@@ -32,12 +33,13 @@ namespace wali
      * configuration space.  It only keeps track of the state and top
      * of stack symbol.  All of the wpds::Config's form a graph that
      * is connected forward and back by the list of Rules.
+     * A WPDS allocates its Configs from its own Arena.
      *
      * @see KeyPair
      * @see Rule
      * @see WPDS
      */
-    class Config : public Printable
+    class Config : public Printable, public util::ArenaAllocated
     {
 
       public:
@@ -55,6 +55,17 @@ namespace wali
             sem_elem_t wWithRule //<! delta \extends r->weight()
             );
 
+        /**
+         * poststar_handle_trans does not record dependencies
+         */
+        virtual bool supports_incremental() const;
+
+        /**
+         * The tracing is in the sequential handlers, which the parallel
+         * engine does not call; always saturate sequentially.
+         */
+        virtual bool saturate_in_parallel() const;
+
     }; // class DebugWPDS
 
   } // namespace wpds
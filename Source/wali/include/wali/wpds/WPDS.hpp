@@ -9,9 +9,11 @@
 #include "wali/Common.hpp"
 #include "wali/Printable.hpp"
 #include "wali/HashMap.hpp"
+#include "wali/RobinHoodHashMap.hpp"
 #include "wali/KeyContainer.hpp"
 #include "wali/SemElem.hpp"
 #include "wali/Worklist.hpp"
+#include "wali/util/Arena.hpp"
 
 // ::wali::wfa
 #include "wali/wfa/WFA.hpp"
@@ -20,19 +22,28 @@
 // ::wali::wpds
 #include "wali/wpds/Wrapper.hpp"
 
+#include <boost/shared_ptr.hpp>
+
 // std c++
 #include <iostream>
 #include <set>
+#include <vector>
 
 namespace wali
 {
   template< typename T > class Worklist;
+  class SemElemInterner;
 
   namespace wfa
   {
     class ITrans;
   }
 
+  namespace util
+  {
+    class WorkStealingPool;
+  }
+
   namespace wpds
   {
 
@@ -63,6 +74,38 @@ namespace wali
          */
         typedef HashMap< Key, std::list< rule_t > > r2hash_t;
 
+        /**
+         * Maps the (state, stack) pair on the r.h.s. of a push rule to
+         * the state gen_state created for it in the current query.
+         */
+        typedef RobinHoodHashMap< KeyPair, Key > gen_state_map_t;
+
+        /**
+         * One unit of work for the parallel saturation engine: a
+         * transition popped off the worklist, the delta it carried, and
+         * the weights computed for it. Each entry of contributions is a
+         * rule (or, for poststar epsilon transitions, NULL) together
+         * with the partner transition it was matched with (or NULL) and
+         * the weight that the step will propagate.
+         */
+        struct SaturationStep
+        {
+          struct Contribution
+          {
+            rule_t * rule;
+            wfa::ITrans * partner;
+            sem_elem_t weight;
+
+            Contribution( rule_t * r, wfa::ITrans * p ) : rule(r), partner(p) {}
+          };
+
+          wfa::ITrans * trans;
+          sem_elem_t delta;
+          std::vector< Contribution > contributions;
+
+          SaturationStep( wfa::ITrans * t, sem_elem_t d ) : trans(t), delta(d) {}
+        };
+
       private:
 
       public:
@@ -82,6 +125,65 @@ namespace wali
          */
         void setWorklist( ref_ptr< Worklist<wfa::ITrans> > wl );
 
+        /**
+         * Set the number of threads used to saturate the output automaton
+         * of pre and poststar queries. The default, 1, runs the classic
+         * sequential worklist algorithm.
+         *
+         * With n > 1, saturation proceeds in rounds. Each round drains
+         * the worklist, shards the popped transitions by (from, stack),
+         * computes the weights of their pre/post steps on a pool of n
+         * work-stealing threads, and then applies the resulting updates to
+         * the output WFA in shard order on the calling thread. The
+         * fixpoint is the same as the sequential one. Because every round
+         * drains the whole worklist, a custom worklist only orders work
+         * within a round.
+         *
+         * The weight domain's extend, combine, diff and zero/one must be
+         * safe to call concurrently, and this includes the reference
+         * counts on shared weights. So n > 1 needs a build with
+         * WALI_ATOMIC_REFCOUNT (see Countable); in other builds it is
+         * an error, and one thread is used.
+         *
+         * FWPDS builds its InterGraph with weightless saturation steps, so
+         * that phase always runs sequentially; the InterGraph is then
+         * solved with independent SCCs of procedures saturated
+         * concurrently (see InterGraph::setThreadPool).
+         *
+         * @return false if n threads could not be used
+         */
+        bool setParallelism( unsigned n );
+
+        /**
+         * @return the number of threads used for saturation
+         */
+        unsigned getParallelism() const {
+          return parallelism;
+        }
+
+        /**
+         * Interns the weights that saturation stores on the transitions
+         * of the output WFA: the weight of every new transition, and the
+         * weight of an existing one after a new weight is combined into
+         * it. Equal weights then share one object, and comparing them
+         * stops at the pointer test.
+         *
+         * The interner must hold weights of this WPDS's domain and stay
+         * alive while queries run; NULL, the default, turns interning
+         * off. FWPDS computes its answer weights lazily from the
+         * InterGraph, so only the weights of its saturation phase are
+         * interned.
+         *
+         * @see SemElemInterner
+         */
+        void setInterner( SemElemInterner * i ) {
+          interner = i;
+        }
+
+        SemElemInterner * getInterner() const {
+          return interner;
+        }
+
 
         /** 
          * @brief create rule with no r.h.s. stack symbols
@@ -229,6 +331,113 @@ namespace wali
          */
         virtual void poststar( wfa::WFA const & input, wfa::WFA & output );
 
+        /**
+         * @brief Perform a poststar query for each automaton in inputs
+         * with a single saturation.
+         *
+         * The inputs' states other than PDS states are renamed apart and
+         * the queries saturated as one automaton. Rules and Configs are
+         * looked up once per transition, and the transitions of a called
+         * procedure, which lead to its generated state, are computed
+         * once for all the queries that call it. outputs[i] is the part
+         * of the result that leads to a state of inputs[i], with the
+         * original state names. It matches poststar(*inputs[i]) up to the
+         * names of generated states, except that the quasi weight of a
+         * generated state combines the calls of every query; this only
+         * matters for weight domains whose quasi_one depends on the
+         * weight.
+         *
+         * Any subclass's poststar can run the combined query. FWPDS
+         * overrides this to run the queries one at a time.
+         */
+        virtual void poststarBatch(
+            std::vector< wfa::WFA const * > const & inputs,
+            std::vector< wfa::WFA > & outputs );
+
+        /**
+         * @brief Perform a poststar query that only saturates as far as
+         * the weights of the target configurations require.
+         *
+         * On return, each output transition (p, g, q) with (p, g) in
+         * targets has the weight poststar would give it, while the rest
+         * of the output may be incomplete. A pass over the rules first
+         * finds the (state, stack) pairs whose transitions can contribute
+         * to a target; for a return point this uses a summary of the
+         * states each called procedure can return in. Transitions of any
+         * other pair are dropped as they come off the worklist, and the
+         * query ends when no transition that matters is left.
+         *
+         * FWPDS saturates through its InterGraph and always runs a full
+         * poststar.
+         */
+        void poststarDemand(
+            wfa::WFA const & input,
+            wfa::WFA & output,
+            std::set< KeyPair > const & targets );
+
+        /**
+         * @brief Perform a poststar query that only saturates as far as
+         * the weights of the configurations targets accepts require:
+         * its transitions out of PDS states and, below them, the
+         * transitions out of its other states.
+         *
+         * @see poststarDemand( wfa::WFA const &, wfa::WFA &, std::set< KeyPair > const & )
+         */
+        void poststarDemand(
+            wfa::WFA const & input,
+            wfa::WFA & output,
+            wfa::WFA const & targets );
+
+        /**
+         * @brief Perform a poststar query and keep its answer up to date
+         * as rules are added, replaced or erased.
+         *
+         * The first call, and any call with a different input or output
+         * WFA than the previous one, runs a full poststar and records,
+         * for each output transition, the transitions it contributed to.
+         * A later call with the same input and output, neither modified
+         * in between, only redoes the work the rule changes since the
+         * previous call require; a change to either WFA shows up in
+         * WFA::getVersion() and makes the call run a full poststar.
+         * Weights changed in place through an ITrans of the input are
+         * not detected: call resetIncremental() after doing so. A new rule, or a weight combined into an
+         * existing one, is applied to the transitions it matches and its
+         * effects propagated. A replaced or erased rule first retracts
+         * every transition derived from the ones it matches and then
+         * re-derives them from the transitions that remain.
+         *
+         * Dependencies are recorded only by this method, so poststar()
+         * does not pay for them. EWPDS, FWPDS and DebugWPDS saturate
+         * differently and always run a full poststar.
+         *
+         * @see resetIncremental
+         */
+        virtual void poststarIncremental( wfa::WFA const & input, wfa::WFA & output );
+
+        /**
+         * Forget the state kept by poststarIncremental, so that its
+         * next call runs a full poststar.
+         */
+        void resetIncremental();
+
+        /**
+         * What the last poststarIncremental call did.
+         */
+        struct IncrementalStats
+        {
+          bool full;          //!< ran a full poststar
+          size_t changes;     //!< rule changes applied
+          size_t retracted;   //!< transitions retracted
+          size_t restarted;   //!< transitions saturation restarted from
+          size_t erased;      //!< retracted transitions not re-derived
+
+          IncrementalStats() : full(true), changes(0), retracted(0), restarted(0), erased(0) {}
+        };
+
+        IncrementalStats const & getIncrementalStats() const {
+          return incrementalStats;
+        }
+
         /**
          * This method writes the WPDS to the passed in 
          * std::ostream parameter. Implements Printable::print.
@@ -313,6 +522,15 @@ namespace wali
 
         sem_elem_t get_theZero() {return theZero; }
 
+        /**
+         * @return a count that changes whenever a rule is added,
+         * replaced or erased, so that data derived from the rules can
+         * tell when it is out of date.
+         */
+        size_t getRuleChanges() const {
+          return ruleChanges;
+        }
+
         void printStatistics(std::ostream & os) const;
         
         void toWfa(wfa::WFA & wfa) const;
@@ -366,6 +584,129 @@ namespace wali
          */
         virtual void unlinkOutput( wfa::WFA& fa ) const;
 
+        /**
+         * The (state, stack) pairs a poststarDemand query needs.
+         * Defined in WPDS-demand.cpp.
+         */
+        struct Demand;
+
+        /**
+         * @return true if poststarDemand can skip work. Subclasses that
+         * do not saturate through the worklist return false.
+         */
+        virtual bool supports_demand() const;
+
+        /**
+         * Runs poststarDemand for the configurations with a head in
+         * targets or a stack symbol in below under the head.
+         */
+        void poststar_demand(
+            wfa::WFA const & input,
+            wfa::WFA & output,
+            std::set< KeyPair > const & targets,
+            std::set< Key > const & below );
+
+        /**
+         * Fills d with the pairs whose transitions can contribute to a
+         * configuration poststar_demand asks for.
+         */
+        void demand_closure(
+            wfa::WFA const & input,
+            std::set< KeyPair > const & targets,
+            std::set< Key > const & below,
+            Demand & d );
+
+        /**
+         * @return true if saturating t can change the weight of a
+         * configuration the current poststarDemand query asks for
+         */
+        bool is_demanded( wfa::ITrans * t ) const;
+
+        /**
+         * Points demand at a Demand while it is alive, and restores the
+         * previous value when it goes away, so an exception out of the
+         * saturation does not leave demand dangling.
+         */
+        class DemandScope
+        {
+          public:
+            DemandScope( WPDS & w, Demand * d ) :
+              wpds(w), saved(w.demand)
+            {
+              w.demand = d;
+            }
+
+            ~DemandScope()
+            {
+              wpds.demand = saved;
+            }
+
+          private:
+            WPDS & wpds;
+            Demand * saved;
+        };
+
+        /**
+         * State kept by poststarIncremental between calls.
+         * Defined in WPDS-incremental.cpp.
+         */
+        struct IncrementalState;
+
+        /**
+         * Sets the transitions that the update and update_prime calls
+         * made while it is alive derive from, for poststarIncremental.
+         */
+        class DependencyScope
+        {
+          public:
+            DependencyScope( WPDS & w, wfa::ITrans * a, wfa::ITrans * b = 0 ) :
+              wpds(w), saved0(w.depSources[0]), saved1(w.depSources[1])
+            {
+              w.depSources[0] = a;
+              w.depSources[1] = b;
+            }
+
+            ~DependencyScope()
+            {
+              wpds.depSources[0] = saved0;
+              wpds.depSources[1] = saved1;
+            }
+
+          private:
+            WPDS & wpds;
+            wfa::ITrans * saved0;
+            wfa::ITrans * saved1;
+        };
+
+        /**
+         * @return true if poststarIncremental can update an answer in
+         * place. Subclasses that change how poststar saturates return
+         * false.
+         */
+        virtual bool supports_incremental() const;
+
+        /**
+         * Records that rule r was added, replaced or erased. A monotone
+         * change only adds weight.
+         */
+        void note_rule_change( rule_t const & r, bool monotone );
+
+        /**
+         * Records that t is the copy of an input transition
+         */
+        void note_seed( wfa::ITrans * t );
+
+        /**
+         * Records that t derives from the current depSources
+         */
+        void note_derived( wfa::ITrans * t );
+
+        /**
+         * Applies the rule changes recorded since the last
+         * poststarIncremental call to its output fa.
+         */
+        void poststarIncrementalUpdate( wfa::WFA & fa );
+
         /**
          * @brief Gets WPDS ready for fixpoint
          */
@@ -383,6 +724,8 @@ namespace wali
 
         /**
          * @brief helper method for prestar
+         *
+         * Equivalent to prestar_apply_call of prestar_call_weight.
          */
         virtual void prestar_handle_call(
             wfa::ITrans * t1 ,
@@ -393,6 +736,8 @@ namespace wali
 
         /**
          * @brief helper method for prestar
+         *
+         * Equivalent to prestar_apply_trans of prestar_rule_weight.
          */
         virtual void prestar_handle_trans(
             wfa::ITrans * t,
@@ -400,6 +745,48 @@ namespace wali
             rule_t & r,
             sem_elem_t delta );
 
+        /**
+         * @brief computes the weight prestar_handle_call propagates
+         *
+         * Must not modify the output WFA or the WPDS; the parallel
+         * saturation engine calls it from worker threads.
+         */
+        virtual sem_elem_t prestar_call_weight(
+            wfa::ITrans * t1,
+            wfa::ITrans * t2,
+            rule_t & r,
+            sem_elem_t delta );
+
+        /**
+         * @brief adds the transition created by prestar_handle_call
+         */
+        virtual void prestar_apply_call(
+            wfa::ITrans * t1,
+            wfa::ITrans * t2,
+            rule_t & r,
+            sem_elem_t wnew );
+
+        /**
+         * @brief computes the weight prestar_handle_trans propagates
+         * through rule r
+         *
+         * Must not modify the output WFA or the WPDS; the parallel
+         * saturation engine calls it from worker threads.
+         */
+        virtual sem_elem_t prestar_rule_weight(
+            wfa::ITrans * t,
+            rule_t & r,
+            sem_elem_t delta );
+
+        /**
+         * @brief adds the transitions created by prestar_handle_trans
+         */
+        virtual void prestar_apply_trans(
+            wfa::ITrans * t,
+            wfa::WFA & ca,
+            rule_t & r,
+            sem_elem_t wrule_trans );
+
         /**
          * @brief Gets WPDS ready for fixpoint
          */
@@ -417,6 +804,8 @@ namespace wali
 
         /**
          * @brief helper method for poststar
+         *
+         * Equivalent to poststar_apply_eps_trans of poststar_eps_weight.
          */
         virtual void poststar_handle_eps_trans(
             wfa::ITrans *teps, 
@@ -426,6 +815,8 @@ namespace wali
 
         /**
          * @brief helper method for poststar
+         *
+         * Equivalent to poststar_apply_trans of poststar_rule_weight.
          */
         virtual void poststar_handle_trans(
             wfa::ITrans * t ,
@@ -434,6 +825,86 @@ namespace wali
             sem_elem_t delta
             );
 
+        /**
+         * @brief computes the weight poststar_handle_eps_trans propagates
+         *
+         * Must not modify the output WFA or the WPDS; the parallel
+         * saturation engine calls it from worker threads.
+         */
+        virtual sem_elem_t poststar_eps_weight(
+            wfa::ITrans * teps,
+            wfa::ITrans * tprime,
+            sem_elem_t delta );
+
+        /**
+         * @brief adds the transition created by poststar_handle_eps_trans
+         */
+        virtual void poststar_apply_eps_trans(
+            wfa::ITrans * teps,
+            wfa::ITrans * tprime,
+            sem_elem_t wght );
+
+        /**
+         * @brief computes the weight poststar_handle_trans propagates
+         * through rule r
+         *
+         * Must not modify the output WFA or the WPDS; the parallel
+         * saturation engine calls it from worker threads.
+         */
+        virtual sem_elem_t poststar_rule_weight(
+            wfa::ITrans * t,
+            rule_t & r,
+            sem_elem_t delta );
+
+        /**
+         * @brief adds the transitions created by poststar_handle_trans
+         */
+        virtual void poststar_apply_trans(
+            wfa::ITrans * t,
+            wfa::WFA & ca,
+            rule_t & r,
+            sem_elem_t delta,
+            sem_elem_t wrule_trans );
+
+        /**
+         * @return true if the current query should saturate with the
+         * parallel engine
+         */
+        virtual bool saturate_in_parallel() const;
+
+        /**
+         * @brief Runs the parallel saturation engine until the
+         * worklist is empty
+         *
+         * @see setParallelism
+         */
+        virtual void computeFixpointParallel( wfa::WFA& fa, bool poststar );
+
+        /**
+         * @return the pool of getParallelism() threads, created on
+         * first use
+         */
+        boost::shared_ptr<util::WorkStealingPool> const & threadPool();
+
+        /**
+         * @brief Fills in step.contributions. Called concurrently.
+         */
+        virtual void prepareStep( SaturationStep & step, wfa::WFA& fa, bool poststar );
+
+        /**
+         * @brief Prepares every step of shards[i]. Called concurrently.
+         */
+        void prepareShard(
+            std::vector< std::vector< SaturationStep > > & shards,
+            size_t i,
+            wfa::WFA & fa,
+            bool poststar );
+
+        /**
+         * @brief Applies the contributions of a prepared step
+         */
+        virtual void applyStep( SaturationStep & step, wfa::WFA& fa, bool poststar );
+
         /**
          * @brief create a new temp state from two existing states
          *
@@ -443,6 +914,13 @@ namespace wali
          */
         virtual Key gen_state( Key state, Key stack );
 
+        /**
+         * @return the state gen_state created for (state, stack) during
+         * poststarSetupFixpoint, or WALI_BAD_KEY if there is none. Does
+         * not create new keys.
+         */
+        Key find_gen_state( Key state, Key stack ) const;
+
         /**
          * @brief link input WFA transitions to Configs
          *
@@ -520,6 +998,15 @@ namespace wali
             Key from, Key stack, Key to, 
             sem_elem_t se, Config * cfg );
 
+        /** @return the interned se, or se if there is no interner */
+        sem_elem_t interned( sem_elem_t se ) const;
+
+        /**
+         * Interns the weight of t, which insert combined a new weight
+         * into, keeping its delta
+         */
+        void internCombined( wfa::ITrans * t ) const;
+
         /**
          * update_prime does not need to take a Config b/c no Config
          * will match a transition that is created here. The from state
@@ -598,6 +1085,59 @@ namespace wali
         sem_elem_t theZero; 
         std::set<wali::Key> pds_states; // set of PDS states
 
+        /**
+         * Number of saturation threads.
+         * @see setParallelism
+         */
+        unsigned parallelism;
+
+        /** @see setInterner */
+        SemElemInterner * interner;
+
+        /**
+         * Created on the first parallel query and kept until the
+         * parallelism changes.
+         */
+        boost::shared_ptr<util::WorkStealingPool> pool;
+
+        /**
+         * Generated states of the current poststar query.
+         * @see find_gen_state
+         */
+        gen_state_map_t gen_states;
+
+        /**
+         * Memory for the Configs in configs; released by clear().
+         */
+        util::ArenaHandle configArena;
+
+        /**
+         * Set while poststarIncremental runs, which is when update,
+         * update_prime and operator() record dependencies.
+         */
+        bool recordingDeps;
+
+        /**
+         * The transitions the current step derives from
+         * @see DependencyScope
+         */
+        wfa::ITrans * depSources[2];
+
+        boost::shared_ptr<IncrementalState> incremental;
+
+        /**
+         * The pairs the current poststarDemand query needs; NULL at
+         * all other times.
+         * @see get_from_worklist
+         */
+        Demand * demand;
+        IncrementalStats incrementalStats;
+
+        /**
+         * @see getRuleChanges
+         */
+        size_t ruleChanges;
+
       private:
 
     };
@@ -246,8 +246,10 @@ namespace wali
           
           /**
            * @brief helper method for prestar
+           *
+           * Applies the merge function of r when t1 is an ETrans.
            */
-          virtual void prestar_handle_call(
+          virtual sem_elem_t prestar_call_weight(
               wfa::ITrans *t1,
               wfa::ITrans *t2,
               rule_t &r,
@@ -257,22 +259,56 @@ namespace wali
           /**
            * @brief helper method for prestar
            */
-          virtual void prestar_handle_trans(
+          virtual void prestar_apply_call(
+              wfa::ITrans *t1,
+              wfa::ITrans *t2,
+              rule_t &r,
+              sem_elem_t wNew
+              );
+
+          /**
+           * @brief helper method for prestar
+           */
+          virtual sem_elem_t prestar_rule_weight(
               wfa::ITrans * t,
-              WFA & ca  ,
               rule_t & r,
               sem_elem_t delta );
 
+          /**
+           * @brief helper method for prestar
+           */
+          virtual void prestar_apply_trans(
+              wfa::ITrans * t,
+              WFA & ca  ,
+              rule_t & r,
+              sem_elem_t wrule_trans );
+
           /**
            * @brief helper method for poststar
            */
-          virtual void poststar_handle_trans(
+          virtual sem_elem_t poststar_rule_weight(
               wfa::ITrans * t ,
-              WFA & ca   ,
               rule_t & r,
               sem_elem_t delta
               );
 
+          /**
+           * The merge functions make a retraction non-local, so
+           * poststarIncremental always runs a full poststar.
+           */
+          virtual bool supports_incremental() const;
+
+          /**
+           * @brief helper method for poststar
+           */
+          virtual void poststar_apply_trans(
+              wfa::ITrans * t ,
+              WFA & ca   ,
+              rule_t & r,
+              sem_elem_t delta,
+              sem_elem_t wrule_trans
+              );
+
           virtual void update_etrans(
               Key from
               , Key stack
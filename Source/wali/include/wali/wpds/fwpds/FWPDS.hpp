@@ -25,6 +25,7 @@ namespace wali {
 
   namespace graph {
     class InterGraph;
+    class RegExpDag;
   }
 
   namespace wpds {
@@ -35,6 +36,7 @@ namespace wali {
     namespace fwpds 
     {
 
+      class FwpdsSummaryCache;
 
       class FWPDS : public ewpds::EWPDS 
       {
@@ -45,6 +47,8 @@ namespace wali {
            */
           static const std::string XMLTag;
 
+          friend class FwpdsSummaryCache;
+
         public:
           FWPDS();
           FWPDS(bool newton);
@@ -62,6 +66,14 @@ namespace wali {
           
           // Newton can leave the output automaton with either tensored weights or not.
           bool isOutputTensored();
+
+          /// The backend that solves the linear system of each Newton
+          /// round; an empty pointer (the default) means
+          /// graph::RegExpNewtonSolver. Only used with useNewton(true).
+          void setNewtonSolver(boost::shared_ptr<graph::NewtonSolver> s);
+
+          /// Rounds and timings of the last Newton prestar/poststar
+          graph::NewtonStats const & getNewtonStats() const;
           ////////////
           // add rules
           ////////////
@@ -89,6 +101,16 @@ namespace wali {
 
           void poststarIGR( wfa::WFA const & input, wfa::WFA & output );
 
+          /**
+           * Runs poststar on each input. A combined saturation would
+           * share the generated states, and so the InterGraph, between
+           * the queries, and the lazily computed weights of one query
+           * would then take in paths of the others.
+           */
+          virtual void poststarBatch(
+              std::vector< wfa::WFA const * > const & inputs,
+              std::vector< wfa::WFA > & outputs );
+
           ///////////////////////
           // FWPDS Settings
           //////////////////////
@@ -101,7 +123,21 @@ namespace wali {
            */
           void topDownEval(bool f);
 
+          /** @brief InterGraphs built from now on put their regular
+           * expressions in dag, which must outlive them, instead of in
+           * one of their own. SWPDS solves groups of procedures
+           * separately this way and queries them as one SummaryGraph.
+           */
+          void shareRegExpDag(graph::RegExpDag * dag);
+
         private:
+          /**
+           * The InterGraph is built with weightless saturation steps that
+           * record into interGr, so only the checking phase may run in
+           * parallel.
+           */
+          bool saturate_in_parallel() const;
+
           void prestar_handle_call(
               wfa::ITrans *t1,
               wfa::ITrans *t2,
@@ -150,6 +186,12 @@ namespace wali {
           ///////////
           bool checkResults( wfa::WFA const & input, bool poststar );
 
+          /**
+           * poststar builds an InterGraph instead of draining the
+           * worklist, so poststarDemand runs a full poststar
+           */
+          virtual bool supports_demand() const;
+
 
         protected:
           sem_elem_t wghtOne;
@@ -158,6 +200,17 @@ namespace wali {
           bool checkingPhase;
           bool newton;
           bool topDown;
+          graph::RegExpDag * sharedDag;
+
+          /**
+           * The cache answering the current query; NULL at all other
+           * times.
+           * @see FwpdsSummaryCache
+           */
+          FwpdsSummaryCache * summaries;
+
+          boost::shared_ptr<graph::NewtonSolver> newtonSolver;
+          graph::NewtonStats newtonStats;
 
       }; // class FWPDS
 
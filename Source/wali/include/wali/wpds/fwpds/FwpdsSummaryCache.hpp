@@ -0,0 +1,228 @@
+#ifndef wali_wpds_fwpds_FWPDS_SUMMARY_CACHE_GUARD
+#define wali_wpds_fwpds_FWPDS_SUMMARY_CACHE_GUARD 1
+
+/**
+ * @file FwpdsSummaryCache.hpp
+ *
+ * Procedure summaries of an FWPDS that are computed once and reused
+ * by every pre* or post* query on it.
+ */
+
+#include "wali/Common.hpp"
+#include "wali/HashMap.hpp"
+#include "wali/KeyContainer.hpp"
+#include "wali/wfa/WFA.hpp"
+
+#include <boost/shared_ptr.hpp>
+
+#include <set>
+#include <string>
+#include <vector>
+
+namespace wali {
+
+  namespace wfa {
+    class ITrans;
+  }
+
+  namespace wpds {
+
+    class Rule;
+
+    namespace fwpds {
+
+      class FWPDS;
+
+      /**
+       * @class FwpdsSummaryCache
+       *
+       * Answers prestar and poststar queries on an FWPDS from summaries
+       * that only depend on its rules.
+       *
+       * For poststar, the summaries are the transitions of
+       * poststar({ (p,e,(p,e)) | (p,e) is the target of a push rule })
+       * into the states (p,e), i.e., the same-level paths of every
+       * procedure. A query copies in the summaries of the procedures it
+       * calls the first time it reaches them instead of saturating their
+       * bodies.
+       *
+       * For prestar, the summaries are the transitions of prestar of
+       * the empty automaton, i.e., the pop summaries (p,g,p'). A query
+       * starts from them instead of deriving them again.
+       *
+       * Only the query-specific part of the InterGraph is built and
+       * solved per query; the answers are the same as FWPDS::poststar
+       * and FWPDS::prestar. Summaries are computed on the first query
+       * of each kind and again after the rules of the FWPDS change.
+       *
+       * The FWPDS answers the queries itself when the cache cannot be
+       * used: with a Wrapper, with Newton's method, when checking
+       * results, or (for prestar) when WALi is not strict about
+       * transitions into PDS states.
+       *
+       * The summaries can be saved to a file and loaded by a later
+       * process with the same rules, which then starts without
+       * solving anything (see save and load).
+       */
+      class FwpdsSummaryCache
+      {
+        public:
+          /** How much work the cache saved */
+          struct Stats
+          {
+            size_t builds;      //!< times summaries were computed
+            size_t queries;     //!< queries answered from summaries
+            size_t fallbacks;   //!< queries the FWPDS answered itself
+            size_t reused;      //!< summary transitions copied into answers
+
+            Stats() : builds(0), queries(0), fallbacks(0), reused(0) {}
+          };
+
+        public:
+          /**
+           * The cache keeps a reference to pds, which must outlive it.
+           */
+          explicit FwpdsSummaryCache( FWPDS & pds );
+          ~FwpdsSummaryCache();
+
+          void prestar( wfa::WFA const & input, wfa::WFA & output );
+          wfa::WFA prestar( wfa::WFA const & input );
+
+          void poststar( wfa::WFA const & input, wfa::WFA & output );
+          wfa::WFA poststar( wfa::WFA const & input );
+
+          /** Drops the summaries; the next query computes them again */
+          void clear();
+
+          /**
+           * Computes the summaries if needed and writes them to path.
+           *
+           * The file holds the summary weights as SemElem::serialize
+           * writes them, the keys as the strings or ints they were made
+           * from, and a fingerprint of the rules. Its tables are fixed
+           * size records, so load can map it and decode the summaries of
+           * a procedure only when a query first calls it.
+           *
+           * @return false if the weight domain does not implement
+           * SemElem::serialize, a key of the rules is neither a string
+           * nor an int key, or path could not be written
+           */
+          bool save( std::string const & path );
+
+          /**
+           * Replaces the summaries by those in a file written by save.
+           * Merge functions are compared by what they print.
+           *
+           * @return false, leaving the cache as it was, if path cannot be
+           * read, is not such a file, or was saved for other rules
+           *
+           * Only the layout of the file is checked here. The weights are
+           * read when a query first needs them; if one cannot be, the
+           * summaries are computed again.
+           */
+          bool load( std::string const & path );
+
+          Stats const & getStats() const {
+            return stats;
+          }
+
+          /**
+           * @return true if t, in the answer to the current query, was
+           * copied from the summaries, so its weight is already known
+           */
+          bool reused( wfa::ITrans const & t ) const;
+
+        private:
+          friend class FWPDS;
+
+          typedef std::vector< wfa::ITrans const * > trans_list_t;
+          typedef HashMap< KeyPair, trans_list_t > entry_map_t;
+          typedef HashMap< Key, KeyPair > gen_map_t;
+
+          class QueryScope;
+
+          /** A file given to load. Defined in FwpdsSummaryCache-io.cpp */
+          struct FileIndex;
+
+          bool usable( bool poststar ) const;
+          void buildPoststar();
+          void buildPrestar();
+
+          /**
+           * Called by FWPDS when a poststar query pushes to entry, whose
+           * generated state is gstate. Copies in the summaries of the
+           * procedure and of the ones it calls, unless already there.
+           */
+          void loadPoststar( KeyPair entry, Key gstate );
+
+          /**
+           * Called by FWPDS in place of prestarSetupFixpoint
+           */
+          void setupPrestar( wfa::WFA const & input, wfa::WFA & output );
+
+          /** Inserts a copy of st with the given states into the answer */
+          wfa::ITrans * copyIn( wfa::ITrans const * st, Key from, Key to );
+
+          /**
+           * Decodes the summaries of entry from the loaded file into
+           * postByEntry. If one of their weights cannot be read, the
+           * file is dropped and damaged is set.
+           * @return false if the file has none
+           */
+          bool decodeEntry( KeyPair entry );
+
+          /**
+           * Decodes the pop summaries from the loaded file
+           * @return false if one of their weights cannot be read
+           */
+          bool decodePops();
+
+          /**
+           * @return the push rule with r.h.s. stack first that calls
+           * callee, or NULL. EWPDS allows at most one.
+           */
+          Rule * pushRuleInto( Key stack, KeyPair callee ) const;
+
+          /** Frees the transitions decoded from a file */
+          void releaseDecoded();
+
+          /**
+           * Stops decoding the poststar (or prestar) summaries of the
+           * loaded file, which are being computed again
+           */
+          void forgetFile( bool poststar );
+
+        private:
+          FWPDS & pds;
+          Stats stats;
+
+          bool havePost;
+          size_t postRules;         //!< pds.getRuleChanges() at build
+          wfa::WFA postSummaries;
+          entry_map_t postByEntry;  //!< summaries into each entry's state
+          gen_map_t entryOf;        //!< generated state -> entry
+
+          bool havePre;
+          size_t preRules;
+          wfa::WFA preSummaries;
+          trans_list_t popSummaries;
+
+          boost::shared_ptr< FileIndex > file;
+          std::vector< wfa::ITrans * > decoded;  //!< owned, from file
+
+          // During a query
+          bool inPoststar;
+          std::set< Key > loaded;   //!< states whose summaries were copied in
+          bool damaged;             //!< decodeEntry met a bad weight
+
+          FwpdsSummaryCache( FwpdsSummaryCache const & );
+          FwpdsSummaryCache & operator=( FwpdsSummaryCache const & );
+      };
+
+    } // namespace fwpds
+
+  } // namespace wpds
+
+} // namespace wali
+
+#endif  // wali_wpds_fwpds_FWPDS_SUMMARY_CACHE_GUARD
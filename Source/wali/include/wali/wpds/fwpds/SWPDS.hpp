@@ -2,6 +2,7 @@
 #define wali_wpds_fwpds_SWPDS_GUARD 1
 
 #include <map>
+#include <set>
 #include "wali/Common.hpp"
 
 #include "wali/wpds/RuleFunctor.hpp"
@@ -77,11 +78,86 @@ namespace wali
         void nonSummaryPoststar( wfa::WFA &input, wfa::WFA &output);
 
         void addEntryPoint(Key e);
+
+        /*!
+         * Stops treating e as a procedure entry. It remains one while
+         * some push rule targets it.
+         */
+        void removeEntryPoint(Key e);
+
         void preprocess();
+
+        /*!
+         * Rules and entry points may change after preprocess. Queries
+         * then bring the summaries up to date first; update does it
+         * ahead of time.
+         *
+         * A change whose from-stack is not reachable from any entry
+         * point cannot change any summary and is absorbed without
+         * solving anything. Any other change makes the next update
+         * solve again the procedures the from-stack is in, once for all
+         * changes made since, and then the callers of each procedure
+         * whose summary changed.
+         *
+         * @return true if the summaries were solved again
+         */
+        bool update();
+
+        /*!
+         * Rule and entry point changes since preprocess, and what they
+         * cost.
+         */
+        struct UpdateStats
+        {
+          size_t changes;     //!< changes made after preprocess
+          size_t absorbed;    //!< changes that needed no summaries solved
+          size_t resolves;    //!< times the summaries were solved again
+          size_t procedures;  //!< procedures solved again
+
+          UpdateStats() : changes(0), absorbed(0), resolves(0), procedures(0) {}
+        };
+
+        UpdateStats const & getUpdateStats() const {
+          return updateStats;
+        }
+
         bool reachable(Key k);
         bool multiple_proc(Key k);
 
+        virtual bool erase_rule(
+            Key from_state,
+            Key from_stack,
+            Key to_state,
+            Key to_stack1,
+            Key to_stack2 );
+
       private:
+        /*!
+         * Brings the summaries up to date: solves the procedures that
+         * are new, changed, or call a procedure whose summary changed,
+         * and builds pre_pds.
+         */
+        void solveSummaries();
+
+        /*!
+         * Solves the procedures with the given entries, made of the
+         * given stacks, and adds them to sgr. The procedures they call
+         * from elsewhere must be in sgr already.
+         */
+        FWPDS * solveProcedures(
+            std::set<Key> const & entries,
+            std::set<Key> const & stacks,
+            std::set<Key> const & callees );
+
+        /// Fills pre_pds from the summaries and the push rules
+        void buildPrePds();
+
+        /*!
+         * Records a change to a rule from from_stack; push_target is
+         * the entry a push rule goes to, WALI_EPSILON otherwise.
+         */
+        void noteRuleChange(Key from_stack, Key push_target, bool erased);
+
         virtual bool make_rule(
             Config *f,
             Config *t,
@@ -97,15 +173,29 @@ namespace wali
             Config *t,
             Key stk2,
 
-            rule_t& r ) {
-          return this->FWPDS::make_rule(f, t, stk2, r);
-        }
+            rule_t& r );
 
       private:
         WpdsStackSymbols syms;
+        /// The entry points given to addEntryPoint
+        std::set<Key> userEntries;
         bool preprocessed;
+        /// The summaries do not reflect the rules
+        bool stale;
+        /// Only pre_pds does not reflect the push rules
+        bool prePdsStale;
+        UpdateStats updateStats;
         EWPDS pre_pds;
         graph::SummaryGraph *sgr;
+
+        /// Procedures that call each other, by their entries, and the
+        /// FWPDS that solved them into sgr
+        typedef std::map< std::set<Key>, FWPDS * > unit_map_t;
+        unit_map_t units;
+        /// The entries of the procedures each stack is in
+        std::map< Key, std::set<Key> > procsOf;
+        /// Entries of the procedures changed since they were solved
+        std::set<Key> dirty;
       }; // class SWPDS
 
     } // namespace fwpds
@@ -4,6 +4,7 @@
 
 #include "wali/Common.hpp"
 #include "wali/KeyPairSource.hpp"
+#include "wali/KeySpace.hpp"
 
 namespace wali
 {
@@ -56,6 +57,10 @@ namespace wali
 
   Key KeyPairSource::get_first(Key k)
   {
+    KeySpace::key_pair_t pair;
+    if (getKeySpace()->getKeyPair(k, pair)) {
+        return pair.first;
+    }
     key_src_t ks = getKeySource(k);
     KeyPairSource const * kps = dynamic_cast<KeyPairSource const *>(ks.get_ptr());
     if (kps == NULL) {
@@ -68,6 +73,10 @@ namespace wali
 
   Key KeyPairSource::get_second(Key k)
   {
+    KeySpace::key_pair_t pair;
+    if (getKeySpace()->getKeyPair(k, pair)) {
+        return pair.second;
+    }
     key_src_t ks = getKeySource(k);
     KeyPairSource const * kps = dynamic_cast<KeyPairSource const *>(ks.get_ptr());
     fast_assert(kps != NULL);
@@ -6,6 +6,7 @@
 #include <sstream>
 #include <cassert>
 #include <cstring>
+#include <typeinfo>
 #include "wali/Common.hpp"
 #include "wali/KeySpace.hpp"
 #include "wali/KeySource.hpp"
@@ -18,12 +19,223 @@
 namespace wali
 {
 
-  KeySpace::KeySpace()
+  namespace
   {
+    // Finalizer of splitmix64; spreads every input bit over the result.
+    inline size_t mix( unsigned long long x )
+    {
+      x ^= x >> 30;
+      x *= 0xbf58476d1ce4e5b9ULL;
+      x ^= x >> 27;
+      x *= 0x94d049bb133111ebULL;
+      x ^= x >> 31;
+      return static_cast<size_t>(x);
+    }
+  }
+
+  const Key KeySpace::INVALID;
+  const size_t KeySpace::NUM_SHARDS;
+  const size_t KeySpace::FIRST_CHUNK_SIZE;
+  const size_t KeySpace::MAX_CHUNKS;
+  const size_t KeySpace::ARENA_BLOCK_SIZE;
+
+  KeySpace::KeySpace() : numKeys(0)
+  {
+    for( size_t i = 0 ; i < MAX_CHUNKS ; i++ )
+      values[i].store(0, std::memory_order_relaxed);
   }
 
   KeySpace::~KeySpace()
   {
+    clear();
+    for( size_t i = 0 ; i < MAX_CHUNKS ; i++ )
+      delete[] values[i].load(std::memory_order_relaxed);
+  }
+
+  size_t KeySpace::hashString( const char* s, size_t len )
+  {
+    // FNV-1a
+    unsigned long long h = 14695981039346656037ULL;
+    for( size_t i = 0 ; i < len ; i++ ) {
+      h ^= static_cast<unsigned char>(s[i]);
+      h *= 1099511628211ULL;
+    }
+    return mix(h);
+  }
+
+  size_t KeySpace::hashInt( int i )
+  {
+    return mix(static_cast<unsigned int>(i));
+  }
+
+  size_t KeySpace::hashPair( Key k1, Key k2 )
+  {
+    return mix(k1 * 0x9e3779b97f4a7c15ULL + k2);
+  }
+
+  size_t KeySpace::hashEntry( Entry const & e, Kind kind )
+  {
+    switch( kind ) {
+      case STRING:
+        return hashString(reinterpret_cast<const char*>(e.first), e.second);
+      case INT:
+        return hashInt(static_cast<int>(e.first));
+      case PAIR:
+        return hashPair(e.first, e.second);
+      default:
+        assert(false && "not a compact key");
+        return 0;
+    }
+  }
+
+  void KeySpace::locate( Key key, size_t & chunk, size_t & offset )
+  {
+    // chunk c starts at FIRST_CHUNK_SIZE * (2^c - 1)
+    size_t scaled = key / FIRST_CHUNK_SIZE + 1;
+    chunk = 0;
+    while( scaled > 1 ) {
+      scaled >>= 1;
+      chunk++;
+    }
+    offset = key - FIRST_CHUNK_SIZE * ((size_t(1) << chunk) - 1);
+  }
+
+  KeySpace::Entry * KeySpace::entry( Key key, bool allocate )
+  {
+    size_t chunk, offset;
+    locate(key, chunk, offset);
+    if( chunk >= MAX_CHUNKS )
+      return 0;
+
+    Entry * table = values[chunk].load(std::memory_order_acquire);
+    if( table == 0 && allocate ) {
+      Entry * fresh = new Entry[FIRST_CHUNK_SIZE << chunk];
+      // Keys of one chunk may be created under different shard locks,
+      // so several threads can race to allocate it.
+      if( values[chunk].compare_exchange_strong(table, fresh,
+            std::memory_order_acq_rel, std::memory_order_acquire) )
+        table = fresh;
+      else
+        delete[] fresh;
+    }
+    return (table == 0) ? 0 : &table[offset];
+  }
+
+  KeySpace::Entry * KeySpace::publishedEntry( Key key, Kind & kind )
+  {
+    kind = EMPTY;
+    if( key >= size() )
+      return 0;
+    Entry * e = entry(key, false);
+    if( e == 0 )
+      return 0;
+    kind = static_cast<Kind>(e->kind.load(std::memory_order_acquire));
+    return (kind == EMPTY) ? 0 : e;
+  }
+
+  Key KeySpace::newKey( Entry * & e )
+  {
+    Key key = numKeys.fetch_add(1, std::memory_order_relaxed);
+    e = entry(key, true);
+    assert(e != 0);
+    return key;
+  }
+
+  void KeySpace::growTable( KeyTable & table, Kind kind )
+  {
+    size_t const capacity = table.slots.empty() ? 16 : 2 * table.slots.size();
+    std::vector< Key > old(capacity, INVALID);
+    old.swap(table.slots);
+
+    size_t const mask = capacity - 1;
+    for( size_t i = 0 ; i < old.size() ; i++ ) {
+      if( old[i] == INVALID )
+        continue;
+      size_t pos = (hashEntry(*entry(old[i], false), kind) / NUM_SHARDS) & mask;
+      while( table.slots[pos] != INVALID )
+        pos = (pos + 1) & mask;
+      table.slots[pos] = old[i];
+    }
+  }
+
+  Key KeySpace::internCompact( Shard & shard, KeyTable & table, Kind kind,
+                               size_t hash, size_t first, size_t second )
+  {
+    // Keep the load factor at or below 1/2.
+    if( 2 * (table.used + 1) > table.slots.size() )
+      growTable(table, kind);
+
+    // The low bits picked the shard; use the rest for the slot.
+    size_t const mask = table.slots.size() - 1;
+    size_t pos = (hash / NUM_SHARDS) & mask;
+    for( ; table.slots[pos] != INVALID ; pos = (pos + 1) & mask ) {
+      Entry const & e = *entry(table.slots[pos], false);
+      if( e.second != second )
+        continue;
+      if( kind == STRING ) {
+        if( 0 == memcmp(reinterpret_cast<const char*>(e.first),
+                        reinterpret_cast<const char*>(first), second) )
+          return table.slots[pos];
+      }
+      else if( e.first == first ) {
+        return table.slots[pos];
+      }
+    }
+
+    if( kind == STRING ) {
+      // Copy the bytes into the arena; blocks are never reallocated so
+      // the pointer stays valid for the life of the key.
+      StringArena & arena = shard.arena;
+      char * bytes;
+      if( second > ARENA_BLOCK_SIZE / 4 ) {
+        bytes = new char[second];
+        arena.blocks.insert(arena.blocks.begin(), bytes);
+      }
+      else {
+        if( arena.blocks.empty() || arena.left < second ) {
+          arena.blocks.push_back(new char[ARENA_BLOCK_SIZE]);
+          arena.left = ARENA_BLOCK_SIZE;
+        }
+        bytes = arena.blocks.back() + (ARENA_BLOCK_SIZE - arena.left);
+        arena.left -= second;
+      }
+      memcpy(bytes, reinterpret_cast<const char*>(first), second);
+      first = reinterpret_cast<size_t>(bytes);
+    }
+
+    Entry * e;
+    Key key = newKey(e);
+    e->first = first;
+    e->second = second;
+    e->kind.store(kind, std::memory_order_release);
+
+    table.slots[pos] = key;
+    table.used++;
+    return key;
+  }
+
+  Key KeySpace::internString( const char* s, size_t len )
+  {
+    size_t const hash = hashString(s, len);
+    Shard & shard = shards[hash & (NUM_SHARDS - 1)];
+    std::lock_guard<std::mutex> guard(shard.lock);
+    return internCompact(shard, shard.strings, STRING, hash,
+                         reinterpret_cast<size_t>(s), len);
+  }
+
+  Key KeySpace::internPoly( Shard & shard, key_src_t const & ks )
+  {
+    ks_hash_map_t::iterator it = shard.keymap.find(ks);
+    if( it != shard.keymap.end() )
+      return it->second;
+
+    Entry * e;
+    Key key = newKey(e);
+    shard.keymap.insert(ks,key);
+    // The keymap owns the reference; the table only borrows it.
+    e->source.store(ks.get_ptr(), std::memory_order_relaxed);
+    e->kind.store(POLY, std::memory_order_release);
+    return key;
   }
 
   /**
@@ -39,18 +251,117 @@ namespace wali
    */
   wali_key_t KeySpace::getKey( key_src_t ks )
   {
-    ks_hash_map_t::iterator it = keymap.find(ks);
-    wali_key_t key;
-    if( it != keymap.end() )
-    {
-      key = it->second;
+    // The common sources are stored compactly. Only the exact classes
+    // qualify; a subclass may have its own notion of equality.
+    std::type_info const & type = typeid(*ks);
+    if( type == typeid(StringSource) ) {
+      std::string const s = static_cast<StringSource*>(ks.get_ptr())->getString();
+      return internString(s.data(), s.size());
     }
-    else {
-      key = values.size();
-      keymap.insert(ks,key);
-      values.push_back(ks);
+    if( type == typeid(IntSource) )
+      return getKey( static_cast<IntSource*>(ks.get_ptr())->getInt() );
+    if( type == typeid(KeyPairSource) ) {
+      KeyPairSource * kps = static_cast<KeyPairSource*>(ks.get_ptr());
+      return getKey( kps->first(), kps->second() );
+    }
+
+    Shard & shard = shards[ks->hash() & (NUM_SHARDS - 1)];
+    std::lock_guard<std::mutex> guard(shard.lock);
+    return internPoly(shard, ks);
+  }
+
+  void KeySpace::getKeys( std::vector< key_src_t > const & sources,
+                          std::vector< Key > & keys )
+  {
+    keys.assign(sources.size(), WALI_EPSILON);
+
+    // Bucket the exotic sources by shard so each lock is taken once;
+    // compact ones take their own (allocation-free) path.
+    std::vector< std::vector< size_t > > byShard(NUM_SHARDS);
+    for( size_t i = 0 ; i < sources.size() ; i++ ) {
+      std::type_info const & type = typeid(*sources[i]);
+      if( type == typeid(StringSource) || type == typeid(IntSource)
+          || type == typeid(KeyPairSource) )
+        keys[i] = getKey(sources[i]);
+      else
+        byShard[sources[i]->hash() & (NUM_SHARDS - 1)].push_back(i);
+    }
+
+    for( size_t s = 0 ; s < NUM_SHARDS ; s++ ) {
+      std::vector< size_t > const & members = byShard[s];
+      if( members.empty() )
+        continue;
+      std::lock_guard<std::mutex> guard(shards[s].lock);
+      for( size_t i = 0 ; i < members.size() ; i++ )
+        keys[members[i]] = internPoly(shards[s], sources[members[i]]);
+    }
+  }
+
+  void KeySpace::getKeys( std::vector< std::string > const & strs,
+                          std::vector< Key > & keys )
+  {
+    keys.assign(strs.size(), WALI_EPSILON);
+
+    std::vector< size_t > hashes(strs.size());
+    std::vector< std::vector< size_t > > byShard(NUM_SHARDS);
+    for( size_t i = 0 ; i < strs.size() ; i++ ) {
+      // The empty string is WALI_EPSILON.
+      if( strs[i] == "" )
+        continue;
+      hashes[i] = hashString(strs[i].data(), strs[i].size());
+      byShard[hashes[i] & (NUM_SHARDS - 1)].push_back(i);
+    }
+
+    for( size_t s = 0 ; s < NUM_SHARDS ; s++ ) {
+      std::vector< size_t > const & members = byShard[s];
+      if( members.empty() )
+        continue;
+      Shard & shard = shards[s];
+      std::lock_guard<std::mutex> guard(shard.lock);
+      for( size_t i = 0 ; i < members.size() ; i++ ) {
+        std::string const & str = strs[members[i]];
+        keys[members[i]] = internCompact(shard, shard.strings, STRING,
+            hashes[members[i]], reinterpret_cast<size_t>(str.data()), str.size());
+      }
+    }
+  }
+
+  void KeySpace::getKeys( std::vector< key_pair_t > const & pairs,
+                          std::vector< Key > & keys )
+  {
+    keys.resize(pairs.size());
+
+    std::vector< size_t > hashes(pairs.size());
+    std::vector< std::vector< size_t > > byShard(NUM_SHARDS);
+    for( size_t i = 0 ; i < pairs.size() ; i++ ) {
+      hashes[i] = hashPair(pairs[i].first, pairs[i].second);
+      byShard[hashes[i] & (NUM_SHARDS - 1)].push_back(i);
+    }
+
+    for( size_t s = 0 ; s < NUM_SHARDS ; s++ ) {
+      std::vector< size_t > const & members = byShard[s];
+      if( members.empty() )
+        continue;
+      Shard & shard = shards[s];
+      std::lock_guard<std::mutex> guard(shard.lock);
+      for( size_t i = 0 ; i < members.size() ; i++ ) {
+        key_pair_t const & kp = pairs[members[i]];
+        keys[members[i]] = internCompact(shard, shard.pairs, PAIR,
+            hashes[members[i]], kp.first, kp.second);
+      }
+    }
+  }
+
+  void KeySpace::reserve( size_t n )
+  {
+    for( Key k = 0 ; k < n ; ) {
+      size_t chunk, offset;
+      locate(k, chunk, offset);
+      if( entry(k, true) == 0 )
+        break;
+      // skip to the start of the next chunk
+      k += (FIRST_CHUNK_SIZE << chunk) - offset;
     }
-    return key;
   }
 
   /**
@@ -59,7 +370,7 @@ namespace wali
    */
   Key KeySpace::getKey( const std::string& s )
   {
-    return (s == "") ? WALI_EPSILON : getKey( new StringSource(s) );
+    return (s == "") ? WALI_EPSILON : internString( s.data(), s.size() );
   }
 
   /**
@@ -69,7 +380,7 @@ namespace wali
   Key KeySpace::getKey( const char* s )
   {
     return ((s == NULL) || (strlen(s) == 0)) ?
-      WALI_EPSILON : getKey( new StringSource(s) );
+      WALI_EPSILON : internString( s, strlen(s) );
   }
 
   /**
@@ -78,12 +389,17 @@ namespace wali
    */
   Key KeySpace::getKey( int i )
   {
-    return getKey( new IntSource(i) );
+    size_t const hash = hashInt(i);
+    Shard & shard = shards[hash & (NUM_SHARDS - 1)];
+    std::lock_guard<std::mutex> guard(shard.lock);
+    // Store the int's bits; hashEntry and printEntry cast them back.
+    return internCompact(shard, shard.ints, INT, hash,
+                         static_cast<unsigned int>(i), 0);
   }
 
   Key KeySpace::getKey( const llvm::Value *v )
   {
-    return getKey( new LLVMValueSource(v) );
+    return getKey( key_src_t(new LLVMValueSource(v)) );
   }
 
   /**
@@ -92,13 +408,16 @@ namespace wali
    */
   Key KeySpace::getKey( Key k1, Key k2 )
   {
-    return getKey( new KeyPairSource(k1,k2) );
+    size_t const hash = hashPair(k1, k2);
+    Shard & shard = shards[hash & (NUM_SHARDS - 1)];
+    std::lock_guard<std::mutex> guard(shard.lock);
+    return internCompact(shard, shard.pairs, PAIR, hash, k1, k2);
   }
 
   // @author Amanda Burton
   wali_key_t KeySpace::getKey( std::set<wali_key_t> kys )
   {
-    return getKey( new KeySetSource(kys) );
+    return getKey( key_src_t(new KeySetSource(kys)) );
   }
 
 
@@ -115,12 +434,52 @@ namespace wali
    */
   key_src_t KeySpace::getKeySource( Key key )
   {
-    key_src_t ksrc = 0;
-    if( key < size() )
-    {
-      ksrc = values[key];
+    Kind kind;
+    Entry * e = publishedEntry(key, kind);
+    if( e == 0 )
+      return 0;
+
+    KeySource * src = e->source.load(std::memory_order_acquire);
+    if( src != 0 )
+      return src;
+
+    // A compact key: build its KeySource once and keep it.
+    key_src_t fresh;
+    switch( kind ) {
+      case STRING:
+        fresh = new StringSource(std::string(
+              reinterpret_cast<const char*>(e->first), e->second));
+        break;
+      case INT:
+        fresh = new IntSource(static_cast<int>(static_cast<unsigned int>(e->first)));
+        break;
+      case PAIR:
+        fresh = new KeyPairSource(e->first, e->second);
+        break;
+      default:
+        assert(false && "POLY entry without a source");
+        return 0;
+    }
+
+    if( e->source.compare_exchange_strong(src, fresh.get_ptr(),
+          std::memory_order_acq_rel, std::memory_order_acquire) ) {
+      std::lock_guard<std::mutex> guard(materializedLock);
+      materialized.push_back(fresh);
+      return fresh;
     }
-    return ksrc;
+    // Another thread won the race; use its copy.
+    return src;
+  }
+
+  bool KeySpace::getKeyPair( Key key, key_pair_t & kp )
+  {
+    Kind kind;
+    Entry * e = publishedEntry(key, kind);
+    if( e == 0 || kind != PAIR )
+      return false;
+    kp.first = e->first;
+    kp.second = e->second;
+    return true;
   }
 
   /**
@@ -129,13 +488,32 @@ namespace wali
    */
   void KeySpace::clear()
   {
-    keymap.clear();
+    size_t const n = size();
+    for( Key k = 0 ; k < n ; k++ ) {
+      Entry * e = entry(k, false);
+      if( e != 0 ) {
+        e->kind.store(EMPTY, std::memory_order_relaxed);
+        e->source.store(0, std::memory_order_relaxed);
+        e->first = e->second = 0;
+      }
+    }
+    numKeys.store(0);
+    for( size_t i = 0 ; i < NUM_SHARDS ; i++ ) {
+      Shard & shard = shards[i];
+      shard.keymap.clear();
+      shard.strings = KeyTable();
+      shard.ints = KeyTable();
+      shard.pairs = KeyTable();
+      for( size_t b = 0 ; b < shard.arena.blocks.size() ; b++ )
+        delete[] shard.arena.blocks[b];
+      shard.arena = StringArena();
+      assert( shard.keymap.size() == 0 );
+    }
     {
-      ks_vector_t TEMP;
-      TEMP.swap(values);
+      std::vector< key_src_t > TEMP;
+      TEMP.swap(materialized);
     }
-    assert( keymap.size() == 0 );
-    assert( values.size() == 0 );
+    assert( size() == 0 );
   }
 
   /**
@@ -143,7 +521,30 @@ namespace wali
    */
   size_t KeySpace::size()
   {
-    return values.size();
+    return numKeys.load(std::memory_order_acquire);
+  }
+
+  void KeySpace::printEntry( std::ostream& o, Entry const & e, Kind kind )
+  {
+    switch( kind ) {
+      case STRING:
+        o.write(reinterpret_cast<const char*>(e.first), e.second);
+        break;
+      case INT:
+        o << static_cast<int>(static_cast<unsigned int>(e.first));
+        break;
+      case PAIR:
+        // same as KeyPairSource::print
+        o << "(";
+        printKey(o, e.first);
+        o << ",";
+        printKey(o, e.second);
+        o << ")";
+        break;
+      default:
+        e.source.load(std::memory_order_acquire)->print(o);
+        break;
+    }
   }
 
   /**
@@ -153,10 +554,11 @@ namespace wali
    */
   std::ostream& KeySpace::printKey( std::ostream& o, Key key, bool abbreviate )
   {
-    key_src_t ksrc = getKeySource(key);
-    if( ksrc.is_valid() ) {
+    Kind kind;
+    Entry * e = publishedEntry(key, kind);
+    if( e != 0 ) {
       std::stringstream str;
-      ksrc->print(str);
+      printEntry(str, *e, kind);
 
       if(str.str().length() > 20 && abbreviate) {
         o << "[" << key << "]";
@@ -180,13 +582,16 @@ namespace wali
    */
   std::string KeySpace::key2str( Key key )
   {
-    key_src_t ksrc = getKeySource(key);
-    if( ksrc.is_valid() ) {
-      return ksrc->toString();
-    }
-    else {
+    Kind kind;
+    Entry * e = publishedEntry(key, kind);
+    if( e == 0 )
       return "??";
-    }
+    if( kind == STRING )
+      return std::string(reinterpret_cast<const char*>(e->first), e->second);
+
+    std::stringstream str;
+    printEntry(str, *e, kind);
+    return str.str();
   }
 
 } // namespace wali
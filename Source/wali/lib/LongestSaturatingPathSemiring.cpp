@@ -1,5 +1,8 @@
 #include "wali/LongestSaturatingPathSemiring.hpp"
 
+#include <cstring>
+#include <ostream>
+
 namespace wali {
 
   namespace {
@@ -38,6 +41,17 @@ namespace wali {
   }
 
 
+  bool LongestSaturatingPathSemiring::isZero() const
+  {
+    return v == (unsigned int)(-1);
+  }
+
+  bool LongestSaturatingPathSemiring::isOne() const
+  {
+    return v == 0;
+  }
+
+
   unsigned int LongestSaturatingPathSemiring::getNum() const
   {
     return v;
@@ -101,4 +115,21 @@ namespace wali {
     return out;
   }
 
+  bool LongestSaturatingPathSemiring::serialize(std::ostream &out) const
+  {
+    out.write(reinterpret_cast<char const *>(&v), sizeof(v));
+    out.write(reinterpret_cast<char const *>(&biggest), sizeof(biggest));
+    return true;
+  }
+
+  sem_elem_t LongestSaturatingPathSemiring::deserialize(char const * data, size_t size) const
+  {
+    unsigned int d, big;
+    if(size != sizeof(d) + sizeof(big))
+      return NULL;
+    std::memcpy(&d, data, sizeof(d));
+    std::memcpy(&big, data + sizeof(d), sizeof(big));
+    return new LongestSaturatingPathSemiring(d, big);
+  }
+
 }
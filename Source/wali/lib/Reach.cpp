@@ -33,6 +33,16 @@ sem_elem_t Reach::zero() const
   return Z;
 }
 
+bool Reach::isZero() const
+{
+  return !isreached;
+}
+
+bool Reach::isOne() const
+{
+  return isreached;
+}
+
 // zero is the annihilator for extend
 sem_elem_t Reach::extend( SemElem* se )
 {
@@ -68,4 +78,17 @@ sem_elem_t Reach::from_string( const std::string& s ) const {
   return (s == "ONE") ? one() : zero();
 }
 
+bool Reach::serialize( std::ostream & o ) const
+{
+  o.put(isreached ? 1 : 0);
+  return true;
+}
+
+sem_elem_t Reach::deserialize( char const * data, size_t size ) const
+{
+  if (size != 1 || (data[0] != 0 && data[0] != 1))
+    return NULL;
+  return (data[0] == 1) ? one() : zero();
+}
+
 }
@@ -30,6 +30,31 @@ namespace wali
     return o;
   }
 
+  bool SemElem::serialize( std::ostream& o ATTR_UNUSED ) const
+  {
+    (void) o;
+    return false;
+  }
+
+  sem_elem_t SemElem::deserialize( char const * data ATTR_UNUSED, size_t size ATTR_UNUSED ) const
+  {
+    (void) data;
+    (void) size;
+    return NULL;
+  }
+
+  bool SemElem::isZero() const
+  {
+    sem_elem_t z = zero();
+    return z.get_ptr() == this || equal(z.get_ptr());
+  }
+
+  bool SemElem::isOne() const
+  {
+    sem_elem_t o = one();
+    return o.get_ptr() == this || equal(o.get_ptr());
+  }
+
   bool
   SemElem::underApproximates(SemElem * that)
   {
@@ -0,0 +1,40 @@
+/**
+ * @file SemElemInterner.cpp
+ */
+
+#include "wali/SemElemInterner.hpp"
+
+namespace wali
+{
+  SemElemInterner::SemElemInterner( sem_elem_t some_weight ) :
+    theZero(some_weight->zero()),
+    theOne(some_weight->one())
+  {
+  }
+
+  sem_elem_t SemElemInterner::intern( sem_elem_t se )
+  {
+    if( se->isZero() ) {
+      stats.hits++;
+      return theZero;
+    }
+    if( se->isOne() ) {
+      stats.hits++;
+      return theOne;
+    }
+
+    std::pair< table_t::iterator, bool > ins = table.insert(se);
+    if( ins.second )
+      stats.misses++;
+    else
+      stats.hits++;
+    return *ins.first;
+  }
+
+  void SemElemInterner::clear()
+  {
+    table.clear();
+    stats = Stats();
+  }
+
+} // namespace wali
@@ -27,6 +27,16 @@ namespace wali
     return new SemElemPair( first->zero(),second->zero() );
   }
 
+  bool SemElemPair::isZero() const
+  {
+    return first->isZero() && second->isZero();
+  }
+
+  bool SemElemPair::isOne() const
+  {
+    return first->isOne() && second->isOne();
+  }
+
   // Perform the extend operation
   sem_elem_t SemElemPair::extend( SemElem * se )
   {
@@ -1,5 +1,8 @@
 #include "wali/ShortestPathSemiring.hpp"
 
+#include <cstring>
+#include <ostream>
+
 namespace wali {
 
   namespace {
@@ -29,6 +32,17 @@ namespace wali {
   }
 
 
+  bool ShortestPathSemiring::isZero() const
+  {
+    return v == (unsigned int)(-1);
+  }
+
+  bool ShortestPathSemiring::isOne() const
+  {
+    return v == 0;
+  }
+
+
   unsigned int ShortestPathSemiring::getNum() const
   {
     return v;
@@ -88,4 +102,19 @@ namespace wali {
     return out;
   }
 
+  bool ShortestPathSemiring::serialize(std::ostream &out) const
+  {
+    out.write(reinterpret_cast<char const *>(&v), sizeof(v));
+    return true;
+  }
+
+  sem_elem_t ShortestPathSemiring::deserialize(char const * data, size_t size) const
+  {
+    unsigned int d;
+    if(size != sizeof(d))
+      return NULL;
+    std::memcpy(&d, data, sizeof(d));
+    return new ShortestPathSemiring(d);
+  }
+
 }
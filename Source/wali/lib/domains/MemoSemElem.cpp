@@ -0,0 +1,328 @@
+#include "wali/domains/MemoSemElem.hpp"
+
+#include <cassert>
+
+namespace wali
+{
+  namespace domains
+  {
+    namespace
+    {
+      size_t
+      mix(size_t h)
+      {
+        // Pointers and small hashes have poor low bits
+        h ^= h >> 33;
+        h *= static_cast<size_t>(0xff51afd7ed558ccdULL);
+        h ^= h >> 33;
+        return h;
+      }
+
+      MemoSemElem *
+      asMemo(SemElem * se)
+      {
+        MemoSemElem * that = dynamic_cast<MemoSemElem*>(se);
+        assert(that);
+        return that;
+      }
+    }
+
+
+    ////////////////////
+    // OperationCache
+    ////////////////////
+
+    OperationCache::OperationCache(size_t slots, KeyMode mode)
+      : mode_(mode)
+      , hits_(0)
+      , misses_(0)
+      , evictions_(0)
+    {
+      size_t n = NumStripes;
+      while (n < slots) {
+        n <<= 1;
+      }
+      slots_.resize(n);
+    }
+
+
+    sem_elem_t
+    OperationCache::extend(sem_elem_t left, sem_elem_t right)
+    {
+      return apply(ExtendOp, left, right);
+    }
+
+
+    sem_elem_t
+    OperationCache::combine(sem_elem_t left, sem_elem_t right)
+    {
+      return apply(CombineOp, left, right);
+    }
+
+
+    size_t
+    OperationCache::slotOf(Op op, SemElem * left, SemElem * right) const
+    {
+      size_t l, r;
+      if (mode_ == ByValue) {
+        l = left->hash();
+        r = right->hash();
+      }
+      else {
+        l = reinterpret_cast<size_t>(left);
+        r = reinterpret_cast<size_t>(right);
+      }
+      return mix(l * 31 + mix(r) + op) & (slots_.size() - 1);
+    }
+
+
+    bool
+    OperationCache::matches(Slot const & slot, Op op, SemElem * left, SemElem * right) const
+    {
+      if (slot.op != op) {
+        return false;
+      }
+      if (mode_ == ByValue) {
+        return slot.left->equal(left) && slot.right->equal(right);
+      }
+      return slot.left.get_ptr() == left && slot.right.get_ptr() == right;
+    }
+
+
+    sem_elem_t
+    OperationCache::apply(Op op, sem_elem_t left, sem_elem_t right)
+    {
+      size_t index = slotOf(op, left.get_ptr(), right.get_ptr());
+      // Slots that share a stripe are spread across the table
+      std::mutex & stripe = stripes_[index % NumStripes];
+      Slot & slot = slots_[index];
+
+      {
+        std::lock_guard<std::mutex> guard(stripe);
+        if (matches(slot, op, left.get_ptr(), right.get_ptr())) {
+          hits_++;
+          return slot.result;
+        }
+      }
+      misses_++;
+
+      sem_elem_t result = (op == ExtendOp) ? left->extend(right) : left->combine(right);
+
+      // The evicted weights are released after the lock is dropped
+      Slot old;
+      {
+        std::lock_guard<std::mutex> guard(stripe);
+        old = slot;
+        slot.op = op;
+        slot.left = left;
+        slot.right = right;
+        slot.result = result;
+      }
+      if (old.op != NoOp) {
+        evictions_++;
+      }
+      return result;
+    }
+
+
+    OperationCache::Stats
+    OperationCache::getStats() const
+    {
+      Stats stats;
+      stats.hits = hits_;
+      stats.misses = misses_;
+      stats.evictions = evictions_;
+      return stats;
+    }
+
+
+    void
+    OperationCache::clear()
+    {
+      for (size_t i = 0; i < slots_.size(); ++i) {
+        Slot old;
+        {
+          std::lock_guard<std::mutex> guard(stripes_[i % NumStripes]);
+          std::swap(old, slots_[i]);
+        }
+      }
+      hits_ = 0;
+      misses_ = 0;
+      evictions_ = 0;
+    }
+
+
+    ////////////////////
+    // MemoSemElem
+    ////////////////////
+
+    MemoSemElem::MemoSemElem(sem_elem_t backing, cache_t cache)
+      : backing_elem_(backing)
+      , cache_(cache)
+    {
+      assert(backing_elem_.is_valid());
+      assert(cache_);
+    }
+
+
+    sem_elem_t
+    MemoSemElem::wrap(sem_elem_t se) const
+    {
+      if (!se.is_valid()) {
+        return se;
+      }
+      return new MemoSemElem(se, cache_);
+    }
+
+
+    sem_elem_t
+    MemoSemElem::one() const
+    {
+      return wrap(backing_elem_->one());
+    }
+
+
+    sem_elem_t
+    MemoSemElem::zero() const
+    {
+      return wrap(backing_elem_->zero());
+    }
+
+
+    bool
+    MemoSemElem::isZero() const
+    {
+      return backing_elem_->isZero();
+    }
+
+
+    bool
+    MemoSemElem::isOne() const
+    {
+      return backing_elem_->isOne();
+    }
+
+
+    sem_elem_t
+    MemoSemElem::extend(SemElem * se)
+    {
+      MemoSemElem * that = asMemo(se);
+      return wrap(cache_->extend(backing_elem_, that->backing_elem_));
+    }
+
+
+    sem_elem_t
+    MemoSemElem::combine(SemElem * se)
+    {
+      MemoSemElem * that = asMemo(se);
+      return wrap(cache_->combine(backing_elem_, that->backing_elem_));
+    }
+
+
+    bool
+    MemoSemElem::equal(SemElem * se) const
+    {
+      MemoSemElem * that = asMemo(se);
+      return backing_elem_->equal(that->backing_elem_);
+    }
+
+
+    bool
+    MemoSemElem::underApproximates(SemElem * se)
+    {
+      MemoSemElem * that = asMemo(se);
+      return backing_elem_->underApproximates(that->backing_elem_);
+    }
+
+
+    std::ostream &
+    MemoSemElem::print(std::ostream & o) const
+    {
+      return backing_elem_->print(o);
+    }
+
+
+    std::ostream &
+    MemoSemElem::marshall(std::ostream & o) const
+    {
+      return backing_elem_->marshall(o);
+    }
+
+
+    bool
+    MemoSemElem::serialize(std::ostream & o) const
+    {
+      return backing_elem_->serialize(o);
+    }
+
+
+    sem_elem_t
+    MemoSemElem::deserialize(char const * data, size_t size) const
+    {
+      return wrap(backing_elem_->deserialize(data, size));
+    }
+
+
+    sem_elem_t
+    MemoSemElem::diff(SemElem * se)
+    {
+      MemoSemElem * that = asMemo(se);
+      return wrap(backing_elem_->diff(that->backing_elem_));
+    }
+
+
+    sem_elem_t
+    MemoSemElem::quasi_one() const
+    {
+      return wrap(backing_elem_->quasi_one());
+    }
+
+
+    std::pair<sem_elem_t, sem_elem_t>
+    MemoSemElem::delta(SemElem * se)
+    {
+      MemoSemElem * that = asMemo(se);
+      std::pair<sem_elem_t, sem_elem_t> ans = backing_elem_->delta(that->backing_elem_);
+      return std::make_pair(wrap(ans.first), wrap(ans.second));
+    }
+
+
+    sem_elem_t
+    MemoSemElem::star()
+    {
+      return wrap(backing_elem_->star());
+    }
+
+
+    bool
+    MemoSemElem::containerLessThan(SemElem const * other) const
+    {
+      MemoSemElem const * that = dynamic_cast<MemoSemElem const *>(other);
+      assert(that);
+      return backing_elem_->containerLessThan(that->backing_elem_);
+    }
+
+
+    size_t
+    MemoSemElem::hash() const
+    {
+      return backing_elem_->hash();
+    }
+
+
+    std::ostream &
+    MemoSemElem::print_typename(std::ostream & os) const
+    {
+      return backing_elem_->print_typename(os << "MemoSemElem[") << "]";
+    }
+
+  }
+}
+
+
+// Yo emacs!
+// Local Variables:
+//     c-file-style: "ellemtel"
+//     c-basic-offset: 2
+//     indent-tabs-mode: nil
+// End:
@@ -147,7 +147,7 @@ namespace
                              sem_elem_t add_this,
                              bool include_zeroes)
   {
-    if (!include_zeroes && add_this->equal(add_this->zero())) {
+    if (!include_zeroes && add_this->isZero()) {
       return;
     }
     
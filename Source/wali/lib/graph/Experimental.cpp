@@ -1,3 +1,41 @@
+namespace {
+  // The weights from a few source nodes (the rows) to every node.
+  // Only the entries that were set are stored; all others are zero.
+  class SparseWeightRows {
+    public:
+      SparseWeightRows(int n, sem_elem_t z) : row_of(n, -1), zero(z) {}
+
+      void addRow(int v) {
+        if(row_of[v] == -1) {
+          row_of[v] = (int)rows.size();
+          rows.push_back(row_t());
+        }
+      }
+
+      sem_elem_t get(int u, int v) const {
+        assert(row_of[u] != -1);
+        row_t const &r = rows[row_of[u]];
+        row_t::const_iterator it = r.find(v);
+        return (it == r.end()) ? zero : it->second;
+      }
+
+      void set(int u, int v, sem_elem_t w) {
+        assert(row_of[u] != -1);
+        rows[row_of[u]][v] = w;
+      }
+
+      void combine(int u, int v, sem_elem_t w) {
+        set(u, v, get(u, v)->combine(w));
+      }
+
+    private:
+      typedef std::map<int, sem_elem_t> row_t;
+      std::vector<int> row_of;
+      std::vector<row_t> rows;
+      sem_elem_t zero;
+  };
+}
+
 
 void IntraGraph::compressGraphAggressive(list<int> &ts, vector<int> &cs,
                                          list<int> &nts, vector<int> &ncs,
@@ -47,15 +85,10 @@ void IntraGraph::compressGraphAggressive(list<int> &ts, vector<int> &cs,
   map<int,int>::iterator cit;
   set<int>::iterator cn_it;
 
-  sem_elem_t **temp = new sem_elem_t *[n];
-  for(i=0;i<n;i++) {
-    temp[i] = new sem_elem_t[n];
-  }
+  // Only paths that start at a node of cnodes_id are needed
+  SparseWeightRows temp(n, se->zero());
   for(cn_it = cnodes_id.begin(); cn_it != cnodes_id.end(); cn_it++) {
-    v = *cn_it;
-    for(j=0;j<n;j++) {
-      temp[v][j] = se->zero();
-    }
+    temp.addRow(*cn_it);
   }
 
   // Solve for (_,_) where first node made it to cnodes_id
@@ -67,7 +100,7 @@ void IntraGraph::compressGraphAggressive(list<int> &ts, vector<int> &cs,
     while(*beg != v) {
       beg++;
     }
-    temp[v][v] = se->one();
+    temp.set(v,v,se->one());
     beg++;
     while(beg != end) {
       u = *beg;
@@ -75,15 +108,15 @@ void IntraGraph::compressGraphAggressive(list<int> &ts, vector<int> &cs,
         beg++;
         continue;
       }
-      list<int>::iterator beg2 = nodes[u].incoming.begin();
-      list<int>::iterator end2 = nodes[u].incoming.end();
+      CSRAdjacency::iterator beg2 = adjacency().in_begin(u);
+      CSRAdjacency::iterator end2 = adjacency().in_end(u);
       while(beg2 != end2) {
         w = edges[*beg2].src;
         if(edges[*beg2].updatable) {
           beg2++;
           continue;
         }
-        temp[v][u] = temp[v][u]->combine(extend(temp[v][w],edges[*beg2].weight));
+        temp.combine(v,u,extend(temp.get(v,w),edges[*beg2].weight));
         STAT(stats.ncombine++);
         beg2++;
       }
@@ -97,8 +130,8 @@ void IntraGraph::compressGraphAggressive(list<int> &ts, vector<int> &cs,
     set<int>::iterator cn_it2;
     for(cn_it2 = cnodes_id.begin(); cn_it2 != cnodes_id.end(); cn_it2++) {
       v = *cn_it2;
-      list<int>::iterator beg = nodes[v].incoming.begin();
-      list<int>::iterator end = nodes[v].incoming.end();
+      CSRAdjacency::iterator beg = adjacency().in_begin(v);
+      CSRAdjacency::iterator end = adjacency().in_end(v);
       while(beg != end) {
         if(edges[*beg].updatable) {
           beg++;
@@ -106,9 +139,9 @@ void IntraGraph::compressGraphAggressive(list<int> &ts, vector<int> &cs,
         }
         w = edges[*beg].src;
         if(cnodes_id.find(w) == cnodes_id.end()) {
-          temp[u][v] = temp[u][v]->combine(extend(temp[u][w],edges[*beg].weight));
+          temp.combine(u,v,extend(temp.get(u,w),edges[*beg].weight));
         } else {
-          temp[w][v] = temp[w][v]->combine(edges[*beg].weight);
+          temp.combine(w,v,edges[*beg].weight);
         }
         STAT(stats.ncombine++);
         beg++;
@@ -123,7 +156,7 @@ void IntraGraph::compressGraphAggressive(list<int> &ts, vector<int> &cs,
       ci = cs[i];
       for(j=0;j<m;j++) {
         cj = cs[j];
-        temp[ci][cj] = temp[ci][cj]->combine(extend(temp[ci][ck], extend(temp[ck][ck]->star(), temp[ck][cj])));
+        temp.combine(ci,cj,extend(temp.get(ci,ck), extend(temp.get(ck,ck)->star(), temp.get(ck,cj))));
         STAT(stats.ncombine++);
         STAT(stats.nstar++);
       }
@@ -136,7 +169,7 @@ void IntraGraph::compressGraphAggressive(list<int> &ts, vector<int> &cs,
       ci = cs[i];
       for(j=0;j<m;j++) {
         cj = cs[j];
-        temp[u][ci] = temp[u][ci]->combine(extend(temp[u][cj],temp[cj][ci]));
+        temp.combine(u,ci,extend(temp.get(u,cj),temp.get(cj,ci)));
         STAT(stats.ncombine++);
       }
     }
@@ -144,8 +177,6 @@ void IntraGraph::compressGraphAggressive(list<int> &ts, vector<int> &cs,
 
   // fill up cedges
   for(i=0;i<(int)cnodes.size();i++) {
-    cnodes[i].outgoing.clear();
-    cnodes[i].incoming.clear();
     cnodes[i].visited = 0;
     cnodes[i].iscutset = false;
   }
@@ -154,19 +185,16 @@ void IntraGraph::compressGraphAggressive(list<int> &ts, vector<int> &cs,
     u = nodeno(cnodes[i]);
     for(j=0;j<(int)cnodes.size();j++) {
       v = nodeno(cnodes[j]);
-      IntraGraphEdge ed(dag, i,j,temp[u][v],false);
+      IntraGraphEdge ed(dag, i,j,temp.get(u,v),false);
       for(k=0;k<m;k++) {
         w = cs[k];
-        ed.weight = ed.weight->combine(extend(temp[u][w],temp[w][v]));
+        ed.weight = ed.weight->combine(extend(temp.get(u,w),temp.get(w,v)));
         STAT(stats.ncombine++);
       }
-      if(!ed.weight->equal(se->zero()) && !(i==j && ed.weight->equal(se->one()))) {
+      if(!ed.weight->isZero() && !(i==j && ed.weight->isOne())) {
         //ed.weight->print(cout << i << "," << j << ":") << "\n";
         ed.regexp = dag->constant(ed.weight);
         cedges.push_back(ed);
-        int e = cedges.size() - 1;
-        cnodes[i].outgoing.push_back(e);
-        cnodes[j].incoming.push_back(e);
       }
     }
   }
@@ -176,19 +204,11 @@ void IntraGraph::compressGraphAggressive(list<int> &ts, vector<int> &cs,
     ed.src = orig_to_compress[ed.src];
     ed.tgt = orig_to_compress[ed.tgt];
     cedges.push_back(ed);
-    int e = cedges.size() - 1;
-    cnodes[ed.src].outgoing.push_back(e);
-    cnodes[ed.tgt].incoming.push_back(e);
   }
   // build new topsort and cutset lists
-  topSort(cnodes,cnodes.size(),cedges,cedges.size(),nts,ncs,false,false);
+  topSort(cnodes,cnodes.size(),cedges,cedges.size(),
+          CSRAdjacency(cnodes.size(),cedges,cedges.size()),nts,ncs,false,false);
 
-  // delete stuff
-    
-  for(i = 0; i < n; i++) {
-    delete [] temp[i];
-  }
-  delete [] temp;
 }
 
 void IntraGraph::compressGraph(list<int> &ts, vector<int> &cs,
@@ -236,15 +256,10 @@ void IntraGraph::compressGraph(list<int> &ts, vector<int> &cs,
 
   map<int,int>::iterator cit;
 
-  sem_elem_t **temp = new sem_elem_t *[n];
-  for(i=0;i<n;i++) {
-    temp[i] = new sem_elem_t[n];
-  }
+  // Only paths that start at a compressed node are needed
+  SparseWeightRows temp(n, se->zero());
   for(cit = orig_to_compress.begin(); cit != orig_to_compress.end(); cit++) {
-    v = cit->first;
-    for(j=0;j<n;j++) {
-      temp[v][j] = se->zero();
-    }
+    temp.addRow(cit->first);
   }
 
   // Solve for (_,_) where first node made it to cnodes
@@ -255,7 +270,7 @@ void IntraGraph::compressGraph(list<int> &ts, vector<int> &cs,
     while(*beg != v) {
       beg++;
     }
-    temp[v][v] = se->one();
+    temp.set(v,v,se->one());
     beg++;
     while(beg != end) {
       u = *beg;
@@ -263,15 +278,15 @@ void IntraGraph::compressGraph(list<int> &ts, vector<int> &cs,
         beg++;
         continue;
       }
-      list<int>::iterator beg2 = nodes[u].incoming.begin();
-      list<int>::iterator end2 = nodes[u].incoming.end();
+      CSRAdjacency::iterator beg2 = adjacency().in_begin(u);
+      CSRAdjacency::iterator end2 = adjacency().in_end(u);
       while(beg2 != end2) {
         w = edges[*beg2].src;
         if(edges[*beg2].updatable) {
           beg2++;
           continue;
         }
-        temp[v][u] = temp[v][u]->combine(extend(temp[v][w],edges[*beg2].weight));
+        temp.combine(v,u,extend(temp.get(v,w),edges[*beg2].weight));
         STAT(stats.ncombine++);
         beg2++;
       }
@@ -284,8 +299,8 @@ void IntraGraph::compressGraph(list<int> &ts, vector<int> &cs,
     u = cit->first;
     for(i=0;i<m;i++) {
       v = cs[i];
-      list<int>::iterator beg = nodes[v].incoming.begin();
-      list<int>::iterator end = nodes[v].incoming.end();
+      CSRAdjacency::iterator beg = adjacency().in_begin(v);
+      CSRAdjacency::iterator end = adjacency().in_end(v);
       while(beg != end) {
         if(edges[*beg].updatable) {
           beg++;
@@ -293,9 +308,9 @@ void IntraGraph::compressGraph(list<int> &ts, vector<int> &cs,
         }
         w = edges[*beg].src;
         if(orig_to_compress.find(w) == orig_to_compress.end()) {
-          temp[u][v] = temp[u][v]->combine(extend(temp[u][w],edges[*beg].weight));
+          temp.combine(u,v,extend(temp.get(u,w),edges[*beg].weight));
         } else {
-          temp[w][v] = temp[w][v]->combine(edges[*beg].weight);
+          temp.combine(w,v,edges[*beg].weight);
         }
         beg++;
       }
@@ -304,8 +319,6 @@ void IntraGraph::compressGraph(list<int> &ts, vector<int> &cs,
 
   // fill up cedges
   for(i=0;i<(int)cnodes.size();i++) {
-    cnodes[i].outgoing.clear();
-    cnodes[i].incoming.clear();
     cnodes[i].visited = 0;
     cnodes[i].iscutset = false;
   }
@@ -314,14 +327,11 @@ void IntraGraph::compressGraph(list<int> &ts, vector<int> &cs,
     u = nodeno(cnodes[i]);
     for(j=0;j<(int)cnodes.size();j++) {
       v = nodeno(cnodes[j]);
-      IntraGraphEdge ed(dag, i,j,temp[u][v],false);
-      if(!ed.weight->equal(se->zero()) && !(i==j && ed.weight->equal(se->one()))) {
+      IntraGraphEdge ed(dag, i,j,temp.get(u,v),false);
+      if(!ed.weight->isZero() && !(i==j && ed.weight->isOne())) {
         //ed.weight->print(cout << i << "," << j << ":") << "\n";
         ed.regexp = dag->constant(ed.weight);
         cedges.push_back(ed);
-        int e = cedges.size() - 1;
-        cnodes[i].outgoing.push_back(e);
-        cnodes[j].incoming.push_back(e);
       }
     }
   }
@@ -331,9 +341,6 @@ void IntraGraph::compressGraph(list<int> &ts, vector<int> &cs,
     ed.src = orig_to_compress[ed.src];
     ed.tgt = orig_to_compress[ed.tgt];
     cedges.push_back(ed);
-    int e = cedges.size() - 1;
-    cnodes[ed.src].outgoing.push_back(e);
-    cnodes[ed.tgt].incoming.push_back(e);
   }
   // build new topsort and cutset lists
   for(i=0;i<m;i++) {
@@ -345,12 +352,6 @@ void IntraGraph::compressGraph(list<int> &ts, vector<int> &cs,
       nts.push_back(orig_to_compress[*tsit]);
   }
 
-  // delete stuff
-    
-  for(i = 0; i < n; i++) {
-    delete [] temp[i];
-  }
-  delete [] temp;
 }
 
 // O(n^3) method
@@ -4,6 +4,7 @@
 #include "wali/graph/Functional.hpp"
 
 #include "wali/util/Timer.hpp"
+#include "wali/util/WorkStealingPool.hpp"
 
 #include <math.h>
 #include <stdlib.h>
@@ -14,6 +15,8 @@
 #include <iomanip>
 #include <sstream>
 #include <boost/cast.hpp>
+#include <boost/bind.hpp>
+#include <algorithm>
 
 // ::wali
 #include "wali/SemElemTensor.hpp"
@@ -165,7 +168,7 @@ namespace wali {
           return sem_elem_t(0);
         }
 
-        InterGraph::InterGraph(wali::sem_elem_t s, bool e, bool pre, bool n)
+        InterGraph::InterGraph(wali::sem_elem_t s, bool e, bool pre, bool n, RegExpDag * shared)
         {
           sem = s;
           intra_graph_uf = NULL;
@@ -175,13 +178,15 @@ namespace wali {
           max_scc_computed = 0;
           newtonGr = NULL;
           runningNewton = false;
-          dag = new RegExpDag();
+          ownsDag = (shared == NULL);
+          dag = ownsDag ? new RegExpDag() : shared;
           count = 0;
           isOutputAutomatonTensored = false;
         }
 
         InterGraph::~InterGraph() {
-          delete dag;
+          if(ownsDag)
+            delete dag;
           std::set<IntraGraph*> deleteGr;
           for(unsigned i = 0; i < nodes.size(); i++) {
             if(nodes[i].gr && intra_graph_uf->find(i) == (int)i) {
@@ -224,7 +229,7 @@ namespace wali {
         int InterGraph::intra_edgeno(Transition &src, Transition &tgt) {
           int s = nodeno(src);
           int t = nodeno(tgt);
-          std::list<int>::iterator it = nodes[s].outgoing.begin();
+          std::vector<int>::iterator it = nodes[s].outgoing.begin();
           for(; it != nodes[s].outgoing.end(); it++) {
             if(intra_edges[*it].tgt == t) {
               return *it;
@@ -770,9 +775,10 @@ namespace wali {
           sem = tensorSetUpFP(sem_old, sem_old);
 #if defined(PPP_DBG) && PPP_DBG >= 0
           long totCombines=0, totExtends=0, totStars=0;
-          unsigned maxNewtonRounds = 0;
-          unsigned totNewtonRounds = 0;
 #endif
+          newtonStats.clear();
+          if(!newtonSolver)
+            newtonSolver.reset(new RegExpNewtonSolver());
 
 
           // For each SCC, solve completely using Newton's method.
@@ -1035,8 +1041,9 @@ namespace wali {
                 }              
               }
               // (5)
-              // Use Tarjan's path listing algorithm to generate regular expressions for nodes.
-              graph->setupIntraSolution();
+              // The solver sets up the linear system when saturation starts,
+              // e.g., RegExpNewtonSolver uses Tarjan's path listing algorithm
+              // to generate regular expressions for nodes.
 
 #if defined(PPP_DBG) && PPP_DBG >= 1
               // We have the intra graph ready at this point. 
@@ -1052,12 +1059,7 @@ namespace wali {
               cout << "GRAPH " << scc_n << "\n";
 #endif 
               // (6) Now solve the linearized problem by saturating.
-              unsigned numRounds = 0;
-              graph->saturate(numRounds);
-#if defined(PPP_DBG) && PPP_DBG >= 0
-              maxNewtonRounds = numRounds > maxNewtonRounds ? numRounds : maxNewtonRounds;
-              totNewtonRounds += numRounds;
-#endif
+              graph->saturate(*newtonSolver, newtonStats);
               // The next SCC will use another sat process phase.
               dag->stopSatProcess();
             }
@@ -1096,8 +1098,8 @@ namespace wali {
           totExtends = dag->countTotalExtends();
           totStars = dag->countTotalStars();
 
-          cout << "Maximum number of Newton rounds: " << maxNewtonRounds << endl;
-          cout << "Total number of Newton rounds: " << totNewtonRounds << endl;
+          cout << "Maximum number of Newton rounds: " << newtonStats.maxRounds << endl;
+          cout << "Total number of Newton rounds: " << newtonStats.rounds << endl;
           cout << "Total number of combines: " << totCombines << endl;
           cout << "Total number of Extends: " << totExtends << endl;
           cout << "Total number of Stars: " << totStars << endl;
@@ -1151,6 +1153,20 @@ namespace wali {
 #endif 
         }
 
+        bool InterGraph::setThreadPool(boost::shared_ptr<util::WorkStealingPool> p) {
+#ifndef WALI_ATOMIC_REFCOUNT
+          if(p && p->numThreads() > 1) {
+            *waliErr << "[ERROR] InterGraph::setThreadPool: saturating on "
+                     << p->numThreads() << " threads needs a build with WALI_ATOMIC_REFCOUNT.\n";
+            assert(0);
+            pool.reset();
+            return false;
+          }
+#endif
+          pool = p;
+          return true;
+        }
+
         // If an argument is passed in then only weights on those transitions will be available
         // I can fix this (i.e., weights for others will be available on demand), but not right now.
         void InterGraph::setupInterSolution(std::list<Transition> *wt_required) {
@@ -1262,11 +1278,15 @@ namespace wali {
               max_scc_required = (max_scc_required >= nodes[nno].gr->scc_number) ? max_scc_required : nodes[nno].gr->scc_number;
             }
           }
-          gr_it = gr_sorted.begin();
-          for(unsigned scc_n = 1; scc_n <= max_scc_required; scc_n++) {
-            bfsIntra(*gr_it, scc_n);
-            setup_worklist(gr_sorted, gr_it, scc_n, worklist);
-            numSteps += saturate(worklist,scc_n);
+          if(pool && pool->numThreads() > 1) {
+            numSteps = saturateInWaves(gr_sorted, max_scc_required);
+          } else {
+            gr_it = gr_sorted.begin();
+            for(unsigned scc_n = 1; scc_n <= max_scc_required; scc_n++) {
+              bfsIntra(*gr_it, scc_n);
+              setup_worklist(gr_sorted, gr_it, scc_n, worklist);
+              numSteps += saturate(worklist,scc_n);
+            }
           }
 #if defined(PPP_DBG) && PPP_DBG >= 0
           cout << "Total number of steps: " << numSteps << endl;
@@ -1384,8 +1404,50 @@ namespace wali {
       return out;
     }
 
+    struct InterGraph::DeferredUpdate {
+      unsigned from_scc;
+      int onode1;
+      int inode;
+      sem_elem_t weight;
+
+      // Only the order of the SCCs that made them matters
+      bool operator<(const DeferredUpdate &d) const {
+        return from_scc < d.from_scc;
+      }
+    };
+
+    // The saturation of one SCC, as a task for the pool
+    struct InterGraph::SCCTask {
+      unsigned scc_n;
+      std::list<IntraGraph *>::iterator first;
+      int steps;
+      InterGraphStats stats;
+      RegExpStats regexp_stats;
+      std::vector<DeferredUpdate> later;
+    };
+
+    namespace {
+      // Sends the RegExp counters of this thread to a task while in scope
+      class ThreadStatsScope {
+        public:
+          explicit ThreadStatsScope(RegExpStats *s) {
+            RegExpDag::collectThreadStats(s);
+          }
+          ~ThreadStatsScope() {
+            RegExpDag::collectThreadStats(NULL);
+          }
+      };
+    }
+
     // New Saturation Procedure -- minimize calls to get_weight
     int InterGraph::saturate(multiset<tup> &worklist, unsigned scc_n) {
+      return saturate(worklist, scc_n, stats, NULL);
+    }
+
+    // When later is not NULL, updates to the edges of later SCCs are
+    // collected there instead of being made
+    int InterGraph::saturate(multiset<tup> &worklist, unsigned scc_n,
+        InterGraphStats &st, std::vector<DeferredUpdate> *later) {
       int numSteps = 0;
       sem_elem_t weight;
       std::list<int> *moutnodes;
@@ -1404,7 +1466,7 @@ namespace wali {
           continue;
         nodes[onode].weight = weight;
 
-        STAT(stats.niter++);
+        STAT(st.niter++);
 
         FWPDSDBGS(
             cout << "Popped ";
@@ -1430,8 +1492,13 @@ namespace wali {
           } else {
             uw = inter_edges[*beg].weight->extend(weight);
           }
-          STAT(stats.nextend++);
-          nodes[inode].gr->updateEdgeWeight(nodes[onode1].intra_nodeno, nodes[inode].intra_nodeno, uw);
+          STAT(st.nextend++);
+          if(later != NULL && nodes[inode].gr->scc_number != scc_n) {
+            DeferredUpdate d = { scc_n, onode1, inode, uw };
+            later->push_back(d);
+          } else {
+            nodes[inode].gr->updateEdgeWeight(nodes[onode1].intra_nodeno, nodes[inode].intra_nodeno, uw);
+          }
         }
         // Go through all targets again and insert them into the workist without
         // seeing if they actually got modified or not
@@ -1458,6 +1525,109 @@ namespace wali {
 
     }
 
+    // Parallel saturation. An SCC can be saturated once every SCC that
+    // updates its edges is done, so the SCCs are put into waves by the
+    // longest chain of such SCCs above them, and the SCCs of a wave are
+    // saturated concurrently. The updates a wave makes to later SCCs are
+    // held back until the target is about to be saturated, and are then
+    // made in SCC order -- the order sequential saturation makes them in.
+    int InterGraph::saturateInWaves(std::list<IntraGraph *> &gr_sorted, unsigned max_scc) {
+      unsigned components = gr_sorted.empty() ? 0 : gr_sorted.back()->scc_number;
+      std::vector<std::list<IntraGraph *>::iterator> first(components + 1, gr_sorted.end());
+      std::vector<unsigned> wave(components + 1, 0);
+      unsigned nwaves = 0;
+
+      std::list<IntraGraph *>::iterator gr_it;
+      for(gr_it = gr_sorted.begin(); gr_it != gr_sorted.end(); gr_it++) {
+        IntraGraph *gr = *gr_it;
+        unsigned scc_n = gr->scc_number;
+        if(scc_n > max_scc)
+          break;
+        if(first[scc_n] == gr_sorted.end())
+          first[scc_n] = gr_it;
+        nwaves = std::max(nwaves, wave[scc_n] + 1);
+
+        std::list<int> *outnodes = gr->getOutTransitions();
+        std::list<int>::iterator it;
+        for(it = outnodes->begin(); it != outnodes->end(); it++) {
+          std::list<int>::iterator beg = nodes[*it].out_hyper_edges.begin();
+          std::list<int>::iterator end = nodes[*it].out_hyper_edges.end();
+          for(; beg != end; beg++) {
+            unsigned ch_scc = nodes[inter_edges[*beg].tgt].gr->scc_number;
+            if(ch_scc != scc_n)
+              wave[ch_scc] = std::max(wave[ch_scc], wave[scc_n] + 1);
+          }
+        }
+      }
+
+      std::vector< std::vector<unsigned> > waves(nwaves);
+      for(unsigned scc_n = 1; scc_n <= max_scc; scc_n++)
+        waves[wave[scc_n]].push_back(scc_n);
+
+      std::vector< std::vector<DeferredUpdate> > pending(components + 1);
+      int numSteps = 0;
+      for(unsigned w = 0; w < nwaves; w++) {
+        std::vector<SCCTask> tasks(waves[w].size());
+        for(size_t i = 0; i < tasks.size(); i++) {
+          unsigned scc_n = waves[w][i];
+          applyDeferred(pending[scc_n]);
+          tasks[i].scc_n = scc_n;
+          tasks[i].first = first[scc_n];
+          tasks[i].steps = 0;
+        }
+
+        if(tasks.size() == 1) {
+          saturateSCC(tasks, gr_sorted, 0);
+        } else {
+          dag->evaluatingInParallel(true);
+          try {
+            pool->run(tasks.size(), boost::bind(&InterGraph::saturateSCC,
+                  this, boost::ref(tasks), boost::ref(gr_sorted), _1));
+          } catch(...) {
+            dag->evaluatingInParallel(false);
+            throw;
+          }
+          dag->evaluatingInParallel(false);
+        }
+
+        for(size_t i = 0; i < tasks.size(); i++) {
+          SCCTask &task = tasks[i];
+          numSteps += task.steps;
+          STAT(stats.niter += task.stats.niter);
+          STAT(stats.nextend += task.stats.nextend);
+          dag->addStats(task.regexp_stats);
+          for(size_t j = 0; j < task.later.size(); j++) {
+            DeferredUpdate &d = task.later[j];
+            pending[nodes[d.inode].gr->scc_number].push_back(d);
+          }
+        }
+      }
+
+      // SCCs that were not needed still get their updates
+      for(unsigned scc_n = max_scc + 1; scc_n <= components; scc_n++)
+        applyDeferred(pending[scc_n]);
+      return numSteps;
+    }
+
+    void InterGraph::saturateSCC(std::vector<SCCTask> &tasks, std::list<IntraGraph *> &gr_sorted, size_t i) {
+      SCCTask &task = tasks[i];
+      ThreadStatsScope scope(&task.regexp_stats);
+      std::list<IntraGraph *>::iterator gr_it = task.first;
+      WorkList worklist;
+      bfsIntra(*gr_it, task.scc_n);
+      setup_worklist(gr_sorted, gr_it, task.scc_n, worklist);
+      task.steps = saturate(worklist, task.scc_n, task.stats, &task.later);
+    }
+
+    void InterGraph::applyDeferred(std::vector<DeferredUpdate> &updates) {
+      std::stable_sort(updates.begin(), updates.end());
+      for(size_t i = 0; i < updates.size(); i++) {
+        DeferredUpdate &d = updates[i];
+        nodes[d.inode].gr->updateEdgeWeight(nodes[d.onode1].intra_nodeno, nodes[d.inode].intra_nodeno, d.weight);
+      }
+      updates.clear();
+    }
+
     // Must be called after saturation
     sem_elem_t InterGraph::get_call_weight(Transition t) {
       unsigned orig_size = nodes.size();
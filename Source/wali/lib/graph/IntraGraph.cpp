@@ -35,22 +35,18 @@ namespace wali {
     }
 
     int IntraGraph::edgeno(int s, int t) {
-      // For newton, the source node 0 has many edges going out.
-      // On the other hand, all nodes have only a small number 
-      // of edges coming in. So we change this to the equivalent
-      // use of incoming edges instead.
-      //list<int>::iterator it = nodes[s].outgoing.begin();
-      //for(; it != nodes[s].outgoing.end(); it++) {
-      //  if(edges[*it].tgt == t) {
-      //    return *it;
-      //  }
-      //}
-      list<int>::iterator it = nodes[t].incoming.begin();
-      for(; it != nodes[t].incoming.end(); it++){
-        if(edges[*it].src == s)
-          return *it;
-      }
-      return -1;
+      // For newton, the source node 0 has many edges going out, so
+      // scanning the edges of a node is not an option.
+      edge_index_t::const_iterator it = edge_index.find(std::make_pair(s,t));
+      if(it == edge_index.end())
+        return -1;
+      return it->second;
+    }
+
+    CSRAdjacency const & IntraGraph::adjacency() {
+      if(csr.num_nodes() != nnodes || csr.num_edges() != nedges)
+        csr.build(nnodes, edges, nedges);
+      return csr;
     }
 
     ostream &operator << (ostream &out, const IntraGraphStats &s) {
@@ -76,8 +72,9 @@ namespace wali {
       int n = nedges;
       int i;
       out << "IntraGraph:\n";
+      CSRAdjacency const & adj = adjacency();
       for(i=0;i<nnodes;i++) {
-        if(nodes[i].outgoing.size() == 0 && nodes[i].incoming.size() == 0) {
+        if(adj.out_degree(i) == 0 && adj.in_degree(i) == 0) {
           //print_trans(nodes[i].trans, out, pop);
           out << i << " ";
           out << "\n";
@@ -131,7 +128,8 @@ namespace wali {
 
     // return value: number of SCCs
     int IntraGraph::SCC(vector<IntraGraphNode> &cnodes, int ncnodes,
-			vector<IntraGraphEdge> &cedges, int UNUSED_PARAMETER(ncedges)) {
+			vector<IntraGraphEdge> &cedges, int UNUSED_PARAMETER(ncedges),
+                        CSRAdjacency const &adj) {
       int n = ncnodes;
       int i;
       // reset visited
@@ -140,21 +138,21 @@ namespace wali {
         cnodes[i].scc_number = 0;
       }
 
-      typedef pair<int, list<int>::iterator> pos_t;
+      typedef pair<int, CSRAdjacency::iterator> pos_t;
       list<pos_t> stack;
       list<int> ts;
       // DFS(G)
       for( i=0;i<n;i++) {
         if(cnodes[i].visited != 0) continue;
-        stack.push_front(pos_t(i, cnodes[i].outgoing.begin()));
+        stack.push_front(pos_t(i, adj.out_begin(i)));
         while(!stack.empty()) {
           pos_t p = stack.front();
           stack.pop_front();
           int v = p.first;
-          list<int>::iterator it = p.second;
+          CSRAdjacency::iterator it = p.second;
           cnodes[v].visited = 1; // gray
           bool done = true;
-          while(it != cnodes[v].outgoing.end()) {
+          while(it != adj.out_end(v)) {
             int c = cedges[*it].tgt;
             if(cnodes[c].visited == 1) { // gray
               it++;
@@ -162,7 +160,7 @@ namespace wali {
               it++;
             } else { // white
               stack.push_front(pos_t(v,++it));
-              stack.push_front(pos_t(c, cnodes[c].outgoing.begin()));
+              stack.push_front(pos_t(c, adj.out_begin(c)));
               done = false;
               break;
             }
@@ -188,16 +186,16 @@ namespace wali {
         if(cnodes[i].visited != 0) continue;
         scc_n++;
 
-        stack.push_front(pos_t(i, cnodes[i].incoming.begin()));
+        stack.push_front(pos_t(i, adj.in_begin(i)));
         while(!stack.empty()) {
           pos_t p = stack.front();
           stack.pop_front();
           int v = p.first;
-          list<int>::iterator it = p.second;
+          CSRAdjacency::iterator it = p.second;
           cnodes[v].visited = 1; // gray
           cnodes[v].scc_number = scc_n;
           bool done = true;
-          while(it != cnodes[v].incoming.end()) {
+          while(it != adj.in_end(v)) {
             int c = cedges[*it].src;
             if(cnodes[c].visited == 1) { // gray
               it++;
@@ -205,7 +203,7 @@ namespace wali {
               it++;
             } else { // white
               stack.push_front(pos_t(v,++it));
-              stack.push_front(pos_t(c, cnodes[c].incoming.begin()));
+              stack.push_front(pos_t(c, adj.in_begin(c)));
               done = false;
               break;
             }
@@ -221,7 +219,7 @@ namespace wali {
     // postcond: sets iscutset for all nodes
     void IntraGraph::topSort(vector<IntraGraphNode> &cnodes, int ncnodes,
 			     vector<IntraGraphEdge> &cedges, int UNUSED_PARAMETER(ncedges),
-                             list<int> &ts, vector<int> &cs, bool no_outgoing, bool no_updatable) {
+                             CSRAdjacency const &adj, list<int> &ts, vector<int> &cs, bool no_outgoing, bool no_updatable) {
       int n = ncnodes;
       int i;
       // reset visited
@@ -230,19 +228,19 @@ namespace wali {
         cnodes[i].iscutset = false;
       }
       // First find a cutset
-      typedef pair<int, list<int>::iterator> pos_t;
+      typedef pair<int, CSRAdjacency::iterator> pos_t;
       list<pos_t> stack;
       for( i=0;i<n;i++) {
         if(cnodes[i].visited != 0) continue;
-        stack.push_front(pos_t(i, cnodes[i].outgoing.begin()));
+        stack.push_front(pos_t(i, adj.out_begin(i)));
         while(!stack.empty()) {
           pos_t p = stack.front();
           stack.pop_front();
           int v = p.first;
-          list<int>::iterator it = p.second;
+          CSRAdjacency::iterator it = p.second;
           cnodes[v].visited = 1; // gray
           bool done = true;
-          while(it != cnodes[v].outgoing.end()) {
+          while(it != adj.out_end(v)) {
             int c = cedges[*it].tgt;
             if(no_updatable && cedges[*it].updatable) {
               it++;
@@ -255,7 +253,7 @@ namespace wali {
               it++;
             } else { // white
               stack.push_front(pos_t(v,++it));
-              stack.push_front(pos_t(c, cnodes[c].outgoing.begin()));
+              stack.push_front(pos_t(c, adj.out_begin(c)));
               done = false;
               break;
             }
@@ -275,19 +273,19 @@ namespace wali {
       // assert(cnodes[0].iscutset == false);
       for(i = 0; i < n; i++) {
         if(cnodes[i].visited != 0) continue;
-        stack.push_front(pos_t(i, cnodes[i].outgoing.begin()));
+        stack.push_front(pos_t(i, adj.out_begin(i)));
         while(!stack.empty()) {
           pos_t p = stack.front();
           stack.pop_front();
           int v = p.first;
-          list<int>::iterator it = p.second;
+          CSRAdjacency::iterator it = p.second;
           if(no_outgoing && cnodes[v].iscutset) {
             cnodes[v].visited = 2; // black
             continue;
           }
           cnodes[v].visited = 1; // gray
           bool done = true;
-          while(it != cnodes[v].outgoing.end()) {
+          while(it != adj.out_end(v)) {
             int c = cedges[*it].tgt;
             if(no_updatable && cedges[*it].updatable) {
               it++;
@@ -302,7 +300,7 @@ namespace wali {
               it++;
             } else { // white
               stack.push_front(pos_t(v,++it));
-              stack.push_front(pos_t(c, cnodes[c].outgoing.begin()));
+              stack.push_front(pos_t(c, adj.out_begin(c)));
               done = false;
               break;
             }
@@ -317,7 +315,8 @@ namespace wali {
 
     void IntraGraph::buildCutsetRegExp(list<int> &ts, vector<int> &cs,
                                        vector<IntraGraphNode> &cnodes, int ncnodes,
-				       vector<IntraGraphEdge> &cedges, int UNUSED_PARAMETER(ncedges)) {
+				       vector<IntraGraphEdge> &cedges, int UNUSED_PARAMETER(ncedges),
+                                       CSRAdjacency const &adj) {
       int m = cs.size();
       int n = ncnodes;
       assert(n == (int)ts.size());
@@ -338,8 +337,8 @@ namespace wali {
         v = *it;
         if(cnodes[v].iscutset)
           continue;
-        list<int>::iterator beg = cnodes[v].incoming.begin();
-        list<int>::iterator end = cnodes[v].incoming.end();
+        CSRAdjacency::iterator beg = adj.in_begin(v);
+        CSRAdjacency::iterator end = adj.in_end(v);
         for(; beg != end; beg++) {
           temp[m][v] = dag->combine(temp[m][v], dag->extend(temp[m][cedges[*beg].src], cedges[*beg].regexp));
         }
@@ -358,8 +357,8 @@ namespace wali {
           v = *beg;
           if(cnodes[v].iscutset)
             continue;
-          list<int>::iterator beg2 = cnodes[v].incoming.begin();
-          list<int>::iterator end2 = cnodes[v].incoming.end();
+          CSRAdjacency::iterator beg2 = adj.in_begin(v);
+          CSRAdjacency::iterator end2 = adj.in_end(v);
           for(; beg2 != end2; beg2++) {
             temp[i][v] = dag->combine(temp[i][v], dag->extend(temp[i][cedges[*beg2].src], cedges[*beg2].regexp));
           }
@@ -380,8 +379,8 @@ namespace wali {
       for(i = 0; i < m; i++) {
         for(j = 0; j < m; j++) {
           int v = cs[j];
-          list<int>::iterator beg = cnodes[v].incoming.begin();
-          list<int>::iterator end = cnodes[v].incoming.end();
+          CSRAdjacency::iterator beg = adj.in_begin(v);
+          CSRAdjacency::iterator end = adj.in_end(v);
           for(; beg != end; beg++) {
             reg[i][j] = dag->combine(reg[i][j], dag->extend(temp[i][cedges[*beg].src], cedges[*beg].regexp));
           }
@@ -406,8 +405,8 @@ namespace wali {
       // correct temp[m]
       for(i=0;i<m;i++) {
         v = cs[i];
-        list<int>::iterator beg = cnodes[v].incoming.begin();
-        list<int>::iterator end = cnodes[v].incoming.end();
+        CSRAdjacency::iterator beg = adj.in_begin(v);
+        CSRAdjacency::iterator end = adj.in_end(v);
         for(; beg != end; beg++) {
           temp[m][v] = dag->combine(temp[m][v], dag->extend(temp[m][cedges[*beg].src], cedges[*beg].regexp));
         }
@@ -440,8 +439,9 @@ namespace wali {
 
     void IntraGraph::dfs(int v, set<int> &gray, set<int> &black, set<int> &cutset) {
       gray.insert(v);
-      list<int>::iterator ch = nodes[v].outgoing.begin();
-      for(; ch != nodes[v].outgoing.end(); ch++) {
+      CSRAdjacency const & adj = adjacency();
+      CSRAdjacency::iterator ch = adj.out_begin(v);
+      for(; ch != adj.out_end(v); ch++) {
         int c = edges[*ch].tgt;
         set<int>::iterator it = gray.find(c);
         if(it != gray.end()) { // child is gray
@@ -533,8 +533,7 @@ namespace wali {
           edges[eno].updatable_no = uno;
           updatable_edges.push_back(eno);
         }
-        nodes[s].outgoing.push_back(eno);
-        nodes[t].incoming.push_back(eno);
+        edge_index.insert(std::make_pair(std::make_pair(s,t), eno));
       }
       return eno;
 
@@ -579,8 +578,7 @@ namespace wali {
 
       int e = nedges - 1;
 
-      nodes[s].outgoing.push_back(e);
-      nodes[t].incoming.push_back(e);
+      edge_index.insert(std::make_pair(std::make_pair(s,t), e));
 
       if(updatable) {
         updatable_edges.push_back(e);
@@ -600,8 +598,8 @@ namespace wali {
       nedges++;
 
       int e = nedges - 1;
-      nodes[0].outgoing.push_back(e);
-      nodes[n].incoming.push_back(e);
+      // A parallel edge from the source; edgeno keeps finding the first
+      edge_index.insert(std::make_pair(std::make_pair(0,n), e));
     }
 
     int IntraGraph::setSource(int n, sem_elem_t init_weight, functional_t exp) 
@@ -758,7 +756,7 @@ namespace wali {
       // The first node is a fake "source" node, so skip it
       for(i=1;i<n;i++) {
         sem_elem_t wt = nodes[i].regexp->get_weight();
-        if(!wt->equal(se->zero())) {
+        if(!wt->isZero()) {
           change.push_back(WTransition(nodes[i].trans, wt));
         }
       }
@@ -799,7 +797,7 @@ namespace wali {
       // Return the updated list of transitions
       for(i=0;i<n;i++) {
         sem_elem_t wt = nodes[i].regexp->get_weight();
-        if(!wt->equal(se->zero())) {
+        if(!wt->isZero()) {
           change.push_back(WTransition(nodes[i].trans, wt));
         }
       }
@@ -861,11 +859,14 @@ namespace wali {
 
     sem_elem_t IntraGraph::get_weight(int nno) {
 
+      if(!regexpWeights)
+        return nodes[nno].weight;
+
       if(nodes[nno].regexp.get_ptr() == NULL) {
         assert(0);
         //buildCutsetRegExp(topsort_list,cutset_list,nodes,edges); 
         vector<PathSequence> seq;
-        domRegExp(nodes,nnodes,edges,nedges,seq);
+        domRegExp(nodes,nnodes,edges,nedges,adjacency(),seq);
         buildRegExp(seq);
       }
       FWPDSDBGS({
@@ -902,7 +903,7 @@ namespace wali {
 #if REGEXP_METHOD==0
 
       // SCC followed by Dominator version
-      computePathSequence(nodes, nnodes, edges, nedges, path_sequence);
+      computePathSequence(nodes, nnodes, edges, nedges, adjacency(), path_sequence);
       buildRegExp(path_sequence);
 
       { // NAK DEBUGGING REGEXP
@@ -920,14 +921,14 @@ namespace wali {
       STAT(stats.ndom_sequence = path_sequence.size());
 #elif REGEXP_METHOD==1
       // Dominator
-      domRegExp(nodes, nnodes, edges, nedges, path_sequence);
+      domRegExp(nodes, nnodes, edges, nedges, adjacency(), path_sequence);
       buildRegExp(path_sequence);
 
       STAT(stats.ndom_sequence = path_sequence.size());
 #elif REGEXP_METHOD==2
 
       // Dominator version + regexp compression and huffman-height minimization
-      domRegExp(nodes, nnodes, edges, nedges, path_sequence);
+      domRegExp(nodes, nnodes, edges, nedges, adjacency(), path_sequence);
       buildRegExp(path_sequence);
       STAT(stats.ndom_sequence = path_sequence.size());
       for(nit = out_nodes_intra->begin(); nit != out_nodes_intra->end(); nit++) {
@@ -941,9 +942,9 @@ namespace wali {
 #elif REGEXP_METHOD==3
 
       // Dominators with compression
-      topSort(nodes,nnodes, edges, nedges, topsort_list,cutset_list, false, false);
+      topSort(nodes,nnodes, edges, nedges, adjacency(), topsort_list,cutset_list, false, false);
       compressGraph(topsort_list,cutset_list,ts,cs,cnodes,cedges,orig_to_compress);
-      domRegExp(cnodes, cnodes.size(), cedges, cedges.size(), path_sequence);
+      domRegExp(cnodes, cnodes.size(), cedges, cedges.size(), CSRAdjacency(cnodes.size(), cedges, cedges.size()), path_sequence);
       buildRegExp(path_sequence);
       STAT(stats.ndom_sequence = path_sequence.size());
       for(nit = out_nodes_intra->begin(); nit != out_nodes_intra->end(); nit++) {
@@ -953,15 +954,15 @@ namespace wali {
 #elif REGEXP_METHOD==4
 
       // Cutset version
-      topSort(nodes,edges,topsort_list,cutset_list, false, false);
-      buildCutsetRegExp(topsort_list,cutset_list,nodes,nnodes, edges, nedges); return;
+      topSort(nodes,nnodes, edges, nedges, adjacency(), topsort_list,cutset_list, false, false);
+      buildCutsetRegExp(topsort_list,cutset_list,nodes,nnodes, edges, nedges, adjacency()); return;
 
 #elif REGEXP_METHOD==5
 
       // Cutset with compression
       compressGraph(topsort_list,cutset_list,ts,cs,cnodes,cedges,orig_to_compress);
       //cout << cs.size() << "\n";
-      buildCutsetRegExp(ts,cs,cnodes,cnodes.size(), cedges, cedges.size());
+      buildCutsetRegExp(ts,cs,cnodes,cnodes.size(), cedges, cedges.size(), CSRAdjacency(cnodes.size(), cedges, cedges.size()));
 
       for(nit = out_nodes_intra->begin(); nit != out_nodes_intra->end(); nit++) {
         int nno = *nit;
@@ -1009,7 +1010,8 @@ namespace wali {
 
     //Use of tree[.] is deprecated
     // e \in tree[v] iff (v = e.tgt and e.src = dom[e.tgt])
-    void IntraGraph::domRegExp(vector<IntraGraphNode> &cnodes, int ncnodes, vector<IntraGraphEdge> &cedges, int ncedges, vector<PathSequence> &sequence) {
+    void IntraGraph::domRegExp(vector<IntraGraphNode> &cnodes, int ncnodes, vector<IntraGraphEdge> &cedges, int ncedges,
+                               CSRAdjacency const &adj, vector<PathSequence> &sequence) {
       int n = ncnodes;
       int i;
 
@@ -1045,7 +1047,7 @@ namespace wali {
       // reg : vertex -> R(vertex)
 
       // does not take much time
-      int *dom = computeDominators(cnodes, ncnodes, cedges, ncedges, buffer, children);
+      int *dom = computeDominators(cnodes, ncnodes, cedges, ncedges, adj, buffer, children);
 
       int j,u,v,w;
         
@@ -1082,8 +1084,8 @@ namespace wali {
         set<int>::iterator end = children[u].end();
         for(; beg != end; beg++) {
           v = *beg;
-          list<int>::iterator ebeg = cnodes[v].incoming.begin();
-          list<int>::iterator eend = cnodes[v].incoming.end();
+          CSRAdjacency::iterator ebeg = adj.in_begin(v);
+          CSRAdjacency::iterator eend = adj.in_end(v);
           for(; ebeg != eend; ebeg++) {
             w = cedges[*ebeg].src;
             //if(*ebeg == tree[v]) continue;
@@ -1099,8 +1101,6 @@ namespace wali {
               sub_node_number[w] = wt;
               node_number[wt] = w;
               sub_cnodes.push_back(cnodes[w]);
-              sub_cnodes[wt].incoming.clear();
-              sub_cnodes[wt].outgoing.clear();
             } else {
               wt = sub_node_number[w];
             }
@@ -1109,28 +1109,25 @@ namespace wali {
               sub_node_number[v] = vt;
               node_number[vt] = v;
               sub_cnodes.push_back(cnodes[v]);
-              sub_cnodes[vt].incoming.clear();
-              sub_cnodes[vt].outgoing.clear();
             } else {
               vt = sub_node_number[v];
             }
             sub_cedges.push_back(IntraGraphEdge(dag, wt, vt, se->zero(), false));
             et = sub_cedges.size() - 1;
-            sub_cnodes[wt].outgoing.push_back(et);
-            sub_cnodes[vt].incoming.push_back(et);
             sub_cedges[et].regexp = eval_and_sequence(cnodes, cedges, *ebeg, ancestor, sequence);
           }
         }
         // Compute a path sequence for sub-graph
         int slength = sequence.size();
-        computePathSequence(sub_cnodes, sub_cnodes.size(), sub_cedges, sub_cedges.size(), sequence, true);
+        CSRAdjacency sub_adj(sub_cnodes.size(), sub_cedges, sub_cedges.size());
+        computePathSequence(sub_cnodes, sub_cnodes.size(), sub_cedges, sub_cedges.size(), sub_adj, sequence, true);
         // Solve
         beg = children[u].begin();
         for(; beg != end; beg++) {
           v = *beg;
           reg[v] = dag->constant(se->zero());
-          list<int>::iterator ebeg = cnodes[v].incoming.begin();
-          list<int>::iterator eend = cnodes[v].incoming.end();
+          CSRAdjacency::iterator ebeg = adj.in_begin(v);
+          CSRAdjacency::iterator eend = adj.in_end(v);
           for(; ebeg != eend; ebeg++) {
             if(cedges[*ebeg].src != dom[v]) continue;
             reg[v] = dag->combine(reg[v], cedges[*ebeg].regexp);
@@ -1161,10 +1158,10 @@ namespace wali {
       }
       // Finalize
 
-      if(cnodes[0].incoming.size() != 0) {
+      if(adj.in_degree(0) != 0) {
         reg_exp_t q = dag->constant(se->zero());
-        list<int>::iterator beg = cnodes[0].incoming.begin();
-        list<int>::iterator end = cnodes[0].incoming.end();
+        CSRAdjacency::iterator beg = adj.in_begin(0);
+        CSRAdjacency::iterator end = adj.in_end(0);
 
         assert(dom[0] == -1); // node 0 has no tree edges
         for(; beg != end; beg++) {
@@ -1213,18 +1210,18 @@ namespace wali {
     }
 
     void IntraGraph::computePathSequence(vector<IntraGraphNode> &cnodes, int ncnodes, vector<IntraGraphEdge> &cedges, 
-                                         int ncedges, vector<PathSequence> &sequence, bool use_cutset) {
+                                         int ncedges, CSRAdjacency const &adj, vector<PathSequence> &sequence, bool use_cutset) {
       if(ncedges == 0) 
         return;
           
-      int maxs = SCC(cnodes,ncnodes,cedges,ncedges);
+      int maxs = SCC(cnodes,ncnodes,cedges,ncedges,adj);
       int n = (int)ncnodes;
       int m = (int)ncedges;
       int i;
       //static int count = 0;
 
       if(use_cutset && m < n) { // possibly acyclic
-        computePathSequenceCutset(cnodes,ncnodes,cedges,ncedges,sequence);
+        computePathSequenceCutset(cnodes,ncnodes,cedges,ncedges,adj,sequence);
         return;
       }
 
@@ -1242,8 +1239,6 @@ namespace wali {
         scc_nodes[s].push_back(cnodes[i]);
 
         int last = scc_nodes[s].size();
-        scc_nodes[s][last-1].incoming.clear();
-        scc_nodes[s][last-1].outgoing.clear();
 
         node_map[i] = last-1;
         inv_node_map[s][last-1] = i;
@@ -1260,8 +1255,6 @@ namespace wali {
           scc_edges[s1].push_back(IntraGraphEdge(dag, ns,nt,se->zero(),false));
           int last = scc_edges[s1].size();
           scc_edges[s1][last-1].regexp = cedges[i].regexp;
-          scc_nodes[s1][ns].outgoing.push_back(last-1);
-          scc_nodes[s1][nt].incoming.push_back(last-1);
         }
       }
 
@@ -1295,10 +1288,11 @@ namespace wali {
 
       for(i=1;i<=maxs;i++) {
         vector<PathSequence> seq;
+        CSRAdjacency scc_adj(scc_nodes[i].size(), scc_edges[i], scc_edges[i].size());
         if(use_cutset)
-          computePathSequenceCutset(scc_nodes[i],scc_nodes[i].size(),scc_edges[i],scc_edges[i].size(),seq);
+          computePathSequenceCutset(scc_nodes[i],scc_nodes[i].size(),scc_edges[i],scc_edges[i].size(),scc_adj,seq);
         else
-          domRegExp(scc_nodes[i], scc_nodes[i].size(), scc_edges[i], scc_edges[i].size(), seq);
+          domRegExp(scc_nodes[i], scc_nodes[i].size(), scc_edges[i], scc_edges[i].size(), scc_adj, seq);
 
         for(j=0;j<seq.size();j++) {
           sequence.push_back(PathSequence(seq[j].regexp, inv_node_map[i][seq[j].src], inv_node_map[i][seq[j].tgt]));
@@ -1319,12 +1313,13 @@ namespace wali {
       //WIN(stats.path_seq_time  += clock() - start);
     }
 
-    void IntraGraph::computePathSequenceCutset(vector<IntraGraphNode> &cnodes, int ncnodes, vector<IntraGraphEdge> &cedges, int ncedges, vector<PathSequence> &sequence) {
+    void IntraGraph::computePathSequenceCutset(vector<IntraGraphNode> &cnodes, int ncnodes, vector<IntraGraphEdge> &cedges, int ncedges,
+                                               CSRAdjacency const &adj, vector<PathSequence> &sequence) {
       int n = (int)ncnodes;
       if(ncedges==0) return;
 
       list<int> ts; vector<int> cs;
-      topSort(cnodes,ncnodes,cedges,ncedges,ts,cs,false,false);
+      topSort(cnodes,ncnodes,cedges,ncedges,adj,ts,cs,false,false);
       int m = (int)cs.size();
 
       list<int>::iterator beg,end;
@@ -1343,8 +1338,8 @@ namespace wali {
       end = ts.end();
       for(; beg != end; beg++) {
         v = *beg;
-        list<int>::iterator beg2 = cnodes[v].outgoing.begin();
-        list<int>::iterator end2 = cnodes[v].outgoing.end();
+        CSRAdjacency::iterator beg2 = adj.out_begin(v);
+        CSRAdjacency::iterator end2 = adj.out_end(v);
         for(; beg2 != end2; beg2++) {
           u = cedges[*beg2].tgt;
           if(!cnodes[u].iscutset)
@@ -1374,8 +1369,8 @@ namespace wali {
           v = *beg;
           if(cnodes[v].iscutset)
             continue;
-          list<int>::iterator beg2 = cnodes[v].incoming.begin();
-          list<int>::iterator end2 = cnodes[v].incoming.end();
+          CSRAdjacency::iterator beg2 = adj.in_begin(v);
+          CSRAdjacency::iterator end2 = adj.in_end(v);
           for(; beg2 != end2; beg2++) {
             reg[i][v] = dag->combine(reg[i][v], dag->extend(reg[i][cedges[*beg2].src], cedges[*beg2].regexp));
           }
@@ -1385,8 +1380,8 @@ namespace wali {
       for(i = 0; i < m; i++) {
         for(j = 0; j < m; j++) {
           v = cs[j];
-          list<int>::iterator beg = cnodes[v].incoming.begin();
-          list<int>::iterator end = cnodes[v].incoming.end();
+          CSRAdjacency::iterator beg = adj.in_begin(v);
+          CSRAdjacency::iterator end = adj.in_end(v);
           for(; beg != end; beg++) {
             u = cedges[*beg].src;
             if(!cnodes[u].iscutset) {
@@ -1438,8 +1433,8 @@ namespace wali {
       end = ts.end();
       for(; beg != end; beg++) {
         v = *beg;
-        list<int>::iterator beg2 = cnodes[v].outgoing.begin();
-        list<int>::iterator end2 = cnodes[v].outgoing.end();
+        CSRAdjacency::iterator beg2 = adj.out_begin(v);
+        CSRAdjacency::iterator end2 = adj.out_end(v);
         for(; beg2 != end2; beg2++) {
           u = cedges[*beg2].tgt;
           if(!cnodes[u].iscutset)
@@ -1494,6 +1489,7 @@ namespace wali {
     // buffer must be of size atleast 4*ncnodes
     int *IntraGraph::computeDominators(vector<IntraGraphNode> &cnodes, int ncnodes,
 				       vector<IntraGraphEdge> &cedges, int ncedges ATTR_UNUSED,
+                                       CSRAdjacency const &adj,
 				       int *buffer, set<int> *bucket_buffer) {
       (void) ncedges;
 
@@ -1514,15 +1510,15 @@ namespace wali {
       }
       count = 0;
 
-      dfsDominators(cnodes,cedges,0,parent,semi,vertex,count);
+      dfsDominators(cnodes,cedges,adj,0,parent,semi,vertex,count);
 
       assert(count == n);
 
       // Step 2 and 3
       for(i = n-1; i >= 1; i--) {
         w = vertex[i];
-        list<int>::iterator beg = cnodes[w].incoming.begin();
-        list<int>::iterator end = cnodes[w].incoming.end();
+        CSRAdjacency::iterator beg = adj.in_begin(w);
+        CSRAdjacency::iterator end = adj.in_end(w);
         for(; beg != end; beg++) {
           v = cedges[*beg].src;
           u = le.eval(v);
@@ -1555,17 +1551,17 @@ namespace wali {
     }
 
     void IntraGraph::dfsDominators(vector<IntraGraphNode> &cnodes, vector<IntraGraphEdge> &cedges, 
-                                   int v, int *parent, int *semi, int *vertex, int &n) {
+                                   CSRAdjacency const &adj, int v, int *parent, int *semi, int *vertex, int &n) {
       semi[v] = n;
       vertex[n] = v;
       n++;
-      list<int>::iterator beg = cnodes[v].outgoing.begin();
-      list<int>::iterator end = cnodes[v].outgoing.end();
+      CSRAdjacency::iterator beg = adj.out_begin(v);
+      CSRAdjacency::iterator end = adj.out_end(v);
       for(; beg != end; beg++) {
         int w = cedges[*beg].tgt;
         if(semi[w] == -1) {
           parent[w] = v;
-          dfsDominators(cnodes,cedges,w,parent,semi,vertex,n);
+          dfsDominators(cnodes,cedges,adj,w,parent,semi,vertex,n);
         }
       }
     }
@@ -1622,66 +1618,66 @@ namespace wali {
      * Function description:
      *   // The actual function is quite simple. This implementation is long because when PPP_DBG is
      *   // >= 2, it dumps lots of debugging information.
-     *   (1) Find out the minimal set of regular expression dags such that computing the value for
-     *   these nodes computes all the needed weights, i.e., all regular expression nodes that label
-     *   some IntraGraph node are computed. 
+     *   (1) Let the solver set up the linear system, e.g., the regular expressions and the
+     *   minimal set of them that must be evaluated (@see RegExpNewtonSolver).
      *   In each newton round 
-     *     (2) evaluate minimal set of regular expressions (as computed above)
+     *     (2) solve the linear system with the current coefficients
      *     (3) Find out what nodes have new values. FIXME: can this be done faster? Currently this
      *     is a linear time operation.
      *     (4) Reevaluate the required functionals (this changes the weights on some mutable edges)
      *     (5) did we change any edge? If yes, repeat, else we're done.
      *
      **/
-    void IntraGraph::saturate(unsigned& numRounds)
+    void IntraGraph::saturate(NewtonSolver & solver, NewtonStats & newtonStats)
     {
 
       bool repeat = true;
-      numRounds = 0;
+      unsigned numRounds = 0;
 #if defined(PPP_DBG) && PPP_DBG >= 0
       ++saturateCount;
 #endif
 
-      // (1) Just once, set up the minimal dag that needs to be evaluated each time.
-      dag->computeMinimalRoots();
+      // (1) Just once, set up the system for the solver
+      solver.prepare(*this);
       while(repeat){
         ++numRounds;
-        //(2) First, evaluate the current regular expressions completely.
-        dag->evaluateRoots();
+        long long roundStart = util::details::now();
+        //(2) First, solve the current linear system completely.
+        solver.solve(*this);
 
         //(3) Now, obtain the set of nodes who's values have changed.
         std::vector<IntraGraphNode*> changedNodes;
         // The first node is the source node.
         for(int i = 1; i < nnodes; ++i){
-          if(nodes[i].weight == NULL || !nodes[i].weight->equal(nodes[i].regexp->get_weight())){
+          sem_elem_t wt = solver.weight(*this, i);
+          if(nodes[i].weight == NULL || !nodes[i].weight->equal(wt)){
             changedNodes.push_back(&nodes[i]);
-            nodes[i].weight = nodes[i].regexp->get_weight();
+            nodes[i].weight = wt;
           }
         }
         // (4) Given the set of nodes who's weights have changed, find the set of mutable edges that
         // need to be updated.
-        std::set<unsigned long> updateEdgesSet;
-        std::vector<unsigned long> updateEdges;
+        std::set<int> updateEdgesSet;
+        std::vector<int> updateEdges;
         std::vector<sem_elem_t> weights;
         for(vector<IntraGraphNode*>::const_iterator iter = changedNodes.begin(); iter != changedNodes.end(); ++iter){
-          for(std::set<int>::const_iterator ei = (*iter)->dependentEdges.begin(); ei != (*iter)->dependentEdges.end(); ++ei){
+          for(std::vector<int>::const_iterator ei = (*iter)->dependentEdges.begin(); ei != (*iter)->dependentEdges.end(); ++ei){
             assert(edges[*ei].updatable);
-            int updatable_no = edges[*ei].updatable_no;
-            if(updateEdgesSet.find(updatable_no) == updateEdgesSet.end()){
-              updateEdges.push_back(updatable_no);
+            if(updateEdgesSet.insert(*ei).second){
+              updateEdges.push_back(*ei);
               sem_elem_t wt = edges[*ei].exp->evaluate(this).get_ptr();
               weights.push_back(wt);
               //update the edge anyway. This weight should not be used, except for debugging.
               edges[*ei].weight = weights.back();
-              updateEdgesSet.insert(updatable_no);
             }
           }
         }
         // (5)
         if(updateEdges.size() > 0){
           repeat  = true;
-          dag->update(updateEdges, weights);
+          solver.updateCoefficients(*this, updateEdges, weights);
         }else repeat = false;
+        newtonStats.roundSeconds.push_back(util::details::to_sec(util::details::now() - roundStart));
 #if defined(PPP_DBG) && PPP_DBG >= 1
           {
             stringstream ss;
@@ -1756,6 +1752,12 @@ namespace wali {
           }
 #endif
       }
+      solver.finish(*this);
+
+      newtonStats.systems++;
+      newtonStats.rounds += numRounds;
+      if(numRounds > newtonStats.maxRounds)
+        newtonStats.maxRounds = numRounds;
     }
 
     /**
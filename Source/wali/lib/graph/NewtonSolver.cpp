@@ -0,0 +1,178 @@
+/**
+ * @file NewtonSolver.cpp
+ */
+
+#include "wali/graph/NewtonSolver.hpp"
+#include "wali/graph/IntraGraph.hpp"
+#include "wali/graph/RegExp.hpp"
+
+#include <numeric>
+
+namespace wali
+{
+  namespace graph
+  {
+    double NewtonStats::totalSeconds() const
+    {
+      return std::accumulate(roundSeconds.begin(), roundSeconds.end(), 0.0);
+    }
+
+    std::ostream & operator << (std::ostream & out, NewtonStats const & s)
+    {
+      out << "Newton systems : " << s.systems << "\n";
+      out << "Newton rounds : " << s.rounds << "\n";
+      out << "Max rounds per system : " << s.maxRounds << "\n";
+      out << "Time in rounds (sec) : " << s.totalSeconds() << "\n";
+      return out;
+    }
+
+    NewtonSolver::~NewtonSolver()
+    {
+    }
+
+    void NewtonSolver::finish(IntraGraph & UNUSED_PARAMETER(g))
+    {
+    }
+
+    ////////////////////
+    // RegExpNewtonSolver
+    ////////////////////
+
+    char const * RegExpNewtonSolver::name() const
+    {
+      return "regexp";
+    }
+
+    void RegExpNewtonSolver::prepare(IntraGraph & g)
+    {
+      // Tarjan's path listing, then the minimal set of dag nodes that
+      // must be evaluated to get all node weights.
+      g.setupIntraSolution();
+      g.dag->computeMinimalRoots();
+    }
+
+    void RegExpNewtonSolver::solve(IntraGraph & g)
+    {
+      g.dag->evaluateRoots();
+    }
+
+    sem_elem_t RegExpNewtonSolver::weight(IntraGraph & g, int node)
+    {
+      return g.nodes[node].regexp->get_weight();
+    }
+
+    void RegExpNewtonSolver::updateCoefficients(
+        IntraGraph & g,
+        std::vector<int> const & edges,
+        std::vector<sem_elem_t> const & weights)
+    {
+      std::vector<unsigned long> unos;
+      unos.reserve(edges.size());
+      for(std::vector<int>::const_iterator it = edges.begin(); it != edges.end(); ++it)
+        unos.push_back(g.edges[*it].updatable_no);
+      g.dag->update(unos, weights);
+    }
+
+    ////////////////////
+    // IterativeNewtonSolver
+    ////////////////////
+
+    char const * IterativeNewtonSolver::name() const
+    {
+      return "iterative";
+    }
+
+    void IterativeNewtonSolver::prepare(IntraGraph & g)
+    {
+      g.regexpWeights = false;
+
+      // g.se is not tensored even when the weights of g are, so take
+      // zero and one from the edges, as the dag takes them from the
+      // semiring of the saturation process.
+      sem_elem_t unit = g.se;
+      coefficient.assign(g.nedges, sem_elem_t());
+      for(int e = 0; e < g.nedges; ++e){
+        coefficient[e] = g.edges[e].weight;
+        if(g.edges[e].src != -1 && unit == g.se)
+          unit = coefficient[e];
+      }
+
+      value.assign(g.nnodes, unit->zero());
+      value[0] = unit->one();
+      g.nodes[0].weight = value[0];
+
+      onWorklist.assign(g.nnodes, false);
+      worklist.clear();
+      worklist.push_back(0);
+      onWorklist[0] = true;
+    }
+
+    void IterativeNewtonSolver::propagateFrom(IntraGraph & g, int node)
+    {
+      CSRAdjacency const & adj = g.adjacency();
+      for(CSRAdjacency::iterator it = adj.out_begin(node); it != adj.out_end(node); ++it){
+        IntraGraphEdge const & edge = g.edges[*it];
+        // Node 0 is the source; its weight stays one
+        if(edge.src == -1 || edge.tgt == 0 || coefficient[*it]->isZero())
+          continue;
+        // Same direction of extend as RegExpDag::extend
+        sem_elem_t contribution = g.running_prestar
+          ? coefficient[*it]->extend(value[node])
+          : value[node]->extend(coefficient[*it]);
+        sem_elem_t old = value[edge.tgt];
+        sem_elem_t now = old->combine(contribution);
+        if(!now->equal(old)){
+          value[edge.tgt] = now;
+          if(!onWorklist[edge.tgt]){
+            onWorklist[edge.tgt] = true;
+            worklist.push_back(edge.tgt);
+          }
+        }
+      }
+    }
+
+    void IterativeNewtonSolver::solve(IntraGraph & g)
+    {
+      while(!worklist.empty()){
+        int node = worklist.front();
+        worklist.pop_front();
+        onWorklist[node] = false;
+        propagateFrom(g, node);
+      }
+    }
+
+    sem_elem_t IterativeNewtonSolver::weight(IntraGraph & UNUSED_PARAMETER(g), int node)
+    {
+      return value[node];
+    }
+
+    void IterativeNewtonSolver::updateCoefficients(
+        IntraGraph & g,
+        std::vector<int> const & edges,
+        std::vector<sem_elem_t> const & weights)
+    {
+      for(size_t i = 0; i < edges.size(); ++i){
+        int e = edges[i];
+        // The functionals are monotone and the values only grow, so the
+        // new value subsumes the old one; combining keeps the constant
+        // part of an edge that is also updatable (see IntraGraph::addEdge).
+        coefficient[e] = coefficient[e]->combine(weights[i]);
+        int src = g.edges[e].src;
+        if(!onWorklist[src]){
+          onWorklist[src] = true;
+          worklist.push_back(src);
+        }
+      }
+    }
+
+    void IterativeNewtonSolver::finish(IntraGraph & UNUSED_PARAMETER(g))
+    {
+      coefficient.clear();
+      value.clear();
+      worklist.clear();
+      onWorklist.clear();
+    }
+
+  } // namespace graph
+
+} // namespace wali
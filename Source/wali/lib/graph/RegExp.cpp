@@ -5,6 +5,7 @@
 #include <iterator>
 #include <cassert>
 #include <sstream>
+#include <thread>
 
 #if defined(PPP_DBG)
 #include "wali/SemElemTensor.hpp"
@@ -14,6 +15,61 @@ namespace wali {
 
     namespace graph {
 
+      thread_local RegExpStats * RegExpDag::thread_stats = NULL;
+
+      RegExpChildren::~RegExpChildren()
+      {
+        delete [] spill;
+      }
+
+      void RegExpChildren::reserve(unsigned c)
+      {
+        if(c <= cap)
+          return;
+        unsigned ncap = (cap * 2 > c) ? cap * 2 : c;
+        reg_exp_t * nspill = new reg_exp_t[ncap];
+        reg_exp_t * old = begin();
+        for(unsigned i = 0; i < n; i++)
+          nspill[i] = old[i];
+        if(spill != 0)
+          delete [] spill;
+        else {
+          for(unsigned i = 0; i < INLINE; i++)
+            inl[i] = 0;
+        }
+        spill = nspill;
+        cap = ncap;
+      }
+
+      void RegExpChildren::push_back(reg_exp_t const & r)
+      {
+        reg_exp_t keep = r; // r may be one of ours
+        reserve(n + 1);
+        begin()[n++] = keep;
+      }
+
+      void RegExpChildren::push_front(reg_exp_t const & r)
+      {
+        reg_exp_t keep = r;
+        reserve(n + 1);
+        reg_exp_t * data = begin();
+        for(unsigned i = n; i > 0; i--)
+          data[i] = data[i-1];
+        data[0] = keep;
+        n++;
+      }
+
+      void RegExpChildren::insert(iterator pos, iterator first, iterator last)
+      {
+        assert(pos == end());
+        (void) pos;
+        // [first, last) belongs to another node, so growing is safe
+        reserve(n + (unsigned)(last - first));
+        reg_exp_t * data = begin();
+        for(; first != last; ++first)
+          data[n++] = *first;
+      }
+
       RegExpDag::RegExpDag()
       {
         currentSatProcess = 0;
@@ -22,6 +78,7 @@ namespace wali {
         executing_poststar = true;
         initialized = false;
         top_down_eval = true;
+        parallel_eval = false;
       }
 
       reg_exp_t RegExpDag::updatable(node_no_t nno, sem_elem_t se) 
@@ -41,14 +98,21 @@ namespace wali {
 #endif
               return updatable_nodes[nno];
             }
+            if(parallel_eval) {
+              // Neither updatable_nodes nor nodeArena may be changed by
+              // several threads. The nodes are all made when the edges of
+              // the IntraGraphs are added, before any saturation.
+              cerr << "RegExp: Error: cannot create updatable nodes while evaluating in parallel\n";
+              assert(0);
+            }
             for(size_t i = updatable_nodes.size(); i < nno; i++) {
               // These nodes are being created proactively. They aren't referenced in the 
               // graphs yet, so don't add them to roots.
-              RegExp * r = new RegExp(currentSatProcess, this, i,se->zero());
+              RegExp * r = new (nodeArena.get()) RegExp(currentSatProcess, this, i,se->zero());
               updatable_nodes.push_back(r);
             }
             // Create the desired updatable node, and add it to roots
-            reg_exp_t r = new RegExp(currentSatProcess, this, nno, se);
+            reg_exp_t r = new (nodeArena.get()) RegExp(currentSatProcess, this, nno, se);
 #if defined(PPP_DBG) && PPP_DBG >= 0
             reg_exp_key_t insKey(r->type, r);
             rootsInSatProcess.insert(insKey, r);
@@ -68,8 +132,12 @@ namespace wali {
           if(dirty)
             return;
           dirty = true;
-          for(wali::util::unordered_set<RegExp*>::iterator
-                pit = parents.begin(); pit != parents.end(); ++pit)
+          if(parents.first != 0)
+            parents.first->setDirty();
+          if(parents.rest == 0)
+            return;
+          for(RegExpParents::rest_t::iterator
+                pit = parents.rest->begin(); pit != parents.rest->end(); ++pit)
           {
             (*pit)->setDirty();
           }
@@ -88,26 +156,27 @@ namespace wali {
             assert(0);
           }
 
-          unsigned int &update_count = satProcesses[currentSatProcess].update_count;
+          unsigned int t = ++satProcesses[currentSatProcess].update_count;
           for(unsigned i = 0; i < nnos.size(); ++i){
             node_no_t nno = nnos[i];
             sem_elem_t se = ses[i];
             updatable(nno,se); // make sure that this node exists
             if(!updatable_nodes[nno]->value->equal(se)) {
 #ifdef DWPDS
-              updatable_nodes[nno]->delta[update_count+1] = se->diff(updatable_nodes[nno]->value);
+              updatable_nodes[nno]->aux().delta[t] = se->diff(updatable_nodes[nno]->value);
 #endif
               updatable_nodes[nno]->value = se;
-              updatable_nodes[nno]->last_change = update_count + 1;
-              updatable_nodes[nno]->last_seen = update_count + 1;
+              updatable_nodes[nno]->last_change = t;
+              updatable_nodes[nno]->last_seen = t;
 #if defined(PUSH_EVAL)
               updatable_nodes[nno]->setDirty();
 #endif
-              updatable_nodes[nno]->eval_map.clear();
-              updatable_nodes[nno]->updates.push_back(update_count);
+              updatable_nodes[nno]->clear_eval_map();
+#if defined(PPP_DBG) && PPP_DBG >= 0
+              updatable_nodes[nno]->aux().updates.push_back(t - 1);
+#endif
             }
           }
-          update_count = update_count + 1;
         }
 
         void RegExpDag::update(node_no_t nno, sem_elem_t se) {
@@ -119,19 +188,22 @@ namespace wali {
 
           updatable(nno,se); // make sure that this node exists
           if(!updatable_nodes[nno]->value->equal(se)) {
-            unsigned int &update_count = satProcesses[currentSatProcess].update_count;
-            updatable_nodes[nno]->updates.push_back(update_count);
+            // Each update gets its own count, even when several threads
+            // update (different) nodes at once
+            unsigned int t = ++satProcesses[currentSatProcess].update_count;
+#if defined(PPP_DBG) && PPP_DBG >= 0
+            updatable_nodes[nno]->aux().updates.push_back(t - 1);
+#endif
 #ifdef DWPDS
-            updatable_nodes[nno]->delta[update_count+1] = se->diff(updatable_nodes[nno]->value);
+            updatable_nodes[nno]->aux().delta[t] = se->diff(updatable_nodes[nno]->value);
 #endif
-            update_count = update_count + 1;
             updatable_nodes[nno]->value = se;
-            updatable_nodes[nno]->last_change = update_count;
-            updatable_nodes[nno]->last_seen = update_count;
+            updatable_nodes[nno]->last_change = t;
+            updatable_nodes[nno]->last_seen = t;
 #if defined(PUSH_EVAL)
             updatable_nodes[nno]->setDirty();
 #endif
-            updatable_nodes[nno]->eval_map.clear();
+            updatable_nodes[nno]->clear_eval_map();
             
           }
           //updates.push_back(nno);
@@ -162,7 +234,7 @@ namespace wali {
                     out << ")*";
                     break;
                 case Extend: {
-                                 list<reg_exp_t>::iterator it;
+                                 RegExpChildren::iterator it;
                                  it = children.begin();
                                  out << "(";
                                  (*it)->print(out) << ")";
@@ -174,7 +246,7 @@ namespace wali {
                                  break;
                              }
                 case Combine: {
-                                  list<reg_exp_t>::iterator it;
+                                  RegExpChildren::iterator it;
                                   it = children.begin();
                                   out << "(";
                                   (*it)->print(out) << ")";
@@ -197,8 +269,8 @@ namespace wali {
           long me;
           bool isZero = false, isOne = false;
           if(value != NULL){
-            isZero = value->equal(value->zero());
-            isOne = value->equal(value->one());
+            isZero = value->isZero();
+            isOne = value->isOne();
           }else{
             isZero = true;
           }
@@ -228,11 +300,13 @@ namespace wali {
               //me = hse(value); 
               me = updatable_node_no;
               //updates
-              if(printUpdates){
+#if defined(PPP_DBG) && PPP_DBG >= 0
+              if(printUpdates && aux_data != 0){
                 updatess << "updates: ";
-                for(vector<unsigned>::iterator it = updates.begin(); it != updates.end(); ++it)
+                for(vector<unsigned>::iterator it = aux_data->updates.begin(); it != aux_data->updates.end(); ++it)
                   updatess << *it << " ";
               }
+#endif
               if(seen.find(me) != seen.end())
                 return me;
               if(isRoot)
@@ -270,13 +344,15 @@ namespace wali {
 
           //evaluations
           stringstream evaluatess;
-          if(printUpdates){
+#if defined(PPP_DBG) && PPP_DBG >= 0
+          if(printUpdates && aux_data != 0){
             evaluatess << "evaluations: ";
-            for(vector<unsigned>::iterator it = evaluations.begin(); it != evaluations.end(); ++it)
+            for(vector<unsigned>::iterator it = aux_data->evaluations.begin(); it != aux_data->evaluations.end(); ++it)
               evaluatess << *it << " ";
           }
+#endif
 
-          for(list<reg_exp_t>::iterator it = children.begin(); it != children.end(); it++)
+          for(RegExpChildren::iterator it = children.begin(); it != children.end(); it++)
             others.push_back((*it)->toDot(out, seen, printUpdates));
           switch(type){
             case Constant:
@@ -349,10 +425,10 @@ namespace wali {
             }
 #ifndef REGEXP_CACHING
             reg_exp_t res;
-            if(r->type == Constant && r->value->equal(r->value->zero()))
-              res = new RegExp(currentSatProcess, this, r->value->one());
+            if(r->type == Constant && r->value->isZero())
+              res = new (nodeArena.get()) RegExp(currentSatProcess, this, r->value->one());
             else 
-              res = new RegExp(currentSatProcess, this, Star, r);
+              res = new (nodeArena.get()) RegExp(currentSatProcess, this, Star, r);
 #if defined(PPP_DBG) && PPP_DBG >= 0
             // Manipulate the set of root nodes.
             // remove r from roots.
@@ -366,16 +442,16 @@ namespace wali {
 #else // REGEXP_CACHING
 
             if(r->type == Constant) {
-                if(r->value->equal(r->value->one()) || r->value->equal(r->value->zero())) {
+                if(r->value->isOne() || r->value->isZero()) {
                     assert(r == reg_exp_one || r == reg_exp_zero);
                     return reg_exp_one;
                 }
             }
 
             reg_exp_key_t rkey(Star, r);
-            reg_exp_hash_t::iterator it = reg_exp_hash.find(rkey);
+            reg_exp_cons_hash_t::iterator it = reg_exp_hash.find(rkey);
             if(it == reg_exp_hash.end()) {
-                reg_exp_t res = new RegExp(currentSatProcess, this, Star, r);
+                reg_exp_t res = new (nodeArena.get()) RegExp(currentSatProcess, this, Star, r);
                 reg_exp_hash.insert(rkey, res);
 
 #if defined(PPP_DBG) && PPP_DBG >= 0
@@ -413,13 +489,13 @@ namespace wali {
         reg_exp_t RegExpDag::combine(reg_exp_t r1, reg_exp_t r2) {
             if(r1.get_ptr() == r2.get_ptr()) 
                 return r1;
-            if(r1->type == Constant && r1->value->equal(r1->value->zero())) {
+            if(r1->type == Constant && r1->value->isZero()) {
                 return r2;
-            } else if(r2->type == Constant && r2->value->equal(r2->value->zero())) {
+            } else if(r2->type == Constant && r2->value->isZero()) {
                 return r1;
             }
 #ifndef REGEXP_CACHING
-            reg_exp_t res = new RegExp(currentSatProcess, this, Combine, r1, r2);
+            reg_exp_t res = new (nodeArena.get()) RegExp(currentSatProcess, this, Combine, r1, r2);
 #if defined(PPP_DBG) && PPP_DBG >= 0
             // Manipulate the set of root nodes.
             // remove r1,r2 from roots.
@@ -434,7 +510,7 @@ namespace wali {
             return res;
 #else
             reg_exp_key_t rkey1(Combine, r1, r2);
-            reg_exp_hash_t::iterator it = reg_exp_hash.find(rkey1);
+            reg_exp_cons_hash_t::iterator it = reg_exp_hash.find(rkey1);
             if(it == reg_exp_hash.end()) {
                 STAT(stats.hashmap_misses++);
                 reg_exp_key_t rkey2(Combine, r2, r1);
@@ -442,7 +518,7 @@ namespace wali {
                 // NAK - fold this if underneath the upper one
                 //     - didn't make sense the other way.
                 if(it == reg_exp_hash.end()) {
-                    reg_exp_t res = new RegExp(currentSatProcess, this, Combine, r1, r2);
+                    reg_exp_t res = new (nodeArena.get()) RegExp(currentSatProcess, this, Combine, r1, r2);
                     reg_exp_hash.insert(rkey2, res);
 
 #if defined(PPP_DBG) && PPP_DBG >= 0
@@ -471,14 +547,14 @@ namespace wali {
                 r1 = r2;
                 r2 = tmp;
             }
-            if(r1->type == Constant && r1->value->equal(r1->value->zero())) {
+            if(r1->type == Constant && r1->value->isZero()) {
                 return r1;
-            } else if(r2->type == Constant && r2->value->equal(r2->value->zero())) {
+            } else if(r2->type == Constant && r2->value->isZero()) {
                 return r2;
             } 
 
 #ifndef REGEXP_CACHING
-            reg_exp_t res = new RegExp(currentSatProcess, this, Extend, r1, r2);
+            reg_exp_t res = new (nodeArena.get()) RegExp(currentSatProcess, this, Extend, r1, r2);
 #if defined(PPP_DBG) && PPP_DBG >= 0
             // Manipulate the set of root nodes.
             // remove r1,r2 from roots.
@@ -492,15 +568,15 @@ namespace wali {
 #endif
             return res;
 #else
-            if(r1->type == Constant && r1->value->equal(r1->value->one())) {
+            if(r1->type == Constant && r1->value->isOne()) {
                 return r2;
-            } else if(r2->type == Constant && r2->value->equal(r2->value->one())) {
+            } else if(r2->type == Constant && r2->value->isOne()) {
                 return r1;
             }
             reg_exp_key_t rkey(Extend, r1, r2);
-            reg_exp_hash_t::iterator it = reg_exp_hash.find(rkey);
+            reg_exp_cons_hash_t::iterator it = reg_exp_hash.find(rkey);
             if(it == reg_exp_hash.end()) {
-                reg_exp_t res = new RegExp(currentSatProcess, this, Extend, r1, r2);
+                reg_exp_t res = new (nodeArena.get()) RegExp(currentSatProcess, this, Extend, r1, r2);
                 reg_exp_hash.insert(rkey, res);
 
 #if defined(PPP_DBG) && PPP_DBG >= 0
@@ -523,22 +599,22 @@ namespace wali {
         }
 
         reg_exp_t RegExpDag::constant(sem_elem_t se) {
-            if(se->equal(se->zero()))
+            if(se->isZero())
                 return reg_exp_zero;
 #ifndef REGEXP_CACHING
-            reg_exp_t res = new RegExp(currentSatProcess, this, se);
+            reg_exp_t res = new (nodeArena.get()) RegExp(currentSatProcess, this, se);
 #if defined(PPP_DBG) && PPP_DBG >= 0
             reg_exp_key_t insKey(res->type, res);
             rootsInSatProcess.insert(insKey, res);
 #endif
             return res;
 #else
-            if(se->equal(se->one()))
+            if(se->isOne())
                 return reg_exp_one;
 
             const_reg_exp_hash_t::iterator it = const_reg_exp_hash.find(se);
             if(it == const_reg_exp_hash.end()) {
-                reg_exp_t res = new RegExp(currentSatProcess, this, se);
+                reg_exp_t res = new (nodeArena.get()) RegExp(currentSatProcess, this, se);
                 const_reg_exp_hash.insert(se, res);
 #if defined(PPP_DBG) && PPP_DBG >= 0
                 reg_exp_key_t insKey(res->type, res);
@@ -574,9 +650,9 @@ namespace wali {
           graphLabelsInSatProcess.clear();
           updatable_nodes.clear();
          
-          reg_exp_zero = new RegExp(currentSatProcess, this, se->zero());
+          reg_exp_zero = new (nodeArena.get()) RegExp(currentSatProcess, this, se->zero());
           reg_exp_key_t insZeroKey(reg_exp_zero->type, reg_exp_zero);
-          reg_exp_one = new RegExp(currentSatProcess, this, se->one());
+          reg_exp_one = new (nodeArena.get()) RegExp(currentSatProcess, this, se->one());
           reg_exp_key_t insOneKey(reg_exp_one->type, reg_exp_one);
 #if defined(PPP_DBG) && PPP_DBG >= 0
           rootsInSatProcess.insert(insZeroKey, reg_exp_zero);
@@ -649,18 +725,18 @@ namespace wali {
             }
 
             if(r->type == Updatable) {
-                r->outnodes.insert(r->updatable_node_no);
+                r->aux().outnodes.insert(r->updatable_node_no);
                 return r;
             }
 
             if(r->type == Star || r->type == Combine) {
-                reg_exp_t res = new RegExp(currentSatProcess, this, r->value->zero());
+                reg_exp_t res = new (nodeArena.get()) RegExp(currentSatProcess, this, r->value->zero());
 
-                list<reg_exp_t>::iterator it;
+                RegExpChildren::iterator it;
                 for(it = r->children.begin(); it != r->children.end(); it++) {
                     reg_exp_t temp = minimize_height(*it, cache);
                     res->children.push_back(temp);
-                    my_set_union(res->outnodes, temp->outnodes);
+                    my_set_union(res->aux().outnodes, temp->aux().outnodes);
                 }
 
                 res->type = r->type;
@@ -675,12 +751,12 @@ namespace wali {
             // Now r->type == Extend
 #define MINIMIZE_HEIGHT 2
 #if MINIMIZE_HEIGHT==1 // Commutative Huffman-style tree
-            list<reg_exp_t>::iterator it;
+            RegExpChildren::iterator it;
             multiset< heap_t, cmp_heap_t > heap;
 
             for(it = r->children.begin(); it != r->children.end(); it++) {
                 reg_exp_t temp = minimize_height(*it, cache);
-                heap.insert(heap_t(temp->outnodes.size(), temp));
+                heap.insert(heap_t(temp->aux().outnodes.size(), temp));
             }
 
             while(heap.size() != 1) {
@@ -689,40 +765,41 @@ namespace wali {
                 heap_t e2 = *heap.begin();
                 heap.erase(heap.begin());
 
-                reg_exp_t res = new RegExp(currentSatProcess, this, Extend, e1.second, e2.second);
+                reg_exp_t res = new (nodeArena.get()) RegExp(currentSatProcess, this, Extend, e1.second, e2.second);
                 res->value = r->value;
                 res->last_seen = r->last_seen;
                 res->last_change = r->last_change;
-                my_set_union(res->outnodes, e1.second->outnodes);
-                my_set_union(res->outnodes, e2.second->outnodes);
+                my_set_union(res->aux().outnodes, e1.second->aux().outnodes);
+                my_set_union(res->aux().outnodes, e2.second->aux().outnodes);
 
-                heap.insert(heap_t(e1.second->outnodes.size() + e2.second->outnodes.size(), res));
+                heap.insert(heap_t(e1.second->aux().outnodes.size() + e2.second->aux().outnodes.size(), res));
             }
 
             reg_exp_t ans = (*heap.begin()).second;
 #elif MINIMIZE_HEIGHT==2 // Non-Commutative Huffman-style tree
             list<reg_exp_t>::iterator it;
+            RegExpChildren::iterator cit;
             list<reg_exp_t> heap;
 
-            for(it = r->children.begin(); it != r->children.end(); it++) {
-                reg_exp_t temp = minimize_height(*it, cache);
+            for(cit = r->children.begin(); cit != r->children.end(); cit++) {
+                reg_exp_t temp = minimize_height(*cit, cache);
                 heap.push_back(temp);
             }
 
             while(heap.size() != 1) {
                 list<reg_exp_t>::iterator min_pos = heap.begin(), next_it;
-                size_t min = (*min_pos)->outnodes.size();
+                size_t min = (*min_pos)->aux().outnodes.size();
                 it = heap.begin();
                 it++;
-                min += (*it)->outnodes.size();
+                min += (*it)->aux().outnodes.size();
                 for(; it != heap.end(); it++) {
                     next_it = it;
                     next_it++;
                     if(next_it == heap.end())
                         break;
-                    if( (*it)->outnodes.size() + (*next_it)->outnodes.size() < min) {
+                    if( (*it)->aux().outnodes.size() + (*next_it)->aux().outnodes.size() < min) {
                         min_pos = it;
-                        min = (*it)->outnodes.size() + (*next_it)->outnodes.size();
+                        min = (*it)->aux().outnodes.size() + (*next_it)->aux().outnodes.size();
                     }
                 }
                 next_it = min_pos; next_it++;
@@ -733,12 +810,12 @@ namespace wali {
                 heap.erase(min_pos);
                 min_pos = next_it;
 
-                reg_exp_t res = new RegExp(currentSatProcess, this, Extend, r1, r2);
+                reg_exp_t res = new (nodeArena.get()) RegExp(currentSatProcess, this, Extend, r1, r2);
                 res->value = r->value;
                 res->last_seen = r->last_seen;
                 res->last_change = r->last_change;
-                my_set_union(res->outnodes, r1->outnodes);
-                my_set_union(res->outnodes, r2->outnodes);
+                my_set_union(res->aux().outnodes, r1->aux().outnodes);
+                my_set_union(res->aux().outnodes, r2->aux().outnodes);
 
                 heap.insert(min_pos,res);
             }
@@ -750,8 +827,8 @@ namespace wali {
             list<reg_exp_t> *list2 = new list<reg_exp_t>;
             list<reg_exp_t> *temp;
 
-            for(it = r->children.begin(); it != r->children.end(); it++) {
-                reg_exp_t temp = minimize_height(*it, cache);
+            for(RegExpChildren::iterator cit = r->children.begin(); cit != r->children.end(); cit++) {
+                reg_exp_t temp = minimize_height(*cit, cache);
                 list1->push_back(temp);
             }
             while(list1->size() != 1) {
@@ -761,7 +838,7 @@ namespace wali {
                         list2->push_back(*it);
                     } else {
                         reg_exp_t r1 = *it, r2 = *next_it;
-                        reg_exp_t res = new RegExp(currentSatProcess, this, Extend, r1, r2);
+                        reg_exp_t res = new (nodeArena.get()) RegExp(currentSatProcess, this, Extend, r1, r2);
                         res->value = r->value;
                         res->last_seen = r->last_seen;
                         res->last_change = r->last_change;
@@ -814,7 +891,7 @@ namespace wali {
                     cache[r] = ch;
                     return ch;
                 }
-                reg_exp_t res = new RegExp(currentSatProcess, this, Star,ch);
+                reg_exp_t res = new (nodeArena.get()) RegExp(currentSatProcess, this, Star,ch);
                 res->last_seen = r->last_seen;
                 res->last_change = r->last_change;
                 res->value = r->value;
@@ -824,7 +901,7 @@ namespace wali {
             reg_exp_t res;
             if(r->type == Extend) {
                 assert(r->children.size() == 2);
-                list<reg_exp_t>::iterator it = r->children.begin();
+                RegExpChildren::iterator it = r->children.begin();
                 reg_exp_t r1 = *it;
                 it++;
                 reg_exp_t r2 = *it;
@@ -832,7 +909,7 @@ namespace wali {
                 r2 = compress(r2, cache);
                 res = compressExtend(r1,r2);
             } else if(r->type == Combine) {
-                list<reg_exp_t>::iterator it = r->children.begin();
+                RegExpChildren::iterator it = r->children.begin();
                 reg_exp_t r1 = *it;
                 it++;
                 reg_exp_t r2 = *it;
@@ -858,11 +935,11 @@ namespace wali {
             }
 
             if(r1->type == Constant && r2->type == Constant) {
-                reg_exp_t res = new RegExp(currentSatProcess, this, r1->value->combine(r2->value));
+                reg_exp_t res = new (nodeArena.get()) RegExp(currentSatProcess, this, r1->value->combine(r2->value));
                 STAT(stats.ncombine++);
                 return res;
             }
-            reg_exp_t res = new RegExp(currentSatProcess, this, r1->value->zero());
+            reg_exp_t res = new (nodeArena.get()) RegExp(currentSatProcess, this, r1->value->zero());
             res->type = Combine;
 
             if(r1->type == Combine && r2->type == Combine) {
@@ -870,15 +947,15 @@ namespace wali {
                 reg_exp_t fc1 = r1->children.front();
                 reg_exp_t fc2 = r2->children.front();
                 if(fc1->type == Constant && fc2->type == Constant) {
-                    reg_exp_t fc = new RegExp(currentSatProcess, this, fc1->value->combine(fc2->value));
+                    reg_exp_t fc = new (nodeArena.get()) RegExp(currentSatProcess, this, fc1->value->combine(fc2->value));
                     STAT(stats.ncombine++);
                     res->children.push_back(fc);
-                    res->children.insert(res->children.end(), ++r1->children.begin(), r1->children.end());
-                    res->children.insert(res->children.end(), ++r2->children.begin(), r2->children.end());
+                    res->children.insert(res->children.end(), r1->children.begin() + 1, r1->children.end());
+                    res->children.insert(res->children.end(), r2->children.begin() + 1, r2->children.end());
                 } else if(fc2->type == Constant) {
                     res->children.push_back(fc2);
                     res->children.insert(res->children.end(), r1->children.begin(), r1->children.end());
-                    res->children.insert(res->children.end(), ++r2->children.begin(), r2->children.end());
+                    res->children.insert(res->children.end(), r2->children.begin() + 1, r2->children.end());
                 } else {
                     res->children.insert(res->children.end(), r1->children.begin(), r1->children.end());
                     res->children.insert(res->children.end(), r2->children.begin(), r2->children.end());
@@ -889,10 +966,10 @@ namespace wali {
 
                 reg_exp_t fc2 = r2->children.front();
                 if(fc2->type == Constant) {
-                    reg_exp_t fc = new RegExp(currentSatProcess, this, fc2->value->combine(r1->value));
+                    reg_exp_t fc = new (nodeArena.get()) RegExp(currentSatProcess, this, fc2->value->combine(r1->value));
                     STAT(stats.ncombine++);
                     res->children.push_back(fc);
-                    res->children.insert(res->children.end(), ++r2->children.begin(), r2->children.end());
+                    res->children.insert(res->children.end(), r2->children.begin() + 1, r2->children.end());
                     return res;
                 }
             }
@@ -900,10 +977,10 @@ namespace wali {
 
                 reg_exp_t fc1 = r1->children.front();
                 if(fc1->type == Constant) {
-                    reg_exp_t fc = new RegExp(currentSatProcess, this, fc1->value->combine(r2->value));
+                    reg_exp_t fc = new (nodeArena.get()) RegExp(currentSatProcess, this, fc1->value->combine(r2->value));
                     STAT(stats.ncombine++);
                     res->children.push_back(fc);
-                    res->children.insert(res->children.end(), ++r1->children.begin(), r1->children.end());
+                    res->children.insert(res->children.end(), r1->children.begin() + 1, r1->children.end());
                     return res;
                 }
             }
@@ -930,11 +1007,11 @@ namespace wali {
         reg_exp_t RegExpDag::compressExtend(reg_exp_t r1, reg_exp_t r2) {
 #ifndef COMMUTATIVE_EXTEND
             if(r1->type == Constant && r2->type == Constant) {
-                reg_exp_t res = new RegExp(currentSatProcess, this, r1->value->extend(r2->value));
+                reg_exp_t res = new (nodeArena.get()) RegExp(currentSatProcess, this, r1->value->extend(r2->value));
                 STAT(stats.nextend++);
                 return res;
             }
-            reg_exp_t res = new RegExp(currentSatProcess, this, r1->value->zero());
+            reg_exp_t res = new (nodeArena.get()) RegExp(currentSatProcess, this, r1->value->zero());
             res->type = Extend;
 
             if(r1->type == Extend && r2->type == Extend) {
@@ -942,11 +1019,11 @@ namespace wali {
                 reg_exp_t lc = r1->children.back();
                 reg_exp_t fc = r2->children.front();
                 if(lc->type == Constant && fc->type == Constant) {
-                    reg_exp_t mc = new RegExp(currentSatProcess, this, lc->value->extend(fc->value));
+                    reg_exp_t mc = new (nodeArena.get()) RegExp(currentSatProcess, this, lc->value->extend(fc->value));
                     STAT(stats.nextend++);
-                    res->children.insert(res->children.end(), r1->children.begin(), --r1->children.end());
+                    res->children.insert(res->children.end(), r1->children.begin(), r1->children.end() - 1);
                     res->children.push_back(mc);
-                    res->children.insert(res->children.end(), ++r2->children.begin(), r2->children.end());
+                    res->children.insert(res->children.end(), r2->children.begin() + 1, r2->children.end());
                 } else {
                     res->children.insert(res->children.end(), r1->children.begin(), r1->children.end());
                     res->children.insert(res->children.end(), r2->children.begin(), r2->children.end());
@@ -957,19 +1034,19 @@ namespace wali {
             if(r1->type == Constant && r2->type == Extend) {
                 reg_exp_t fc = r2->children.front();
                 if(fc->type == Constant) {
-                    reg_exp_t f = new RegExp(currentSatProcess, this, r1->value->extend(fc->value));
+                    reg_exp_t f = new (nodeArena.get()) RegExp(currentSatProcess, this, r1->value->extend(fc->value));
                     STAT(stats.nextend++);
                     res->children.push_back(f);
-                    res->children.insert(res->children.end(), ++r2->children.begin(), r2->children.end());
+                    res->children.insert(res->children.end(), r2->children.begin() + 1, r2->children.end());
                     return res;
                 }
             }
             if(r1->type == Extend && r2->type == Constant) {
                 reg_exp_t lc = r1->children.back();
                 if(lc->type == Constant) {
-                    reg_exp_t l = new RegExp(currentSatProcess, this, lc->value->extend(r2->value));
+                    reg_exp_t l = new (nodeArena.get()) RegExp(currentSatProcess, this, lc->value->extend(r2->value));
                     STAT(stats.nextend++);
-                    res->children.insert(res->children.end(), r1->children.begin(), --r1->children.end());
+                    res->children.insert(res->children.end(), r1->children.begin(), r1->children.end() - 1);
                     res->children.push_back(l);
                     return res;
                 }
@@ -990,11 +1067,11 @@ namespace wali {
 #else // COMMUTATIVE_EXTEND
 
             if(r1->type == Constant && r2->type == Constant) {
-                reg_exp_t res = new RegExp(currentSatProcess, this, r1->value->extend(r2->value));
+                reg_exp_t res = new (nodeArena.get()) RegExp(currentSatProcess, this, r1->value->extend(r2->value));
                 STAT(stats.nextend++);
                 return res;
             }
-            reg_exp_t res = new RegExp(currentSatProcess, this, r1->value->zero());
+            reg_exp_t res = new (nodeArena.get()) RegExp(currentSatProcess, this, r1->value->zero());
             res->type = Extend;
 
             if(r1->type == Extend && r2->type == Extend) {
@@ -1002,15 +1079,15 @@ namespace wali {
                 reg_exp_t fc1 = r1->children.front();
                 reg_exp_t fc2 = r2->children.front();
                 if(fc1->type == Constant && fc2->type == Constant) {
-                    reg_exp_t fc = new RegExp(currentSatProcess, this, fc1->value->extend(fc2->value));
+                    reg_exp_t fc = new (nodeArena.get()) RegExp(currentSatProcess, this, fc1->value->extend(fc2->value));
                     STAT(stats.nextend++);
                     res->children.push_back(fc);
-                    res->children.insert(res->children.end(), ++r1->children.begin(), r1->children.end());
-                    res->children.insert(res->children.end(), ++r2->children.begin(), r2->children.end());
+                    res->children.insert(res->children.end(), r1->children.begin() + 1, r1->children.end());
+                    res->children.insert(res->children.end(), r2->children.begin() + 1, r2->children.end());
                 } else if(fc2->type == Constant) {
                     res->children.push_back(fc2);
                     res->children.insert(res->children.end(), r1->children.begin(), r1->children.end());
-                    res->children.insert(res->children.end(), ++r2->children.begin(), r2->children.end());
+                    res->children.insert(res->children.end(), r2->children.begin() + 1, r2->children.end());
                 } else {
                     res->children.insert(res->children.end(), r1->children.begin(), r1->children.end());
                     res->children.insert(res->children.end(), r2->children.begin(), r2->children.end());
@@ -1021,10 +1098,10 @@ namespace wali {
 
                 reg_exp_t fc2 = r2->children.front();
                 if(fc2->type == Constant) {
-                    reg_exp_t fc = new RegExp(currentSatProcess, this, fc2->value->extend(r1->value));
+                    reg_exp_t fc = new (nodeArena.get()) RegExp(currentSatProcess, this, fc2->value->extend(r1->value));
                     STAT(stats.nextend++);
                     res->children.push_back(fc);
-                    res->children.insert(res->children.end(), ++r2->children.begin(), r2->children.end());
+                    res->children.insert(res->children.end(), r2->children.begin() + 1, r2->children.end());
                     return res;
                 }
             }
@@ -1032,10 +1109,10 @@ namespace wali {
 
                 reg_exp_t fc1 = r1->children.front();
                 if(fc1->type == Constant) {
-                    reg_exp_t fc = new RegExp(currentSatProcess, this, fc1->value->extend(r2->value));
+                    reg_exp_t fc = new (nodeArena.get()) RegExp(currentSatProcess, this, fc1->value->extend(r2->value));
                     STAT(stats.nextend++);
                     res->children.push_back(fc);
-                    res->children.insert(res->children.end(), ++r1->children.begin(), r1->children.end());
+                    res->children.insert(res->children.end(), r1->children.begin() + 1, r1->children.end());
                     return res;
                 }
             }
@@ -1065,7 +1142,7 @@ namespace wali {
         int RegExp::calculate_height(set<RegExp *> &visited, out_node_stat_t &stat_map) {
             assert(stat_map.size() == 0);
             if(visited.find(this) != visited.end()) {
-                stat_map = outnode_height;
+                stat_map = aux().outnode_height;
                 out_node_stat_t::iterator it;
                 for(it = stat_map.begin(); it != stat_map.end(); it++) {
                     it->second = out_node_height_t(0,0); // reset value because visited=true
@@ -1082,7 +1159,7 @@ namespace wali {
                     break;
                 case Star: {
                                assert(children.size() == 1);
-                               list<reg_exp_t>::iterator ch = children.begin();
+                               RegExpChildren::iterator ch = children.begin();
                                out_node_stat_t stat_map_ch;
                                changestat += (*ch)->calculate_height(visited,stat_map_ch);
                                out_node_stat_t::iterator it;
@@ -1092,7 +1169,7 @@ namespace wali {
                                break;
                            }
                 case Extend: {
-                                 list<reg_exp_t>::iterator ch;
+                                 RegExpChildren::iterator ch;
                                  for(ch = children.begin(); ch != children.end(); ch++) {
                                      out_node_stat_t stat_map_ch;
                                      changestat += (*ch)->calculate_height(visited,stat_map_ch);
@@ -1109,7 +1186,7 @@ namespace wali {
                                  break;
                              }
                 case Combine: {
-                                  list<reg_exp_t>::iterator ch;
+                                  RegExpChildren::iterator ch;
                                   for(ch = children.begin(); ch != children.end(); ch++) {
                                       out_node_stat_t stat_map_ch;
                                       changestat += (*ch)->calculate_height(visited,stat_map_ch);
@@ -1126,7 +1203,7 @@ namespace wali {
                                   break;
                               }
             }
-            outnode_height = stat_map;
+            aux().outnode_height = stat_map;
             return changestat;
         }
 
@@ -1155,7 +1232,7 @@ namespace wali {
           if(visited.find(ekey) != visited.end())
             return;
           visited.insert(ekey, r);
-          for(list<reg_exp_t>::iterator it = r->children.begin(); it != r->children.end(); ++it)
+          for(RegExpChildren::iterator it = r->children.begin(); it != r->children.end(); ++it)
             markReachable(*it);
         }
 
@@ -1166,7 +1243,7 @@ namespace wali {
           // IntraGraph in one or more steps.
           for(reg_exp_hash_t::iterator it = graphLabelsInSatProcess.begin(); it != graphLabelsInSatProcess.end(); ++it){
             reg_exp_t root = it->second;
-            for(list<reg_exp_t>::iterator cit = root->children.begin(); cit != root->children.end(); ++cit){
+            for(RegExpChildren::iterator cit = root->children.begin(); cit != root->children.end(); ++cit){
               reg_exp_t child = *cit;
               markReachable(child);
             }
@@ -1208,7 +1285,7 @@ namespace wali {
 #if defined(PUSH_EVAL)
           assert(0 && "evaluate_iteratively not implemented for PUSH_EVAL mode");
 #endif
-          typedef list<reg_exp_t>::iterator iter_t;
+          typedef RegExpChildren::iterator iter_t;
           typedef pair<reg_exp_t, iter_t > stack_el;
 
           if(last_seen == dag->satProcesses[satProcess].update_count)
@@ -1250,7 +1327,7 @@ namespace wali {
                              break;
                            }
                 case Extend: {
-                               list<reg_exp_t>::iterator ch;
+                               RegExpChildren::iterator ch;
                                sem_elem_t wnew = re->value->one();
                                bool changed = false;
                                unsigned max = re->last_change;
@@ -1272,7 +1349,7 @@ namespace wali {
                                break;
                              }
                 case Combine: {
-                                list<reg_exp_t>::iterator ch;
+                                RegExpChildren::iterator ch;
                                 sem_elem_t wnew = re->value;
                                 unsigned max = re->last_change;
                                 for(ch = re->children.begin(); ch != re->children.end(); ch++) {
@@ -1304,34 +1381,35 @@ namespace wali {
           sem_elem_t ret;
 #if defined(PUSH_EVAL)
           if(dirty){
-            eval_map.clear();
+            clear_eval_map();
             dirty = false;
           }else{
-            it = eval_map.find(w);
-            if(it != eval_map.end()){
+            it = aux().eval_map.find(w);
+            if(it != aux().eval_map.end()){
               return it->second;
             }
           }
 #else
           if(last_seen == dag->satProcesses[satProcess].update_count) {
-            it = eval_map.find(w);
-            if(it != eval_map.end()) {
+            it = aux().eval_map.find(w);
+            if(it != aux().eval_map.end()) {
               return it->second;
             } else { 
 #if 0
               if(false && last_change != (unsigned)-1) {// "value" is available
                 ret = w->extend(value);
-                eval_map[w] = ret;
+                aux().eval_map[w] = ret;
                 return ret;
               }
 #endif
             }
           } else {
-            eval_map.clear();
+            clear_eval_map();
           }
 #endif //#if defined(PUSH_EVAL)
-          unsigned int &update_count = dag->satProcesses[dag->currentSatProcess].update_count;
-          evaluations.push_back(update_count);
+#if defined(PPP_DBG) && PPP_DBG >= 0
+          aux().evaluations.push_back(dag->satProcesses[dag->currentSatProcess].update_count);
+#endif
           switch(type) {
             case Constant:
             case Updatable:
@@ -1361,7 +1439,7 @@ namespace wali {
                          break;
                        }
             case Extend: {
-                           list<reg_exp_t>::iterator ch;
+                           RegExpChildren::iterator ch;
                            sem_elem_t temp = w;
                            for(ch = children.begin(); ch != children.end(); ch++) {
                              temp = (*ch)->evaluate(temp);
@@ -1370,7 +1448,7 @@ namespace wali {
                            break;
                          }
             case Combine: {
-                            list<reg_exp_t>::iterator ch;
+                            RegExpChildren::iterator ch;
                             sem_elem_t temp = w->zero();
                             for(ch = children.begin(); ch != children.end(); ch++) {
                               temp = temp->combine((*ch)->evaluate(w));
@@ -1380,7 +1458,7 @@ namespace wali {
                             break;
                           }
           }
-          eval_map[w] = ret;
+          aux().eval_map[w] = ret;
           last_seen = dag->satProcesses[satProcess].update_count; last_change = (unsigned)-1;
           return ret;
         }
@@ -1391,24 +1469,25 @@ namespace wali {
           sem_elem_t ret;
 
           if(last_seen == dag->satProcesses[satProcess].update_count) {
-            it = eval_map.find(w);
-            if(it != eval_map.end()) {
+            it = aux().eval_map.find(w);
+            if(it != aux().eval_map.end()) {
               return it->second;
             } else { 
 #if 0
               if(false && last_change != (unsigned)-1) {// "value" is available
                 ret = w->extend(value);
-                eval_map[w] = ret;
+                aux().eval_map[w] = ret;
                 return ret;
               }
 #endif
             }
           } else {
-            eval_map.clear();
+            clear_eval_map();
           }
 
-          unsigned int &update_count = dag->satProcesses[dag->currentSatProcess].update_count;
-          evaluations.push_back(update_count);
+#if defined(PPP_DBG) && PPP_DBG >= 0
+          aux().evaluations.push_back(dag->satProcesses[dag->currentSatProcess].update_count);
+#endif
           switch(type) {
             case Constant:
             case Updatable:
@@ -1429,7 +1508,7 @@ namespace wali {
                          break;
                        }
             case Extend: {
-                           list<reg_exp_t>::reverse_iterator ch;
+                           RegExpChildren::reverse_iterator ch;
                            sem_elem_t temp = w;
                            for(ch = children.rbegin(); ch != children.rend(); ch++) {
                              temp = (*ch)->evaluateRev(temp);
@@ -1438,7 +1517,7 @@ namespace wali {
                            break;
                          }
             case Combine: {
-                            list<reg_exp_t>::iterator ch;
+                            RegExpChildren::iterator ch;
                             sem_elem_t temp = w->zero();
                             for(ch = children.begin(); ch != children.end(); ch++) {
                               temp = temp->combine((*ch)->evaluateRev(w));
@@ -1448,7 +1527,7 @@ namespace wali {
                               break;
                           }
         }
-        eval_map[w] = ret;
+        aux().eval_map[w] = ret;
         last_seen = dag->satProcesses[satProcess].update_count; last_change = (unsigned)-1;
         return ret;
     }
@@ -1463,13 +1542,16 @@ namespace wali {
             }
 
         }
-        delta_map_t::iterator it = delta.upper_bound(ls);
         sem_elem_t del = value->zero();
-        if(it == delta.end()) {
+        if(aux_data == 0) {
+            return del;
+        }
+        delta_map_t::iterator it = aux_data->delta.upper_bound(ls);
+        if(it == aux_data->delta.end()) {
             return del;
         }
         //int cnt=0;
-        while(it != delta.end()) {
+        while(it != aux_data->delta.end()) {
             del = del->combine(it->second);
             it++;
             //cnt++;
@@ -1482,6 +1564,11 @@ namespace wali {
 #endif
 
     sem_elem_t RegExp::get_weight() {
+        if(dag->parallel_eval) {
+            // Only evaluate() may look at a node other threads can see
+            evaluate();
+            return value;
+        }
         if(last_seen == dag->satProcesses[satProcess].update_count && last_change != (unsigned)-1)  // evaluate(w) sets last_change to -1
             return value;
 
@@ -1501,28 +1588,63 @@ namespace wali {
 #endif
     }
 
+    namespace {
+        // Holds a RegExp's busy flag
+        class EvalLock {
+            public:
+                explicit EvalLock(std::atomic<bool> &b) : busy(b) {
+                    while(busy.exchange(true, std::memory_order_acquire))
+                        std::this_thread::yield();
+                }
+                ~EvalLock() {
+                    busy.store(false, std::memory_order_release);
+                }
+            private:
+                std::atomic<bool> &busy;
+        };
+    }
+
     void RegExp::evaluate() {
+        if(!dag->parallel_eval) {
+            evaluateNode();
+            return;
+        }
+        // A thread holds the locks of a node's ancestors while it waits
+        // for the node, and the dag has no cycles, so this cannot deadlock
+        EvalLock lock(busy);
+        evaluateNode();
+    }
+
+    void RegExp::evaluateNode() {
+        // Other threads may bump the count while this node is evaluated,
+        // but not for any node below it
+        unsigned int const now = dag->satProcesses[satProcess].update_count;
 #if defined(PUSH_EVAL)
         if(!dirty){
-          last_seen = dag->satProcesses[satProcess].update_count;
+          last_seen = now;
           return;
         }
 #endif
-        if(last_seen == dag->satProcesses[satProcess].update_count) return;
-        unsigned int &update_count = dag->satProcesses[dag->currentSatProcess].update_count;
-        evaluations.push_back(update_count);
+        if(last_seen == now) return;
+#if defined(PPP_DBG) && PPP_DBG >= 0
+        aux().evaluations.push_back(dag->satProcesses[dag->currentSatProcess].update_count);
+#endif
         nevals++;
         switch(type) {
             case Constant: 
             case Updatable: 
+#if defined(PUSH_EVAL)
+                // Clean, so that the next update marks the parents dirty
+                dirty = false;
+#endif
                 return;
             case Star: {
-                           reg_exp_t ch = children.front();
+                           RegExp *ch = children.front().get_ptr();
                            ch->evaluate();
                            if(ch->last_change > last_seen) { // child did not change
 #ifdef DWPDS
                                sem_elem_t w = value->one(),del = value->one(),temp;
-                               while(!del->equal(value->zero())) {
+                               while(!del->isZero()) {
                                    temp = del->extend(ch->value);
                                    del = temp->diff(w);
                                    w = w->combine(temp);
@@ -1530,22 +1652,22 @@ namespace wali {
 #else
                                sem_elem_t w = ch->value->star();
 #endif
-                               STAT(dag->stats.nstar++);
+                               STAT(dag->eval_stats().nstar++);
 
                                if(!value->equal(w)) {
                                    last_change = ch->last_change;
 #ifdef DWPDS
                                    sem_elem_t dval = w->diff(value);
-                                   delta[last_change] = dval;
+                                   aux().delta[last_change] = dval;
 #endif
                                    value = w;
                                }
                            }
-                           last_seen = dag->satProcesses[satProcess].update_count;
+                           last_seen = now;
                            break;
                        }
             case Combine: {
-                              list<reg_exp_t>::iterator ch;
+                              RegExpChildren::iterator ch;
                               sem_elem_t wnew = value;
                               sem_elem_t wchange = value->zero();
                               unsigned max = last_change;
@@ -1558,7 +1680,7 @@ namespace wali {
                                       wchange = wchange->combine((*ch)->value);
 #endif
                                       max = ((*ch)->last_change > max) ? (*ch)->last_change : max;
-                                      STAT(dag->stats.ncombine++);
+                                      STAT(dag->eval_stats().ncombine++);
                                   }
                               }
                               wnew = wnew->combine(wchange);
@@ -1567,15 +1689,15 @@ namespace wali {
                                   last_change = max;
 #ifdef DWPDS
                                   sem_elem_t dval = wchange->diff(value);
-                                  delta[last_change] = dval; // wchange->diff(value)
+                                  aux().delta[last_change] = dval; // wchange->diff(value)
 #endif
                                   value = wnew;
                               }
-                              last_seen = dag->satProcesses[satProcess].update_count;
+                              last_seen = now;
                               break;
                           }
             case Extend: {
-                             list<reg_exp_t>::iterator ch;
+                             RegExpChildren::iterator ch;
                              sem_elem_t wnew;
                              bool changed = false;
                              unsigned max = last_change;
@@ -1588,7 +1710,7 @@ namespace wali {
                                 cnt *= 2;
                                 }
                                 */
-                             list<reg_exp_t>::reverse_iterator rch;
+                             RegExpChildren::reverse_iterator rch;
                              for(rch = children.rbegin(); rch != children.rend(); rch++) {
                                  (*rch)->evaluate();
                                  changed = changed | ((*rch)->last_change > last_seen);
@@ -1603,7 +1725,7 @@ namespace wali {
 
                              if(changed) {
 #ifdef DWPDS
-                                 list<reg_exp_t>::iterator sel;
+                                 RegExpChildren::iterator sel;
                                  sem_elem_t del;
                                  wnew = value->zero();
                                  for(sel = children.begin(); sel != children.end(); sel++) {
@@ -1625,23 +1747,23 @@ namespace wali {
                                  for(ch = children.begin(); ch != children.end(); ch++) {
                                      wnew = wnew->extend( (*ch)->value);
                                      max = ((*ch)->last_change > max) ? (*ch)->last_change : max;    
-                                     STAT(dag->stats.nextend++);
+                                     STAT(dag->eval_stats().nextend++);
                                  }
 #endif
                                  if(!value->equal(wnew)) {
                                      last_change = max;
 #ifdef DWPDS
-                                     delta[last_change] = wnew->diff(value); // del;
+                                     aux().delta[last_change] = wnew->diff(value); // del;
 #endif
                                      value = wnew;
                                  }
                              }
-                             last_seen = dag->satProcesses[satProcess].update_count;
+                             last_seen = now;
                              break;
                          }
         }
         last_change = (last_change > 1) ? last_change : 1;
-        assert(last_seen == dag->satProcesses[satProcess].update_count);
+        assert(last_seen == now);
 #if defined(PUSH_EVAL)
         dirty = false;
 #endif 
@@ -1680,7 +1802,7 @@ namespace wali {
         if(uptodate) {
             return value;
         }
-        list<reg_exp_t>::iterator it = children.begin();
+        RegExpChildren::iterator it = children.begin();
         for(; it != children.end(); it++) {
             (*it)->reevaluateIter();
         }
@@ -1720,7 +1842,7 @@ namespace wali {
             return false;
         }
         gray.insert(this);
-        list<reg_exp_t>::iterator ch = children.begin();
+        RegExpChildren::iterator ch = children.begin();
         for(; ch != children.end(); ch++) {
             set<RegExp *>::iterator it = gray.find((*ch).get_ptr());
             if(it != gray.end()) { // cycle
@@ -1824,7 +1946,7 @@ namespace wali {
         return 0;
       visited.insert(ekey, e);
       long total = 0;
-      for(list<reg_exp_t>::iterator cit = e->children.begin(); cit != e->children.end(); ++cit)
+      for(RegExpChildren::iterator cit = e->children.begin(); cit != e->children.end(); ++cit)
         total += countLabels(*cit);
       if(graphLabelsAcrossSatProcesses.find(ekey) != graphLabelsAcrossSatProcesses.end())
         total += 1;
@@ -1854,7 +1976,7 @@ namespace wali {
       if(e->children.size() == 0){
         max = 1;
       }else{
-        for(list<reg_exp_t>::iterator cit = e->children.begin(); cit != e->children.end(); ++cit){
+        for(RegExpChildren::iterator cit = e->children.begin(); cit != e->children.end(); ++cit){
           long cur = getHeight(*cit);
           max = cur > max ? cur : max;
         }
@@ -1886,7 +2008,7 @@ namespace wali {
       }
       visited.insert(ekey, e);
       bool onSpline = false;
-      for(list<reg_exp_t>::iterator cit = e->children.begin(); cit != e->children.end(); ++cit)
+      for(RegExpChildren::iterator cit = e->children.begin(); cit != e->children.end(); ++cit)
         onSpline |= markSpline(*cit);
       if(e->type == Updatable)
        onSpline = true; 
@@ -1916,7 +2038,7 @@ namespace wali {
       if(it == spline.end())
         return 0;
       long count = 0;
-      for(list<reg_exp_t>::iterator cit = e->children.begin(); cit != e->children.end(); ++cit){
+      for(RegExpChildren::iterator cit = e->children.begin(); cit != e->children.end(); ++cit){
         reg_exp_key_t ckey((*cit)->type, *cit);
         if(spline.find(ckey) != spline.end()){
           count += countFrontier(*cit);
@@ -1949,7 +2071,7 @@ namespace wali {
       if(e->children.size() == 0)
         return 1;
       long total = 0;
-      for(list<reg_exp_t>::iterator cit = e->children.begin(); cit != e->children.end(); ++cit)
+      for(RegExpChildren::iterator cit = e->children.begin(); cit != e->children.end(); ++cit)
         total += countTotalLeaves(*cit);
       return total;
     }
@@ -1973,7 +2095,7 @@ namespace wali {
       long total = 0;
       if(e->type == wali::graph::Combine)
         ++total;
-      for(list<reg_exp_t>::iterator cit = e->children.begin(); cit != e->children.end(); ++cit)
+      for(RegExpChildren::iterator cit = e->children.begin(); cit != e->children.end(); ++cit)
         total += countTotalCombines(*cit);
       return total;
     }
@@ -1998,7 +2120,7 @@ namespace wali {
       long total = 0;
       if(e->type == wali::graph::Extend)
         ++total;
-      for(list<reg_exp_t>::iterator cit = e->children.begin(); cit != e->children.end(); ++cit)
+      for(RegExpChildren::iterator cit = e->children.begin(); cit != e->children.end(); ++cit)
         total += countTotalExtends(*cit);
       return total;
     }
@@ -2022,7 +2144,7 @@ namespace wali {
       long total = 0;
       if(e->type == wali::graph::Star)
         ++total;
-      for(list<reg_exp_t>::iterator cit = e->children.begin(); cit != e->children.end(); ++cit)
+      for(RegExpChildren::iterator cit = e->children.begin(); cit != e->children.end(); ++cit)
         total += countTotalStars(*cit);
       return total;
     }
@@ -2045,7 +2167,7 @@ namespace wali {
       if(it != visited.end())
         return;
       visited.insert(ekey, e);
-      for(list<reg_exp_t>::iterator cit = e->children.begin(); cit != e->children.end(); ++cit)
+      for(RegExpChildren::iterator cit = e->children.begin(); cit != e->children.end(); ++cit)
         excludeFromCountReachable(*cit);
     }
 
@@ -2069,7 +2191,7 @@ namespace wali {
       long total = 0;
       //if(e->type == Combine || e->type == Extend || e->type == Star)
       ++total;
-      for(list<reg_exp_t>::iterator cit = e->children.begin(); cit != e->children.end(); ++cit)
+      for(RegExpChildren::iterator cit = e->children.begin(); cit != e->children.end(); ++cit)
         total += countTotalNodes(*cit);
       return total;
     }
@@ -2084,7 +2206,7 @@ namespace wali {
         reg_exp_t const e = rit->second;
         reg_exp_key_t ekey(e->type, e);
         visited.insert(ekey, e);
-        for(list<reg_exp_t>::iterator cit = e->children.begin(); cit != e->children.end(); ++cit)
+        for(RegExpChildren::iterator cit = e->children.begin(); cit != e->children.end(); ++cit)
           removeDagFromRoots(*cit);
       }
     }
@@ -2097,7 +2219,7 @@ namespace wali {
         return;
       visited.insert(ekey, e);      
       rootsAcrossSatProcesses.erase(ekey);
-      for(list<reg_exp_t>::iterator cit = e->children.begin(); cit != e->children.end(); ++cit)
+      for(RegExpChildren::iterator cit = e->children.begin(); cit != e->children.end(); ++cit)
         removeDagFromRoots(*cit);
     }
 
@@ -27,56 +27,108 @@ namespace wali {
   namespace graph {
 
     SummaryGraph::SummaryGraph(InterGraphPtr gr, Key ss, set<Key> &pe, wfa::WFA &Agrow, InterGraph::PRINT_OP pop) {
-      post_igr = gr;
       dag = gr->dag;
+      ownsDag = false;
+      sem = gr->sem;
       pkey = pop;
       init_state = ss;
 
-      procEntries = pe;
+      addProcedures(gr, pe, Agrow);
+    }
 
-      if(procEntries.size() != post_igr->gr_list.size()) {
-        cerr << "SWPDS: Error: the number of procedure entries do not match with the number of procedures"
-             << "created by FWPDS. Check that post*(Agrow) did not generate new mid-states\n";
-        assert(0);
-      }
+    SummaryGraph::SummaryGraph(Key ss, sem_elem_t s, InterGraph::PRINT_OP pop) {
+      dag = new RegExpDag();
+      ownsDag = true;
+      sem = s;
+      pkey = pop;
+      init_state = ss;
+    }
+
+    void SummaryGraph::addProcedures(InterGraphPtr gr, set<Key> const & pe, wfa::WFA &Agrow) {
+      InterGraph *igr = gr.get_ptr();
+      assert(igr->dag == dag);
+
+      Unit &unit = units[pe];
+      assert(!unit.igr.is_valid());
+      unit.igr = gr;
 
       // Update all weights
-      post_igr->update_all_weights();
+      igr->update_all_weights();
 
-      // Build a stack -> node map
-      int i, n = (int)post_igr->nodes.size();
+      // Find the procedure of each IntraGraph from the entry node in it.
+      // Entries not in pe belong to procedures added before, which the
+      // IntraGraph only summarizes.
+      std::map<IntraGraph *, Key> graphEntry;
+      int i, n = (int)igr->nodes.size();
       for(i=0;i<n;i++) {
-        int stk = post_igr->nodes[i].trans.stack;
-        if(stk == 0) continue;
+        Key stk = igr->nodes[i].trans.stack;
+        if((Key)igr->nodes[i].trans.src != init_state || stk == WALI_EPSILON) continue;
+        if(pe.find(stk) != pe.end() || procGraph.find(stk) != procGraph.end()) {
+          graphEntry[igr->nodes[i].gr] = stk;
+        }
+      }
 
-        if(stack_graph_map.find(stk) == stack_graph_map.end()) {
-          stack_graph_map.insert(stk, i);
+      std::list<IntraGraph *>::iterator it;
+      for(it = igr->gr_list.begin(); it != igr->gr_list.end(); it++) {
+        IntraGraph *g = *it;
+        std::map<IntraGraph *, Key>::iterator eit = graphEntry.find(g);
+        if(eit == graphEntry.end()) {
+          cerr << "SWPDS: Error: the number of procedure entries do not match with the number of procedures"
+               << "created by FWPDS. Check that post*(Agrow) did not generate new mid-states\n";
+          assert(0);
+        }
+        graphOwner[g] = igr;
+        g->visited = false;
+        if(pe.find(eit->second) != pe.end()) {
+          procEntryMap[g] = eit->second;
+          procGraph[eit->second] = g;
         } else {
-          // Sanity check: Every stk should be in a unique IntraGraph
-          int j = stack_graph_map[stk];
-          if(post_igr->nodes[i].gr != post_igr->nodes[j].gr) {
-            pkey(cerr << "SWPDS: Warning: Node belongs to multiple procedures: ", stk) << "\n";
-            multiple_proc_nodes.insert(stk);
-
-            //TODO: This can be fixed. For now, we assume that this node is a terminal node, i.e.,
-            //it cannot reach any node except itself. (This assumption comes because such nodes
-            //are typically self loops "error: goto error".) Therefore, if the node has
-            //other successors, they may not show up in post* automaton
-            //Also, one should not run a prestar query from an automaton that has such a node.
-            //assert(0);
-          }
+          stubEntry[g] = eit->second;
         }
       }
 
-      // construct procEntryMap
-      set<Key>::iterator sit;
-      for(sit = procEntries.begin(); sit != procEntries.end(); sit++) {
-        int nno = stk2nodeno(*sit);
-        if(nno == -1) {
+      set<Key>::const_iterator sit;
+      for(sit = pe.begin(); sit != pe.end(); sit++) {
+        std::map<Key, IntraGraph *>::iterator pit = procGraph.find(*sit);
+        if(pit == procGraph.end() || graphOwner[pit->second] != igr) {
           cerr << "SWPDS: Error: Procedure entry node reachable. Check argument to SummaryGraph constructor\n";
           assert(0);
         }
-        procEntryMap[post_igr->nodes[nno].gr] = *sit;
+      }
+
+      // Locate the stacks of the procedures
+      std::set<Key> located;
+      for(i=0;i<n;i++) {
+        int stk = igr->nodes[i].trans.stack;
+        if(stk == 0) continue;
+
+        IntraGraph *g = igr->nodes[i].gr;
+        if(stubEntry.find(g) != stubEntry.end()) continue;
+
+        std::vector<Location> &locs = stack_graph_map[stk];
+        size_t j;
+        for(j = 0; j < locs.size(); j++) {
+          if(locs[j].igr->nodes[locs[j].nno].gr == g) break;
+        }
+        if(j < locs.size()) continue;
+
+        locs.push_back(Location(igr, i));
+        if(located.insert(stk).second) {
+          unit.stacks.push_back(stk);
+          popWeightMap.erase(stk);
+        }
+        if(locs.size() > 1) {
+          // Sanity check: Every stk should be in a unique IntraGraph
+          pkey(cerr << "SWPDS: Warning: Node belongs to multiple procedures: ", stk) << "\n";
+          multiple_proc_nodes.insert(stk);
+
+          //TODO: This can be fixed. For now, we assume that this node is a terminal node, i.e.,
+          //it cannot reach any node except itself. (This assumption comes because such nodes
+          //are typically self loops "error: goto error".) Therefore, if the node has
+          //other successors, they may not show up in post* automaton
+          //Also, one should not run a prestar query from an automaton that has such a node.
+          //assert(0);
+        }
       }
 
       // Construct a map: ETrans -> ERule used to create it
@@ -100,47 +152,108 @@ namespace wali {
           assert(et != 0);
 
           eruleMap[tr] = et->getERule();
+          unit.erules.push_back(tr);
         }
       }
 
-
-      // clear visited, and do more preprocessing inside IntraGraphs (evaluate path sequence weights)
-      std::list<IntraGraph *>::iterator it;
-      for(it = post_igr->gr_list.begin(); it != post_igr->gr_list.end(); it++) {
-        IntraGraph *gr = *it;
-        gr->setupSummarySolution();
-        gr->visited = false;
+      // do more preprocessing inside IntraGraphs (evaluate path sequence weights)
+      for(it = igr->gr_list.begin(); it != igr->gr_list.end(); it++) {
+        IntraGraph *g = *it;
+        if(stubEntry.find(g) == stubEntry.end())
+          g->setupSummarySolution();
       }
 
       // Pop weights
       {
         Timer timer("Pop Weights");
-        calculatePopWeights();
+        calculatePopWeights(igr);
       }
 
     }
 
+    void SummaryGraph::removeProcedures(set<Key> const & pe) {
+      std::map< std::set<Key>, Unit >::iterator uit = units.find(pe);
+      if(uit == units.end())
+        return;
+
+      Unit &unit = uit->second;
+      InterGraph *igr = unit.igr.get_ptr();
+
+      std::vector<Key>::iterator kit;
+      for(kit = unit.stacks.begin(); kit != unit.stacks.end(); kit++) {
+        StackGraphMap::iterator sit = stack_graph_map.find(*kit);
+        assert(sit != stack_graph_map.end());
+        std::vector<Location> &locs = sit->second;
+        std::vector<Location> rest;
+        for(size_t j = 0; j < locs.size(); j++) {
+          if(locs[j].igr != igr)
+            rest.push_back(locs[j]);
+        }
+        if(rest.size() <= 1)
+          multiple_proc_nodes.erase(*kit);
+        if(rest.empty())
+          stack_graph_map.erase(sit);
+        else
+          locs.swap(rest);
+        popWeightMap.erase(*kit);
+      }
+
+      std::vector<Transition>::iterator tit;
+      for(tit = unit.erules.begin(); tit != unit.erules.end(); tit++) {
+        eruleMap.erase(*tit);
+      }
+
+      std::list<IntraGraph *>::iterator it;
+      for(it = igr->gr_list.begin(); it != igr->gr_list.end(); it++) {
+        procEntryMap.erase(*it);
+        stubEntry.erase(*it);
+        graphOwner.erase(*it);
+        updated_graphs.erase(*it);
+      }
+
+      set<Key>::const_iterator eit;
+      for(eit = pe.begin(); eit != pe.end(); eit++) {
+        procGraph.erase(*eit);
+      }
+
+      units.erase(uit);
+    }
+
     // For each node n, calculate MOP(n,\epsilon).
     // This only requires a bunch of IntraProcedural queries
-    void SummaryGraph::calculatePopWeights() {
-      Transition tr(init_state, WALI_EPSILON, 0);
-      
+    void SummaryGraph::calculatePopWeights(InterGraph *igr) {
       list<IntraGraph *>::iterator it;
-      for(it = post_igr->gr_list.begin(); it != post_igr->gr_list.end(); it++) {
+      for(it = igr->gr_list.begin(); it != igr->gr_list.end(); it++) {
         IntraGraph *gr = *it;
+        if(stubEntry.find(gr) != stubEntry.end()) continue;
         
         // Get the eps-transition node (poor IntraGraphs don't know what their nodes are)
-        Key pe = procEntryMap[gr];
-        int nno = stk2nodeno(pe);
-        assert(nno != -1);
-        tr.tgt = post_igr->nodes[nno].trans.tgt;
+        Location const *loc = locate(procEntryMap[gr], gr);
+        assert(loc != 0);
+        Transition tr(init_state, WALI_EPSILON, igr->nodes[loc->nno].trans.tgt);
 
-        if(!post_igr->exists(tr)) continue;
+        if(!igr->exists(tr)) continue;
 
-        gr->calculatePopWeights(post_igr->nodes[post_igr->nodeno(tr)].intra_nodeno);
+        gr->calculatePopWeights(igr->nodes[igr->nodeno(tr)].intra_nodeno);
       }
     }
 
+    sem_elem_t SummaryGraph::summary(Key e) {
+      std::map<Key, IntraGraph *>::iterator it = procGraph.find(e);
+      if(it == procGraph.end())
+        return NULL;
+
+      Location const *loc = locate(e, it->second);
+      assert(loc != 0);
+      Transition tr(init_state, WALI_EPSILON, loc->igr->nodes[loc->nno].trans.tgt);
+      if(!loc->igr->exists(tr))
+        return NULL;
+
+      // Like pushWeight, the weight of a transition from init_state
+      // is the one in the InterGraph
+      return loc->igr->nodes[loc->igr->nodeno(tr)].weight;
+    }
+
     // Return MOP(k,\epsilon)
     sem_elem_t SummaryGraph::popWeight(Key k) {
 
@@ -158,18 +271,19 @@ namespace wali {
       } else {
         // Find the appropriate node number in the intragraph k belongs
         // to.
-        int nno = stk2nodeno(k);
-        Transition tr(init_state, k, post_igr->nodes[nno].trans.tgt);
-        if(!post_igr->exists(tr)) {
+        Location const *loc = stk2nodeno(k);
+        InterGraph *igr = loc->igr;
+        Transition tr(init_state, k, igr->nodes[loc->nno].trans.tgt);
+        if(!igr->exists(tr)) {
           ret = NULL;
         } else {
-          nno = post_igr->nodeno(tr);
-          ret = post_igr->nodes[nno].gr->popWeight(post_igr->nodes[nno].intra_nodeno);
+          int nno = igr->nodeno(tr);
+          ret = igr->nodes[nno].gr->popWeight(igr->nodes[nno].intra_nodeno);
         }
       }
 
       if(ret.get_ptr() == NULL) {
-        ret = post_igr->sem->zero();
+        ret = sem->zero();
       }
 
       popWeightMap[k] = ret;
@@ -181,11 +295,11 @@ namespace wali {
     // Error code: returns WALI_EPSILON if k is unreachable
     Key SummaryGraph::getEntry(Key k) {
       assert(k != WALI_EPSILON);
-      int nno = stk2nodeno(k);
+      Location const *loc = stk2nodeno(k);
 
-      if(nno == -1) return WALI_EPSILON;
+      if(loc == 0) return WALI_EPSILON;
 
-      return procEntryMap[post_igr->nodes[nno].gr];
+      return procEntryMap[loc->igr->nodes[loc->nno].gr];
     }
 
     // return MOP(entry(k), k)
@@ -196,19 +310,20 @@ namespace wali {
       if(!reachable(k))
         return NULL;
 
-      int nno = stk2nodeno(k);
-      Transition tr(init_state, k, post_igr->nodes[nno].trans.tgt);
-      assert(post_igr->exists(tr));
+      Location const *loc = stk2nodeno(k);
+      InterGraph *igr = loc->igr;
+      Transition tr(init_state, k, igr->nodes[loc->nno].trans.tgt);
+      assert(igr->exists(tr));
 
       // It is ok to get (init_state, k, _) weight directly from the
       // InterGraph without calling get_weight. This is because only the
       // weight of (mid-state, k, _) is computed on a call to get_weight
-      return post_igr->nodes[post_igr->nodeno(tr)].weight;
+      return igr->nodes[igr->nodeno(tr)].weight;
     }
 
 
     // mimics getIntraNodeNumber (see that function for more comments)
-    // returns "is the node present in post_igr", i.e., it is reachable
+    // returns "is the node present in an InterGraph", i.e., it is reachable
     // from some procedure entry?
     bool SummaryGraph::reachable(Key stk) {
       assert(stk != WALI_EPSILON);
@@ -216,15 +331,15 @@ namespace wali {
       Transition tr(init_state, stk, init_state); // final state is redundant
       
       // Locate the stack first
-      int nno = stk2nodeno(tr.stack);
-      if(nno == -1) {
+      Location const *loc = stk2nodeno(tr.stack);
+      if(loc == 0) {
         return false;       
       }
       
       // get the correct intended transition
       Transition tt = tr;
-      tt.tgt = post_igr->nodes[nno].trans.tgt;
-      if(!post_igr->exists(tt)) {
+      tt.tgt = loc->igr->nodes[loc->nno].trans.tgt;
+      if(!loc->igr->exists(tt)) {
         // Transition does not exist (This may happen when there is a call that never returns
         // and t.stack is the return node for that call)
         return false;
@@ -238,17 +353,56 @@ namespace wali {
       return (multiple_proc_nodes.find(stk) != multiple_proc_nodes.end());
     }
 
-    SummaryGraph::~SummaryGraph() { }
+    SummaryGraph::~SummaryGraph() {
+      // The regular expressions of the InterGraphs live in the dag
+      units.clear();
+      if(ownsDag)
+        delete dag;
+    }
 
-    // stack node --> post_igr node number
-    int SummaryGraph::stk2nodeno(int stk) {
+    // stack node --> its node in the InterGraph of (the first) procedure
+    // it is in
+    SummaryGraph::Location const * SummaryGraph::stk2nodeno(int stk) {
       StackGraphMap::iterator it = stack_graph_map.find(stk);
       if(it == stack_graph_map.end()) { // we should have already seen stk
         //pkey(cout << "SummaryGraph saw this for the first time:", stk) << "\n";
         //assert(0);
-        return -1;
+        return 0;
+      }
+      return &it->second.front();
+    }
+
+    // stack node --> its node in IntraGraph gr
+    SummaryGraph::Location const * SummaryGraph::locate(int stk, IntraGraph *gr) {
+      StackGraphMap::iterator it = stack_graph_map.find(stk);
+      if(it == stack_graph_map.end())
+        return 0;
+      std::vector<Location> const &locs = it->second;
+      for(size_t j = 0; j < locs.size(); j++) {
+        if(locs[j].igr->nodes[locs[j].nno].gr == gr)
+          return &locs[j];
+      }
+      return 0;
+    }
+
+    // The InterGraph that has a node for tr
+    InterGraph * SummaryGraph::owner(Transition &tr) {
+      StackGraphMap::iterator it = stack_graph_map.find(tr.stack);
+      if(it == stack_graph_map.end())
+        return 0;
+      std::vector<Location> const &locs = it->second;
+      for(size_t j = 0; j < locs.size(); j++) {
+        if(locs[j].igr->exists(tr))
+          return locs[j].igr;
+      }
+      return 0;
+    }
+
+    void SummaryGraph::clearVisited() {
+      std::map<IntraGraph *, InterGraph *>::iterator it;
+      for(it = graphOwner.begin(); it != graphOwner.end(); it++) {
+        it->first->visited = false;
       }
-      return it->second;
     }
 
     int SummaryGraph::trans2nodeno(Transition &t) {
@@ -265,16 +419,16 @@ namespace wali {
       assert(tr.stack != (int)WALI_EPSILON);
 
       // Locate the stack first
-      int nno = stk2nodeno(tr.stack);
-      if(nno == -1) {
+      Location const *loc = stk2nodeno(tr.stack);
+      if(loc == 0) {
         pkey(cout << "Warning: Unreachable code (", tr.stack) << ")\n";
         return -1;
       }
 
       // get the correct intended transition
       Transition tt = tr;
-      tt.tgt = post_igr->nodes[nno].trans.tgt;
-      if(!post_igr->exists(tt)) {
+      tt.tgt = loc->igr->nodes[loc->nno].trans.tgt;
+      if(!loc->igr->exists(tt)) {
         // Transition does not exist (This may happen when there is a call that never returns
         // and t.stack is the return node for that call)
         pkey(cout << "Warning: Unreachable code (", tr.stack) << ")\n";
@@ -282,8 +436,8 @@ namespace wali {
         return -1;
       }
 
-      int nno2 = post_igr->nodeno(tt);
-      return post_igr->nodes[nno2].intra_nodeno;
+      int nno2 = loc->igr->nodeno(tt);
+      return loc->igr->nodes[nno2].intra_nodeno;
     }
 
     void SummaryGraph::getUpdatedTransitions(std::list<WTransition> &ls) {
@@ -301,7 +455,6 @@ namespace wali {
 
     void SummaryGraph::preGetUpdatedTransitions(list<WTransition> &ls) {
       set<IntraGraph *>::iterator it;
-      list<IntraGraph *>::iterator lit;
 
       for(it = updated_graphs.begin(); it != updated_graphs.end(); it++) {
         IntraGraph *gr = *it;
@@ -312,10 +465,7 @@ namespace wali {
       // clear all updates
       updated_graphs.clear();
       changed_graphs.clear();
-      for(lit = post_igr->gr_list.begin(); lit != post_igr->gr_list.end(); lit++) {
-        IntraGraph *gr = *lit;
-        gr->visited = false;
-      }
+      clearVisited();
     }
 
     void SummaryGraph::preAddUpdate(Transition &t, sem_elem_t wt) {
@@ -329,7 +479,8 @@ namespace wali {
         return;
       }
 
-      IntraGraph *gr = post_igr->nodes[stk2nodeno(t.stack)].gr;
+      Location const *loc = stk2nodeno(t.stack);
+      IntraGraph *gr = loc->igr->nodes[loc->nno].gr;
       
       gr->updateWeight(nno, wt);
       if(!gr->visited) {
@@ -340,8 +491,6 @@ namespace wali {
     }
 
     void SummaryGraph::getMiddleTransitions(std::list<WTransition> &ls) {
-      std::list<IntraGraph *>::iterator it;
-
       // Mark all Intragraphs whose transitions should be there
       while(!changed_graphs.empty()) {
         IntraGraph *gr = changed_graphs.front();
@@ -350,6 +499,10 @@ namespace wali {
         std::set<IntraGraph *>::iterator it2;
         for(it2 = gr->calls.begin(); it2 != gr->calls.end(); it2++) {
           IntraGraph *ch = *it2;
+          // A procedure of another unit
+          std::map<IntraGraph *, Key>::iterator sit = stubEntry.find(ch);
+          if(sit != stubEntry.end())
+            ch = procGraph[sit->second];
           if(!ch->visited) {
             ch->visited = true;
             changed_graphs.push_back(ch);
@@ -357,19 +510,20 @@ namespace wali {
         }
       }
       // Get all the appropriate transitions
-      int i, n = post_igr->nodes.size();
-      for(i=0;i<n;i++) {
-        if(post_igr->nodes[i].gr->visited) {
-          //IntraGraph::print_trans(nodes[i].trans, cout) << "\n";
-          ls.push_back(WTransition(post_igr->nodes[i].trans,post_igr->nodes[i].weight));
+      std::map< std::set<Key>, Unit >::iterator uit;
+      for(uit = units.begin(); uit != units.end(); uit++) {
+        InterGraph *igr = uit->second.igr.get_ptr();
+        int i, n = igr->nodes.size();
+        for(i=0;i<n;i++) {
+          if(igr->nodes[i].gr->visited) {
+            //IntraGraph::print_trans(nodes[i].trans, cout) << "\n";
+            ls.push_back(WTransition(igr->nodes[i].trans,igr->nodes[i].weight));
+          }
         }
       }
 
       // clear all updates
-      for(it = post_igr->gr_list.begin(); it != post_igr->gr_list.end(); it++) {
-        IntraGraph *gr = *it;
-        gr->visited = false;
-      }
+      clearVisited();
       changed_graphs.clear();
     }
 
@@ -391,7 +545,7 @@ namespace wali {
     // after that do APSP style computation of weights on the eps transtions.
     void SummaryGraph::summaryPoststar(wali::wfa::WFA const & ca_in, wali::wfa::WFA& ca_out) {
       int i;
-      dag->startSatProcess(post_igr->sem);
+      dag->startSatProcess(sem);
       dag->extendDirectionBackwards(false);
 
       typedef pair<int, Key> tup;
@@ -474,11 +628,11 @@ namespace wali {
           
           ITrans *t = *trans_it;
           
-          int nno = stk2nodeno(t->stack());
-          if(nno == -1)
+          Location const *loc = stk2nodeno(t->stack());
+          if(loc == 0)
             continue;
           
-          IntraGraph *gr = post_igr->nodes[nno].gr;
+          IntraGraph *gr = loc->igr->nodes[loc->nno].gr;
           gr_set.insert(gr);
           
           // Keep track of IntraGraphs we're going to explore (for adding MiddleTransitions later)
@@ -500,7 +654,7 @@ namespace wali {
             // This creates a node for the transition
             int nno = trans2nodeno(tr);
 
-            nodes[nno].weight = post_igr->sem->zero();
+            nodes[nno].weight = sem->zero();
             if(tr.stack == (int)WALI_EPSILON)
               state_has_eps.insert(q);
           }
@@ -515,11 +669,11 @@ namespace wali {
             
           ITrans *t = *trans_it;
           
-          int nno = stk2nodeno(t->stack());
-          if(nno == -1)
+          Location const *loc = stk2nodeno(t->stack());
+          if(loc == 0)
             continue;
 
-          IntraGraph *gr = post_igr->nodes[nno].gr;
+          IntraGraph *gr = loc->igr->nodes[loc->nno].gr;
           Transition tr(init_state, t->stack(), q);
           int intra_nno = getIntraNodeNumber(tr);
 
@@ -534,7 +688,7 @@ namespace wali {
             assert(t->stack() != WALI_EPSILON);
             if(nodes[cno].uno == -1) {
               int uno = dag->getNextUpdatableNumber();
-              reg_exp_t reg = dag->updatable(uno, post_igr->sem->zero()); // create the updatable node (increments updatable number)
+              reg_exp_t reg = dag->updatable(uno, sem->zero()); // create the updatable node (increments updatable number)
               reg = dag->extend(reg, dag->constant(popWeight(t->stack())));
               pop_regexp_list.push_back(reg);
 
@@ -580,7 +734,7 @@ namespace wali {
       }
 
       delete timer1;
-      //post_igr->sem->printSemiringTime(cout) << "\n";
+      //sem->printSemiringTime(cout) << "\n";
 
       Timer *timer = new Timer("SWPDS Saturation");
       // Finally, we're all setup to run saturation
@@ -672,7 +826,7 @@ namespace wali {
 
       delete timer2;
 
-      //post_igr->sem->printSemiringTime(cout) << "\n";
+      //sem->printSemiringTime(cout) << "\n";
 
       // Add middle transitions
       std::list<WTransition> ls;
@@ -686,11 +840,7 @@ namespace wali {
       // clean up
 
       // clear changed graphs
-      std::list<IntraGraph *>::iterator gr_lit;
-      for(gr_lit = post_igr->gr_list.begin(); gr_lit != post_igr->gr_list.end(); gr_lit++) {
-        IntraGraph *gr = *gr_lit;
-        gr->visited = false;
-      }
+      clearVisited();
 
       changed_graphs.clear();
       trans_map.clear();
@@ -701,7 +851,7 @@ namespace wali {
     // All such transitions go to a (non-init) state of the input automaton.
     // They may have init of a mid-state as the source state.
     void SummaryGraph::addIntraTrans(Transition &tr, sem_elem_t wt, wfa::WFA &ca_out) {
-      if(!wt.is_valid() || wt->equal(wt->zero())) return;
+      if(!wt.is_valid() || wt->isZero()) return;
 
       // check the source state to see if an ETrans needs to be added
       if((Key)tr.src == init_state) {
@@ -710,20 +860,21 @@ namespace wali {
       } else {
         
         // wt is the "weight at call site". To get the weight after
-        // call, we would have to consult post_igr->eHandler
-        // For this, we need to know the corresponding transition in post_igr
+        // call, we would have to consult the eHandler of its InterGraph
+        // For this, we need to know the corresponding transition there
         // (because the target state of tr is one in ca_out)        
         Transition trprime(tr);
-        int nno = stk2nodeno(tr.stack);
-        assert(nno != -1);
-        trprime.tgt = post_igr->nodes[nno].trans.tgt;
+        Location const *loc = stk2nodeno(tr.stack);
+        assert(loc != 0);
+        InterGraph *igr = loc->igr;
+        trprime.tgt = igr->nodes[loc->nno].trans.tgt;
 
         int nret, ncall;
-        assert(post_igr->exists(trprime));
-        nret = post_igr->nodeno(trprime);
+        assert(igr->exists(trprime));
+        nret = igr->nodeno(trprime);
         
-        assert(post_igr->eHandler.exists(nret));
-        sem_elem_t wtCallRule = post_igr->eHandler.get_dependency(nret, ncall);
+        assert(igr->eHandler.exists(nret));
+        sem_elem_t wtCallRule = igr->eHandler.get_dependency(nret, ncall);
         assert(ncall != -1);
         
         // Get the Erule
@@ -747,7 +898,7 @@ namespace wali {
     // Add transitions (init / mid-state, *, mid-state). These are the ones
     // with preprocessed weights.
     void SummaryGraph::addMiddleTrans(Transition &tr, sem_elem_t wt, wfa::WFA &ca_out) {
-      if(!wt.is_valid() || wt->equal(wt->zero())) return;
+      if(!wt.is_valid() || wt->isZero()) return;
 
       Key src = changeStateGeneration(tr.src, ca_out.getGeneration());
       Key tgt = changeStateGeneration(tr.tgt, ca_out.getGeneration());
@@ -759,13 +910,15 @@ namespace wali {
       } else {
         
         // wt is the "weight at call site". To get the weight after
-        // call, we would have to consult post_igr->eHandler
+        // call, we would have to consult the eHandler of the
+        // InterGraph of tr
         int nret, ncall;
-        assert(post_igr->exists(tr));
-        nret = post_igr->nodeno(tr);
+        InterGraph *igr = owner(tr);
+        assert(igr != 0);
+        nret = igr->nodeno(tr);
         
-        assert(post_igr->eHandler.exists(nret));
-        sem_elem_t wtCallRule = post_igr->eHandler.get_dependency(nret, ncall);
+        assert(igr->eHandler.exists(nret));
+        sem_elem_t wtCallRule = igr->eHandler.get_dependency(nret, ncall);
         assert(ncall != -1);
         
         // Get the Erule
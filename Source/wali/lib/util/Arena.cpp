@@ -0,0 +1,133 @@
+/**
+ * @file Arena.cpp
+ */
+
+#include "wali/util/Arena.hpp"
+
+#include <cassert>
+#include <cstdlib>
+#include <new>
+
+namespace wali
+{
+  namespace util
+  {
+    const size_t Arena::ALIGN;
+    const size_t Arena::MAX_BLOCK;
+    const size_t Arena::NUM_CLASSES;
+
+    Arena::Arena( size_t chunk_bytes ) :
+      cur(0),
+      end(0),
+      chunkBytes(chunk_bytes),
+      allocations(0),
+      live(0),
+      liveBytes(0),
+      reserved(0),
+      detached(false)
+    {
+      for( size_t i = 0 ; i < NUM_CLASSES ; i++ )
+        freeLists[i] = 0;
+    }
+
+    Arena::~Arena()
+    {
+      releaseChunks();
+    }
+
+    void * Arena::allocate( Arena * arena, size_t bytes )
+    {
+      size_t size = (bytes + sizeof(Header) + ALIGN - 1) & ~(ALIGN - 1);
+      Header * h;
+      if( arena && size <= MAX_BLOCK ) {
+        h = static_cast< Header * >( arena->take(size) );
+        h->arena = arena;
+      }
+      else {
+        h = static_cast< Header * >( ::operator new(size) );
+        h->arena = 0;
+      }
+      h->size = size;
+      return reinterpret_cast< char * >(h) + sizeof(Header);
+    }
+
+    void Arena::deallocate( void * p )
+    {
+      if( p == 0 )
+        return;
+      Header * h = reinterpret_cast< Header * >(
+          static_cast< char * >(p) - sizeof(Header) );
+      if( h->arena )
+        h->arena->give(h);
+      else
+        ::operator delete(h);
+    }
+
+    void * Arena::take( size_t size )
+    {
+      allocations++;
+      live++;
+      liveBytes += size;
+
+      FreeNode *& head = freeLists[size / ALIGN];
+      if( head ) {
+        FreeNode * n = head;
+        head = n->next;
+        return n;
+      }
+      if( static_cast< size_t >(end - cur) < size ) {
+        char * chunk = static_cast< char * >( ::operator new(chunkBytes) );
+        chunks.push_back(chunk);
+        reserved += chunkBytes;
+        cur = chunk;
+        end = chunk + chunkBytes;
+      }
+      void * p = cur;
+      cur += size;
+      return p;
+    }
+
+    void Arena::give( Header * h )
+    {
+      assert( live > 0 );
+      live--;
+      liveBytes -= h->size;
+
+      size_t cls = h->size / ALIGN;
+      FreeNode * n = reinterpret_cast< FreeNode * >(h);
+      n->next = freeLists[cls];
+      freeLists[cls] = n;
+
+      if( detached && live == 0 )
+        delete this;
+    }
+
+    void Arena::reset()
+    {
+      if( live == 0 )
+        releaseChunks();
+    }
+
+    void Arena::detach()
+    {
+      if( live == 0 )
+        delete this;
+      else
+        detached = true;
+    }
+
+    void Arena::releaseChunks()
+    {
+      for( size_t i = 0 ; i < chunks.size() ; i++ )
+        ::operator delete( chunks[i] );
+      chunks.clear();
+      cur = end = 0;
+      reserved = 0;
+      for( size_t i = 0 ; i < NUM_CLASSES ; i++ )
+        freeLists[i] = 0;
+    }
+
+  } // namespace util
+
+} // namespace wali
+
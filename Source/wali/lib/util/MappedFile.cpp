@@ -0,0 +1,61 @@
+/**
+ * @file MappedFile.cpp
+ */
+
+#include "wali/util/MappedFile.hpp"
+
+#include <fstream>
+#include <iterator>
+
+#ifndef _WIN32
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+namespace wali
+{
+  namespace util
+  {
+    MappedFile::MappedFile( std::string const & path ) :
+      ok(false), mapped(false), bytes(NULL), length(0)
+    {
+#ifndef _WIN32
+      int fd = open(path.c_str(), O_RDONLY);
+      if( fd < 0 )
+        return;
+      struct stat st;
+      if( fstat(fd, &st) == 0 && st.st_size > 0 ) {
+        void * p = mmap(NULL, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if( p != MAP_FAILED ) {
+          bytes = static_cast<char const *>(p);
+          length = static_cast<size_t>(st.st_size);
+          mapped = true;
+          ok = true;
+        }
+      }
+      close(fd);
+      if( ok )
+        return;
+#endif
+      std::ifstream in(path.c_str(), std::ios::in | std::ios::binary);
+      if( !in )
+        return;
+      copy.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+      bytes = copy.empty() ? NULL : &copy[0];
+      length = copy.size();
+      ok = !in.bad();
+    }
+
+    MappedFile::~MappedFile()
+    {
+#ifndef _WIN32
+      if( mapped )
+        munmap(const_cast<char *>(bytes), length);
+#endif
+    }
+
+  } // namespace util
+
+} // namespace wali
@@ -0,0 +1,149 @@
+/**
+ * @file WorkStealingPool.cpp
+ */
+
+#include "wali/util/WorkStealingPool.hpp"
+
+#include <cassert>
+
+namespace wali
+{
+  namespace util
+  {
+
+    WorkStealingPool::WorkStealingPool( size_t num_threads ) :
+      current(0),
+      batch(0),
+      active(0),
+      stopping(false)
+    {
+      if( num_threads == 0 )
+        num_threads = 1;
+      for( size_t i = 0 ; i < num_threads ; i++ )
+        queues.push_back( new Queue() );
+      for( size_t i = 1 ; i < num_threads ; i++ )
+        threads.push_back( std::thread(&WorkStealingPool::workerLoop, this, i) );
+    }
+
+    WorkStealingPool::~WorkStealingPool()
+    {
+      {
+        std::lock_guard<std::mutex> guard(control);
+        stopping = true;
+      }
+      batchStarted.notify_all();
+      for( size_t i = 0 ; i < threads.size() ; i++ )
+        threads[i].join();
+      for( size_t i = 0 ; i < queues.size() ; i++ )
+        delete queues[i];
+    }
+
+    void WorkStealingPool::run( size_t num_tasks, task_t const & task )
+    {
+      if( num_tasks == 0 )
+        return;
+
+      // Nothing to share the batch with; skip the hand-off entirely.
+      if( threads.empty() || num_tasks == 1 ) {
+        for( size_t i = 0 ; i < num_tasks ; i++ )
+          task(i);
+        return;
+      }
+
+      // No worker is running, so the queues can be filled without locks.
+      for( size_t i = 0 ; i < num_tasks ; i++ )
+        queues[i % queues.size()]->tasks.push_back(i);
+
+      {
+        std::lock_guard<std::mutex> guard(control);
+        current = &task;
+        failure = std::exception_ptr();
+        active = threads.size();
+        batch++;
+      }
+      batchStarted.notify_all();
+
+      drain(0);
+
+      std::exception_ptr error;
+      {
+        std::unique_lock<std::mutex> guard(control);
+        while( active != 0 )
+          batchFinished.wait(guard);
+        current = 0;
+        error = failure;
+      }
+      if( error )
+        std::rethrow_exception(error);
+    }
+
+    void WorkStealingPool::workerLoop( size_t self )
+    {
+      size_t seen = 0;
+      while( true )
+      {
+        {
+          std::unique_lock<std::mutex> guard(control);
+          while( !stopping && batch == seen )
+            batchStarted.wait(guard);
+          if( stopping )
+            return;
+          seen = batch;
+        }
+
+        drain(self);
+
+        {
+          std::lock_guard<std::mutex> guard(control);
+          assert(active > 0);
+          if( --active == 0 )
+            batchFinished.notify_one();
+        }
+      }
+    }
+
+    // Tasks are only handed out at the start of a batch, so once a worker
+    // finds every queue empty there is nothing left for it to do.
+    void WorkStealingPool::drain( size_t self )
+    {
+      size_t task;
+      while( pop(self, task) || steal(self, task) ) {
+        try {
+          (*current)(task);
+        }
+        catch( ... ) {
+          std::lock_guard<std::mutex> guard(control);
+          if( !failure )
+            failure = std::current_exception();
+        }
+      }
+    }
+
+    bool WorkStealingPool::pop( size_t self, size_t & task )
+    {
+      Queue & q = *queues[self];
+      std::lock_guard<std::mutex> guard(q.lock);
+      if( q.tasks.empty() )
+        return false;
+      task = q.tasks.back();
+      q.tasks.pop_back();
+      return true;
+    }
+
+    bool WorkStealingPool::steal( size_t self, size_t & task )
+    {
+      for( size_t i = 1 ; i < queues.size() ; i++ ) {
+        Queue & victim = *queues[(self + i) % queues.size()];
+        std::lock_guard<std::mutex> guard(victim.lock);
+        if( !victim.tasks.empty() ) {
+          task = victim.tasks.front();
+          victim.tasks.pop_front();
+          return true;
+        }
+      }
+      return false;
+    }
+
+  } // namespace util
+
+} // namespace wali
@@ -79,7 +79,7 @@ namespace wali
     void TransZeroWeight::operator()( ITrans* t )
     {
       sem_elem_t wt = t->weight();
-      if(wt->equal(wt->zero())) {
+      if(wt->isZero()) {
         zeroWeightTrans.insert(t);
       }
     }
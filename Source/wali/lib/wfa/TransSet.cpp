@@ -7,48 +7,148 @@
 #include "wali/wfa/TransSet.hpp"
 #include "wali/wfa/TransFunctor.hpp"
 
-#if IMPL_LIST
-#   define IMPLFIND( impl,t ) std::find<wali::wfa::TransSet::iterator,wali::wfa::ITransEq>(impl.begin(),impl.end(),t)
-#else
-#   define IMPLFIND( impl,t ) impl.find(t)
-#endif
+#include <algorithm>
 
 namespace wali {
 
   namespace wfa {
 
+    const size_t TransSet::INLINE_SIZE;
+    const size_t TransSet::SMALL_SIZE;
+
+    TransSet::TransSet() :
+      heap(0),
+      capacity(INLINE_SIZE),
+      used(0),
+      live(0),
+      index(0)
+    {
+    }
+
+    TransSet::TransSet( const TransSet& other ) :
+      Printable(),
+      heap(0),
+      capacity(INLINE_SIZE),
+      used(0),
+      live(0),
+      index(0)
+    {
+      for( const_iterator it = other.begin() ; it != other.end() ; it++ )
+        insert( *it );
+    }
+
+    TransSet& TransSet::operator=( const TransSet& other )
+    {
+      if( this != &other ) {
+        TransSet tmp(other);
+        swap(tmp);
+      }
+      return *this;
+    }
+
+    TransSet::~TransSet()
+    {
+      delete[] heap;
+      delete index;
+    }
+
+    void TransSet::swap( TransSet& other )
+    {
+      // Only the active one of inlined/heap matters, so swapping both
+      // swaps the contents.
+      std::swap_ranges( inlined,inlined + INLINE_SIZE,other.inlined );
+      std::swap( heap,other.heap );
+      std::swap( capacity,other.capacity );
+      std::swap( used,other.used );
+      std::swap( live,other.live );
+      std::swap( index,other.index );
+    }
+
+    void TransSet::clear()
+    {
+      used = 0;
+      live = 0;
+      delete index;
+      index = 0;
+    }
+
+    size_t TransSet::findPos( Key from, Key stack, Key to ) const
+    {
+      if( index ) {
+        index_t::const_iterator it = index->find( KeyTriple(from,stack,to) );
+        return (it == index->end()) ? used : it->second;
+      }
+      ITrans* const* s = slots();
+      for( size_t p = 0 ; p < used ; p++ ) {
+        ITrans* t = s[p];
+        if( t && t->to() == to && t->stack() == stack && t->from() == from )
+          return p;
+      }
+      return used;
+    }
+
+    void TransSet::buildIndex()
+    {
+      index = new index_t( 2 * live );
+      ITrans* const* s = slots();
+      for( size_t p = 0 ; p < used ; p++ ) {
+        if( s[p] )
+          index->insert( KeyTriple(s[p]->from(),s[p]->stack(),s[p]->to()),p );
+      }
+    }
+
+    void TransSet::compact()
+    {
+      ITrans** s = slots();
+      size_t n = 0;
+      for( size_t p = 0 ; p < used ; p++ ) {
+        if( s[p] )
+          s[n++] = s[p];
+      }
+      used = n;
+      if( index ) {
+        delete index;
+        index = 0;
+        buildIndex();
+      }
+    }
+
     ITrans* TransSet::erase( ITrans* t ) {
       ITrans* tret = NULL;
       iterator it = find(t);
       if( it != end() ) {
         tret = *it;
-        impl.erase(it);
+        erase(it);
       }
       return tret;
     }
 
     ITrans* TransSet::erase( Key from, Key stack, Key to ) {
-      Trans terase(from,stack,to,0);
-      return erase(&terase);
-    }
-
-    TransSet::iterator TransSet::find( Key from, Key stack, Key to ) {
-      Trans terase(from,stack,to,0);
-      ITrans* why = &terase;
-      return IMPLFIND(impl,why);
+      ITrans* tret = NULL;
+      iterator it = find(from,stack,to);
+      if( it != end() ) {
+        tret = *it;
+        erase(it);
+      }
+      return tret;
     }
 
-    TransSet::const_iterator TransSet::find( Key from, Key stack, Key to ) const {
-      Trans terase(from,stack,to,0);
-      return find(&terase);
+    void TransSet::erase( iterator it ) {
+      ITrans*& slot = slots()[it.pos];
+      assert( slot );
+      if( index )
+        index->erase( KeyTriple(slot->from(),slot->stack(),slot->to()) );
+      // Leave a hole; used stays put so that end() does not move.
+      slot = 0;
+      live--;
     }
 
-    TransSet::iterator TransSet::find( ITrans* t ) {
-      return IMPLFIND(impl,t);
+    TransSet::iterator TransSet::find( Key from, Key stack, Key to ) const {
+      return iterator( this,findPos(from,stack,to) );
     }
 
-    TransSet::const_iterator TransSet::find( ITrans* t ) const {
-      return IMPLFIND(impl,t);
+    TransSet::iterator TransSet::find( ITrans* t ) const {
+      return find( t->from(),t->stack(),t->to() );
     }
 
     namespace details {
@@ -71,7 +171,7 @@ namespace wali {
 
     void TransSet::each( ConstTransFunctor& tf ) const
     {
-      details::each(impl.begin(), impl.end(), tf);
+      details::each(begin(), end(), tf);
     }
         
     void TransSet::each( boost::function<void(ITrans * t)> & tf )
@@ -81,24 +181,40 @@ namespace wali {
 
     void TransSet::each( boost::function<void(ITrans const * t)> & tf ) const
     {
-      details::each(impl.begin(), impl.end(), tf);
+      details::each(begin(), end(), tf);
     }
 
     bool TransSet::insert( ITrans* t )
     {
-      bool b = true;
-#if IMPL_LIST
-      impl.push_back(t);
-#else
-      b = impl.insert(t).second;
+      bool b = (findPos(t->from(),t->stack(),t->to()) == used);
       // BEGIN DEBUGGING
       // We should never insert the same transition twice
       if( !b ) {
         t->print( *waliErr << "\tERROR" ) << std::endl;
         assert(b);
+        return b;
       }
       // END DEBUGGING
-#endif
+
+      if( used == capacity ) {
+        if( used - live >= live ) {
+          compact();
+        }
+        else {
+          ITrans** grown = new ITrans*[2 * capacity];
+          std::copy( slots(),slots() + used,grown );
+          delete[] heap;
+          heap = grown;
+          capacity *= 2;
+        }
+      }
+      slots()[used] = t;
+      live++;
+      if( index )
+        index->insert( KeyTriple(t->from(),t->stack(),t->to()),used );
+      used++;
+      if( !index && live > SMALL_SIZE )
+        buildIndex();
       return b;
     }
 
@@ -117,7 +233,7 @@ namespace wali {
     }
 
     size_t TransSet::size() const {
-      return impl.size();
+      return live;
     }
 
   } // namespace wfa
@@ -424,7 +424,7 @@ namespace wali
           // Now get the weight. That's the net weight from 'source' to
           // 'target', where 'target' is actually a state in 'this' WFA.
           sem_elem_t weight = (*trans)->weight();
-          if (!weight->equal(weight->zero())) {
+          if (!weight->isZero()) {
             closures[source][target] = (*trans)->weight();
           }
         }
@@ -63,6 +63,7 @@ namespace wali
         : init_state( WALI_EPSILON )
         , query(q)
         , generation(0)
+        , version(0)
         , progress(prog)
         , defaultPathSummaryImplementation(globalDefaultPathSummaryImplementation)
         , defaultPathSummaryFwpdsDirection(globalDefaultPathSummaryFwpdsDirection)
@@ -74,6 +75,7 @@ namespace wali
     }
 
     WFA::WFA( const WFA & rhs ) : Printable()
+        , version(0)
     {
       operator=(rhs);
     }
@@ -97,7 +99,7 @@ namespace wali
         for( ; it != rhs.state_map.end(); it++ ) {
           // FIXME: why is this ->zero()? --EED 5/11/2012
           addState( it->first, it->second->weight()->zero() );
-          if (!it->second->acceptWeight()->equal(it->second->acceptWeight()->zero())) {
+          if (!it->second->acceptWeight()->isZero()) {
             getState(it->first)->acceptWeight() = it->second->acceptWeight();
           }
         }
@@ -125,7 +127,7 @@ namespace wali
        */
       TransDeleter td;
       for_each(td);
-
+      transArena->reset();
 
       /* Must manually delete all State objects. If reference
        * counting is used this code can be removed
@@ -153,6 +155,7 @@ namespace wali
       F.clear();
       Q.clear();
       init_state = WALI_EPSILON;
+      ++version;
     }
 
     //!
@@ -297,7 +300,7 @@ namespace wali
         Key q,
         sem_elem_t se )
     {
-      return addTrans( new Trans(p,g,q,se) );
+      return addTrans( new (getTransArena()) Trans(p,g,q,se) );
     }
 
     //!
@@ -355,6 +358,7 @@ namespace wali
       state->eraseTrans(t);
 
       delete t;
+      ++version;
     }
 
     namespace details {
@@ -713,8 +717,8 @@ namespace wali
                   && (*fa_trans_iter)->from() == (*fa_trans_iter)->to())
               {
                 sem_elem_t tw = (*this_trans_iter)->weight(), fw = (*fa_trans_iter)->weight();
-                assert(tw->equal(tw->one()));
-                assert(fw->equal(fw->one()));
+                assert(tw->isOne());
+                assert(fw->isOne());
                 continue;
               }
               details::handle_transition(dest, worklist,
@@ -950,6 +954,7 @@ namespace wali
             eraseTransFromEpsMap(t);
             tSet.erase(eraseIt);
             delete t;
+            ++version;
           }
         }
       }
@@ -1159,6 +1164,7 @@ namespace wali
     WFA::insert( ITrans* tnew )
     {
       bool inserted = true;
+      ++version;
       
       ////
       // WFA::find code duplicated to keep
@@ -1732,7 +1738,7 @@ namespace wali
       {
         if (finish.find(*final) != finish.end()) {
           sem_elem_t weight = finish[*final];
-          if (!weight->equal(weight->zero())) {
+          if (!weight->isZero()) {
             return true;
           }
         }
@@ -2419,7 +2425,10 @@ namespace wali
          << "              states: " << numStates() << "\n"
          << "    accepting states: " << getFinalStates().size() << "\n"
          << "             symbols: " << symbols.size() << "\n"
-         << "         transitions: " << counter.getNumTrans() << "\n";
+         << "         transitions: " << counter.getNumTrans() << "\n"
+         << "   trans allocations: " << transArena->numAllocations() << "\n"
+         << "    trans live bytes: " << transArena->bytesLive() << "\n"
+         << "   trans arena bytes: " << transArena->bytesReserved() << "\n";
     }
 
 
@@ -80,15 +80,15 @@ namespace wali
     }
 
     // Test if the Witness has user weight ZERO
-    bool Witness::isZero()
+    bool Witness::isZero() const
     {
-      return user_se->equal( user_se->zero() );
+      return user_se->isZero();
     }
 
     // Test if the Witness has user weight ONE
-    bool Witness::isOne()
+    bool Witness::isOne() const
     {
-      return user_se->equal( user_se->one() );
+      return user_se->isOne();
     }
 
     sem_elem_t Witness::one() const
@@ -189,10 +189,13 @@ namespace wali
         sem_elem_t se, Config * cfg
         )
     {
-      wfa::ITrans* tmp = new Trans(from,stack,to,se);
+      wfa::ITrans* tmp = new (currentOutputWFA->getTransArena()) Trans(from,stack,to,interned(se));
       tmp->print( *waliErr << "  --- [DebugWPDS::update] t_gen ==" ) << std::endl;
 
-      wfa::ITrans* t = currentOutputWFA->insert(tmp).first;
+      std::pair< wfa::ITrans *, bool > ins = currentOutputWFA->insert(tmp);
+      wfa::ITrans* t = ins.first;
+      if( !ins.second )
+        internCombined(t);
       t->setConfig(cfg);
       if (t->modified()) {
         worklist->put( t );
@@ -207,10 +210,22 @@ namespace wali
         sem_elem_t wWithRule //<! delta \extends r->weight()
         )
     {
-      wfa::ITrans* tmp = new Trans(from,r->to_stack2(),call->to(),wWithRule);
+      wfa::ITrans* tmp = new (currentOutputWFA->getTransArena()) Trans(from,r->to_stack2(),call->to(),interned(wWithRule));
       tmp->print( *waliErr << "  --- [DebugWPDS::update_prime] t_gen ==" ) << std::endl;
-      wfa::ITrans* t = currentOutputWFA->insert(tmp).first;
-      return t;
+      std::pair< wfa::ITrans *, bool > ins = currentOutputWFA->insert(tmp);
+      if( !ins.second )
+        internCombined(ins.first);
+      return ins.first;
+    }
+
+    bool DebugWPDS::supports_incremental() const
+    {
+      return false;
+    }
+
+    bool DebugWPDS::saturate_in_parallel() const
+    {
+      return false;
     }
   }   // namespace wpds
 
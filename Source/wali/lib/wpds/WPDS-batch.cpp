@@ -0,0 +1,175 @@
+/**
+ * @file WPDS-batch.cpp
+ *
+ * Batched poststar: several queries saturated as one automaton whose
+ * generated states, and so procedure summaries, are shared.
+ */
+
+#include "wali/Common.hpp"
+#include "wali/wfa/TransFunctor.hpp"
+#include "wali/wpds/WPDS.hpp"
+#include "wali/util/unordered_map.hpp"
+
+#include <sstream>
+#include <vector>
+
+namespace wali
+{
+  using wfa::ITrans;
+  using wfa::WFA;
+
+  namespace wpds
+  {
+    namespace
+    {
+      typedef util::unordered_map< Key, Key > rename_map_t;
+      typedef util::unordered_map< Key, std::vector< ITrans const * > > incoming_map_t;
+
+      /// Copies the transitions of one query into the combined input
+      class RenameCopier : public wfa::ConstTransFunctor
+      {
+        public:
+          RenameCopier( WPDS const & w, Key t, WFA & c, rename_map_t & o, std::vector< Key > & s ) :
+            wpds(w), tag(t), combined(c), original(o), states(s) {}
+
+          Key rename( Key k )
+          {
+            if( wpds.is_pds_state(k) )
+              return k;
+            Key renamed = getKey(k, tag);
+            if( original.insert( std::make_pair(renamed, k) ).second )
+              states.push_back(renamed);
+            return renamed;
+          }
+
+          virtual void operator()( ITrans const * t )
+          {
+            combined.addTrans( t->copy(rename(t->from()), t->stack(), rename(t->to())) );
+          }
+
+        private:
+          WPDS const & wpds;
+          Key tag;
+          WFA & combined;
+          rename_map_t & original;
+          std::vector< Key > & states;
+      };
+
+      /// Indexes the transitions of the combined output by to state
+      class IncomingIndexer : public wfa::ConstTransFunctor
+      {
+        public:
+          explicit IncomingIndexer( incoming_map_t & i ) : incoming(i) {}
+
+          virtual void operator()( ITrans const * t )
+          {
+            incoming[t->to()].push_back(t);
+          }
+
+        private:
+          incoming_map_t & incoming;
+      };
+
+      Key original_name( rename_map_t const & original, Key k )
+      {
+        rename_map_t::const_iterator it = original.find(k);
+        return (it == original.end()) ? k : it->second;
+      }
+    }
+
+    void WPDS::poststarBatch(
+        std::vector< WFA const * > const & inputs,
+        std::vector< WFA > & outputs )
+    {
+      outputs.clear();
+      outputs.resize( inputs.size() );
+      if( inputs.empty() )
+        return;
+
+      // Rename the queries apart, remembering the renamed states of each
+      WFA combined;
+      rename_map_t original;
+      std::vector< std::vector< Key > > roots( inputs.size() );
+      std::vector< Key > finals;
+      Key init = WALI_EPSILON;
+      for( size_t i = 0 ; i < inputs.size() ; i++ )
+      {
+        WFA const & input = *inputs[i];
+        std::stringstream ss;
+        ss << "poststarBatch#" << i;
+        RenameCopier copier( *this, getKey(ss.str()), combined, original, roots[i] );
+        input.for_each(copier);
+
+        if( i == 0 )
+          init = copier.rename( input.getInitialState() );
+        std::set< Key > const & F = input.getFinalStates();
+        for( std::set< Key >::const_iterator it = F.begin() ; it != F.end() ; it++ )
+          finals.push_back( copier.rename(*it) );
+      }
+
+      if( combined.numTransitions() == 0u ) {
+        for( size_t i = 0 ; i < inputs.size() ; i++ )
+          poststar( *inputs[i], outputs[i] );
+        return;
+      }
+
+      sem_elem_t zero = combined.getSomeWeight()->zero();
+      combined.addState( init, zero );
+      combined.setInitialState(init);
+      for( size_t i = 0 ; i < finals.size() ; i++ ) {
+        combined.addState( finals[i], zero );
+        combined.addFinalState( finals[i] );
+      }
+
+      WFA out;
+      poststar(combined, out);
+
+      incoming_map_t incoming;
+      IncomingIndexer indexer(incoming);
+      out.for_each(indexer);
+
+      // Each answer is what can still reach one of its query's states
+      for( size_t i = 0 ; i < inputs.size() ; i++ )
+      {
+        WFA const & input = *inputs[i];
+        WFA & fa = outputs[i];
+        fa.setQuery( out.getQuery() );
+        fa.setGeneration( input.getGeneration() + 1 );
+        fa.addState( input.getInitialState(), zero );
+        fa.setInitialState( input.getInitialState() );
+        std::set< Key > const & finals = input.getFinalStates();
+        for( std::set< Key >::const_iterator it = finals.begin() ; it != finals.end() ; it++ )
+        {
+          fa.addState( *it, zero );
+          fa.addFinalState(*it);
+        }
+        for( gen_state_map_t::const_iterator git = gen_states.begin() ; git != gen_states.end() ; git++ )
+          fa.addState( git->second, zero );
+
+        std::vector< Key > work( roots[i] );
+        std::set< Key > seen( work.begin(), work.end() );
+        while( !work.empty() )
+        {
+          Key q = work.back();
+          work.pop_back();
+          incoming_map_t::const_iterator iit = incoming.find(q);
+          if( iit == incoming.end() )
+            continue;
+          std::vector< ITrans const * > const & ts = iit->second;
+          for( size_t j = 0 ; j < ts.size() ; j++ )
+          {
+            ITrans const * t = ts[j];
+            fa.addTrans( t->copy( original_name(original, t->from()),
+                                  t->stack(),
+                                  original_name(original, t->to()) ) );
+            if( seen.insert(t->from()).second )
+              work.push_back( t->from() );
+          }
+        }
+      }
+    }
+
+  } // namespace wpds
+
+} // namespace wali
+
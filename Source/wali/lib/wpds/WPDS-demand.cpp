@@ -0,0 +1,304 @@
+/**
+ * @file WPDS-demand.cpp
+ *
+ * Demand-driven poststar: saturate only the transitions that can
+ * contribute to the weights of a set of target configurations.
+ */
+
+#include "wali/Common.hpp"
+#include "wali/wfa/State.hpp"
+#include "wali/wfa/TransFunctor.hpp"
+#include "wali/wfa/TransSet.hpp"
+#include "wali/wpds/WPDS.hpp"
+#include "wali/wpds/Config.hpp"
+#include "wali/wpds/Rule.hpp"
+#include "wali/util/unordered_map.hpp"
+#include "wali/util/unordered_set.hpp"
+
+#include <vector>
+
+namespace wali
+{
+  using wfa::ITrans;
+  using wfa::TransSet;
+  using wfa::WFA;
+  using wfa::State;
+
+  namespace wpds
+  {
+    struct WPDS::Demand
+    {
+      util::unordered_set< KeyPair > heads;
+    };
+
+    namespace
+    {
+      typedef util::unordered_set< KeyPair > head_set_t;
+      typedef std::vector< KeyPair > head_list_t;
+
+      /**
+       * What is known about one procedure, i.e., the configurations
+       * reachable from the target (p', g') of a push rule without
+       * entering another procedure.
+       */
+      struct Procedure
+      {
+        head_set_t heads;                            //!< reachable heads
+        std::set< Key > exits;                       //!< states it returns in
+        std::map< Key, head_list_t > pops;           //!< exit -> heads of the pop rules
+        std::vector< std::pair< KeyPair,Key > > returnSites;  //!< (caller, return symbol)
+      };
+
+      typedef util::unordered_map< KeyPair, Procedure > procedure_map_t;
+
+      /**
+       * Tabulates the heads and exit states of every procedure, in the
+       * style of an interprocedural reachability analysis: the return
+       * site (p'', g'') of a call is reachable once the callee is known
+       * to return in p''.
+       */
+      class ProcedureSummaries
+      {
+        public:
+          procedure_map_t procs;
+
+          void addHead( KeyPair const & proc, KeyPair const & h )
+          {
+            if( procs[proc].heads.insert(h).second )
+              work.push_back( std::make_pair(proc,h) );
+          }
+
+          void addExit( KeyPair const & proc, Key exit, KeyPair const & pop )
+          {
+            Procedure & callee = procs[proc];
+            callee.pops[exit].push_back(pop);
+            if( !callee.exits.insert(exit).second )
+              return;
+            // Copy: addHead may rehash procs
+            std::vector< std::pair< KeyPair,Key > > sites( callee.returnSites );
+            for( size_t i = 0 ; i < sites.size() ; i++ )
+              addHead( sites[i].first, KeyPair(exit, sites[i].second) );
+          }
+
+          void addCall( KeyPair const & caller, KeyPair const & callee, Key ret )
+          {
+            addHead( callee, callee );
+            procs[callee].returnSites.push_back( std::make_pair(caller,ret) );
+            std::set< Key > exits( procs[callee].exits );
+            for( std::set< Key >::const_iterator it = exits.begin() ; it != exits.end() ; it++ )
+              addHead( caller, KeyPair(*it, ret) );
+          }
+
+          bool next( std::pair< KeyPair,KeyPair > & item )
+          {
+            if( work.empty() )
+              return false;
+            item = work.back();
+            work.pop_back();
+            return true;
+          }
+
+        private:
+          std::vector< std::pair< KeyPair,KeyPair > > work;
+      };
+
+      /// Stack symbols read out of states that are not PDS states
+      class BelowCollector : public wfa::ConstTransFunctor
+      {
+        public:
+          BelowCollector( WPDS const & w, std::set< KeyPair > * h, std::set< Key > & b ) :
+            wpds(w), heads(h), below(b) {}
+
+          virtual void operator()( ITrans const * t )
+          {
+            if( !wpds.is_pds_state(t->from()) )
+              below.insert(t->stack());
+            else if( heads != 0 && t->stack() != WALI_EPSILON )
+              heads->insert(t->keypair());
+          }
+
+        private:
+          WPDS const & wpds;
+          std::set< KeyPair > * heads;
+          std::set< Key > & below;
+      };
+    }
+
+    bool WPDS::supports_demand() const
+    {
+      return true;
+    }
+
+    void WPDS::poststarDemand(
+        WFA const & input,
+        WFA & output,
+        std::set< KeyPair > const & targets )
+    {
+      poststar_demand( input, output, targets, std::set< Key >() );
+    }
+
+    void WPDS::poststarDemand(
+        WFA const & input,
+        WFA & output,
+        WFA const & targets )
+    {
+      std::set< KeyPair > heads;
+      std::set< Key > below;
+      BelowCollector collect(*this, &heads, below);
+      targets.for_each(collect);
+      poststar_demand( input, output, heads, below );
+    }
+
+    void WPDS::poststar_demand(
+        WFA const & input,
+        WFA & fa,
+        std::set< KeyPair > const & targets,
+        std::set< Key > const & below )
+    {
+      if( !supports_demand() || input.numTransitions() == 0u ) {
+        poststar(input, fa);
+        return;
+      }
+
+      Demand d;
+      demand_closure( input, targets, below, d );
+
+      poststarSetupFixpoint(input, fa);
+      {
+        DemandScope scope(*this, &d);
+        poststarComputeFixpoint(fa);
+      }
+      unlinkOutput(fa);
+      currentOutputWFA = 0;
+    }
+
+    void WPDS::demand_closure(
+        WFA const & input,
+        std::set< KeyPair > const & targets,
+        std::set< Key > const & below,
+        Demand & d )
+    {
+      // Pop rules by the state they pop to, and the procedures
+      ProcedureSummaries summaries;
+      std::map< Key, head_list_t > popsTo;
+      for( const_iterator cit = config_map().begin() ; cit != config_map().end() ; cit++ )
+      {
+        Config * c = cit->second;
+        for( Config::iterator rit = c->begin() ; rit != c->end() ; rit++ )
+        {
+          rule_t & r = *rit;
+          if( r->to_stack1() == WALI_EPSILON )
+            popsTo[r->to_state()].push_back( cit->first );
+          else if( r->to_stack2() != WALI_EPSILON )
+            summaries.addHead( KeyPair(r->to_state(), r->to_stack1()), KeyPair(r->to_state(), r->to_stack1()) );
+        }
+      }
+
+      std::pair< KeyPair,KeyPair > item;
+      while( summaries.next(item) )
+      {
+        KeyPair const & proc = item.first;
+        Config * c = find_config( item.second.first, item.second.second );
+        if( c == 0 )
+          continue;
+        for( Config::iterator rit = c->begin() ; rit != c->end() ; rit++ )
+        {
+          rule_t & r = *rit;
+          if( r->to_stack1() == WALI_EPSILON )
+            summaries.addExit( proc, r->to_state(), item.second );
+          else if( r->to_stack2() == WALI_EPSILON )
+            summaries.addHead( proc, KeyPair(r->to_state(), r->to_stack1()) );
+          else
+            summaries.addCall( proc, KeyPair(r->to_state(), r->to_stack1()), r->to_stack2() );
+        }
+      }
+
+      // A pop that returns to a state of the input automaton continues
+      // with the symbols read out of it
+      std::set< Key > inputBelow;
+      BelowCollector collect(*this, 0, inputBelow);
+      input.for_each(collect);
+
+      // Walk back from the targets
+      head_set_t & heads = d.heads;
+      head_list_t work;
+      for( std::set< KeyPair >::const_iterator it = targets.begin() ; it != targets.end() ; it++ ) {
+        if( heads.insert(*it).second )
+          work.push_back(*it);
+      }
+      // The transitions out of a generated state come from its calls
+      for( std::set< Key >::const_iterator it = below.begin() ; it != below.end() ; it++ )
+      {
+        r2hash_t::iterator r2it = r2hash.find(*it);
+        if( r2it == r2hash.end() )
+          continue;
+        std::list< rule_t >::iterator lsit = r2it->second.begin();
+        for( ; lsit != r2it->second.end() ; lsit++ ) {
+          KeyPair caller( (*lsit)->from_state(), (*lsit)->from_stack() );
+          if( heads.insert(caller).second )
+            work.push_back(caller);
+        }
+      }
+
+      while( !work.empty() )
+      {
+        KeyPair h = work.back();
+        work.pop_back();
+        head_list_t preds;
+
+        // Step rules into h, and calls of the procedure h enters
+        Config * c = find_config( h.first, h.second );
+        if( c != 0 ) {
+          for( Config::reverse_iterator rit = c->rbegin() ; rit != c->rend() ; rit++ )
+            preds.push_back( KeyPair((*rit)->from_state(), (*rit)->from_stack()) );
+        }
+
+        // Returns to h: the call, and the pops it returns through
+        r2hash_t::iterator r2it = r2hash.find( h.second );
+        if( r2it != r2hash.end() ) {
+          std::list< rule_t >::iterator lsit = r2it->second.begin();
+          for( ; lsit != r2it->second.end() ; lsit++ )
+          {
+            rule_t & r = *lsit;
+            procedure_map_t::iterator pit =
+              summaries.procs.find( KeyPair(r->to_state(), r->to_stack1()) );
+            if( pit == summaries.procs.end() || pit->second.exits.count(h.first) == 0 )
+              continue;
+            preds.push_back( KeyPair(r->from_state(), r->from_stack()) );
+            head_list_t & pops = pit->second.pops[h.first];
+            preds.insert( preds.end(), pops.begin(), pops.end() );
+          }
+        }
+
+        if( inputBelow.count(h.second) != 0 ) {
+          head_list_t & pops = popsTo[h.first];
+          preds.insert( preds.end(), pops.begin(), pops.end() );
+        }
+
+        for( size_t i = 0 ; i < preds.size() ; i++ ) {
+          if( heads.insert(preds[i]).second )
+            work.push_back(preds[i]);
+        }
+      }
+    }
+
+    bool WPDS::is_demanded( ITrans * t ) const
+    {
+      if( t->stack() != WALI_EPSILON )
+        return demand->heads.count( t->keypair() ) != 0;
+
+      // (p,eps,q) is combined with every (q,y,q')
+      State const * state = currentOutputWFA->getState( t->to() );
+      TransSet const & ts = state->getTransSet();
+      for( TransSet::iterator it = ts.begin() ; it != ts.end() ; it++ ) {
+        Key y = (*it)->stack();
+        if( y == WALI_EPSILON || demand->heads.count( KeyPair(t->from(), y) ) != 0 )
+          return true;
+      }
+      return false;
+    }
+
+  } // namespace wpds
+
+} // namespace wali
+
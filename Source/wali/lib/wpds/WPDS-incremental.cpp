@@ -0,0 +1,433 @@
+/**
+ * @file WPDS-incremental.cpp
+ *
+ * Incremental poststar: after the first query, re-saturate only the
+ * part of the output automaton that rule changes affect.
+ */
+
+#include "wali/Common.hpp"
+#include "wali/SemElem.hpp"
+#include "wali/Worklist.hpp"
+#include "wali/wfa/State.hpp"
+#include "wali/wfa/TransSet.hpp"
+#include "wali/wpds/WPDS.hpp"
+#include "wali/wpds/Config.hpp"
+#include "wali/wpds/Rule.hpp"
+#include "wali/wpds/GenKeySource.hpp"
+#include "wali/util/unordered_map.hpp"
+#include "wali/util/unordered_set.hpp"
+
+#include <cassert>
+#include <vector>
+
+namespace wali
+{
+  using wfa::ITrans;
+  using wfa::TransSet;
+  using wfa::WFA;
+  using wfa::State;
+
+  namespace wpds
+  {
+    /**
+     * The dependency graph of the output transitions, plus what is
+     * needed to tell whether the next call is an update of this one.
+     *
+     * An edge s -> t means that a saturation step on s (alone, or
+     * together with an epsilon transition or a transition out of a
+     * generated state) contributed to t. Attempts that added nothing
+     * are edges too: after a retraction they may contribute again.
+     */
+    struct WPDS::IncrementalState
+    {
+      typedef util::unordered_set< ITrans * > trans_set_t;
+      typedef util::unordered_map< ITrans *, trans_set_t > edge_map_t;
+
+      WFA const * input;
+      WFA * output;
+      size_t generation;    //!< of output after the last call
+      size_t inputVersion;  //!< WFA::getVersion() of input at the last call
+      size_t outputVersion; //!< WFA::getVersion() of output after the last call
+
+      /// gen_states of the last call; other queries overwrite gen_states
+      gen_state_map_t genStates;
+
+      edge_map_t derived;   //!< s -> { t | s -> t }
+      edge_map_t sources;   //!< t -> { s | s -> t }
+
+      /// The copies of the input transitions and their weights
+      util::unordered_map< ITrans *, sem_elem_t > seeds;
+
+      std::set< KeyPair > changed;    //!< l.h.s. of every rule change
+      std::set< KeyPair > retracted;  //!< l.h.s. of replaced and erased rules
+      std::set< KeyPair > calls;      //!< callee of replaced and erased push rules
+      size_t numChanges;
+
+      /// Transitions whose Config an update set, to be unlinked
+      std::vector< ITrans * > linked;
+      bool trackLinks;
+
+      IncrementalState( WFA const & in, WFA & out ) :
+        input(&in), output(&out), generation(0),
+        inputVersion(in.getVersion()), outputVersion(0),
+        numChanges(0), trackLinks(false)
+      {
+      }
+
+      void addEdge( ITrans * s, ITrans * t )
+      {
+        derived[s].insert(t);
+        sources[t].insert(s);
+      }
+
+      /// Drops the edges out of t
+      void dropDerived( ITrans * t )
+      {
+        edge_map_t::iterator it = derived.find(t);
+        if( it == derived.end() )
+          return;
+        trans_set_t::iterator dit = it->second.begin();
+        for( ; dit != it->second.end() ; dit++ )
+          sources[*dit].erase(t);
+        derived.erase(it);
+      }
+
+      /// Drops the edges into t
+      void dropSources( ITrans * t )
+      {
+        edge_map_t::iterator it = sources.find(t);
+        if( it == sources.end() )
+          return;
+        trans_set_t::iterator sit = it->second.begin();
+        for( ; sit != it->second.end() ; sit++ )
+          derived[*sit].erase(t);
+        sources.erase(it);
+      }
+    };
+
+    namespace
+    {
+      bool is_gen_state( Key k )
+      {
+        return dynamic_cast< GenKeySource * >( getKeySource(k).get_ptr() ) != 0;
+      }
+    }
+
+    bool WPDS::supports_incremental() const
+    {
+      return true;
+    }
+
+    void WPDS::resetIncremental()
+    {
+      incremental.reset();
+    }
+
+    void WPDS::note_rule_change( rule_t const & r, bool monotone )
+    {
+      IncrementalState & inc = *incremental;
+      KeyPair lhs(r->from_state(), r->from_stack());
+      inc.changed.insert(lhs);
+      if( !monotone ) {
+        inc.retracted.insert(lhs);
+        if( r->to_stack2() != WALI_EPSILON )
+          inc.calls.insert( KeyPair(r->to_state(), r->to_stack1()) );
+      }
+      inc.numChanges++;
+    }
+
+    void WPDS::note_seed( ITrans * t )
+    {
+      incremental->seeds[t] = t->weight();
+    }
+
+    void WPDS::note_derived( ITrans * t )
+    {
+      IncrementalState & inc = *incremental;
+      for( int i = 0 ; i < 2 ; i++ ) {
+        if( depSources[i] != 0 && depSources[i] != t )
+          inc.addEdge(depSources[i], t);
+      }
+      if( inc.trackLinks )
+        inc.linked.push_back(t);
+    }
+
+    void WPDS::poststarIncremental( WFA const & input, WFA & fa )
+    {
+      if( !supports_incremental() ) {
+        incremental.reset();
+        poststar(input, fa);
+        return;
+      }
+
+      incrementalStats = IncrementalStats();
+      if( incremental
+          && incremental->input == &input
+          && incremental->output == &fa
+          && &input != &fa
+          && fa.getGeneration() == incremental->generation
+          && input.getVersion() == incremental->inputVersion
+          && fa.getVersion() == incremental->outputVersion )
+      {
+        incrementalStats.full = false;
+        incrementalStats.changes = incremental->numChanges;
+        recordingDeps = true;
+        poststarIncrementalUpdate(fa);
+        recordingDeps = false;
+      }
+      else {
+        if( input.numTransitions() == 0u ) {
+          incremental.reset();
+          poststar(input, fa);
+          return;
+        }
+        incremental.reset( new IncrementalState(input, fa) );
+        recordingDeps = true;
+        poststarSetupFixpoint(input, fa);
+        poststarComputeFixpoint(fa);
+        recordingDeps = false;
+        unlinkOutput(fa);
+      }
+
+      IncrementalState & inc = *incremental;
+      inc.genStates = gen_states;
+      inc.generation = fa.getGeneration();
+      inc.outputVersion = fa.getVersion();
+      inc.changed.clear();
+      inc.retracted.clear();
+      inc.calls.clear();
+      inc.numChanges = 0;
+      currentOutputWFA = 0;
+    }
+
+    void WPDS::poststarIncrementalUpdate( WFA & fa )
+    {
+      IncrementalState & inc = *incremental;
+      currentOutputWFA = &fa;
+      gen_states = inc.genStates;
+      inc.trackLinks = true;
+
+      sem_elem_t fazero = fa.getSomeWeight()->zero();
+
+      // New push rules need their generated states
+      std::set< KeyPair >::const_iterator kpit = inc.changed.begin();
+      for( ; kpit != inc.changed.end() ; kpit++ )
+      {
+        Config * c = find_config(kpit->first, kpit->second);
+        if( c == 0 )
+          continue;
+        for( Config::iterator rit = c->begin() ; rit != c->end() ; rit++ )
+        {
+          rule_t & r = *rit;
+          if( r->to_stack2() == WALI_EPSILON )
+            continue;
+          KeyPair callee(r->to_state(), r->to_stack1());
+          if( gen_states.find(callee) == gen_states.end() ) {
+            Key gstate = gen_state(r->to_state(), r->to_stack1());
+            fa.addState(gstate, fazero);
+            gen_states.insert(callee, gstate);
+          }
+        }
+      }
+
+      // Everything derived from a transition that a replaced or
+      // erased rule matches is retracted: the closure of its
+      // successors in the dependency graph.
+      IncrementalState::trans_set_t affected;
+      std::vector< ITrans * > stack;
+      for( kpit = inc.retracted.begin() ; kpit != inc.retracted.end() ; kpit++ )
+      {
+        WFA::kp_map_t::iterator it = fa.kpmap.find(*kpit);
+        if( it == fa.kpmap.end() )
+          continue;
+        TransSet & ts = it->second;
+        for( TransSet::iterator tsit = ts.begin() ; tsit != ts.end() ; tsit++ )
+          stack.push_back(*tsit);
+      }
+      while( !stack.empty() )
+      {
+        ITrans * t = stack.back();
+        stack.pop_back();
+        IncrementalState::edge_map_t::iterator it = inc.derived.find(t);
+        if( it == inc.derived.end() )
+          continue;
+        IncrementalState::trans_set_t::iterator dit = it->second.begin();
+        for( ; dit != it->second.end() ; dit++ ) {
+          if( affected.insert(*dit).second )
+            stack.push_back(*dit);
+        }
+      }
+
+      // Saturation restarts from the transitions the changed rules
+      // match and from every surviving transition that contributed
+      // to a retracted one.
+      IncrementalState::trans_set_t frontier;
+      for( kpit = inc.changed.begin() ; kpit != inc.changed.end() ; kpit++ )
+      {
+        WFA::kp_map_t::iterator it = fa.kpmap.find(*kpit);
+        if( it == fa.kpmap.end() )
+          continue;
+        TransSet & ts = it->second;
+        for( TransSet::iterator tsit = ts.begin() ; tsit != ts.end() ; tsit++ ) {
+          if( affected.find(*tsit) == affected.end() )
+            frontier.insert(*tsit);
+        }
+      }
+      IncrementalState::trans_set_t::iterator ait = affected.begin();
+      for( ; ait != affected.end() ; ait++ )
+      {
+        IncrementalState::edge_map_t::iterator it = inc.sources.find(*ait);
+        if( it == inc.sources.end() )
+          continue;
+        IncrementalState::trans_set_t::iterator sit = it->second.begin();
+        for( ; sit != it->second.end() ; sit++ ) {
+          if( affected.find(*sit) == affected.end() )
+            frontier.insert(*sit);
+        }
+      }
+
+      // Retract. Copies of input transitions go back to their input
+      // weight, and a generated state whose call transition is retracted
+      // recomputes its quasi weight.
+      std::vector< ITrans * > restart;
+      for( ait = affected.begin() ; ait != affected.end() ; ait++ )
+      {
+        ITrans * t = *ait;
+        inc.dropDerived(t);
+        inc.dropSources(t);
+        if( is_gen_state(t->to()) )
+          fa.getState(t->to())->quasi = fazero;
+
+        util::unordered_map< ITrans *, sem_elem_t >::iterator seed = inc.seeds.find(t);
+        if( seed != inc.seeds.end() ) {
+          t->setWeight(seed->second);
+          restart.push_back(t);
+        }
+        else {
+          t->setWeight(fazero);
+          t->setDelta(fazero);
+        }
+      }
+      incrementalStats.retracted = affected.size();
+
+      // Re-run the steps of the frontier with their full weight. Their
+      // edges are recorded again as they go.
+      IncrementalState::trans_set_t::iterator fit = frontier.begin();
+      for( ; fit != frontier.end() ; fit++ )
+      {
+        ITrans * t = *fit;
+        inc.dropDerived(t);
+        if( !is_gen_state(t->from()) ) {
+          restart.push_back(t);
+          continue;
+        }
+        // Transitions out of generated states never go on the
+        // worklist, so redo the epsilon steps poststar_apply_trans
+        // takes when one of them changes.
+        WFA::eps_map_t::iterator epsit = fa.eps_map.find( t->from() );
+        if( epsit == fa.eps_map.end() )
+          continue;
+        TransSet & epsSet = epsit->second;
+        for( TransSet::iterator tsit = epsSet.begin() ; tsit != epsSet.end() ; tsit++ )
+        {
+          ITrans * teps = *tsit;
+          // post() handles retracted ones once they are derived again
+          if( affected.find(teps) != affected.end() )
+            continue;
+          DependencyScope scope(*this, t, teps);
+          update( teps->from(), t->stack(), t->to(),
+              t->weight()->extend( teps->weight() ),
+              make_config( teps->from(),t->stack() ) );
+        }
+      }
+      for( size_t i = 0 ; i < restart.size() ; i++ )
+      {
+        ITrans * t = restart[i];
+        t->setDelta( t->weight() );
+        t->setConfig( make_config(t->from(), t->stack()) );
+        inc.linked.push_back(t);
+        worklist->put(t);
+      }
+      incrementalStats.restarted = restart.size();
+
+      poststarComputeFixpoint(fa);
+
+      // Steps that combined with a retracted transition before it was
+      // derived again may have added transitions with weight zero.
+      IncrementalState::trans_set_t dead;
+      for( ait = affected.begin() ; ait != affected.end() ; ait++ ) {
+        if( (*ait)->weight()->equal(fazero) )
+          dead.insert(*ait);
+      }
+      for( size_t i = 0 ; i < inc.linked.size() ; i++ ) {
+        ITrans * t = inc.linked[i];
+        t->setConfig(0);
+        if( t->weight()->equal(fazero) )
+          dead.insert(t);
+      }
+      inc.linked.clear();
+      inc.trackLinks = false;
+
+      // Drop what was retracted and not derived again
+      std::set< Key > orphans;
+      IncrementalState::trans_set_t::iterator dit = dead.begin();
+      for( ; dit != dead.end() ; dit++ )
+      {
+        ITrans * t = *dit;
+        inc.dropDerived(t);
+        inc.dropSources(t);
+        inc.seeds.erase(t);
+        orphans.insert(t->from());
+        fa.erase(t->from(), t->stack(), t->to());
+        incrementalStats.erased++;
+      }
+
+      // along with the PDS states left without transitions, which
+      // poststar would not have added
+      std::set< Key >::const_iterator oit = orphans.begin();
+      for( ; oit != orphans.end() ; oit++ )
+      {
+        Key q = *oit;
+        if( is_gen_state(q)
+            || !fa.getState(q)->getTransSet().empty()
+            || q == fa.getInitialState()
+            || fa.isFinalState(q)
+            || inc.input->getState(q) != 0 )
+          continue;
+        fa.eraseState(q);
+      }
+
+      // and the generated states of calls that no rule makes anymore
+      for( kpit = inc.calls.begin() ; kpit != inc.calls.end() ; kpit++ )
+      {
+        Config * c = find_config(kpit->first, kpit->second);
+        bool called = false;
+        if( c != 0 ) {
+          for( Config::reverse_iterator rit = c->rbegin() ; rit != c->rend() ; rit++ ) {
+            if( (*rit)->to_stack2() != WALI_EPSILON ) {
+              called = true;
+              break;
+            }
+          }
+        }
+        gen_state_map_t::iterator git = gen_states.find(*kpit);
+        if( called || git == gen_states.end() )
+          continue;
+        Key gstate = git->second;
+        State * state = fa.getState(gstate);
+        if( state != 0
+            && state->getTransSet().empty()
+            && ( fa.eps_map.find(gstate) == fa.eps_map.end()
+              || fa.eps_map.find(gstate)->second.empty() )
+            && fa.find(kpit->first, kpit->second, gstate) == 0 )
+        {
+          fa.eraseState(gstate);
+          gen_states.erase(git);
+        }
+      }
+    }
+
+  } // namespace wpds
+
+} // namespace wali
+
@@ -7,6 +7,7 @@
 
 #include "wali/Common.hpp"
 #include "wali/SemElem.hpp"
+#include "wali/SemElemInterner.hpp"
 #include "wali/Worklist.hpp"
 #include "wali/KeyPairSource.hpp"
 #include "wali/wfa/State.hpp"
@@ -19,6 +20,8 @@
 #include "wali/wpds/Wrapper.hpp"
 #include "wali/wpds/GenKeySource.hpp"
 #include "wali/DefaultWorklist.hpp"
+#include "wali/util/WorkStealingPool.hpp"
+#include <algorithm>
 #include <iostream>
 #include <cassert>
 
@@ -43,15 +46,27 @@ namespace wali
     WPDS::WPDS() :
       wrapper(0),
       worklist( new DefaultWorklist<wfa::ITrans>() ),
-      currentOutputWFA(0)
+      currentOutputWFA(0),
+      parallelism(1),
+      interner(0),
+      recordingDeps(false),
+      demand(0),
+      ruleChanges(0)
     {
+      depSources[0] = depSources[1] = 0;
     }
 
     WPDS::WPDS( ref_ptr<Wrapper> w ) :
       wrapper(w),
       worklist( new DefaultWorklist<wfa::ITrans>() ),
-      currentOutputWFA(0)
+      currentOutputWFA(0),
+      parallelism(1),
+      interner(0),
+      recordingDeps(false),
+      demand(0),
+      ruleChanges(0)
     {
+      depSources[0] = depSources[1] = 0;
     }
 
     WPDS::WPDS( const WPDS& w ) :
@@ -59,8 +74,14 @@ namespace wali
       wali::wfa::ConstTransFunctor(),
       wrapper(w.wrapper),
       worklist( new DefaultWorklist<wfa::ITrans>() ),
-      currentOutputWFA(0)
+      currentOutputWFA(0),
+      parallelism(w.parallelism),
+      interner(w.interner),
+      recordingDeps(false),
+      demand(0),
+      ruleChanges(0)
     {
+      depSources[0] = depSources[1] = 0;
       RuleCopier rc(*this,wrapper);
       w.for_each(rc);
     }
@@ -87,6 +108,7 @@ namespace wali
 
       /* clear everything */
       config_map().clear();
+      configArena->reset();
       //*waliErr << "  1. Cleared config_map()" << std::endl;
 
       rule_zeroes.clear();
@@ -95,11 +117,15 @@ namespace wali
       r2hash.clear();
       //*waliErr << "  3. Cleared r2hash()" << std::endl;
 
+      ruleChanges++;
+
       worklist->clear();
       //*waliErr << "  4. Cleared worklist()" << std::endl;
 
       pds_states.clear();
       //*waliErr << "  5. Cleared pds_states()" << std::endl;
+
+      incremental.reset();
     }
 
     /**
@@ -114,6 +140,28 @@ namespace wali
       worklist = wl;
     }
 
+    bool WPDS::setParallelism( unsigned n )
+    {
+      bool ok = true;
+      if (n == 0)
+        n = 1;
+#ifndef WALI_ATOMIC_REFCOUNT
+      if (n > 1) {
+        // The workers copy shared sem_elem_ts, and so would race on
+        // their plain counts.
+        *waliErr << "[ERROR] WPDS::setParallelism(" << n << ") needs a build"
+          << " with WALI_ATOMIC_REFCOUNT. Using 1 thread.\n";
+        assert(0);
+        n = 1;
+        ok = false;
+      }
+#endif
+      if (n != parallelism)
+        pool.reset();
+      parallelism = n;
+      return ok;
+    }
+
     bool WPDS::add_rule(
         Key from_state,
         Key from_stack,
@@ -298,6 +346,10 @@ namespace wali
 
     void WPDS::prestarComputeFixpoint( WFA& fa )
     {
+      if( saturate_in_parallel() ) {
+        computeFixpointParallel(fa, false);
+        return;
+      }
 
       wfa::ITrans * t;
 
@@ -359,13 +411,31 @@ namespace wali
         rule_t  &r,
         sem_elem_t delta
         )
+    {
+      prestar_apply_call( t1, t2, r, prestar_call_weight(t1, t2, r, delta) );
+    }
+
+    sem_elem_t WPDS::prestar_call_weight(
+        wfa::ITrans * t1,
+        wfa::ITrans * t2 ATTR_UNUSED,
+        rule_t & r,
+        sem_elem_t delta
+        )
     {
       // f(r) * t1
       sem_elem_t wrtp = r->weight()->extend( t1->weight() );
 
       // f(r) * t2 * delta
-      sem_elem_t wnew = wrtp->extend( delta );
+      return wrtp->extend( delta );
+    }
 
+    void WPDS::prestar_apply_call(
+        wfa::ITrans * t1 ATTR_UNUSED,
+        wfa::ITrans * t2,
+        rule_t & r,
+        sem_elem_t wnew
+        )
+    {
       // update
       update( r->from()->state()
           , r->from()->stack()
@@ -383,8 +453,25 @@ namespace wali
         sem_elem_t delta
         )
     {
+      prestar_apply_trans( t, fa, r, prestar_rule_weight(t, r, delta) );
+    }
+
+    sem_elem_t WPDS::prestar_rule_weight(
+        wfa::ITrans * t ATTR_UNUSED,
+        rule_t & r,
+        sem_elem_t delta
+        )
+    {
+      return r->weight()->extend( delta );
+    }
 
-      sem_elem_t wrule_trans = r->weight()->extend( delta );
+    void WPDS::prestar_apply_trans(
+        wfa::ITrans* t ,
+        WFA & fa   ,
+        rule_t & r,
+        sem_elem_t wrule_trans
+        )
+    {
       Key fstate = r->from()->state();
       Key fstack = r->from()->stack();
 
@@ -459,6 +546,7 @@ namespace wali
       assert(randwgt != NULL);
 
       // Generate midstates for each rule type two
+      gen_states.clear();
       r2hash_t::iterator r2it = r2hash.begin();
       for( ; r2it != r2hash.end() ; r2it++ )
       {
@@ -469,6 +557,7 @@ namespace wali
           rule_t & r = *rlsit;
           Key gstate = gen_state( r->to_state(),r->to_stack1() );
           fa.addState( gstate, randwgt->zero() );
+          gen_states.insert( KeyPair(r->to_state(),r->to_stack1()), gstate );
         }
         if( fa.progress.is_valid() )
             fa.progress->tick();
@@ -477,6 +566,11 @@ namespace wali
 
     void WPDS::poststarComputeFixpoint( WFA& fa )
     {
+      if( saturate_in_parallel() ) {
+        computeFixpointParallel(fa, true);
+        return;
+      }
+
       wfa::ITrans* t;
 
       while( get_from_worklist( t ) ) 
@@ -524,9 +618,156 @@ namespace wali
       }
     }
 
+    bool WPDS::saturate_in_parallel() const
+    {
+      return parallelism > 1;
+    }
+
+    boost::shared_ptr<util::WorkStealingPool> const & WPDS::threadPool()
+    {
+      if( !pool )
+        pool.reset( new util::WorkStealingPool(parallelism) );
+      return pool;
+    }
+
+    void WPDS::computeFixpointParallel( WFA& fa, bool poststar )
+    {
+      threadPool();
+
+      // More shards than threads so that stealing can even out
+      // the load; the shards are applied in a fixed order, so the
+      // result does not depend on which thread prepared what.
+      size_t const max_shards = 8 * static_cast<size_t>(parallelism);
+      hm_hash< KeyPair > hasher;
+
+      std::vector< std::vector< SaturationStep > > shards;
+      wfa::ITrans * t;
+
+      while( !worklist->empty() )
+      {
+        std::vector< SaturationStep > round;
+        while( get_from_worklist( t ) ) {
+          sem_elem_t dnew = t->getDelta();
+          // Reset delta of t to zero to signify completion
+          // of work for that delta
+          t->setDelta(dnew->zero());
+          round.push_back( SaturationStep(t,dnew) );
+        }
+
+        size_t nshards = std::min( round.size(), max_shards );
+        shards.assign( nshards, std::vector< SaturationStep >() );
+        for( size_t i = 0 ; i < round.size() ; i++ ) {
+          size_t shard = hasher( round[i].trans->keypair() ) % nshards;
+          shards[shard].push_back( round[i] );
+        }
+        round.clear();
+
+        pool->run( nshards, [this, &shards, &fa, poststar]( size_t i ) {
+            prepareShard( shards, i, fa, poststar );
+          } );
+
+        for( size_t i = 0 ; i < nshards ; i++ ) {
+          std::vector< SaturationStep > & shard = shards[i];
+          for( size_t j = 0 ; j < shard.size() ; j++ ) {
+            applyStep( shard[j], fa, poststar );
+            if( poststar && fa.progress.is_valid() )
+              fa.progress->tick();
+          }
+        }
+      }
+    }
+
+    void WPDS::prepareShard(
+        std::vector< std::vector< SaturationStep > > & shards,
+        size_t i,
+        WFA & fa,
+        bool poststar )
+    {
+      std::vector< SaturationStep > & shard = shards[i];
+      for( size_t j = 0 ; j < shard.size() ; j++ )
+        prepareStep( shard[j], fa, poststar );
+    }
+
+    void WPDS::prepareStep( SaturationStep & step, WFA& fa, bool poststar )
+    {
+      wfa::ITrans * t = step.trans;
+      Config * config = t->getConfig();
+      assert( config );
+
+      if( poststar && WALI_EPSILON != t->stack() ) {
+        Config::iterator fwit = config->begin();
+        for( ; fwit != config->end() ; fwit++ ) {
+          step.contributions.push_back( SaturationStep::Contribution(&*fwit,0) );
+          step.contributions.back().weight =
+            poststar_rule_weight( t,*fwit,step.delta );
+        }
+      }
+      else if( poststar ) {
+        State * state = fa.getState( t->to() );
+        State::iterator it = state->begin();
+        for(  ; it != state->end() ; it++ ) {
+          step.contributions.push_back( SaturationStep::Contribution(0,*it) );
+          step.contributions.back().weight =
+            poststar_eps_weight( t,*it,step.delta );
+        }
+      }
+      else {
+        Config::reverse_iterator bwit = config->rbegin();
+        for( ; bwit != config->rend() ; bwit++ ) {
+          step.contributions.push_back( SaturationStep::Contribution(&*bwit,0) );
+          step.contributions.back().weight =
+            prestar_rule_weight( t,*bwit,step.delta );
+        }
+
+        r2hash_t::iterator r2it = r2hash.find( t->stack() );
+        if( r2it != r2hash.end() ) {
+          std::list< rule_t > & ls = r2it->second;
+          std::list< rule_t >::iterator lsit;
+          for( lsit = ls.begin() ; lsit != ls.end() ; lsit++ ) {
+            rule_t & r = *lsit;
+            wfa::ITrans *tp = fa.find(r->to_state(),r->to_stack1(),t->from());
+            if( tp != 0 ) {
+              step.contributions.push_back( SaturationStep::Contribution(&r,tp) );
+              step.contributions.back().weight =
+                prestar_call_weight( tp,t,r,step.delta );
+            }
+          }
+        }
+      }
+    }
+
+    void WPDS::applyStep( SaturationStep & step, WFA& fa, bool poststar )
+    {
+      std::vector< SaturationStep::Contribution >::iterator it;
+      for( it = step.contributions.begin() ; it != step.contributions.end() ; it++ )
+      {
+        if( poststar && it->rule != 0 )
+          poststar_apply_trans( step.trans,fa,*it->rule,step.delta,it->weight );
+        else if( poststar )
+          poststar_apply_eps_trans( step.trans,it->partner,it->weight );
+        else if( it->partner == 0 )
+          prestar_apply_trans( step.trans,fa,*it->rule,it->weight );
+        else
+          prestar_apply_call( it->partner,step.trans,*it->rule,it->weight );
+      }
+    }
+
     void WPDS::poststar_handle_eps_trans(wfa::ITrans *teps, wfa::ITrans*tprime, sem_elem_t delta)
     {
-      sem_elem_t wght = tprime->poststar_eps_closure( delta );
+      poststar_apply_eps_trans( teps, tprime, poststar_eps_weight(teps, tprime, delta) );
+    }
+
+    sem_elem_t WPDS::poststar_eps_weight(
+        wfa::ITrans * teps ATTR_UNUSED,
+        wfa::ITrans * tprime,
+        sem_elem_t delta )
+    {
+      return tprime->poststar_eps_closure( delta );
+    }
+
+    void WPDS::poststar_apply_eps_trans(wfa::ITrans *teps, wfa::ITrans*tprime, sem_elem_t wght)
+    {
+      DependencyScope scope(*this, teps, tprime);
       Config * config = make_config( teps->from(),tprime->stack() );
       update( teps->from()
           , tprime->stack()
@@ -543,19 +784,46 @@ namespace wali
         sem_elem_t delta
         )
     {
+      poststar_apply_trans( t, fa, r, delta, poststar_rule_weight(t, r, delta) );
+    }
+
+    sem_elem_t WPDS::poststar_rule_weight(
+        wfa::ITrans* t,
+        rule_t & r,
+        sem_elem_t delta
+        )
+    {
+      // The transition the rule adds to: (p', g', q) for a step rule,
+      // ((p',g'), g'', q) for a push rule.
+      Key from = r->to_state();
+      Key stack = r->to_stack1();
+      if( r->to_stack2() != WALI_EPSILON ) {
+        from = find_gen_state( r->to_state(),r->to_stack1() );
+        stack = r->to_stack2();
+      }
+
+      // A push rule whose state was not generated yet has no
+      // transition to diff against.
+      wfa::ITrans const * existing = (from == WALI_BAD_KEY) ? 0
+        : currentOutputWFA->find(from, stack, t->to());
+      sem_elem_t existing_weight =
+        (existing != 0) ? existing->weight() : t->weight()->zero();
+      return delta->extendAndDiff(r->weight(), existing_weight);
+    }
+
+    void WPDS::poststar_apply_trans(
+        wfa::ITrans* t, // t is a non-epsilon transition
+        WFA & fa,
+        rule_t & r,
+        sem_elem_t delta,
+        sem_elem_t wrule_trans
+        )
+    {
+      DependencyScope scope(*this, t);
       Key rtstate = r->to_state();
       Key rtstack = r->to_stack1();
       
       if( r->to_stack2() == WALI_EPSILON ) {
-        Trans existing;
-        sem_elem_t existing_weight;
-        if (currentOutputWFA->find(rtstate, rtstack, t->to(), existing)) {
-          existing_weight = existing.weight();
-        }
-        else {
-          existing_weight = t->weight()->zero();
-        }
-        sem_elem_t wrule_trans = delta->extendAndDiff(r->weight(), existing_weight);
         // t must be a rule 1 (pop rules handled by poststar_handle_eps_trans)
         update( rtstate, rtstack, t->to(), wrule_trans, r->to() );
       }
@@ -565,16 +833,6 @@ namespace wali
         // and create 2 new transitions
         Key gstate = gen_state( rtstate,rtstack );
 
-        Trans existing;
-        sem_elem_t existing_weight;
-        if (currentOutputWFA->find(gstate, r->to_stack2(), t->to(), existing)) {
-          existing_weight = existing.weight();
-        }
-        else {
-          existing_weight = t->weight()->zero();
-        }
-        sem_elem_t wrule_trans = delta->extendAndDiff(r->weight(), existing_weight);
-
         wfa::ITrans* tprime = 
           update_prime( gstate, t, r, delta, wrule_trans );
 
@@ -608,6 +866,7 @@ namespace wali
               Config * config = make_config( teps->from(),tpstk );
               sem_elem_t epsW = tprime->getDelta()->extend( teps->weight() );
 
+              DependencyScope epsScope(*this, tprime, teps);
               update( teps->from(),tpstk,tpto,
                   epsW, config );
             }
@@ -627,6 +886,14 @@ namespace wali
             getKey(state,stack)));
     }
 
+    Key WPDS::find_gen_state( Key state, Key stack ) const
+    {
+      gen_state_map_t::const_iterator it = gen_states.find( KeyPair(state,stack) );
+      if( it == gen_states.end() )
+        return WALI_BAD_KEY;
+      return it->second;
+    }
+
 
     std::ostream & WPDS::print( std::ostream & o ) const
     {
@@ -772,6 +1039,8 @@ namespace wali
       // make_rule will create links b/w Configs and the Rule
       r = new Rule(from, to, to_stack2, se);
       bool rb = make_rule(from,to,to_stack2,replace_weight,r);
+      if( incremental )
+        note_rule_change(r, !(rb && replace_weight));
 
       // if rb is false then the rule is new
       if( !rb ) {
@@ -824,6 +1093,8 @@ namespace wali
       // make_rule will create links b/w Configs and the Rule
       r = new Rule(from, to, to_stack2, se);
       bool rb = make_rule(from,to,to_stack2,r);
+      if( incremental )
+        note_rule_change(r, true);
 
       // if rb is false then the rule is new
       if( !rb ) {
@@ -915,6 +1186,9 @@ namespace wali
       }
       assert(!(r == NULL));
       bool erasefrom = from->erase(r);
+      ruleChanges++;
+      if( incremental )
+        note_rule_change(r, false);
 /*
       for(Config::const_iterator it = to->begin();
           it != to->end();
@@ -966,7 +1240,7 @@ namespace wali
     {
       Config *cf = find_config( state,stack );
       if( 0 == cf ) {
-        cf = new Config(state,stack);
+        cf = new (configArena.get()) Config(state,stack);
         KeyPair kp(state,stack);
         config_map().insert( kp,cf );
       }
@@ -992,6 +1266,7 @@ namespace wali
         bool replace_weight,
         rule_t& r )
     {
+      ruleChanges++;
       bool exists = false;
       Config::iterator it = f->begin();
       Config::iterator itEND = f->end();
@@ -1047,6 +1322,7 @@ namespace wali
         Key stk2,
         rule_t& r )
     {
+      ruleChanges++;
       bool exists = false;
       Config::iterator it = f->begin();
       Config::iterator itEND = f->end();
@@ -1096,16 +1372,17 @@ namespace wali
 
     bool WPDS::get_from_worklist( wfa::ITrans* & t )
     {
-      if( !worklist->empty() ) {
+      while( !worklist->empty() ) {
         t = worklist->get();
-        return true;
-      }
-      else {
-        // t is a reference to a pointer so
-        // this NULLs out the pointer t.
-        t = 0;
-        return false;
+        // A poststarDemand query leaves the transitions that
+        // cannot reach its targets unprocessed
+        if( demand == 0 || is_demanded(t) )
+          return true;
       }
+      // t is a reference to a pointer so
+      // this NULLs out the pointer t.
+      t = 0;
+      return false;
     }
 
     /**
@@ -1120,8 +1397,14 @@ namespace wali
         Config * cfg
         )
     {
-      wfa::ITrans*t = currentOutputWFA->insert(new Trans(from,stack,to,se)).first;
+      std::pair< wfa::ITrans *, bool > ins = currentOutputWFA->insert(
+          new (currentOutputWFA->getTransArena()) Trans(from,stack,to,interned(se)));
+      wfa::ITrans*t = ins.first;
+      if( !ins.second )
+        internCombined(t);
       t->setConfig(cfg);
+      if( recordingDeps )
+        note_derived(t);
       if (t->modified()) {
         //t->print(std::cout << "Adding transition: ") << "\n";
         worklist->put( t );
@@ -1144,11 +1427,31 @@ namespace wali
         sem_elem_t wWithRule //<! delta \extends r->weight()
         )
     {
-      wfa::ITrans* tmp = new Trans(from,r->to_stack2(),call->to(),wWithRule);
-      wfa::ITrans* t = currentOutputWFA->insert(tmp).first;
+      wfa::ITrans* tmp = new (currentOutputWFA->getTransArena()) Trans(from,r->to_stack2(),call->to(),interned(wWithRule));
+      std::pair< wfa::ITrans *, bool > ins = currentOutputWFA->insert(tmp);
+      wfa::ITrans* t = ins.first;
+      if( !ins.second )
+        internCombined(t);
+      if( recordingDeps )
+        note_derived(t);
       return t;
     }
 
+    sem_elem_t WPDS::interned( sem_elem_t se ) const
+    {
+      return interner ? interner->intern(se) : se;
+    }
+
+    void WPDS::internCombined( wfa::ITrans * t ) const
+    {
+      if( !interner )
+        return;
+      // setWeight also sets the delta
+      sem_elem_t delta = t->getDelta();
+      t->setWeight(interner->intern(t->weight()));
+      t->setDelta(delta);
+    }
+
     /////////////////////////////////////////////////////////////////
     // Implement TransFunctor.
     // This is used to copy Transitions from the input automaton
@@ -1172,6 +1475,8 @@ namespace wali
 
       // fa.addTrans takes ownership of passed in pointer
       currentOutputWFA->addTrans( t );
+      if( recordingDeps )
+        note_seed(t);
 
       // add t to the worklist for saturation
       worklist->put( t );
@@ -1197,7 +1502,12 @@ namespace wali
          << "   rules:  " << rules.pushRules.size() + rules.popRules.size() + rules.stepRules.size() << "\n"
          << "   pushes: " << rules.pushRules.size() << "\n"
          << "   steps:  " << rules.stepRules.size() << "\n"
-         << "   pops:   " << rules.popRules.size() << "\n";
+         << "   pops:   " << rules.popRules.size() << "\n"
+         << "\n"
+         << "   configs:            " << config_map().size() << "\n"
+         << "   config allocations: " << configArena->numAllocations() << "\n"
+         << "   config live bytes:  " << configArena->bytesLive() << "\n"
+         << "   config arena bytes: " << configArena->bytesReserved() << "\n";
     }
 
     namespace details {
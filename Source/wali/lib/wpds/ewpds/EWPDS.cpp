@@ -302,9 +302,9 @@ namespace wali
       }
 
       // delta is the delta weight on t2
-      void EWPDS::prestar_handle_call(
+      sem_elem_t EWPDS::prestar_call_weight(
           wfa::ITrans* t1,
-          wfa::ITrans* t2,
+          wfa::ITrans* t2 ATTR_UNUSED,
           rule_t &r,
           sem_elem_t delta
           )
@@ -316,21 +316,29 @@ namespace wali
         //r->print(std::cout << "r = ") << "\n";
 
         ETrans *et1 = dynamic_cast<ETrans *> (t1);
-        ETrans *et2 = dynamic_cast<ETrans *> (t2);
-
-        assert(!(et1 == 0 && et2 != 0));
 
-        sem_elem_t w1, wNew;
+        sem_elem_t w1;
 
         // Compute weight on the resulting transition
         if(et1 != 0) {
           erule_t er = (ERule *)(r.get_ptr());
           w1 = er->merge_fn()->apply_f(t1->weight()->one(), t1->weight());
-          wNew = w1->extend(delta);
         } else {
           w1 = r->weight()->extend(t1->weight());
         }
-        wNew = w1->extend(delta);
+        return w1->extend(delta);
+      }
+
+      void EWPDS::prestar_apply_call(
+          wfa::ITrans* t1 ATTR_UNUSED,
+          wfa::ITrans* t2,
+          rule_t &r,
+          sem_elem_t wNew
+          )
+      {
+        ETrans *et2 = dynamic_cast<ETrans *> (t2);
+
+        assert(!(dynamic_cast<ETrans *> (t1) == 0 && et2 != 0));
 
         // Find the appropriate type for the resulting transition
         if(et2 != 0) {
@@ -347,9 +355,8 @@ namespace wali
 
       }
 
-      void EWPDS::prestar_handle_trans(
+      sem_elem_t EWPDS::prestar_rule_weight(
           wfa::ITrans * t ,
-          WFA & fa   ,
           rule_t & r,
           sem_elem_t delta
           )
@@ -361,13 +368,26 @@ namespace wali
 
         ETrans *et = dynamic_cast<ETrans *>(t);
 
+        if(r->stack2() != WALI_EPSILON && et != 0) {
+          erule_t er = (ERule *)(r.get_ptr());
+          return er->merge_fn()->apply_f(delta->one(), delta);
+        }
+        return r->weight()->extend( delta );
+      }
+
+      void EWPDS::prestar_apply_trans(
+          wfa::ITrans * t ,
+          WFA & fa   ,
+          rule_t & r,
+          sem_elem_t wrule_trans
+          )
+      {
+        ETrans *et = dynamic_cast<ETrans *>(t);
+
         Key fstate = r->from()->state();
         Key fstack = r->from()->stack();
 
-        sem_elem_t wrule_trans;
         if(r->stack2() == WALI_EPSILON) {
-          wrule_trans = r->weight()->extend( delta );
-
           if(et != 0) {
             update_etrans( fstate, fstack, t->to(), wrule_trans, r->from() );
           } else {
@@ -375,14 +395,6 @@ namespace wali
           }
 
         } else { 
-          erule_t er = (ERule *)(r.get_ptr());
-
-          if(et == 0) {
-            wrule_trans = r->weight()->extend( delta );
-          } else {
-            wrule_trans = er->merge_fn()->apply_f(delta->one(), delta);
-          }
-
           KeyPair kp( t->to(),r->stack2() );
           WFA::kp_map_t::iterator kpit = fa.kpmap.find( kp );
           WFA::kp_map_t::iterator kpitEND = fa.kpmap.end();
@@ -423,18 +435,31 @@ namespace wali
       }
 
 
-      void EWPDS::poststar_handle_trans(
+      sem_elem_t EWPDS::poststar_rule_weight(
+          wfa::ITrans * t ATTR_UNUSED,
+          rule_t & r,
+          sem_elem_t delta
+          )
+      {
+        //return delta->extend( er->extended_weight() );
+        return delta->extend(r->weight());
+      }
+
+      bool EWPDS::supports_incremental() const
+      {
+        return false;
+      }
+
+      void EWPDS::poststar_apply_trans(
           wfa::ITrans * t ,
           WFA & fa   ,
           rule_t & r,
-          sem_elem_t delta
+          sem_elem_t delta,
+          sem_elem_t wrule_trans
           )
       {
         Key rtstate = r->to_state();
         Key rtstack = r->to_stack1();
-        sem_elem_t wrule_trans = delta->extend(r->weight());
-
-        //sem_elem_t wrule_trans = delta->extend( er->extended_weight() );
 
         if( r->to_stack2() == WALI_EPSILON ) {
           //update( rtstate, rtstack, t->to(), wrule_trans, r->to() );
@@ -566,13 +591,16 @@ namespace wali
           )
       {
 
-        wfa::ITrans *t;
+        std::pair< wfa::ITrans *, bool > ins;
         if(addEtrans) {
-          t = currentOutputWFA->insert(new ETrans(from, stack, to,
-                0, se, 0)).first;
+          ins = currentOutputWFA->insert(new (currentOutputWFA->getTransArena()) ETrans(from, stack, to,
+                0, interned(se), 0));
         } else {
-          t = currentOutputWFA->insert(new wfa::Trans(from, stack, to, se)).first;
+          ins = currentOutputWFA->insert(new (currentOutputWFA->getTransArena()) wfa::Trans(from, stack, to, interned(se)));
         }
+        wfa::ITrans *t = ins.first;
+        if( !ins.second )
+          internCombined(t);
 
         t->setConfig(cfg);
         if (t->modified()) {
@@ -596,11 +624,13 @@ namespace wali
         //
         ERule* er = (ERule*)r.get_ptr();
         wfa::ITrans* tmp = 
-          new ETrans(
+          new (currentOutputWFA->getTransArena()) ETrans(
               from, r->to_stack2(), call->to(),
-              delta, wWithRule, er);
-        wfa::ITrans* t = currentOutputWFA->insert(tmp).first;
-        return t;
+              delta, interned(wWithRule), er);
+        std::pair< wfa::ITrans *, bool > ins = currentOutputWFA->insert(tmp);
+        if( !ins.second )
+          internCombined(ins.first);
+        return ins.first;
       }
 
     } // namespace ewpds
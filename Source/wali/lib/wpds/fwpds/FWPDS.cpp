@@ -33,6 +33,7 @@
 
 // ::wali::wpds::fwpds
 #include "wali/wpds/fwpds/FWPDS.hpp"
+#include "wali/wpds/fwpds/FwpdsSummaryCache.hpp"
 #include "wali/wpds/fwpds/LazyTrans.hpp"
 
 // ::wali::graph
@@ -49,19 +50,19 @@ using namespace wali::wpds::ewpds;
 
 const std::string FWPDS::XMLTag("FWPDS");
 
-FWPDS::FWPDS() : EWPDS(), interGr(NULL), checkingPhase(false), newton(false), topDown(true)
+FWPDS::FWPDS() : EWPDS(), interGr(NULL), checkingPhase(false), newton(false), topDown(true), sharedDag(0), summaries(0)
 {
 }
 
-FWPDS::FWPDS(ref_ptr<wpds::Wrapper> wr) : EWPDS(wr) , interGr(NULL), checkingPhase(false), newton(false), topDown(true)
+FWPDS::FWPDS(ref_ptr<wpds::Wrapper> wr) : EWPDS(wr) , interGr(NULL), checkingPhase(false), newton(false), topDown(true), sharedDag(0), summaries(0)
 {
 }
 
-FWPDS::FWPDS( const FWPDS& f ) : EWPDS(f),interGr(NULL),checkingPhase(false), newton(f.newton), topDown(f.topDown)
+FWPDS::FWPDS( const FWPDS& f ) : EWPDS(f),interGr(NULL),checkingPhase(false), newton(f.newton), topDown(f.topDown), sharedDag(0), summaries(0), newtonSolver(f.newtonSolver)
 {
 }
 
-FWPDS::FWPDS(bool _newton) : EWPDS(), checkingPhase(false), newton(_newton), topDown(true)
+FWPDS::FWPDS(bool _newton) : EWPDS(), checkingPhase(false), newton(_newton), topDown(true), sharedDag(0), summaries(0)
 {
 }
 
@@ -83,11 +84,19 @@ void FWPDS::topDownEval(bool f) {
   // is no worse than what it used to be
 }
 
+void FWPDS::shareRegExpDag(graph::RegExpDag * dag) {
+  sharedDag = dag;
+}
+
 struct FWPDSCopyBackFunctor : public wfa::TransFunctor
 {
   graph::InterGraphPtr gr;
-  FWPDSCopyBackFunctor(graph::InterGraphPtr _gr) : gr(_gr) {}
+  FwpdsSummaryCache const * summaries;
+  FWPDSCopyBackFunctor(graph::InterGraphPtr _gr, FwpdsSummaryCache const * s = 0) : gr(_gr), summaries(s) {}
   virtual void operator()( wfa::ITrans* t ) {
+    // Transitions copied from the summaries already have weights
+    if( summaries != 0 && summaries->reused(*t) )
+      return;
     LazyTrans *lt = static_cast<LazyTrans *> (t);
     lt->setInterGraph(gr);
     
@@ -178,7 +187,10 @@ void FWPDS::prestar( wfa::WFA const & input, wfa::WFA& output )
 {
   // setup output
   addEtrans = true;
-  EWPDS::prestarSetupFixpoint(input,output);
+  if(summaries != 0)
+    summaries->setupPrestar(input,output);
+  else
+    EWPDS::prestarSetupFixpoint(input,output);
   addEtrans = false;
 
   // If theZero is invalid, then there
@@ -197,7 +209,7 @@ void FWPDS::prestar( wfa::WFA const & input, wfa::WFA& output )
   // merge functions, it can be treated as a WPDS.
   // However, there is no cost benefit in using WPDS
   // (it only saves on debugging effort)
-  interGr = new graph::InterGraph(theZero, true, true);
+  interGr = new graph::InterGraph(theZero, true, true, false, sharedDag);
   interGr->dag->topDownEval(topDown);
   interGrs.push_back(interGr);
 
@@ -210,9 +222,18 @@ void FWPDS::prestar( wfa::WFA const & input, wfa::WFA& output )
 
   // Compute summaries
   if(newton)
+  {
+    interGr->setNewtonSolver(newtonSolver);
     interGr->setupNewtonSolution();
-  else
+    newtonStats = interGr->getNewtonStats();
+  }
+  else {
+    if(getParallelism() > 1)
+      interGr->setThreadPool(threadPool());
     interGr->setupInterSolution();
+    // interGr outlives the query; do not keep the threads alive with it
+    interGr->setThreadPool(boost::shared_ptr<util::WorkStealingPool>());
+  }
 
   //interGr->print(std::cout << "THE INTERGRAPH\n",graphPrintKey);
 
@@ -220,7 +241,7 @@ void FWPDS::prestar( wfa::WFA const & input, wfa::WFA& output )
   // output WFA. This does not do computation on weights,
   // but instead uses LazyTrans to put in "lazy" weights
   // that are evaluated on demand.
-  FWPDSCopyBackFunctor copier( interGr );
+  FWPDSCopyBackFunctor copier( interGr, summaries );
   output.for_each(copier);
 
 
@@ -230,6 +251,11 @@ void FWPDS::prestar( wfa::WFA const & input, wfa::WFA& output )
   currentOutputWFA = 0;
 }
 
+bool FWPDS::saturate_in_parallel() const
+{
+  return checkingPhase && EWPDS::saturate_in_parallel();
+}
+
 void FWPDS::prestar_handle_call(wfa::ITrans *t1,
     wfa::ITrans *t2,
     rule_t &r,
@@ -373,6 +399,21 @@ void FWPDS::poststar( wfa::WFA const & input, wfa::WFA& output ) {
   //interGr->print_stats(*waliErr) << "\n";
 }
 
+void FWPDS::poststarBatch(
+    std::vector< wfa::WFA const * > const & inputs,
+    std::vector< wfa::WFA > & outputs )
+{
+  outputs.clear();
+  outputs.resize( inputs.size() );
+  for( size_t i = 0 ; i < inputs.size() ; i++ )
+    poststar( *inputs[i], outputs[i] );
+}
+
+bool FWPDS::supports_demand() const
+{
+  return false;
+}
+
 void FWPDS::poststarIGR( wfa::WFA const & input, wfa::WFA& output )
 {
 
@@ -393,7 +434,7 @@ void FWPDS::poststarIGR( wfa::WFA const & input, wfa::WFA& output )
   // underlying pds is a EWPDS. In the absence of
   // merge functions, it can be treated as a WPDS.
   // However, there is no cost benefit in using WPDS
-  interGr = new graph::InterGraph(theZero, true, false);
+  interGr = new graph::InterGraph(theZero, true, false, false, sharedDag);
   interGr->dag->topDownEval(topDown);
   interGrs.push_back(interGr);
 
@@ -409,10 +450,16 @@ void FWPDS::poststarIGR( wfa::WFA const & input, wfa::WFA& output )
     util::Timer timer(msg);
     // Compute summaries
     if(newton){
+      interGr->setNewtonSolver(newtonSolver);
       interGr->setupNewtonSolution();
+      newtonStats = interGr->getNewtonStats();
     }
-    else
+    else {
+      if(getParallelism() > 1)
+        interGr->setThreadPool(threadPool());
       interGr->setupInterSolution();
+      interGr->setThreadPool(boost::shared_ptr<util::WorkStealingPool>());
+    }
   }
 
   //interGr->print(std::cout << "THE INTERGRAPH\n",graphPrintKey);
@@ -421,7 +468,7 @@ void FWPDS::poststarIGR( wfa::WFA const & input, wfa::WFA& output )
   // output WFA. This does not do computation on weights,
   // but instead uses LazyTrans to put in "lazy" weights
   // that are evaluated on demand.
-  FWPDSCopyBackFunctor copier( interGr );
+  FWPDSCopyBackFunctor copier( interGr, summaries );
   output.for_each(copier);
 
   checkResults(input,true);
@@ -500,13 +547,23 @@ void FWPDS::poststar_handle_trans(
     Key gstate = gen_state( rtstate,rtstack );
     // Note: QuasiOne is not supported in FWPDS
 
+    if(summaries != 0) {
+      // The callee's same-level transitions, starting with
+      // (p,g',(p,g')), come from the cache instead of saturation.
+      // They must be in place before tprime looks for epsilon
+      // transitions below.
+      summaries->loadPoststar(KeyPair(rtstate,rtstack), gstate);
+    }
+
     wfa::ITrans* tprime = update_prime( gstate, t, r, delta, wghtOne);
-    update( rtstate, rtstack, gstate, wghtOne, r->to() );
+    if(summaries == 0) {
+      update( rtstate, rtstack, gstate, wghtOne, r->to() );
 
-    // add source edge
-    interGr->setSource(Transition(rtstate,rtstack, gstate), wghtOne);
-    // add edge (p,g,q) -> (p,g',(p,g'))
-    interGr->addCallEdge(Transition(*t),Transition(rtstate,rtstack, gstate));
+      // add source edge
+      interGr->setSource(Transition(rtstate,rtstack, gstate), wghtOne);
+      // add edge (p,g,q) -> (p,g',(p,g'))
+      interGr->addCallEdge(Transition(*t),Transition(rtstate,rtstack, gstate));
+    }
     // add call-ret edge (p,g,q) -> ((p,g'),rstk2,q)
     interGr->addCallRetEdge(Transition(*t),
         Transition(gstate, r->to_stack2(),t->to()),
@@ -540,6 +597,16 @@ bool FWPDS::isOutputTensored()
   return false;
 }
 
+void FWPDS::setNewtonSolver(boost::shared_ptr<graph::NewtonSolver> s)
+{
+  newtonSolver = s;
+}
+
+graph::NewtonStats const & FWPDS::getNewtonStats() const
+{
+  return newtonStats;
+}
+
 ////////////////////////////////////////////
 // These guys take care of LazyTrans stuff
 ////////////////////////////////////////////
@@ -557,13 +624,13 @@ void FWPDS::update(
 
   wfa::ITrans *t;
   if(addEtrans) {
-    t = new ETrans(from, stack, to, 0, se, 0);
+    t = new (currentOutputWFA->getTransArena()) ETrans(from, stack, to, 0, interned(se), 0);
   } else {
-    t = new wfa::Trans(from, stack, to, se);
+    t = new (currentOutputWFA->getTransArena()) wfa::Trans(from, stack, to, interned(se));
   }
   t->setConfig(cfg);
 
-  LazyTrans * lt = new LazyTrans(t);
+  LazyTrans * lt = new (currentOutputWFA->getTransArena()) LazyTrans(t);
   t = currentOutputWFA->insert(lt).first;
 
   if( t->modified() ) {
@@ -591,10 +658,10 @@ wfa::ITrans* FWPDS::update_prime(
   //
   ERule* er = (ERule*)r.get_ptr();
   wfa::ITrans* et = 
-    new ETrans(
+    new (currentOutputWFA->getTransArena()) ETrans(
         from, r->to_stack2(), call->to(),
-        delta, wWithRule, er);
-  LazyTrans* lt = new LazyTrans(et);
+        delta, interned(wWithRule), er);
+  LazyTrans* lt = new (currentOutputWFA->getTransArena()) LazyTrans(et);
   wfa::ITrans* t = currentOutputWFA->insert(lt).first;
   return t;
 }
@@ -614,7 +681,7 @@ void FWPDS::operator()( wfa::ITrans const * orig ) {
   sem_elem_t se = 
     (wrapper.is_valid()) ? wrapper->wrap(*orig) : orig->weight();
 
-  LazyTrans *t = new LazyTrans( orig->copy() );
+  LazyTrans *t = new (currentOutputWFA->getTransArena()) LazyTrans( orig->copy() );
 
   t->setConfig(c);
   t->setWeight(se);
@@ -0,0 +1,669 @@
+/**
+ * @file FwpdsSummaryCache-io.cpp
+ *
+ * Saving FwpdsSummaryCache summaries to disk and loading them back.
+ *
+ * A file is a FileHeader followed by five sections, each starting at
+ * an offset the header gives:
+ *
+ *   keys      numKeys offsets (uint64) of key records, each a tag byte
+ *             (0 string, 1 int), a uint32 length and the bytes
+ *   entries   numEntries EntryRecords; entry i's summaries are the
+ *             TransRecords [first, first+count)
+ *   trans     TransRecords of every entry, then numPops pop summaries
+ *   weights   the bytes SemElem::serialize wrote, which TransRecords
+ *             refer to by offset and size
+ *
+ * Numbers are in the byte order of the machine that wrote the file;
+ * load rejects files from the other order.
+ */
+
+#include "wali/Common.hpp"
+#include "wali/IntSource.hpp"
+#include "wali/KeySource.hpp"
+#include "wali/StringSource.hpp"
+#include "wali/MergeFn.hpp"
+
+// ::wali::util
+#include "wali/util/MappedFile.hpp"
+
+// ::wali::wfa
+#include "wali/wfa/Trans.hpp"
+
+// ::wali::wpds
+#include "wali/wpds/Rule.hpp"
+#include "wali/wpds/RuleFunctor.hpp"
+#include "wali/wpds/GenKeySource.hpp"
+
+// ::wali::wpds::ewpds
+#include "wali/wpds/ewpds/ERule.hpp"
+#include "wali/wpds/ewpds/ETrans.hpp"
+
+// ::wali::wpds::fwpds
+#include "wali/wpds/fwpds/FWPDS.hpp"
+#include "wali/wpds/fwpds/FwpdsSummaryCache.hpp"
+#include "wali/wpds/fwpds/LazyTrans.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#include <stdint.h>
+
+namespace wali
+{
+  namespace wpds
+  {
+    namespace fwpds
+    {
+      namespace
+      {
+        char const FILE_MAGIC[8] = { 'W', 'A', 'L', 'I', 'S', 'U', 'M', 0 };
+        uint32_t const FILE_VERSION = 1;
+        uint32_t const FILE_BYTE_ORDER = 0x01020304;
+
+        struct FileHeader
+        {
+          char magic[8];
+          uint32_t version;
+          uint32_t byteOrder;
+          uint64_t rules;         //!< fingerprint of the rules
+          uint32_t hasPost;
+          uint32_t hasPre;
+          uint64_t numKeys, keysAt;
+          uint64_t numEntries, entriesAt;
+          uint64_t numTrans, transAt;
+          uint64_t popsFirst, numPops;
+          uint64_t weightsAt, weightsSize;
+        };
+
+        struct EntryRecord
+        {
+          uint32_t state, stack;  //!< keys
+          uint64_t first, count;  //!< TransRecords
+        };
+
+        enum {
+          FROM_ENTRY = 1,   //!< from is the generated state of an entry
+          IS_ETRANS = 2,
+          HAS_CALL = 4,     //!< ETrans with a weight at the call
+          HAS_RULE = 8      //!< ETrans of the push rule into the from entry
+        };
+
+        struct TransRecord
+        {
+          uint32_t from;          //!< key, or entry with FROM_ENTRY
+          uint32_t stack;         //!< key
+          uint32_t to;            //!< key; for entries, unused
+          uint32_t flags;
+          uint64_t weight, callWeight;
+          uint32_t weightSize, callWeightSize;
+        };
+
+        template< typename T >
+        T readAt( char const * base, uint64_t at )
+        {
+          T t;
+          std::memcpy(&t, base + at, sizeof(T));
+          return t;
+        }
+
+        /// true if the n bytes at off do not all lie in the first
+        /// size bytes, without overflowing
+        bool outside( uint64_t off, uint64_t n, uint64_t size )
+        {
+          return off > size || n > size - off;
+        }
+
+        template< typename T >
+        void append( std::string & out, T const & t )
+        {
+          out.append(reinterpret_cast<char const *>(&t), sizeof(T));
+        }
+
+        uint64_t fnv( uint64_t h, std::string const & bytes )
+        {
+          for( size_t i = 0 ; i < bytes.size() ; i++ ) {
+            h ^= static_cast<unsigned char>(bytes[i]);
+            h *= 1099511628211ULL;
+          }
+          return h;
+        }
+
+        /// The portable form of k: a tag and the string or int it
+        /// was made from
+        bool keyBytes( Key k, std::string & out )
+        {
+          key_src_t src = getKeySource(k);
+          std::ostringstream os;
+          if( StringSource * ss = dynamic_cast<StringSource *>(src.get_ptr()) ) {
+            os.put(0);
+            os << ss->getString();
+          }
+          else if( IntSource * is = dynamic_cast<IntSource *>(src.get_ptr()) ) {
+            os.put(1);
+            os << is->getInt();
+          }
+          else {
+            return false;
+          }
+          out = os.str();
+          return true;
+        }
+
+        bool weightBytes( sem_elem_t w, std::string & out )
+        {
+          std::ostringstream os;
+          if( !w->serialize(os) )
+            return false;
+          out = os.str();
+          return true;
+        }
+
+        /// Sums a hash of every rule, so the order of the rules does
+        /// not matter
+        class Fingerprint : public ConstRuleFunctor
+        {
+          public:
+            Fingerprint() : sum(0), portable(true) {}
+
+            virtual void operator()( rule_t const & r )
+            {
+              uint64_t h = 14695981039346656037ULL;
+              Key keys[] = { r->from_state(), r->from_stack(), r->to_state(), r->to_stack1(), r->to_stack2() };
+              std::string bytes;
+              for( size_t i = 0 ; i < sizeof(keys) / sizeof(keys[0]) ; i++ ) {
+                if( !keyBytes(keys[i], bytes) ) {
+                  portable = false;
+                  return;
+                }
+                h = fnv(h, bytes);
+                h = fnv(h, std::string(1, '\n'));
+              }
+              if( !weightBytes(r->weight(), bytes) ) {
+                portable = false;
+                return;
+              }
+              h = fnv(h, bytes);
+              ewpds::ERule const * er = dynamic_cast<ewpds::ERule const *>(r.get_ptr());
+              if( er != 0 && er->merge_fn().is_valid() ) {
+                std::ostringstream os;
+                er->merge_fn()->print(os);
+                h = fnv(h, os.str());
+              }
+              sum += h;
+            }
+
+            uint64_t sum;
+            bool portable;
+        };
+
+        ewpds::ETrans const * asETrans( wfa::ITrans const * t )
+        {
+          if( LazyTrans const * lt = dynamic_cast<LazyTrans const *>(t) )
+            return const_cast<LazyTrans *>(lt)->getETrans();
+          return dynamic_cast<ewpds::ETrans const *>(t);
+        }
+
+        /// Builds the sections of a file in memory
+        class Writer
+        {
+          public:
+            Writer() : ok(true), numTrans(0) {}
+
+            uint32_t key( Key k )
+            {
+              HashMap< Key, uint32_t >::iterator it = keyIds.find(k);
+              if( it != keyIds.end() )
+                return it->second;
+              std::string bytes;
+              if( !keyBytes(k, bytes) ) {
+                ok = false;
+                return 0;
+              }
+              uint32_t id = static_cast<uint32_t>(keyOffsets.size());
+              keyIds.insert(k, id);
+              keyOffsets.push_back(keyData.size());
+              keyData.push_back(bytes[0]);
+              append(keyData, static_cast<uint32_t>(bytes.size() - 1));
+              keyData.append(bytes, 1, std::string::npos);
+              return id;
+            }
+
+            void weight( sem_elem_t w, uint64_t & at, uint32_t & size )
+            {
+              std::string bytes;
+              if( !w.is_valid() || !weightBytes(w, bytes) ) {
+                ok = false;
+                return;
+              }
+              at = weights.size();
+              size = static_cast<uint32_t>(bytes.size());
+              weights += bytes;
+            }
+
+            void trans( wfa::ITrans const * t, uint32_t from, uint32_t flags, uint32_t to )
+            {
+              TransRecord rec;
+              std::memset(&rec, 0, sizeof(rec));
+              rec.from = from;
+              rec.stack = key(t->stack());
+              rec.to = to;
+              weight(t->weight(), rec.weight, rec.weightSize);
+
+              ewpds::ETrans const * et = asETrans(t);
+              if( et != 0 ) {
+                flags |= IS_ETRANS;
+                if( et->getWeightAtCall().is_valid() ) {
+                  flags |= HAS_CALL;
+                  weight(et->getWeightAtCall(), rec.callWeight, rec.callWeightSize);
+                }
+                if( et->getERule().is_valid() ) {
+                  if( !(flags & FROM_ENTRY) )
+                    ok = false;
+                  flags |= HAS_RULE;
+                }
+              }
+              rec.flags = flags;
+              append(transData, rec);
+              numTrans++;
+            }
+
+            bool ok;
+            HashMap< Key, uint32_t > keyIds;
+            std::vector< uint64_t > keyOffsets;
+            std::string keyData;
+            std::string transData;
+            std::string weights;
+            uint64_t numTrans;
+        };
+
+        uint64_t align8( uint64_t n )
+        {
+          return (n + 7) & ~static_cast<uint64_t>(7);
+        }
+      }
+
+      struct FwpdsSummaryCache::FileIndex
+      {
+        explicit FileIndex( std::string const & path ) : map(path), post(false), pre(false) {}
+
+        util::MappedFile map;
+        FileHeader header;
+        std::vector< Key > keys;
+        std::vector< KeyPair > entries;
+        HashMap< KeyPair, uint32_t > entryIds;
+        bool post;   //!< poststar summaries not yet computed again
+        bool pre;    //!< prestar summaries not yet computed again
+
+        TransRecord trans( uint64_t i ) const {
+          return readAt< TransRecord >(map.data(), header.transAt + i * sizeof(TransRecord));
+        }
+      };
+
+      bool FwpdsSummaryCache::save( std::string const & path )
+      {
+        bool post = usable(true);
+        bool pre = usable(false);
+        if( !post && !pre )
+          return false;
+
+        Fingerprint fp;
+        pds.for_each(fp);
+        if( !fp.portable )
+          return false;
+
+        if( post && (!havePost || postRules != pds.getRuleChanges()) )
+          buildPoststar();
+        if( pre ) {
+          if( !havePre || preRules != pds.getRuleChanges() || !decodePops() )
+            buildPrestar();
+        }
+
+        Writer w;
+
+        // Number the entries, and decode whatever the loaded file still
+        // holds so that it is written out too
+        std::vector< KeyPair > entries;
+        HashMap< KeyPair, uint32_t > entryIds;
+        if( post ) {
+          for( gen_map_t::iterator it = entryOf.begin() ; it != entryOf.end() ; it++ ) {
+            if( entryIds.insert(it->second, static_cast<uint32_t>(entries.size())).second )
+              entries.push_back(it->second);
+          }
+          damaged = false;
+          for( size_t i = 0 ; i < entries.size() && !damaged ; i++ ) {
+            if( postByEntry.find(entries[i]) == postByEntry.end() )
+              decodeEntry(entries[i]);
+          }
+          if( damaged ) {
+            damaged = false;
+            buildPoststar();
+          }
+        }
+
+        std::string entryData;
+        for( size_t i = 0 ; i < entries.size() ; i++ ) {
+          EntryRecord rec;
+          rec.state = w.key(entries[i].first);
+          rec.stack = w.key(entries[i].second);
+          rec.first = w.numTrans;
+
+          entry_map_t::iterator eit = postByEntry.find(entries[i]);
+          if( eit != postByEntry.end() ) {
+            trans_list_t & summaries = eit->second;
+            for( trans_list_t::iterator sit = summaries.begin() ; sit != summaries.end() ; sit++ ) {
+              gen_map_t::iterator git = entryOf.find((*sit)->from());
+              if( git != entryOf.end() )
+                w.trans(*sit, entryIds.find(git->second)->second, FROM_ENTRY, 0);
+              else
+                w.trans(*sit, w.key((*sit)->from()), 0, 0);
+            }
+          }
+          rec.count = w.numTrans - rec.first;
+          append(entryData, rec);
+        }
+
+        uint64_t popsFirst = w.numTrans;
+        if( pre ) {
+          for( trans_list_t::iterator it = popSummaries.begin() ; it != popSummaries.end() ; it++ )
+            w.trans(*it, w.key((*it)->from()), 0, w.key((*it)->to()));
+        }
+        if( !w.ok )
+          return false;
+
+        FileHeader h;
+        std::memset(&h, 0, sizeof(h));
+        std::memcpy(h.magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+        h.version = FILE_VERSION;
+        h.byteOrder = FILE_BYTE_ORDER;
+        h.rules = fp.sum;
+        h.hasPost = post;
+        h.hasPre = pre;
+        h.numKeys = w.keyOffsets.size();
+        h.keysAt = sizeof(FileHeader);
+        uint64_t keyDataAt = h.keysAt + h.numKeys * sizeof(uint64_t);
+        h.numEntries = entries.size();
+        h.entriesAt = align8(keyDataAt + w.keyData.size());
+        h.numTrans = w.numTrans;
+        h.transAt = h.entriesAt + entryData.size();
+        h.popsFirst = popsFirst;
+        h.numPops = w.numTrans - popsFirst;
+        h.weightsAt = h.transAt + w.transData.size();
+        h.weightsSize = w.weights.size();
+
+        std::string out;
+        append(out, h);
+        for( size_t i = 0 ; i < w.keyOffsets.size() ; i++ )
+          append(out, static_cast<uint64_t>(keyDataAt + w.keyOffsets[i]));
+        out += w.keyData;
+        out.resize(h.entriesAt, 0);
+        out += entryData;
+        out += w.transData;
+        out += w.weights;
+
+        std::ofstream f(path.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+        f.write(out.data(), static_cast<std::streamsize>(out.size()));
+        return static_cast<bool>(f);
+      }
+
+      bool FwpdsSummaryCache::load( std::string const & path )
+      {
+        if( !pds.theZero.is_valid() )
+          return false;
+
+        boost::shared_ptr< FileIndex > fi(new FileIndex(path));
+        char const * base = fi->map.data();
+        uint64_t size = fi->map.size();
+        if( !fi->map.is_open() || size < sizeof(FileHeader) )
+          return false;
+
+        FileHeader & h = fi->header;
+        h = readAt< FileHeader >(base, 0);
+        if( std::memcmp(h.magic, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0
+            || h.version != FILE_VERSION || h.byteOrder != FILE_BYTE_ORDER )
+          return false;
+
+        // Every table must lie inside the file. The counts are checked
+        // by division first so that the products cannot overflow.
+        if( h.numKeys > size / sizeof(uint64_t)
+            || outside(h.keysAt, h.numKeys * sizeof(uint64_t), size)
+            || h.numEntries > size / sizeof(EntryRecord)
+            || outside(h.entriesAt, h.numEntries * sizeof(EntryRecord), size)
+            || h.numTrans > size / sizeof(TransRecord)
+            || outside(h.transAt, h.numTrans * sizeof(TransRecord), size)
+            || h.popsFirst > h.numTrans
+            || h.numPops != h.numTrans - h.popsFirst
+            || outside(h.weightsAt, h.weightsSize, size) )
+          return false;
+
+        Fingerprint fp;
+        pds.for_each(fp);
+        if( !fp.portable || fp.sum != h.rules )
+          return false;
+
+        for( uint64_t i = 0 ; i < h.numKeys ; i++ ) {
+          uint64_t at = readAt< uint64_t >(base, h.keysAt + i * sizeof(uint64_t));
+          if( outside(at, 5, size) )
+            return false;
+          char tag = base[at];
+          uint32_t len = readAt< uint32_t >(base, at + 1);
+          if( outside(at + 5, len, size) )
+            return false;
+          std::string s(base + at + 5, len);
+          if( tag == 0 )
+            fi->keys.push_back(getKey(s));
+          else if( tag == 1 )
+            fi->keys.push_back(getKey(std::atoi(s.c_str())));
+          else
+            return false;
+        }
+
+        for( uint64_t i = 0 ; i < h.numEntries ; i++ ) {
+          EntryRecord rec = readAt< EntryRecord >(base, h.entriesAt + i * sizeof(EntryRecord));
+          if( rec.state >= h.numKeys || rec.stack >= h.numKeys || outside(rec.first, rec.count, h.popsFirst) )
+            return false;
+          KeyPair entry(fi->keys[rec.state], fi->keys[rec.stack]);
+          fi->entries.push_back(entry);
+          fi->entryIds.insert(entry, static_cast<uint32_t>(i));
+        }
+
+        // Only where the weights are is checked here: they are
+        // deserialized when a query first needs them (see decodeEntry)
+        for( uint64_t i = 0 ; i < h.numTrans ; i++ ) {
+          TransRecord rec = fi->trans(i);
+          bool fromEntry = (rec.flags & FROM_ENTRY) != 0;
+          bool hasCall = (rec.flags & IS_ETRANS) && (rec.flags & HAS_CALL);
+          if( rec.from >= (fromEntry ? h.numEntries : h.numKeys)
+              || rec.stack >= h.numKeys
+              || (i >= h.popsFirst && (fromEntry || rec.to >= h.numKeys))
+              || outside(rec.weight, rec.weightSize, h.weightsSize)
+              || (hasCall && outside(rec.callWeight, rec.callWeightSize, h.weightsSize)) )
+            return false;
+          if( fromEntry && (rec.flags & HAS_RULE)
+              && pushRuleInto(fi->keys[rec.stack], fi->entries[rec.from]) == 0 )
+            return false;
+        }
+
+        // The file is good; it replaces what the cache had
+        clear();
+        file = fi;
+        sem_elem_t one = pds.theZero->one();
+
+        if( h.hasPost ) {
+          // Name the generated states as buildPoststar does
+          wfa::WFA names;
+          names.setGeneration(names.getGeneration() + 1);
+          pds.currentOutputWFA = &names;
+          for( size_t i = 0 ; i < fi->entries.size() ; i++ )
+            entryOf.insert(pds.gen_state(fi->entries[i].first, fi->entries[i].second), fi->entries[i]);
+          pds.currentOutputWFA = 0;
+
+          fi->post = true;
+          havePost = true;
+          postRules = pds.getRuleChanges();
+        }
+        if( h.hasPre ) {
+          fi->pre = true;
+          havePre = true;
+          preRules = pds.getRuleChanges();
+        }
+        return true;
+      }
+
+      void FwpdsSummaryCache::forgetFile( bool poststar )
+      {
+        if( file ) {
+          if( poststar )
+            file->post = false;
+          else
+            file->pre = false;
+        }
+      }
+
+      void FwpdsSummaryCache::releaseDecoded()
+      {
+        for( size_t i = 0 ; i < decoded.size() ; i++ )
+          delete decoded[i];
+        decoded.clear();
+      }
+
+      namespace
+      {
+        /// Deserializes the weight of rec, and its weight at the call
+        /// if it has one
+        bool decodeWeights( sem_elem_t proto, char const * weights, TransRecord const & rec,
+                            sem_elem_t & w, sem_elem_t & wAtCall )
+        {
+          w = proto->deserialize(weights + rec.weight, rec.weightSize);
+          if( (rec.flags & IS_ETRANS) && (rec.flags & HAS_CALL) )
+            wAtCall = proto->deserialize(weights + rec.callWeight, rec.callWeightSize);
+          return w.is_valid() && (wAtCall.is_valid() || !(rec.flags & HAS_CALL));
+        }
+
+        void reportBadWeight()
+        {
+          *waliErr << "[WARNING] FwpdsSummaryCache: a saved weight cannot be read;"
+                   << " the summaries are computed again\n";
+        }
+      }
+
+      Rule * FwpdsSummaryCache::pushRuleInto( Key stack, KeyPair callee ) const
+      {
+        FWPDS::r2hash_t::iterator r2it = pds.r2hash.find(stack);
+        if( r2it == pds.r2hash.end() )
+          return 0;
+        std::list< rule_t >::iterator rit = r2it->second.begin();
+        for( ; rit != r2it->second.end() ; rit++ ) {
+          if( (*rit)->to_state() == callee.first && (*rit)->to_stack1() == callee.second )
+            return rit->get_ptr();
+        }
+        return 0;
+      }
+
+      bool FwpdsSummaryCache::decodeEntry( KeyPair entry )
+      {
+        if( !file || !file->post )
+          return false;
+        HashMap< KeyPair, uint32_t >::iterator idit = file->entryIds.find(entry);
+        if( idit == file->entryIds.end() )
+          return false;
+
+        FileHeader const & h = file->header;
+        char const * base = file->map.data();
+        char const * weights = base + h.weightsAt;
+        EntryRecord er = readAt< EntryRecord >(base, h.entriesAt + idit->second * sizeof(EntryRecord));
+
+        // The states are named as in postSummaries, which is what
+        // loadPoststar renames from
+        wfa::WFA names;
+        names.setGeneration(names.getGeneration() + 1);
+        wfa::WFA * saved = pds.currentOutputWFA;
+        pds.currentOutputWFA = &names;
+        Key to = pds.gen_state(entry.first, entry.second);
+
+        trans_list_t summaries;
+        bool good = true;
+        for( uint64_t i = er.first ; good && i < er.first + er.count ; i++ )
+        {
+          TransRecord rec = file->trans(i);
+          Key stack = file->keys[rec.stack];
+          Key from;
+          ewpds::erule_t erule;
+          if( rec.flags & FROM_ENTRY ) {
+            KeyPair callee = file->entries[rec.from];
+            from = pds.gen_state(callee.first, callee.second);
+            if( rec.flags & HAS_RULE ) {
+              // load checked that there is one
+              erule = static_cast<ewpds::ERule *>(pushRuleInto(stack, callee));
+              assert(erule.is_valid());
+            }
+          }
+          else {
+            from = file->keys[rec.from];
+          }
+
+          sem_elem_t w, wAtCall;
+          if( !decodeWeights(pds.theZero, weights, rec, w, wAtCall) ) {
+            good = false;
+            break;
+          }
+          wfa::ITrans * t;
+          if( rec.flags & IS_ETRANS )
+            t = new ewpds::ETrans(from, stack, to, wAtCall, w, erule);
+          else
+            t = new wfa::Trans(from, stack, to, w);
+          decoded.push_back(t);
+          summaries.push_back(t);
+        }
+
+        pds.currentOutputWFA = saved;
+        if( !good ) {
+          // The summaries of the file can no longer be trusted
+          reportBadWeight();
+          forgetFile(true);
+          damaged = true;
+          return false;
+        }
+        postByEntry[entry] = summaries;
+        return true;
+      }
+
+      bool FwpdsSummaryCache::decodePops()
+      {
+        if( !file || !file->pre )
+          return true;
+        file->pre = false;
+
+        FileHeader const & h = file->header;
+        char const * weights = file->map.data() + h.weightsAt;
+        popSummaries.clear();
+        for( uint64_t i = h.popsFirst ; i < h.numTrans ; i++ )
+        {
+          TransRecord rec = file->trans(i);
+          Key from = file->keys[rec.from];
+          Key stack = file->keys[rec.stack];
+          Key to = file->keys[rec.to];
+          sem_elem_t w, wAtCall;
+          if( !decodeWeights(pds.theZero, weights, rec, w, wAtCall) ) {
+            reportBadWeight();
+            popSummaries.clear();
+            return false;
+          }
+          wfa::ITrans * t;
+          if( rec.flags & IS_ETRANS )
+            t = new ewpds::ETrans(from, stack, to, wAtCall, w, ewpds::erule_t());
+          else
+            t = new wfa::Trans(from, stack, to, w);
+          decoded.push_back(t);
+          popSummaries.push_back(t);
+        }
+        return true;
+      }
+
+    } // namespace fwpds
+
+  } // namespace wpds
+
+} // namespace wali
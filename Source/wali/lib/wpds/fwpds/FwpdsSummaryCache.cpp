@@ -0,0 +1,361 @@
+/**
+ * @file FwpdsSummaryCache.cpp
+ */
+
+#include "wali/Common.hpp"
+
+// ::wali::wfa
+#include "wali/wfa/WFA.hpp"
+#include "wali/wfa/TransFunctor.hpp"
+
+// ::wali::wpds
+#include "wali/wpds/Rule.hpp"
+
+// ::wali::wpds::ewpds
+#include "wali/wpds/ewpds/ETrans.hpp"
+
+// ::wali::wpds::fwpds
+#include "wali/wpds/fwpds/FWPDS.hpp"
+#include "wali/wpds/fwpds/FwpdsSummaryCache.hpp"
+#include "wali/wpds/fwpds/LazyTrans.hpp"
+
+// ::wali::graph
+#include "wali/graph/InterGraph.hpp"
+
+namespace wali
+{
+  namespace wpds
+  {
+    namespace fwpds
+    {
+      namespace
+      {
+        /// Collects the transitions of a WFA that end in one of a set
+        /// of states
+        template< typename Select >
+        struct CollectSummaries : public wfa::ConstTransFunctor
+        {
+          Select select;
+
+          CollectSummaries( Select s ) : select(s) {}
+
+          virtual void operator()( wfa::ITrans const * t ) {
+            select(t);
+          }
+        };
+
+        struct SelectIntoEntry
+        {
+          HashMap< Key, KeyPair > const & entryOf;
+          HashMap< KeyPair, std::vector< wfa::ITrans const * > > & byEntry;
+
+          SelectIntoEntry(
+              HashMap< Key, KeyPair > const & e,
+              HashMap< KeyPair, std::vector< wfa::ITrans const * > > & b ) :
+            entryOf(e), byEntry(b) {}
+
+          void operator()( wfa::ITrans const * t ) {
+            HashMap< Key, KeyPair >::const_iterator it = entryOf.find(t->to());
+            if( it != entryOf.end() )
+              byEntry[it->second].push_back(t);
+          }
+        };
+
+        struct SelectIntoPdsState
+        {
+          FWPDS const & pds;
+          std::vector< wfa::ITrans const * > & out;
+
+          SelectIntoPdsState( FWPDS const & p, std::vector< wfa::ITrans const * > & o ) :
+            pds(p), out(o) {}
+
+          void operator()( wfa::ITrans const * t ) {
+            if( pds.is_pds_state(t->to()) )
+              out.push_back(t);
+          }
+        };
+      }
+
+      /// Attaches the cache to the FWPDS for the duration of a query
+      class FwpdsSummaryCache::QueryScope
+      {
+        public:
+          QueryScope( FwpdsSummaryCache & c, bool poststar ) : cache(c)
+          {
+            cache.inPoststar = poststar;
+            cache.loaded.clear();
+            cache.pds.summaries = &cache;
+          }
+
+          ~QueryScope()
+          {
+            cache.pds.summaries = 0;
+            cache.loaded.clear();
+          }
+
+        private:
+          FwpdsSummaryCache & cache;
+      };
+
+      FwpdsSummaryCache::FwpdsSummaryCache( FWPDS & p ) :
+        pds(p),
+        havePost(false), postRules(0),
+        havePre(false), preRules(0),
+        inPoststar(false), damaged(false)
+      {
+      }
+
+      FwpdsSummaryCache::~FwpdsSummaryCache()
+      {
+        assert(pds.summaries != this);
+        releaseDecoded();
+      }
+
+      void FwpdsSummaryCache::clear()
+      {
+        havePost = false;
+        postSummaries.clear();
+        postByEntry.clear();
+        entryOf.clear();
+
+        havePre = false;
+        preSummaries.clear();
+        popSummaries.clear();
+
+        file.reset();
+        releaseDecoded();
+      }
+
+      bool FwpdsSummaryCache::usable( bool poststar ) const
+      {
+        // The summaries are computed without the wrapper, and are
+        // neither tensored (Newton) nor known to the checking phase
+        if( !pds.theZero.is_valid() || pds.wrapper.is_valid() || pds.newton || get_verify_fwpds() )
+          return false;
+        // Otherwise input transitions into PDS states add to the pop
+        // summaries
+        return poststar || is_strict();
+      }
+
+      ///////////
+      // post*
+      ///////////
+
+      wfa::WFA FwpdsSummaryCache::poststar( wfa::WFA const & input )
+      {
+        wfa::WFA output;
+        poststar(input, output);
+        return output;
+      }
+
+      void FwpdsSummaryCache::poststar( wfa::WFA const & input, wfa::WFA & output )
+      {
+        if( !usable(true) ) {
+          stats.fallbacks++;
+          pds.poststar(input, output);
+          return;
+        }
+        if( !havePost || postRules != pds.getRuleChanges() )
+          buildPoststar();
+
+        damaged = false;
+        {
+          QueryScope scope(*this, true);
+          pds.poststarIGR(input, output);
+        }
+        if( damaged ) {
+          // A summary of the loaded file could not be decoded, so the
+          // answer is missing it
+          damaged = false;
+          buildPoststar();
+          QueryScope scope(*this, true);
+          pds.poststarIGR(input, output);
+        }
+        stats.queries++;
+      }
+
+      void FwpdsSummaryCache::buildPoststar()
+      {
+        forgetFile(true);
+        postSummaries.clear();
+        postByEntry.clear();
+        entryOf.clear();
+
+        // The entry transitions must end in the states that poststar
+        // generates for postSummaries, so that a push to an entry
+        // reaches its summary instead of starting a new one
+        // (cf. SWPDS::preprocess).
+        wfa::WFA entries;
+        entries.setGeneration(entries.getGeneration() + 1);
+        pds.currentOutputWFA = &entries;
+
+        sem_elem_t one = pds.theZero->one();
+        WPDS::r2hash_t::iterator r2it = pds.r2hash.begin();
+        for( ; r2it != pds.r2hash.end() ; r2it++ )
+        {
+          std::list< rule_t >::iterator rit = r2it->second.begin();
+          for( ; rit != r2it->second.end() ; rit++ )
+          {
+            KeyPair entry((*rit)->to_state(), (*rit)->to_stack1());
+            Key gstate = pds.gen_state(entry.first, entry.second);
+            if( entryOf.insert(gstate, entry).second ) {
+              entries.addTrans(entry.first, entry.second, gstate, one);
+              entries.setInitialState(entry.first);
+            }
+          }
+        }
+
+        entries.setGeneration(entries.getGeneration() - 1);
+        pds.currentOutputWFA = 0;
+
+        if( entries.numTransitions() > 0 ) {
+          pds.poststarIGR(entries, postSummaries);
+
+          CollectSummaries< SelectIntoEntry > collect(SelectIntoEntry(entryOf, postByEntry));
+          postSummaries.for_each(collect);
+        }
+
+        havePost = true;
+        postRules = pds.getRuleChanges();
+        stats.builds++;
+      }
+
+      void FwpdsSummaryCache::loadPoststar( KeyPair entry, Key gstate )
+      {
+        std::vector< std::pair< KeyPair, Key > > todo;
+        todo.push_back(std::make_pair(entry, gstate));
+
+        while( !todo.empty() )
+        {
+          entry = todo.back().first;
+          gstate = todo.back().second;
+          todo.pop_back();
+
+          if( !loaded.insert(gstate).second )
+            continue;
+
+          entry_map_t::iterator it = postByEntry.find(entry);
+          if( it == postByEntry.end() ) {
+            if( !decodeEntry(entry) )
+              continue;
+            it = postByEntry.find(entry);
+          }
+
+          trans_list_t & summaries = it->second;
+          for( trans_list_t::iterator sit = summaries.begin() ; sit != summaries.end() ; sit++ )
+          {
+            wfa::ITrans const * st = *sit;
+
+            // Summaries that return to a callee start in the callee's
+            // generated state, which is named after this query
+            Key from = st->from();
+            gen_map_t::iterator git = entryOf.find(from);
+            if( git != entryOf.end() ) {
+              from = pds.gen_state(git->second.first, git->second.second);
+              todo.push_back(std::make_pair(git->second, from));
+            }
+
+            wfa::ITrans * t = copyIn(st, from, gstate);
+
+            // Epsilon summaries are combined with the query's return
+            // transitions (see FWPDS::poststar_handle_eps_trans)
+            if( t->stack() == WALI_EPSILON ) {
+              LazyTrans * lt = static_cast< LazyTrans * >(t);
+              ewpds::ETrans * et = lt->getETrans();
+              if( et != 0 )
+                pds.interGr->setESource(graph::Transition(*t), et->getWeightAtCall(), et->weight());
+              else
+                pds.interGr->setSource(graph::Transition(*t), t->weight());
+            }
+          }
+        }
+      }
+
+      ///////////
+      // pre*
+      ///////////
+
+      wfa::WFA FwpdsSummaryCache::prestar( wfa::WFA const & input )
+      {
+        wfa::WFA output;
+        prestar(input, output);
+        return output;
+      }
+
+      void FwpdsSummaryCache::prestar( wfa::WFA const & input, wfa::WFA & output )
+      {
+        if( !usable(false) ) {
+          stats.fallbacks++;
+          pds.prestar(input, output);
+          return;
+        }
+        if( !havePre || preRules != pds.getRuleChanges() || !decodePops() )
+          buildPrestar();
+
+        QueryScope scope(*this, false);
+        pds.FWPDS::prestar(input, output);
+        stats.queries++;
+      }
+
+      void FwpdsSummaryCache::buildPrestar()
+      {
+        forgetFile(false);
+        preSummaries.clear();
+        popSummaries.clear();
+
+        // Prestar needs some input transition to get a weight from.
+        // No rule applies to one out of a state that is not a PDS
+        // state, so only the pop summaries are derived.
+        wfa::WFA dummy;
+        Key q = getKey("__fwpds_summaries");
+        dummy.addTrans(q, q, q, pds.theZero->one());
+        dummy.setInitialState(q);
+        pds.FWPDS::prestar(dummy, preSummaries);
+
+        CollectSummaries< SelectIntoPdsState > collect(SelectIntoPdsState(pds, popSummaries));
+        preSummaries.for_each(collect);
+
+        havePre = true;
+        preRules = pds.getRuleChanges();
+        stats.builds++;
+      }
+
+      void FwpdsSummaryCache::setupPrestar( wfa::WFA const & input, wfa::WFA & output )
+      {
+        pds.setupOutput(input, output);
+        output.setQuery(wfa::WFA::INORDER);
+
+        // The pop summaries go in without a Config, so they never reach
+        // the worklist; FWPDS::prestar makes them sources like the
+        // input transitions.
+        for( trans_list_t::iterator it = popSummaries.begin() ; it != popSummaries.end() ; it++ )
+          copyIn(*it, (*it)->from(), (*it)->to());
+      }
+
+      ///////////
+      // helpers
+      ///////////
+
+      bool FwpdsSummaryCache::reused( wfa::ITrans const & t ) const
+      {
+        if( inPoststar )
+          return loaded.find(t.to()) != loaded.end();
+        else
+          return pds.is_pds_state(t.to());
+      }
+
+      wfa::ITrans * FwpdsSummaryCache::copyIn( wfa::ITrans const * st, Key from, Key to )
+      {
+        // LazyTrans::copy evaluates the weight, so the copy does not
+        // refer to the InterGraph of the summaries
+        wfa::WFA & fa = *pds.currentOutputWFA;
+        LazyTrans * lt = new (fa.getTransArena()) LazyTrans(st->copy(from, st->stack(), to));
+        stats.reused++;
+        return fa.insert(lt).first;
+      }
+
+    } // namespace fwpds
+
+  } // namespace wpds
+
+} // namespace wali
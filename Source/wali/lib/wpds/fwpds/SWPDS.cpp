@@ -1,6 +1,10 @@
+#include <algorithm>
+#include <vector>
+
 #include "wali/wfa/State.hpp"
 #include "wali/wpds/ewpds/ETrans.hpp"
 #include "wali/wpds/fwpds/SWPDS.hpp"
+#include "wali/wpds/Config.hpp"
 #include "wali/graph/GraphCommon.hpp"
 
 using namespace std;
@@ -27,7 +31,7 @@ namespace wali
       
       void CopyCallRules::operator()( rule_t & r )
       {
-        ref_ptr<ERule> er = dynamic_cast<ERule *> (r.get_ptr());
+        ref_ptr<ewpds::ERule> er = dynamic_cast<ewpds::ERule *> (r.get_ptr());
         assert(er != 0);
         
         if(r->to_stack2() != WALI_EPSILON) {
@@ -39,30 +43,207 @@ namespace wali
 
     namespace fwpds {
 
+      namespace {
+
+        typedef std::map< Key, std::set<Key> > key_sets_t;
+
+        /// The stacks each stack goes on to in its procedure, and the
+        /// entries it calls
+        class ProcedureEdges : public ConstRuleFunctor
+        {
+        public:
+          key_sets_t next;
+          key_sets_t calls;
+
+          virtual void operator()( rule_t const & r )
+          {
+            if(r->to_stack1() == WALI_EPSILON)
+              return;
+            if(r->to_stack2() == WALI_EPSILON) {
+              next[r->from_stack()].insert(r->to_stack1());
+            } else {
+              next[r->from_stack()].insert(r->to_stack2());
+              calls[r->from_stack()].insert(r->to_stack1());
+            }
+          }
+        };
+
+        /// Copies the rules from some stacks into an EWPDS
+        class CopyProcedureRules : public RuleFunctor
+        {
+          ewpds::EWPDS &pds;
+          std::set<Key> const &stacks;
+
+        public:
+          CopyProcedureRules( ewpds::EWPDS &w, std::set<Key> const &s ) : pds(w), stacks(s) {}
+
+          virtual void operator()( rule_t & r )
+          {
+            if(stacks.find(r->from_stack()) == stacks.end())
+              return;
+            if(r->to_stack2() != WALI_EPSILON) {
+              ref_ptr<ewpds::ERule> er = dynamic_cast<ewpds::ERule *> (r.get_ptr());
+              assert(er != 0);
+              pds.add_rule(r->from_state(), r->from_stack(), r->to_state(), r->to_stack1(), r->to_stack2(), r->weight(), er->merge_fn());
+            } else if(r->to_stack1() != WALI_EPSILON) {
+              pds.add_rule(r->from_state(), r->from_stack(), r->to_state(), r->to_stack1(), r->weight());
+            } else {
+              pds.add_rule(r->from_state(), r->from_stack(), r->to_state(), r->weight());
+            }
+          }
+        };
+
+        /// The FWPDS of some procedures. It hands out the InterGraph
+        /// its post* builds, and solves procedures without rules too.
+        class ProcedureSolver : public FWPDS
+        {
+        public:
+          explicit ProcedureSolver( sem_elem_t zero ) {
+            theZero = zero;
+          }
+
+          graph::InterGraphPtr interGraph() {
+            return interGr;
+          }
+
+          /// (start_state, e, <start_state, e>) for each entry e
+          void entryAutomaton( Key start_state, std::set<Key> const & entries, wfa::WFA &Agrow )
+          {
+            // Need to get the WFA::generation correct for the mid-states so that
+            // new mid-states are not created while running poststar
+            Agrow.setGeneration(Agrow.getGeneration() + 1);
+            currentOutputWFA = &Agrow;
+
+            std::set<Key>::const_iterator it;
+            for(it = entries.begin(); it != entries.end(); it++) {
+              Agrow.addTrans(start_state, *it, gen_state(start_state, *it), theZero->one());
+            }
+            Agrow.setInitialState(start_state);
+
+            // Set the generation back to original value
+            Agrow.setGeneration(Agrow.getGeneration() - 1);
+            currentOutputWFA = 0;
+          }
+        };
+
+        /// Tarjan's algorithm over the calls between procedures
+        class CallGraphSccs
+        {
+          key_sets_t const &callees;
+          std::map<Key, int> index;
+          std::map<Key, int> low;
+          std::vector<Key> stack;
+          std::set<Key> onStack;
+
+        public:
+          /// Groups of procedures that call each other, callees first
+          std::vector< std::set<Key> > sccs;
+
+          CallGraphSccs( std::set<Key> const & entries, key_sets_t const & c ) : callees(c)
+          {
+            std::set<Key>::const_iterator it;
+            for(it = entries.begin(); it != entries.end(); it++) {
+              if(index.find(*it) == index.end())
+                visit(*it);
+            }
+          }
+
+        private:
+          void visit( Key e )
+          {
+            int i = (int)index.size();
+            index[e] = i;
+            low[e] = i;
+            stack.push_back(e);
+            onStack.insert(e);
+
+            key_sets_t::const_iterator cit = callees.find(e);
+            if(cit != callees.end()) {
+              std::set<Key>::const_iterator it;
+              for(it = cit->second.begin(); it != cit->second.end(); it++) {
+                if(index.find(*it) == index.end()) {
+                  visit(*it);
+                  low[e] = std::min(low[e], low[*it]);
+                } else if(onStack.find(*it) != onStack.end()) {
+                  low[e] = std::min(low[e], index[*it]);
+                }
+              }
+            }
+
+            if(low[e] == index[e]) {
+              std::set<Key> scc;
+              Key k;
+              do {
+                k = stack.back();
+                stack.pop_back();
+                onStack.erase(k);
+                scc.insert(k);
+              } while(k != e);
+              sccs.push_back(scc);
+            }
+          }
+        };
+
+        bool sameSummary( sem_elem_t a, sem_elem_t b )
+        {
+          if(!a.is_valid() || !b.is_valid())
+            return a.is_valid() == b.is_valid();
+          return a->equal(b);
+        }
+
+      } // namespace
+
       const std::string SWPDS::XMLTag("SWPDS");
 
-      SWPDS::SWPDS() : FWPDS(), preprocessed(false), sgr(NULL) 
+      SWPDS::SWPDS() : FWPDS(), preprocessed(false), stale(false), prePdsStale(false), sgr(NULL) 
       { 
       }
 
       SWPDS::SWPDS(ref_ptr<Wrapper> wr) : 
-        FWPDS(wr), preprocessed(false), sgr(NULL) 
+        FWPDS(wr), preprocessed(false), stale(false), prePdsStale(false), sgr(NULL) 
       { 
       }
 
       SWPDS::~SWPDS() 
       {
+        // sgr keeps the InterGraphs of the units
+        unit_map_t::iterator it;
+        for(it = units.begin(); it != units.end(); it++) {
+          delete it->second;
+        }
         if(sgr != NULL) {
           delete sgr;
         }
       }
 
       void SWPDS::addEntryPoint(Key n) {
-        syms.entryPoints.insert(n);
+        userEntries.insert(n);
+        if(preprocessed) {
+          updateStats.changes++;
+          if(syms.entryPoints.find(n) == syms.entryPoints.end()) {
+            stale = true;
+          } else {
+            updateStats.absorbed++;
+          }
+        } else {
+          syms.entryPoints.insert(n);
+        }
+      }
+
+      void SWPDS::removeEntryPoint(Key n) {
+        if(userEntries.erase(n) == 0)
+          return;
+        if(preprocessed) {
+          // It may still be the target of a push rule; the next
+          // update finds out
+          updateStats.changes++;
+          stale = true;
+        } else {
+          syms.entryPoints.erase(n);
+        }
       }
 
-      // Carried over from WPDS to ensure that no rules are added after
-      // SWPDS is preprocessed
+      // Rules may change after SWPDS is preprocessed; see update
       bool SWPDS::make_rule(
           Config *f,
           Config *t,
@@ -70,17 +251,83 @@ namespace wali
 	  bool replace_weight,
           rule_t& r ) 
       {
+        if(preprocessed)
+          noteRuleChange(f->stack(), (stk2 == WALI_EPSILON) ? WALI_EPSILON : t->stack(), false);
 
-        if(preprocessed) {
-          *waliErr << "[ERROR] SWPDS cannot add rules after calling preprocess.\n";
-          assert(0);
+        return WPDS::make_rule(f,t,stk2,replace_weight,r);
+      }
+
+      bool SWPDS::make_rule(
+          Config *f,
+          Config *t,
+          Key stk2,
+          rule_t& r )
+      {
+        if(preprocessed)
+          noteRuleChange(f->stack(), (stk2 == WALI_EPSILON) ? WALI_EPSILON : t->stack(), false);
+
+        return this->FWPDS::make_rule(f, t, stk2, r);
+      }
+
+      bool SWPDS::erase_rule(
+          Key from_state,
+          Key from_stack,
+          Key to_state,
+          Key to_stack1,
+          Key to_stack2 )
+      {
+        bool erased = WPDS::erase_rule(from_state, from_stack, to_state, to_stack1, to_stack2);
+        if(erased && preprocessed)
+          noteRuleChange(from_stack, (to_stack2 == WALI_EPSILON) ? WALI_EPSILON : to_stack1, true);
+        return erased;
+      }
+
+      void SWPDS::noteRuleChange(Key from_stack, Key push_target, bool erased) {
+        updateStats.changes++;
+
+        // Summaries only describe code reachable from the entry points,
+        // and a rule from unreachable code cannot make anything
+        // reachable. Its push rules are still copied to pre_pds.
+        bool absorbed = !sgr->reachable(from_stack);
+        if(absorbed && push_target != WALI_EPSILON) {
+          // A new entry point needs summaries; the last push rule to an
+          // entry point may take it away
+          absorbed = !erased && syms.entryPoints.find(push_target) != syms.entryPoints.end();
+          prePdsStale = true;
         }
 
-        return WPDS::make_rule(f,t,stk2,replace_weight,r);
+        if(absorbed) {
+          updateStats.absorbed++;
+        } else {
+          // The procedures from_stack is in are solved again, and
+          // their callers if their summaries change. Rules that make
+          // new procedures add entry points.
+          stale = true;
+          key_sets_t::const_iterator it = procsOf.find(from_stack);
+          if(it != procsOf.end())
+            dirty.insert(it->second.begin(), it->second.end());
+        }
       }
 
       void SWPDS::preprocess() {
         assert(!preprocessed);
+        solveSummaries();
+        preprocessed = true;
+      }
+
+      bool SWPDS::update() {
+        assert(preprocessed);
+        if(stale) {
+          solveSummaries();
+          updateStats.resolves++;
+          return true;
+        }
+        if(prePdsStale)
+          buildPrePds();
+        return false;
+      }
+
+      void SWPDS::solveSummaries() {
         assert(theZero.is_valid());
 
         if(pds_states.size() != 1) {
@@ -91,46 +338,161 @@ namespace wali
         Key start_state = *pds_states.begin();
 
         // Get all EWPDS symbols
+        syms = WpdsStackSymbols();
+        syms.entryPoints = userEntries;
         for_each(syms);
 
-        // Create an automaton Agrow with transitions (start_state, e, <start_state,e>)
-        // for each entry point node e.
-        wfa::WFA Agrow;
-        std::set<Key>::iterator it; 
+        cout << "Entry points found: " << syms.entryPoints.size() << "\n";
 
-        // Need to get the WFA::generation correct for the mid-states so that
-        // new mid-states are not created while running poststar        
-        Agrow.setGeneration(Agrow.getGeneration() + 1);
-        currentOutputWFA = &Agrow; 
+        // The stacks of each procedure and the procedures it calls
+        ProcedureEdges edges;
+        for_each(edges);
 
+        key_sets_t procStacks, procCallees;
+        std::set<Key>::iterator it;
+        procsOf.clear();
         for(it = syms.entryPoints.begin(); it != syms.entryPoints.end(); it++) {
           Key entry = *it;
-          Agrow.addTrans(start_state, entry, gen_state(start_state, entry), theZero->one());
+          std::set<Key> &stacks = procStacks[entry];
+          std::set<Key> &callees = procCallees[entry];
+          std::vector<Key> worklist(1, entry);
+          stacks.insert(entry);
+          while(!worklist.empty()) {
+            Key k = worklist.back();
+            worklist.pop_back();
+            procsOf[k].insert(entry);
+
+            key_sets_t::iterator eit = edges.calls.find(k);
+            if(eit != edges.calls.end())
+              callees.insert(eit->second.begin(), eit->second.end());
+
+            eit = edges.next.find(k);
+            if(eit == edges.next.end())
+              continue;
+            std::set<Key>::iterator nit;
+            for(nit = eit->second.begin(); nit != eit->second.end(); nit++) {
+              if(stacks.insert(*nit).second)
+                worklist.push_back(*nit);
+            }
+          }
         }
-        Agrow.setInitialState(start_state);
 
-        // Set the generation back to original value
-        Agrow.setGeneration(Agrow.getGeneration() - 1);
-        currentOutputWFA = 0;
+        CallGraphSccs order(syms.entryPoints, procCallees);
+
+        if(sgr == NULL)
+          sgr = new graph::SummaryGraph(start_state, theZero, (graph::InterGraph::PRINT_OP)printKey);
+
+        // The summaries before, to tell the callers of the procedures
+        // whose summaries change
+        std::map<Key, sem_elem_t> before;
+        unit_map_t::iterator uit;
+        for(uit = units.begin(); uit != units.end(); uit++) {
+          for(it = uit->first.begin(); it != uit->first.end(); it++) {
+            before[*it] = sgr->summary(*it);
+          }
+        }
+
+        // Drop the units whose procedures are no longer grouped so
+        std::set< std::set<Key> > current(order.sccs.begin(), order.sccs.end());
+        for(uit = units.begin(); uit != units.end(); ) {
+          if(current.find(uit->first) == current.end()) {
+            sgr->removeProcedures(uit->first);
+            delete uit->second;
+            units.erase(uit++);
+          } else {
+            uit++;
+          }
+        }
+
+        std::set<Key> changed;
+        std::vector< std::set<Key> >::iterator sit;
+        for(sit = order.sccs.begin(); sit != order.sccs.end(); sit++) {
+          std::set<Key> const &entries = *sit;
+          std::set<Key> stacks, callees;
+          bool solve = (units.find(entries) == units.end());
+          for(it = entries.begin(); it != entries.end(); it++) {
+            stacks.insert(procStacks[*it].begin(), procStacks[*it].end());
+            callees.insert(procCallees[*it].begin(), procCallees[*it].end());
+            if(dirty.find(*it) != dirty.end())
+              solve = true;
+          }
+          for(it = callees.begin(); it != callees.end(); it++) {
+            if(entries.find(*it) == entries.end() && changed.find(*it) != changed.end())
+              solve = true;
+          }
+          if(!solve)
+            continue;
+
+          uit = units.find(entries);
+          if(uit != units.end()) {
+            sgr->removeProcedures(entries);
+            delete uit->second;
+            units.erase(uit);
+          }
+          units[entries] = solveProcedures(entries, stacks, callees);
+          if(preprocessed)
+            updateStats.procedures += entries.size();
+
+          for(it = entries.begin(); it != entries.end(); it++) {
+            if(!sameSummary(before[*it], sgr->summary(*it)))
+              changed.insert(*it);
+          }
+        }
+        dirty.clear();
 
-        cout << "Entry points found: " << syms.entryPoints.size() << "\n";
-        
-        // Then run FWPDS post* on Agrow and get the InterGraph that it creates
-        wfa::WFA postAgrow;
-        poststarIGR(Agrow, postAgrow);
-        interGr->update_all_weights();
-        
-        // Create SummaryGraph from the InterGraph
-        sgr = new graph::SummaryGraph(interGr.get_ptr(), start_state, syms.entryPoints, postAgrow, (graph::InterGraph::PRINT_OP)printKey);
-        
         // Now do pre-processing for pre*
-        
+        buildPrePds();
+
+        stale = false;
+      }
+
+      FWPDS * SWPDS::solveProcedures(
+          std::set<Key> const & entries,
+          std::set<Key> const & stacks,
+          std::set<Key> const & callees )
+      {
+        Key start_state = *pds_states.begin();
+
+        ProcedureSolver *pds = new ProcedureSolver(theZero);
+        pds->topDownEval(topDown);
+        pds->useNewton(newton);
+        pds->shareRegExpDag(sgr->getDag());
+
+        CopyProcedureRules copier(*pds, stacks);
+        for_each(copier);
+
+        // A procedure solved before is only its summary: a pop from its
+        // entry
+        std::set<Key>::const_iterator it;
+        for(it = callees.begin(); it != callees.end(); it++) {
+          if(stacks.find(*it) != stacks.end())
+            continue;
+          sem_elem_t se = sgr->summary(*it);
+          if(se.is_valid())
+            pds->add_rule(start_state, *it, start_state, se);
+        }
+
+        // Then run FWPDS post* on Agrow and get the InterGraph that it creates
+        wfa::WFA Agrow, postAgrow;
+        pds->entryAutomaton(start_state, entries, Agrow);
+        pds->poststarIGR(Agrow, postAgrow);
+        sgr->addProcedures(pds->interGraph(), entries, postAgrow);
+
+        return pds;
+      }
+
+      void SWPDS::buildPrePds() {
+        Key start_state = *pds_states.begin();
+        std::set<Key>::iterator it;
+
+        pre_pds.clear();
+
         // Add (entry -> \y) rules
         for(it = syms.gamma.begin(); it != syms.gamma.end(); it++) {
           sem_elem_t se = sgr->pushWeight(*it);
           Key entry = sgr->getEntry(*it);
           
-          if(entry == WALI_EPSILON || !se.is_valid() || se->equal(se->zero())) {
+          if(entry == WALI_EPSILON || !se.is_valid() || se->isZero()) {
             // unreachable code
             continue;
           }
@@ -141,17 +503,19 @@ namespace wali
         // Add call rules
         ewpds::CopyCallRules cr(pre_pds);
         for_each(cr);
-        
-        preprocessed = true;
+
+        prePdsStale = false;
       }
 
       bool SWPDS::reachable(Key k) {
         assert(preprocessed);
+        update();
         return sgr->reachable(k);
       }
 
       bool SWPDS::multiple_proc(Key k) {
         assert(preprocessed);
+        update();
         return sgr->multiple_proc(k);
       }
 
@@ -161,6 +525,7 @@ namespace wali
           *waliErr << "SWPDS: Error: Must preprocess before running query\n";
           assert(0);
         }
+        update();
 
         if(&ca_out != &ca_in) {
           ca_out.clear();
@@ -193,6 +558,7 @@ namespace wali
           *waliErr << "SWPDS: Error: Must preprocess before running query\n";
           assert(0);
         }
+        update();
 
         if(&ca_out != &ca_in) {
           ca_out.operator=(ca_in);
@@ -204,7 +570,7 @@ namespace wali
         set<Key>::iterator it;
         for(it = syms.entryPoints.begin(); it != syms.entryPoints.end(); it++) {
           sem_elem_t se = sgr->popWeight(*it);
-          if(!se->equal(se->zero())) {
+          if(!se->isZero()) {
             ca_out.insert(new ewpds::ETrans(start_state, *it, start_state, 0, se, 0));
           }
         }
@@ -319,7 +685,7 @@ namespace wali
         for(it = syms.gamma.begin(); it != syms.gamma.end(); it++) {
           if(syms.entryPoints.find(*it) != syms.entryPoints.end()) continue;
           sem_elem_t se = sgr->popWeight(*it);
-          if(!se->equal(se->zero())) {
+          if(!se->isZero()) {
             ca_out.insert(new ewpds::ETrans(start_state, *it, start_state, 0, se, 0));
           }
         }
@@ -1,15 +1,109 @@
+/*!
+ * Times BinRel extends and combines on random assignments, then times
+ * the relational composition at the heart of BinRel::Compose on larger
+ * relations, once as bdd_replace, bdd_relprod and bdd_replace and once
+ * as the fused bdd_relprodreplace, and checks that both agree.
+ *
+ * Usage: binrel_speed_test [seed [vars [composes]]]
+ */
+
 #include "wali/domains/binrel/ProgramBddContext.hpp"
+#include "wali/util/Timer.hpp"
 
 #include <cstdlib>
 #include <ctime>
 #include <string>
 #include <sstream>
 #include <map>
+#include <vector>
 
 using namespace std;
 using namespace wali;
 using namespace wali::domains::binrel;
 
+namespace
+{
+  string varName(int i)
+  {
+    stringstream ss;
+    ss << "v" << i;
+    return ss.str();
+  }
+
+  // x := y + z followed by a few copies, or-ed together a few times
+  bdd randomRelation(ProgramBddContext * voc, int nvars)
+  {
+    bdd r = bddfalse;
+    for(int k = 0; k < 4; ++k){
+      binrel_t c = new BinRel(voc, voc->Assign(varName(rand() % nvars),
+            voc->Plus(voc->From(varName(rand() % nvars)), voc->From(varName(rand() % nvars)))));
+      for(int j = 0; j < 3; ++j)
+        c = c->Compose(new BinRel(voc, voc->Assign(varName(rand() % nvars), voc->From(varName(rand() % nvars)))));
+      r = r | c->getBdd();
+    }
+    return r;
+  }
+
+  // Returns false if the two ways of composing disagree
+  bool timeComposeKernel(int nvars, long composes)
+  {
+    ProgramBddContext * voc = new ProgramBddContext();
+    map<string, int> vars;
+    for(int i = 0; i < nvars; ++i)
+      vars[varName(i)] = 16;
+    voc->setIntVars(vars);
+
+    // The same pairs and variable set as the base vocabulary of BddContext
+    vector<int> lhs, rhs, extra;
+    for(BddContext::const_iterator it = voc->begin(); it != voc->end(); ++it){
+      lhs.push_back(it->second->baseLhs);
+      rhs.push_back(it->second->baseRhs);
+      extra.push_back(it->second->baseExtra);
+    }
+    int n = (int)lhs.size();
+    bddPair * rightShift = bdd_newpair();
+    fdd_setpairs(rightShift, &lhs[0], &rhs[0], n);
+    fdd_setpairs(rightShift, &rhs[0], &extra[0], n);
+    bddPair * restore = bdd_newpair();
+    fdd_setpairs(restore, &extra[0], &rhs[0], n);
+    bdd middle = fdd_makeset(&rhs[0], n);
+
+    vector<bdd> pool;
+    for(int i = 0; i < 32; ++i)
+      pool.push_back(randomRelation(voc, nvars));
+
+    vector<bdd> separate, fused;
+    {
+      util::Timer timer("replace, relprod, replace", cout);
+      for(long i = 0; i < composes; ++i){
+        bdd const & a = pool[i % pool.size()];
+        bdd const & b = pool[(i / pool.size() + i) % pool.size()];
+        bdd shifted = bdd_replace(b, rightShift);
+        bdd joined = bdd_relprod(a, shifted, middle);
+        separate.push_back(bdd_replace(joined, restore));
+      }
+    }
+    {
+      util::Timer timer("relprodreplace", cout);
+      for(long i = 0; i < composes; ++i){
+        bdd const & a = pool[i % pool.size()];
+        bdd const & b = pool[(i / pool.size() + i) % pool.size()];
+        fused.push_back(bdd_relprodreplace(a, NULL, b, rightShift, middle, restore));
+      }
+    }
+    bool agree = (separate == fused);
+
+    separate.clear();
+    fused.clear();
+    pool.clear();
+    middle = bddfalse;
+    bdd_freepair(rightShift);
+    bdd_freepair(restore);
+    delete voc;
+    return agree;
+  }
+}
+
 int main(int argc, char ** argv)
 {
   bool dbg = false;
@@ -23,6 +117,12 @@ int main(int argc, char ** argv)
     istringstream (argv[1]) >> seed;
     srand(seed);
   }
+  int composeVars = 8;
+  long composes = 256;
+  if(argc > 2)
+    istringstream (argv[2]) >> composeVars;
+  if(argc > 3)
+    istringstream (argv[3]) >> composes;
 
   ProgramBddContext * voc = new ProgramBddContext();
   
@@ -37,6 +137,7 @@ int main(int argc, char ** argv)
   vars["h"] = 2;
   voc->setIntVars(vars);
   
+  util::Timer * timer = new util::Timer("extend and combine", cout);
   sem_elem_tensor_t val = new BinRel(voc, bddfalse);
   val = val->tensor(val.get_ptr());
   sem_elem_tensor_t id = new BinRel(voc, voc->Assign("a", voc->From("a")));    
@@ -121,8 +222,15 @@ int main(int argc, char ** argv)
   }
 
   val = NULL;
+  id = NULL;
+  delete timer;
 
   delete voc;
 
+  if(!timeComposeKernel(composeVars, composes)){
+    cout << "bdd_relprodreplace disagrees with the separate operations!" << endl;
+    return 1;
+  }
+
   cout << "Done!" << endl;
 }
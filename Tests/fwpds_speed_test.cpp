@@ -0,0 +1,105 @@
+/*!
+ * Times FWPDS poststar and prestar on random models.
+ *
+ * The models come from RandomPdsGen (AddOns/RandomFWPDS) with random
+ * ShortestPathSemiring weights, so the time goes into building and
+ * solving the IntraGraphs of the summary computation rather than into
+ * the weight domain. For each size the same seeds are used, so runs of
+ * two builds of the library can be compared line by line.
+ *
+ * Usage: fwpds_speed_test [size-factor [seeds]]
+ */
+
+#include "wali/wpds/fwpds/FWPDS.hpp"
+#include "wali/wfa/WFA.hpp"
+#include "wali/ShortestPathSemiring.hpp"
+#include "wali/KeySpace.hpp"
+#include "wali/util/Timer.hpp"
+
+#include "generateRandomFWPDS.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+
+using namespace std;
+using namespace wali;
+using namespace wali::wfa;
+using namespace wali::wpds;
+using namespace wali::wpds::fwpds;
+
+namespace
+{
+  class ShortestPathWtGen : public RandomPdsGen::WtGen
+  {
+    public:
+      virtual sem_elem_t operator () ()
+      {
+        return new ShortestPathSemiring( rand() % 10 );
+      }
+  };
+
+  struct Times
+  {
+    double poststar, prestar;
+  };
+
+  Times timeModel( int factor, unsigned seed )
+  {
+    Times t;
+    RandomPdsGen::wtgen_t wg = new ShortestPathWtGen();
+    RandomPdsGen gen( wg, factor, 10 * factor, factor, 5 * factor, 0, 0.45, 0.45, seed );
+
+    FWPDS pds;
+    RandomPdsGen::Names names;
+    gen.get( pds, names );
+
+    WFA fa;
+    Key acc = getKey( "accept" );
+    for( size_t i = 0 ; i < names.entries.size() ; i++ )
+      fa.addTrans( names.pdsState, names.entries[i], acc, (*wg)() );
+    fa.setInitialState( names.pdsState );
+    fa.addFinalState( acc );
+
+    {
+      WFA out;
+      util::Timer timer( "poststar", cout );
+      pds.poststar( fa, out );
+      t.poststar = timer.elapsed();
+    }
+    {
+      WFA out;
+      util::Timer timer( "prestar", cout );
+      pds.prestar( fa, out );
+      t.prestar = timer.elapsed();
+    }
+    return t;
+  }
+}
+
+int main(int argc, char ** argv)
+{
+  int factor = 40;
+  unsigned seeds = 5;
+  if( argc > 1 ) {
+    istringstream (argv[1]) >> factor;
+  }
+  if( argc > 2 ) {
+    istringstream (argv[2]) >> seeds;
+  }
+  srand(42);
+
+  for( int f = factor / 4 ; f <= factor ; f *= 2 ) {
+    Times total = { 0, 0 };
+    for( unsigned s = 0 ; s < seeds ; s++ ) {
+      Times t = timeModel( f, s );
+      total.poststar += t.poststar;
+      total.prestar += t.prestar;
+    }
+    cout << "\nsize factor " << f << " (" << seeds << " models)\n";
+    cout << "  poststar  " << total.poststar << "\n";
+    cout << "  prestar   " << total.prestar << "\n\n";
+  }
+
+  return 0;
+}
@@ -0,0 +1,148 @@
+/*!
+ * Compares wali::HashMap with wali::RobinHoodHashMap.
+ *
+ * For each of the key types the library hashes most -- Key (KeySpace,
+ * WPDS rule maps), KeyPair (WPDS configurations and gen states) and
+ * reg_exp_key_t (RegExpDag hash-consing) -- times inserting n keys,
+ * looking all of them up, looking up n absent keys, and erasing half of
+ * them, on both maps.
+ *
+ * Usage: hashmap_speed_test [n]
+ */
+
+#include "wali/HashMap.hpp"
+#include "wali/RobinHoodHashMap.hpp"
+#include "wali/KeyContainer.hpp"
+#include "wali/ShortestPathSemiring.hpp"
+#include "wali/graph/RegExp.hpp"
+#include "wali/util/Timer.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+using namespace std;
+using namespace wali;
+using namespace wali::graph;
+
+struct Times
+{
+  double insert, hit, miss, erase;
+};
+
+template< typename Map >
+static Times timeMap( vector< typename Map::key_type > const & present,
+                      vector< typename Map::key_type > const & absent )
+{
+  Times t;
+  Map m;
+  size_t found = 0;
+  {
+    util::Timer timer("insert", cout);
+    for( size_t i = 0 ; i < present.size() ; i++ )
+      m.insert( present[i], typename Map::mapped_type() );
+    t.insert = timer.elapsed();
+  }
+  {
+    util::Timer timer("hit", cout);
+    for( size_t i = 0 ; i < present.size() ; i++ )
+      found += (m.find(present[i]) != m.end());
+    t.hit = timer.elapsed();
+  }
+  {
+    util::Timer timer("miss", cout);
+    for( size_t i = 0 ; i < absent.size() ; i++ )
+      found += (m.find(absent[i]) != m.end());
+    t.miss = timer.elapsed();
+  }
+  {
+    util::Timer timer("erase", cout);
+    for( size_t i = 0 ; i < present.size() ; i += 2 )
+      m.erase( present[i] );
+    t.erase = timer.elapsed();
+  }
+  if( found != present.size() || m.size() != present.size() / 2 ) {
+    cerr << "[ERROR] wrong contents\n";
+    exit(1);
+  }
+  return t;
+}
+
+template< typename K, typename D, typename H, typename E >
+static void compare( string const & name,
+                     vector< K > const & present,
+                     vector< K > const & absent )
+{
+  Times chained = timeMap< HashMap< K,D,H,E > >( present, absent );
+  Times robin = timeMap< RobinHoodHashMap< K,D,H,E > >( present, absent );
+
+  cout << "\n" << name << " (" << present.size() << " keys)\n";
+  cout << "            HashMap  RobinHood  speedup\n";
+  double c[] = { chained.insert, chained.hit, chained.miss, chained.erase };
+  double r[] = { robin.insert, robin.hit, robin.miss, robin.erase };
+  char const * what[] = { "insert", "hit   ", "miss  ", "erase " };
+  for( int i = 0 ; i < 4 ; i++ ) {
+    cout << "  " << what[i] << "  " << c[i] << "  " << r[i] << "  "
+         << (r[i] > 0 ? c[i] / r[i] : 0) << "x\n";
+  }
+}
+
+int main(int argc, char ** argv)
+{
+  size_t n = 1000000;
+  if( argc > 1 ) {
+    istringstream (argv[1]) >> n;
+  }
+  srand(42);
+
+  {
+    vector< Key > present, absent;
+    for( size_t i = 0 ; i < n ; i++ ) {
+      present.push_back( i );
+      absent.push_back( n + i );
+    }
+    compare< Key, Key, hm_hash<Key>, hm_equal<Key> >( "Key", present, absent );
+  }
+
+  {
+    vector< KeyPair > present, absent;
+    for( size_t i = 0 ; i < n ; i++ ) {
+      present.push_back( KeyPair( i % 1000, i / 1000 ) );
+      absent.push_back( KeyPair( i % 1000, n + i / 1000 ) );
+    }
+    compare< KeyPair, Key, hm_hash<KeyPair>, hm_equal<KeyPair> >(
+      "KeyPair", present, absent );
+  }
+
+  {
+    RegExpDag dag;
+    size_t leaves = 2;
+    while( leaves * leaves < 2 * n )
+      leaves++;
+    vector< reg_exp_t > constants;
+    for( size_t i = 0 ; i < leaves ; i++ )
+      constants.push_back( dag.constant( new ShortestPathSemiring(i + 1) ) );
+
+    vector< reg_exp_key_t > present, absent;
+    for( size_t i = 0 ; i < n ; i++ ) {
+      reg_exp_t a = constants[rand() % leaves];
+      reg_exp_t b = constants[rand() % leaves];
+      present.push_back( reg_exp_key_t( Extend, a, b ) );
+      absent.push_back( reg_exp_key_t( Combine, a, b ) );
+    }
+    // The random pairs may repeat; keep the first occurrence only.
+    RobinHoodHashMap< reg_exp_key_t, int, hash_reg_exp_key, reg_exp_key_t > seen;
+    vector< reg_exp_key_t > unique;
+    for( size_t i = 0 ; i < present.size() ; i++ ) {
+      if( seen.insert( present[i], 0 ).second )
+        unique.push_back( present[i] );
+    }
+    absent.resize( unique.size() );
+    compare< reg_exp_key_t, reg_exp_t, hash_reg_exp_key, reg_exp_key_t >(
+      "reg_exp_key_t", unique, absent );
+  }
+
+  return 0;
+}
+
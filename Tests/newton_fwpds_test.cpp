@@ -373,6 +373,7 @@ int main(int argc, char ** argv)
   unsigned seed = 0;
   unsigned numVars = 0;
   int pdsSizeFactor=0;
+  bool tune = false;
   if(argc >=2){
     stringstream s;
     s << argv[1];
@@ -393,6 +394,11 @@ int main(int argc, char ** argv)
     s << argv[4];
     s >> seed;
   }
+  if(argc >= 6){
+    stringstream s;
+    s << argv[5];
+    s >> tune;
+  }
 
   if(seed <= 0) 
     seed = (unsigned)time(NULL);
@@ -405,6 +411,7 @@ int main(int argc, char ** argv)
   cout << "numVars: " << numVars << " bools & " << numVars << " ints" << std::endl;
   cout << "pdsSizeFactor: " << pdsSizeFactor << std::endl;
   cout << "seed: " << seed << std::endl;
+  cout << "tune: " << tune << std::endl;
 
   //unsigned seed = 111;
   program_bdd_context_t bmt = new ProgramBddContext();
@@ -422,6 +429,17 @@ int main(int argc, char ** argv)
       bmt->addIntVar(s.str(),4);
     }
   }
+  if(tune){
+    // Time the tensor strategies on weights like those of the model. The
+    // variables come from addIntVar, which does not use the level
+    // arrangement, so only the detensor method of the choice matters here.
+    std::vector<binrel_t> sample;
+    for(int i = 0; i < 16; ++i)
+      sample.push_back(new BinRel(bmt.get_ptr(), bmt->tGetRandomTransformer(false)));
+    TensorStrategy best = BddContext::tuneTensorStrategy(*bmt, sample, &cout);
+    cout << "Tensor strategy: " << best << std::endl;
+    bmt->setTensorStrategy(best);
+  }
   mwg = new MyWtGen(bmt);
   //pds.print(cout);
   WFACompare fac("KLEENE", "NEWTON");
@@ -0,0 +1,90 @@
+/*!
+ * Measures the single-threaded cost of atomic reference counts.
+ *
+ * Runs the same ref_ptr copy/destroy loop over an object with a plain
+ * unsigned count and over an AtomicCountable, and then a loop of
+ * ShortestPathSemiring extends and combines, whose sem_elem_ts use
+ * Countable's count (atomic only if built with WALI_ATOMIC_REFCOUNT).
+ *
+ * Usage: refcount_speed_test [iterations]
+ */
+
+#include "wali/Countable.hpp"
+#include "wali/ShortestPathSemiring.hpp"
+#include "wali/util/Timer.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+using namespace std;
+using namespace wali;
+
+struct PlainCounted
+{
+  unsigned int count;
+  PlainCounted() : count(0) {}
+};
+
+struct AtomicCounted : AtomicCountable
+{
+};
+
+template< typename T >
+static double copyLoop( long iterations )
+{
+  ref_ptr<T> orig = new T();
+  vector< ref_ptr<T> > held(16);
+
+  util::Timer timer("copyLoop", cout);
+  for( long i = 0 ; i < iterations ; i++ ) {
+    held[i % held.size()] = orig;
+    ref_ptr<T> tmp(orig);
+    held[(i * 7) % held.size()] = tmp;
+  }
+  return timer.elapsed();
+}
+
+static double semElemLoop( long iterations )
+{
+  sem_elem_t one = new ShortestPathSemiring(0);
+  sem_elem_t step = new ShortestPathSemiring(1);
+  sem_elem_t acc = one->zero();
+
+  util::Timer timer("semElemLoop", cout);
+  for( long i = 0 ; i < iterations ; i++ ) {
+    sem_elem_t w = one;
+    for( int j = 0 ; j < 8 ; j++ )
+      w = w->extend(step);
+    acc = acc->combine(w);
+  }
+  return timer.elapsed();
+}
+
+int main(int argc, char ** argv)
+{
+  long iterations = 20000000;
+  if( argc > 1 ) {
+    istringstream (argv[1]) >> iterations;
+  }
+
+#ifdef WALI_ATOMIC_REFCOUNT
+  cout << "Countable uses atomic counts (WALI_ATOMIC_REFCOUNT)\n";
+#else
+  cout << "Countable uses plain counts\n";
+#endif
+
+  double plain = copyLoop<PlainCounted>(iterations);
+  double atomic = copyLoop<AtomicCounted>(iterations);
+  double sem = semElemLoop(iterations / 10);
+
+  cout << "ref_ptr copies, plain count:  " << plain << " s\n";
+  cout << "ref_ptr copies, atomic count: " << atomic << " s";
+  if( plain > 0 )
+    cout << "  (x" << atomic / plain << ")";
+  cout << "\n";
+  cout << "ShortestPath extend/combine:  " << sem << " s\n";
+
+  return 0;
+}
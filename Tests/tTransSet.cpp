@@ -1,23 +1,76 @@
 /*!
  * @author Nick Kidd
  *
- * Test basic operations on wfa::TransSet.
- * TODO - Finish.
+ * Test basic operations on wfa::TransSet, and time walking the
+ * outgoing transitions of a generated WFA (against the std::set
+ * TransSet used to wrap) as well as epsilonClose and path_summary on it.
+ *
+ * Usage: tTransSet [states [rounds]]
  */
 
 #include "wali/Common.hpp"
 #include "wali/wfa/Trans.hpp"
 #include "wali/wfa/TransSet.hpp"
 #include "wali/wfa/WFA.hpp"
+#include "wali/wfa/State.hpp"
+#include "wali/util/Timer.hpp"
 #include "Reach.hpp"
 
-int main()
+#include <algorithm>
+#include <cstdlib>
+#include <set>
+#include <sstream>
+#include <vector>
+
+using wali::Key;
+using wali::getKey;
+using wali::wfa::ITrans;
+using wali::wfa::ITransLT;
+using wali::wfa::Trans;
+using wali::wfa::TransSet;
+using wali::wfa::WFA;
+
+// A WFA over states 0..n-1 where each state has 1-4 outgoing
+// transitions, like the output of a typical poststar.
+static void generate( WFA & fa, size_t n, sem_elem_t one )
+{
+  std::vector<Key> states;
+  for( size_t i = 0 ; i < n ; i++ ) {
+    std::stringstream ss;
+    ss << "tts_q" << i;
+    states.push_back( getKey(ss.str()) );
+    fa.addState( states.back(), one->zero() );
+  }
+  fa.setInitialState( states[0] );
+  fa.addFinalState( states[n-1] );
+  Key syms[] = { getKey("tts_a"), getKey("tts_b"), getKey("tts_c"), wali::WALI_EPSILON };
+  for( size_t i = 0 ; i < n ; i++ ) {
+    // (i, a, i+1) keeps every state co-reachable from the final state
+    if( i + 1 < n )
+      fa.addTrans( states[i], syms[0], states[i+1], one );
+    int fanout = rand() % 4;
+    for( int j = 0 ; j < fanout ; j++ ) {
+      Key to = states[ (i + 1 + rand() % 8) % n ];
+      fa.addTrans( states[i], syms[rand() % 4], to, one );
+    }
+  }
+}
+
+// The access pattern of path_summary and epsilonClose: for each
+// state, read every outgoing transition.
+template< typename Set >
+static size_t walk( std::vector< Set * > const & sets )
+{
+  size_t sum = 0;
+  for( size_t i = 0 ; i < sets.size() ; i++ ) {
+    for( typename Set::const_iterator it = sets[i]->begin() ; it != sets[i]->end() ; it++ )
+      sum += (*it)->to();
+  }
+  return sum;
+}
+
+int main(int argc, char ** argv)
 {
-  using wali::Key;
-  using wali::getKey;
-  using wali::wfa::Trans;
-  using wali::wfa::TransSet;
-  using wali::wfa::WFA;
   Key a = getKey("a");
   Key b = getKey("b");
   Key c = getKey("c");
@@ -30,8 +83,73 @@ int main()
   s.insert( new Trans(a,getKey("b"),d,R->one()) );
   s.print( std::cout << "TransSet " ) << std::endl;
 
-  return 0;
+  size_t n = 200000;
+  int rounds = 200;
+  if( argc > 1 )
+    std::istringstream(argv[1]) >> n;
+  if( argc > 2 )
+    std::istringstream(argv[2]) >> rounds;
+  srand(7);
+
+  WFA fa;
+  generate( fa, n, R->one() );
 
+  // Copy the transitions into fresh TransSets and into the std::set
+  // layout TransSet used to have. Saturation adds transitions to many
+  // states in turn, so insert them in a shuffled order.
+  std::vector< TransSet * > flat;
+  std::vector< std::set< ITrans*,ITransLT > * > tree;
+  std::vector< std::pair< size_t,ITrans * > > order;
+  std::set<Key> const & Q = fa.getStates();
+  for( std::set<Key>::const_iterator q = Q.begin() ; q != Q.end() ; q++ ) {
+    TransSet & ts = fa.getState(*q)->getTransSet();
+    for( TransSet::const_iterator it = ts.begin() ; it != ts.end() ; it++ )
+      order.push_back( std::make_pair(flat.size(),*it) );
+    flat.push_back( new TransSet() );
+    tree.push_back( new std::set< ITrans*,ITransLT >() );
+  }
+  std::random_shuffle( order.begin(),order.end() );
+  for( size_t i = 0 ; i < order.size() ; i++ ) {
+    flat[order[i].first]->insert( order[i].second );
+    tree[order[i].first]->insert( order[i].second );
+  }
 
+  size_t check = 0;
+  double tflat, ttree;
+  {
+    wali::util::Timer timer("TransSet walk", std::cout);
+    for( int r = 0 ; r < rounds ; r++ )
+      check += walk( flat );
+    tflat = timer.elapsed();
+  }
+  {
+    wali::util::Timer timer("std::set walk", std::cout);
+    for( int r = 0 ; r < rounds ; r++ )
+      check -= walk( tree );
+    ttree = timer.elapsed();
+  }
+  if( check != 0 ) {
+    std::cerr << "[ERROR] the two walks disagree\n";
+    return 1;
+  }
+  std::cout << "Walking " << n << " states x " << rounds << " rounds: "
+            << tflat << "s vs " << ttree << "s for std::set ("
+            << (tflat > 0 ? ttree / tflat : 0) << "x)\n";
+
+  {
+    wali::util::Timer timer("epsilonClose", std::cout);
+    for( size_t i = 0 ; i < 10 ; i++ )
+      fa.epsilonClose( fa.getInitialState() );
+  }
+  {
+    wali::util::Timer timer("path_summary", std::cout);
+    fa.path_summary();
+  }
+
+  for( size_t i = 0 ; i < tree.size() ; i++ ) {
+    delete flat[i];
+    delete tree[i];
+  }
+  return 0;
 }
 
@@ -1,5 +1,6 @@
 #include "gtest/gtest.h"
 #include "buddy/bdd.h"
+#include "buddy/fdd.h"
 
 // ::std
 #include <iostream>
@@ -1392,6 +1393,132 @@ namespace{
     bdd b = p.Assume(p.From("a"), p.Const(0));
     ASSERT_NE(b, bddfalse);
   }
+
+
+  // Sizes of Eq23Project and Eq13Project of a few tensored relations over
+  // three variables, counted over the base levels. The context is the only
+  // one alive, so its (small) BuDDy has no other variables to count.
+  static std::vector<double> detensorSizes(TensorStrategy const & s)
+  {
+    ProgramBddContext voc(100000);
+    voc.setTensorStrategy(s);
+    map<string, int> m;
+    m["a"] = 4;
+    m["b"] = 4;
+    m["c"] = 4;
+    voc.setIntVars(m);
+    bdd levels = bddtrue;
+    for(BddContext::const_iterator it = voc.begin(); it != voc.end(); ++it)
+      levels &= fdd_ithset(it->second->baseLhs) & fdd_ithset(it->second->baseRhs);
+
+    binrel_t inc = new BinRel(&voc, voc.Assign("a", voc.Plus(voc.From("a"), voc.Const(1))));
+    binrel_t copy = new BinRel(&voc, voc.Assign("b", voc.From("c")));
+    binrel_t sum = new BinRel(&voc, voc.Assign("c", voc.Plus(voc.From("a"), voc.From("b"))));
+    binrel_t ws[] = {inc, copy, sum, inc->Compose(sum)->Union(copy)};
+    std::vector<double> sizes;
+    for(int i = 0; i < 4; ++i){
+      binrel_t t = ws[i]->Kronecker(ws[(i + 1) % 4])->Compose(ws[(i + 2) % 4]->Kronecker(ws[i]));
+      sizes.push_back(bdd_satcountset(t->Eq23Project()->getBdd(), levels));
+      sizes.push_back(bdd_satcountset(t->Eq13Project()->getBdd(), levels));
+    }
+    return sizes;
+  }
+
+  TEST(wali$domains$binrel$$BddContext$$setTensorStrategy, strategiesAgree)
+  {
+#if (NWA_DETENSOR == 0)
+    TensorLayout layouts[] = {
+      LAYOUT_TENSOR_MAX_AFFINITY, LAYOUT_TENSOR_MIN_AFFINITY,
+      LAYOUT_BASE_MAX_AFFINITY_TENSOR_MIXED, LAYOUT_TENSOR_MATCHED_PAREN};
+    std::vector<double> expected = detensorSizes(TensorStrategy());
+    for(int l = 0; l < 4; ++l){
+      EXPECT_EQ(expected, detensorSizes(TensorStrategy(layouts[l], DETENSOR_METHOD_BIT_BY_BIT)));
+      EXPECT_EQ(expected, detensorSizes(TensorStrategy(layouts[l], DETENSOR_METHOD_TOGETHER)));
+    }
+#endif
+  }
+
+  // Compose as the separate replace, relprod and replace that
+  // bdd_relprodreplace fuses: shift b to the right, join on the middle
+  // levels and move the result back.
+  static bdd separateCompose(ProgramBddContext const & voc, bdd a, bdd b)
+  {
+    bddPair * shift = bdd_newpair();
+    bddPair * restore = bdd_newpair();
+    bdd mid = bddtrue;
+    for(BddContext::const_iterator it = voc.begin(); it != voc.end(); ++it){
+      fdd_setpair(shift, it->second->baseLhs, it->second->baseRhs);
+      fdd_setpair(shift, it->second->baseRhs, it->second->baseExtra);
+      fdd_setpair(restore, it->second->baseExtra, it->second->baseRhs);
+      mid &= fdd_ithset(it->second->baseRhs);
+    }
+    bdd c = bdd_replace(bdd_relprod(a, bdd_replace(b, shift), mid), restore);
+    bdd_freepair(shift);
+    bdd_freepair(restore);
+    return c;
+  }
+
+  TEST(wali$domains$binrel$$BinRel$$Compose, fusedAndSeparateAgree)
+  {
+    ProgramBddContext voc(100000);
+    map<string, int> m;
+    m["a"] = 4;
+    m["b"] = 2;
+    m["c"] = 8;
+    voc.setIntVars(m);
+
+    std::vector<binrel_t> ws;
+    for(unsigned i = 0; i < 6; ++i)
+      ws.push_back(new BinRel(&voc, voc.tGetRandomTransformer(false, i + 1)));
+    ws.push_back(new BinRel(&voc, voc.Assign("c", voc.Plus(voc.From("c"), voc.From("a")))));
+
+    // The second round finds the products of the first in the cache
+    for(int round = 0; round < 2; ++round){
+      for(size_t i = 0; i < ws.size(); ++i){
+        for(size_t j = 0; j < ws.size(); ++j){
+          EXPECT_EQ(separateCompose(voc, ws[i]->getBdd(), ws[j]->getBdd()),
+                    ws[i]->Compose(ws[j])->getBdd())
+            << "round " << round << ", " << i << " ; " << j;
+        }
+      }
+    }
+  }
+
+  TEST(wali$domains$binrel$$BinRel$$Compose, relprodreplaceFallsBack)
+  {
+    ProgramBddContext voc(100000);
+    map<string, int> m;
+    m["a"] = 4;
+    m["b"] = 4;
+    voc.setIntVars(m);
+
+    // Swapping the left and right copies turns the order of their levels
+    // around, so the fused pass cannot rename on the fly
+    bddPair * swap = bdd_newpair();
+    bdd mid = bddtrue;
+    for(BddContext::const_iterator it = voc.begin(); it != voc.end(); ++it){
+      fdd_setpair(swap, it->second->baseLhs, it->second->baseRhs);
+      fdd_setpair(swap, it->second->baseRhs, it->second->baseLhs);
+      mid &= fdd_ithset(it->second->baseRhs);
+    }
+
+    bdd inc = voc.Assign("a", voc.Plus(voc.From("a"), voc.From("b")));
+    bdd copy = voc.Assign("b", voc.From("a"));
+    // The first call finds out, the second goes straight to the
+    // separate operations
+    for(int round = 0; round < 2; ++round){
+      EXPECT_EQ(bdd_relprod(bdd_replace(inc, swap), copy, mid),
+                bdd_relprodreplace(inc, swap, copy, NULL, mid, NULL)) << "round " << round;
+      EXPECT_EQ(bdd_relprod(bdd_replace(copy, swap), inc, mid),
+                bdd_relprodreplace(copy, swap, inc, NULL, mid, NULL)) << "round " << round;
+    }
+    bdd_freepair(swap);
+
+    // Compose still takes the fused pass
+    binrel_t a = new BinRel(&voc, inc);
+    binrel_t b = new BinRel(&voc, copy);
+    EXPECT_EQ(separateCompose(voc, inc, copy), a->Compose(b)->getBdd());
+  }
 } //namespace
 
 
@@ -0,0 +1,129 @@
+#include "gtest/gtest.h"
+#include "buddy/fdd.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "wali/domains/binrel/BitRel.hpp"
+#include "wali/domains/binrel/ProgramBddContext.hpp"
+
+using namespace std;
+using namespace wali;
+using namespace wali::domains::binrel;
+
+namespace {
+
+  char const * const names[] = {"a", "b", "c"};
+
+  map<string, int> vocabulary()
+  {
+    // 24 states, so blocks of the tensored matrices straddle words
+    map<string, int> m;
+    m["a"] = 4;
+    m["b"] = 2;
+    m["c"] = 3;
+    return m;
+  }
+
+  bool sameRelation(binrel_t b, bitrel_t r)
+  {
+    ProgramBddContext const & voc = dynamic_cast<ProgramBddContext const &>(b->getVocabulary());
+    BitRelContext const & con = r->getVocabulary();
+    for(unsigned s = 0; s < con.numStates(); ++s){
+      for(unsigned t = 0; t < con.numStates(); ++t){
+        bdd cube = bddtrue;
+        for(int i = 0; i < 3; ++i){
+          bddinfo_t bi = voc.find(names[i])->second;
+          cube &= fdd_ithvar(bi->baseLhs, con.valueOf(s, names[i]))
+            & fdd_ithvar(bi->baseRhs, con.valueOf(t, names[i]));
+        }
+        if(((b->getBdd() & cube) != bddfalse) != r->getMatrix().get(s, t))
+          return false;
+      }
+    }
+    return true;
+  }
+
+  template<typename Context, typename Rel>
+  vector< ref_ptr<Rel> > transformers(Context & voc)
+  {
+    vector< ref_ptr<Rel> > ws;
+    ws.push_back(new Rel(&voc, voc.Assign("a", voc.Plus(voc.From("a"), voc.Const(1)))));
+    ws.push_back(new Rel(&voc, voc.Assign("c", voc.From("a"))));
+    ws.push_back(new Rel(&voc, voc.Assume(voc.From("b"), voc.True())));
+    ws.push_back(new Rel(&voc, voc.Assign("b", voc.NonDet())));
+    ws.push_back(new Rel(&voc, voc.Assign("a", voc.Times(voc.From("a"), voc.From("c")))));
+    ws.push_back(new Rel(&voc, voc.Assign("b", voc.Or(voc.Not(voc.From("b")), voc.False()))));
+    return ws;
+  }
+
+}
+
+TEST(wali$domains$binrel$$BitRelContext$$fits, vocabularySizes)
+{
+  map<string, int> m;
+  m["a"] = 64;
+  EXPECT_TRUE(BitRelContext::fits(m, true));
+  m["b"] = 64;
+  EXPECT_TRUE(BitRelContext::fits(m));
+  EXPECT_FALSE(BitRelContext::fits(m, true));
+  m["c"] = 2;
+  EXPECT_FALSE(BitRelContext::fits(m));
+}
+
+TEST(wali$domains$binrel$$BitRel, agreesWithBinRel)
+{
+  ProgramBddContext voc(100000);
+  voc.setIntVars(vocabulary());
+  BitRelContext con(vocabulary());
+  ASSERT_EQ(24u, con.numStates());
+
+  vector<binrel_t> bs = transformers<ProgramBddContext, BinRel>(voc);
+  vector<bitrel_t> rs = transformers<BitRelContext, BitRel>(con);
+
+  for(size_t i = 0; i < bs.size(); ++i){
+    EXPECT_TRUE(sameRelation(bs[i], rs[i])) << "transformer " << i;
+    sem_elem_t bstar = bs[i]->star();
+    sem_elem_t rstar = rs[i]->star();
+    EXPECT_TRUE(sameRelation(dynamic_cast<BinRel*>(bstar.get_ptr()),
+                             dynamic_cast<BitRel*>(rstar.get_ptr()))) << "star " << i;
+    for(size_t j = 0; j < bs.size(); ++j){
+      EXPECT_TRUE(sameRelation(bs[i]->Compose(bs[j]), rs[i]->Compose(rs[j])))
+        << "compose " << i << " " << j;
+      EXPECT_TRUE(sameRelation(bs[i]->Union(bs[j]), rs[i]->Union(rs[j])))
+        << "union " << i << " " << j;
+    }
+  }
+
+  for(size_t i = 0; i < bs.size(); ++i){
+    size_t j = (i + 1) % bs.size(), k = (i + 2) % bs.size();
+    binrel_t bt = bs[i]->Kronecker(bs[j])->Compose(bs[k]->Kronecker(bs[i]));
+    bitrel_t rt = rs[i]->Kronecker(rs[j])->Compose(rs[k]->Kronecker(rs[i]));
+    EXPECT_TRUE(sameRelation(bt->Eq23Project(), rt->Eq23Project())) << "detensor " << i;
+    EXPECT_TRUE(sameRelation(bt->Eq13Project(), rt->Eq13Project())) << "detensorTranspose " << i;
+  }
+}
+
+TEST(wali$domains$binrel$$BitRel, semiringIdentities)
+{
+  BitRelContext con(vocabulary());
+  vector<bitrel_t> rs = transformers<BitRelContext, BitRel>(con);
+  bitrel_t one = dynamic_cast<BitRel*>(rs[0]->one().get_ptr());
+  bitrel_t zero = dynamic_cast<BitRel*>(rs[0]->zero().get_ptr());
+
+  EXPECT_TRUE(one->isOne());
+  EXPECT_TRUE(zero->isZero());
+  EXPECT_TRUE(one->Kronecker(one)->isOne());
+  EXPECT_TRUE(one->Kronecker(one)->Eq23Project()->isOne());
+  for(size_t i = 0; i < rs.size(); ++i){
+    EXPECT_TRUE(rs[i]->Compose(one)->Equal(rs[i]));
+    EXPECT_TRUE(one->Compose(rs[i])->Equal(rs[i]));
+    EXPECT_TRUE(rs[i]->Compose(zero)->isZero());
+    EXPECT_TRUE(rs[i]->Union(zero)->Equal(rs[i]));
+    EXPECT_TRUE(rs[i]->Transpose()->Transpose()->Equal(rs[i]));
+    // detensor(one (x) w) = w, detensorTranspose(w^T (x) one) = w
+    EXPECT_TRUE(one->Kronecker(rs[i])->Eq23Project()->Equal(rs[i]));
+    EXPECT_TRUE(rs[i]->Transpose()->Kronecker(one)->Eq13Project()->Equal(rs[i]));
+  }
+}
@@ -0,0 +1,195 @@
+#include "gtest/gtest.h"
+#include "buddy/fdd.h"
+
+#include <algorithm>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "wali/domains/binrel/BinRel.hpp"
+#include "wali/domains/binrel/ProgramBddContext.hpp"
+
+using namespace std;
+using namespace wali;
+using namespace wali::domains::binrel;
+
+namespace {
+
+  const int PAIRS = 5;
+
+  string name(char c, int i)
+  {
+    stringstream ss;
+    ss << c << i;
+    return ss.str();
+  }
+
+  // x0..x4 are created above y0..y4, so relations that tie each xi to yi
+  // are far from their best order.
+  void vocabulary(ProgramBddContext & voc)
+  {
+    map<string, int> m;
+    for(int i = 0; i < PAIRS; ++i){
+      m[name('x', i)] = 4;
+      m[name('y', i)] = 4;
+    }
+    voc.setIntVars(m);
+  }
+
+  vector<binrel_t> transformers(ProgramBddContext & voc)
+  {
+    vector<binrel_t> ws;
+    binrel_t all = new BinRel(&voc, voc.Assume(voc.True(), voc.True()));
+    for(int i = 0; i < PAIRS; ++i){
+      binrel_t eq = new BinRel(&voc, voc.Assume(voc.From(name('x', i)), voc.From(name('y', i))));
+      all = all->Compose(eq);
+      ws.push_back(eq);
+      ws.push_back(new BinRel(&voc, voc.Assign(name('y', i), voc.Plus(voc.From(name('x', i)), voc.Const(1)))));
+    }
+    ws.push_back(all);
+    return ws;
+  }
+
+  // The levels of the nine copies of each bit of each variable
+  vector< vector<int> > copyLevels(ProgramBddContext const & voc)
+  {
+    vector< vector<int> > levels;
+    for(BddContext::const_iterator it = voc.begin(); it != voc.end(); ++it){
+      bddinfo_t bi = it->second;
+      int copies[9] = {
+        (int) bi->baseLhs, (int) bi->baseRhs, (int) bi->baseExtra,
+        (int) bi->tensor1Lhs, (int) bi->tensor1Rhs, (int) bi->tensor1Extra,
+        (int) bi->tensor2Lhs, (int) bi->tensor2Rhs, (int) bi->tensor2Extra};
+      for(int b = 0; b < fdd_varnum(copies[0]); ++b){
+        vector<int> l;
+        for(int c = 0; c < 9; ++c)
+          l.push_back(bdd_var2level(fdd_vars(copies[c])[b]));
+        levels.push_back(l);
+      }
+    }
+    return levels;
+  }
+
+  // The copies of a bit form one block, or one block per ply
+  bool contiguous(vector<int> l)
+  {
+    sort(l.begin(), l.end());
+    if(l.back() - l.front() == 8)
+      return true;
+    for(int p = 0; p < 9; p += 3)
+      if(*max_element(l.begin() + p, l.begin() + p + 3) - *min_element(l.begin() + p, l.begin() + p + 3) != 2)
+        return false;
+    return true;
+  }
+
+  // Blocks are fixed: their variables keep their order
+  bool sameArrangement(vector<int> a, vector<int> b)
+  {
+    for(int i = 0; i < 9; ++i)
+      for(int j = 0; j < 9; ++j)
+        if((a[i] < a[j]) != (b[i] < b[j]))
+          return false;
+    return true;
+  }
+
+  string savedOrder()
+  {
+    stringstream ss;
+    BddContext::saveVariableOrder(ss);
+    return ss.str();
+  }
+
+}
+
+TEST(wali$domains$binrel$$BddContext$$reorder, relationsAndBlocksSurvive)
+{
+  ProgramBddContext voc(100000);
+  vocabulary(voc);
+  vector<binrel_t> ws = transformers(voc);
+  vector<binrel_t> composed;
+  for(size_t i = 0; i < ws.size(); ++i)
+    composed.push_back(ws[i]->Compose(ws[(i + 1) % ws.size()]));
+  vector< vector<int> > before = copyLevels(voc);
+  string order = savedOrder();
+
+  BddContext::enableReordering();
+  BddContext::resetReorderStats();
+  BddContext::reorder();
+  EXPECT_EQ(1u, BddContext::getReorderStats().reorderings);
+  EXPECT_NE(order, savedOrder());
+
+  vector< vector<int> > after = copyLevels(voc);
+  ASSERT_EQ(before.size(), after.size());
+  for(size_t i = 0; i < after.size(); ++i){
+    EXPECT_TRUE(contiguous(after[i])) << "bit " << i;
+    EXPECT_TRUE(sameArrangement(before[i], after[i])) << "bit " << i;
+  }
+
+  // The relations kept across the reordering are still the ones built now
+  vector<binrel_t> again = transformers(voc);
+  for(size_t i = 0; i < ws.size(); ++i){
+    EXPECT_TRUE(ws[i]->Equal(again[i])) << "transformer " << i;
+    EXPECT_TRUE(composed[i]->Equal(again[i]->Compose(again[(i + 1) % again.size()])))
+      << "compose " << i;
+  }
+  BddContext::disableReordering();
+}
+
+TEST(wali$domains$binrel$$BddContext$$reorder, savedOrderRoundTrips)
+{
+  string order;
+  {
+    ProgramBddContext voc(100000);
+    vocabulary(voc);
+    vector<binrel_t> ws = transformers(voc);
+    BddContext::enableReordering();
+    BddContext::reorder();
+    BddContext::disableReordering();
+    order = savedOrder();
+  }
+
+  // A new BuDDy, with the variables at their initial levels
+  ProgramBddContext voc(100000);
+  vocabulary(voc);
+  ASSERT_NE(order, savedOrder());
+  stringstream in(order);
+  EXPECT_TRUE(BddContext::loadVariableOrder(in));
+  EXPECT_EQ(order, savedOrder());
+
+  vector< vector<int> > levels = copyLevels(voc);
+  for(size_t i = 0; i < levels.size(); ++i)
+    EXPECT_TRUE(contiguous(levels[i])) << "bit " << i;
+
+  // Relations built under the loaded order and reordered ones agree
+  vector<binrel_t> ws = transformers(voc);
+  BddContext::enableReordering();
+  BddContext::reorder();
+  BddContext::disableReordering();
+  vector<binrel_t> again = transformers(voc);
+  for(size_t i = 0; i < ws.size(); ++i)
+    EXPECT_TRUE(ws[i]->Equal(again[i])) << "transformer " << i;
+}
+
+TEST(wali$domains$binrel$$BddContext$$reorder, loadRejectsSplitBlocks)
+{
+  ProgramBddContext voc(100000);
+  vocabulary(voc);
+  string order = savedOrder();
+
+  // Move the top variable, the first of its block, to the bottom
+  stringstream in(order), split;
+  string line, top;
+  while(getline(in, line)){
+    if(line.empty() || line[0] == '#')
+      split << line << "\n";
+    else if(top.empty())
+      top = line;
+    else
+      split << line << "\n";
+  }
+  split << top << "\n";
+
+  EXPECT_FALSE(BddContext::loadVariableOrder(split));
+  EXPECT_EQ(order, savedOrder());
+}
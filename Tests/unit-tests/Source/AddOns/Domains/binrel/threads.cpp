@@ -0,0 +1,81 @@
+#include "gtest/gtest.h"
+
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "wali/domains/binrel/BinRel.hpp"
+#include "wali/domains/binrel/ProgramBddContext.hpp"
+
+using namespace std;
+using namespace wali;
+using namespace wali::domains::binrel;
+
+namespace {
+
+  /// Builds a context and a few relations on the calling thread and
+  /// prints what some compositions, stars and detensors of them give.
+  /// Only the printed form leaves the thread: the BDDs belong to its
+  /// BuDDy.
+  string analyze(int variant)
+  {
+    ProgramBddContext voc(100000);
+    map<string, int> m;
+    m["a"] = 4;
+    m["b"] = 4;
+    m["c"] = 2;
+    voc.setIntVars(m);
+
+    vector<binrel_t> ws;
+    ws.push_back(new BinRel(&voc, voc.Assign("a", voc.Plus(voc.From("a"), voc.Const(1)))));
+    ws.push_back(new BinRel(&voc, voc.Assign("b", voc.From("a"))));
+    ws.push_back(new BinRel(&voc, voc.Assume(voc.From("c"), voc.True())));
+    ws.push_back(new BinRel(&voc, voc.Assign("c", voc.NonDet())));
+    ws.push_back(new BinRel(&voc, voc.Assign("a", voc.Times(voc.From("b"), voc.Const(variant + 2)))));
+
+    stringstream ss;
+    for(size_t i = 0; i < ws.size(); ++i){
+      binrel_t w = ws[i];
+      for(size_t j = 0; j < ws.size(); ++j)
+        w = w->Compose(ws[(i + j) % ws.size()])->Union(ws[j]);
+      w->print(ss << "path " << i << ": ") << "\n";
+      w->star()->print(ss << "star " << i << ": ") << "\n";
+
+      binrel_t t = ws[i]->Kronecker(ws[(i + 1) % ws.size()])->Compose(
+          ws[(i + 2) % ws.size()]->Kronecker(ws[i]));
+      t->Eq23Project()->print(ss << "detensor " << i << ": ") << "\n";
+      t->Eq13Project()->print(ss << "detensorTranspose " << i << ": ") << "\n";
+    }
+    return ss.str();
+  }
+
+  void analyzeMany(int variant, int rounds, vector<string> * out)
+  {
+    for(int r = 0; r < rounds; ++r)
+      out->push_back(analyze(variant));
+  }
+
+}
+
+TEST(wali$domains$binrel$$BddContext, threadsHaveIndependentBuddies)
+{
+  string expected[2] = { analyze(0), analyze(1) };
+  ASSERT_NE(expected[0], expected[1]);
+
+  // Each thread creates and destroys its contexts, and so starts and
+  // stops its BuDDy, several times while the other one is computing
+  const int rounds = 5;
+  vector<string> results[2];
+  std::thread t0(analyzeMany, 0, rounds, &results[0]);
+  std::thread t1(analyzeMany, 1, rounds, &results[1]);
+  t0.join();
+  t1.join();
+
+  for(int t = 0; t < 2; ++t){
+    ASSERT_EQ(size_t(rounds), results[t].size());
+    for(int r = 0; r < rounds; ++r)
+      EXPECT_EQ(expected[t], results[t][r]) << "thread " << t << ", round " << r;
+  }
+}
@@ -0,0 +1,95 @@
+#include "SmallProgram.hpp"
+
+#include <sstream>
+
+#include "wali/ShortestPathSemiring.hpp"
+
+using wali::Key;
+using wali::getKey;
+using wali::sem_elem_t;
+using wali::wfa::WFA;
+using wali::wpds::WPDS;
+
+namespace testing
+{
+  sem_elem_t dist(unsigned d)
+  {
+    return new wali::ShortestPathSemiring(d);
+  }
+
+  SmallProgram::SmallProgram(std::string const & prefix)
+    : prefix(prefix)
+  {}
+
+  Key SmallProgram::p() const
+  {
+    return getKey(prefix + "_p");
+  }
+
+  Key SmallProgram::node(int proc, int n) const
+  {
+    std::stringstream ss;
+    ss << prefix << "_p" << proc << "_n" << n;
+    return getKey(ss.str());
+  }
+
+  Key SmallProgram::accept() const
+  {
+    return getKey(prefix + "_accept");
+  }
+
+  void SmallProgram::step(WPDS & pds, int proc, int from, int to, unsigned w) const
+  {
+    pds.add_rule(p(), node(proc, from), p(), node(proc, to), dist(w));
+  }
+
+  void SmallProgram::call(WPDS & pds, int proc, int from, int callee, int to, unsigned w) const
+  {
+    pds.add_rule(p(), node(proc, from), p(), node(callee, 0), node(proc, to), dist(w));
+  }
+
+  void SmallProgram::ret(WPDS & pds, int proc, int n, unsigned w) const
+  {
+    pds.add_rule(p(), node(proc, n), p(), dist(w));
+  }
+
+  void SmallProgram::chain(WPDS & pds, int proc, int last,
+                           std::map<int, int> const & calls) const
+  {
+    for (int n = 0; n < last; ++n) {
+      std::map<int, int>::const_iterator c = calls.find(n);
+      if (c != calls.end())
+        call(pds, proc, n, c->second, n + 1, 1);
+      else
+        step(pds, proc, n, n + 1, n + 1);
+    }
+    ret(pds, proc, last, 1);
+  }
+
+  WFA SmallProgram::query(Key top, Key below) const
+  {
+    sem_elem_t one = dist(0)->one();
+    WFA q;
+    q.addState(p(), one->zero());
+    q.addState(accept(), one->zero());
+    q.setInitialState(p());
+    q.addFinalState(accept());
+    if (below == wali::WALI_EPSILON) {
+      q.addTrans(p(), top, accept(), one);
+    }
+    else {
+      Key mid = getKey(prefix + "_mid");
+      q.addState(mid, one->zero());
+      q.addTrans(p(), top, mid, one);
+      q.addTrans(mid, below, accept(), one);
+    }
+    return q;
+  }
+}
+
+// Yo emacs!
+// Local Variables:
+//     c-file-style: "ellemtel"
+//     c-basic-offset: 2
+//     indent-tabs-mode: nil
+// End:
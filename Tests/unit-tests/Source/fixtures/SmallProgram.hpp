@@ -0,0 +1,62 @@
+#ifndef WALI_TESTING_SMALL_PROGRAM_HPP
+#define WALI_TESTING_SMALL_PROGRAM_HPP
+
+#include <map>
+#include <string>
+
+#include "wali/Key.hpp"
+#include "wali/SemElem.hpp"
+#include "wali/wfa/WFA.hpp"
+#include "wali/wpds/WPDS.hpp"
+
+namespace testing
+{
+  /// A ShortestPathSemiring weight
+  wali::sem_elem_t dist(unsigned d);
+
+  /// Keys, rules and queries for the small shortest-path programs of the
+  /// WPDS tests. The program has one control location, <prefix>_p; node
+  /// n of procedure proc is the stack symbol <prefix>_p<proc>_n<n>. Each
+  /// test file uses its own prefix, so the files do not share keys.
+  class SmallProgram
+  {
+  public:
+    explicit SmallProgram(std::string const & prefix);
+
+    wali::Key p() const;
+    wali::Key node(int proc, int n) const;
+    wali::Key accept() const;
+
+    /// node(proc, from) goes to node(proc, to)
+    void step(wali::wpds::WPDS & pds, int proc, int from, int to, unsigned w) const;
+
+    /// node(proc, from) calls procedure callee, which returns to
+    /// node(proc, to)
+    void call(wali::wpds::WPDS & pds, int proc, int from, int callee, int to, unsigned w) const;
+
+    /// node(proc, n) returns
+    void ret(wali::wpds::WPDS & pds, int proc, int n, unsigned w) const;
+
+    /// Procedure proc as a chain of nodes 0 to last. Node n calls
+    /// calls[n] with weight 1 if it has an entry there, and otherwise
+    /// steps to n + 1 with weight n + 1; the last node returns with
+    /// weight 1.
+    void chain(wali::wpds::WPDS & pds, int proc, int last,
+               std::map<int, int> const & calls = std::map<int, int>()) const;
+
+    /// Accepts <p, top>, or <p, top below> if below is not epsilon
+    wali::wfa::WFA query(wali::Key top, wali::Key below = wali::WALI_EPSILON) const;
+
+  private:
+    std::string prefix;
+  };
+}
+
+// Yo emacs!
+// Local Variables:
+//     c-file-style: "ellemtel"
+//     c-basic-offset: 2
+//     indent-tabs-mode: nil
+// End:
+
+#endif
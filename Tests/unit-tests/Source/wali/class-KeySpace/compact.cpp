@@ -0,0 +1,87 @@
+#include "gtest/gtest.h"
+
+#include "wali/Key.hpp"
+#include "wali/KeySpace.hpp"
+#include "wali/IntSource.hpp"
+#include "wali/KeyPairSource.hpp"
+#include "wali/KeySetSource.hpp"
+#include "wali/StringSource.hpp"
+
+using namespace wali;
+
+
+TEST(wali$KeySpace$getKey, sourceObjectsMatchCompactKeys)
+{
+    Key s = getKey("ks_compact_str");
+    Key i = getKey(123456);
+    Key p = getKey(s, i);
+
+    EXPECT_EQ(s, getKey(new StringSource("ks_compact_str")));
+    EXPECT_EQ(i, getKey(new IntSource(123456)));
+    EXPECT_EQ(p, getKey(new KeyPairSource(s, i)));
+    EXPECT_NE(p, getKey(i, s));
+}
+
+TEST(wali$KeySpace$getKey, negativeIntsAreDistinct)
+{
+    EXPECT_NE(getKey(-1), getKey(1));
+    EXPECT_EQ("-1", key2str(getKey(-1)));
+}
+
+TEST(wali$KeySpace$getKeySource, compactKeysGiveTheirSourceClass)
+{
+    Key s = getKey("ks_compact_src");
+    Key i = getKey(-42);
+    Key p = getKey(s, i);
+
+    StringSource * ss = dynamic_cast<StringSource*>(getKeySource(s).get_ptr());
+    ASSERT_TRUE(ss != NULL);
+    EXPECT_EQ("ks_compact_src", ss->getString());
+
+    IntSource * is = dynamic_cast<IntSource*>(getKeySource(i).get_ptr());
+    ASSERT_TRUE(is != NULL);
+    EXPECT_EQ(-42, is->getInt());
+
+    KeyPairSource * ps = dynamic_cast<KeyPairSource*>(getKeySource(p).get_ptr());
+    ASSERT_TRUE(ps != NULL);
+    EXPECT_EQ(s, ps->first());
+    EXPECT_EQ(i, ps->second());
+
+    // built once and then reused
+    EXPECT_EQ(getKeySource(p).get_ptr(), getKeySource(p).get_ptr());
+}
+
+TEST(wali$KeySpace$key2str, compactKeysPrintLikeTheirSources)
+{
+    Key s = getKey("ks_print");
+    Key p = getKey(s, getKey(7));
+    EXPECT_EQ("ks_print", key2str(s));
+    EXPECT_EQ("(ks_print,7)", key2str(p));
+    EXPECT_EQ(getKeySource(p)->toString(), key2str(p));
+}
+
+TEST(wali$KeySpace$getKeyPair, onlyPairKeysArePairs)
+{
+    Key a = getKey("ks_pair_first");
+    Key b = getKey("ks_pair_second");
+    KeySpace::key_pair_t kp;
+
+    EXPECT_TRUE(getKeySpace()->getKeyPair(getKey(a, b), kp));
+    EXPECT_EQ(a, kp.first);
+    EXPECT_EQ(b, kp.second);
+    EXPECT_EQ(a, KeyPairSource::get_first(getKey(a, b)));
+    EXPECT_EQ(b, KeyPairSource::get_second(getKey(a, b)));
+
+    EXPECT_FALSE(getKeySpace()->getKeyPair(a, kp));
+}
+
+TEST(wali$KeySpace$getKey, otherSourcesStillWork)
+{
+    std::set<Key> ks;
+    ks.insert(getKey("ks_set_a"));
+    ks.insert(getKey("ks_set_b"));
+
+    Key k = getKey(ks);
+    EXPECT_EQ(k, getKey(ks));
+    EXPECT_TRUE(dynamic_cast<KeySetSource*>(getKeySource(k).get_ptr()) != NULL);
+}
@@ -0,0 +1,103 @@
+#include "gtest/gtest.h"
+
+#include "wali/Key.hpp"
+#include "wali/KeySpace.hpp"
+#include "wali/KeyPairSource.hpp"
+
+#include <sstream>
+#include <thread>
+#include <vector>
+
+using namespace wali;
+
+namespace {
+    std::string name(int i)
+    {
+        std::stringstream ss;
+        ss << "ks_concurrent_" << i;
+        return ss.str();
+    }
+
+    void internAll(int first, int count, std::vector<Key> * out)
+    {
+        for (int i = 0; i < count; ++i) {
+            (*out)[i] = getKey(name(first + i));
+            // read back something another thread may be creating
+            EXPECT_EQ(name(first + i), key2str((*out)[i]));
+        }
+    }
+}
+
+
+TEST(wali$KeySpace$getKey, concurrentInterningGivesOneKeyPerSource)
+{
+    const int per_thread = 5000;
+    // Ranges overlap by half, so each name is interned by two threads.
+    std::vector<std::vector<Key> > results(4, std::vector<Key>(per_thread));
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.push_back(std::thread(internAll, t * per_thread / 2, per_thread,
+                                      &results[t]));
+    }
+    for (size_t t = 0; t < threads.size(); ++t) {
+        threads[t].join();
+    }
+
+    for (int t = 0; t < 4; ++t) {
+        for (int i = 0; i < per_thread; ++i) {
+            EXPECT_EQ(getKey(name(t * per_thread / 2 + i)), results[t][i]);
+        }
+    }
+}
+
+TEST(wali$KeySpace$getKeys, batchedStringsMatchSingleLookups)
+{
+    std::vector<std::string> strs;
+    strs.push_back("ks_batch_a");
+    strs.push_back("");
+    strs.push_back("ks_batch_b");
+    strs.push_back("ks_batch_a");
+
+    std::vector<Key> keys;
+    getKeySpace()->getKeys(strs, keys);
+
+    ASSERT_EQ(4u, keys.size());
+    EXPECT_EQ(getKey("ks_batch_a"), keys[0]);
+    EXPECT_EQ(WALI_EPSILON, keys[1]);
+    EXPECT_EQ(getKey("ks_batch_b"), keys[2]);
+    EXPECT_EQ(keys[0], keys[3]);
+}
+
+TEST(wali$KeySpace$getKeys, batchedPairsMatchSingleLookups)
+{
+    Key a = getKey("ks_pair_a");
+    Key b = getKey("ks_pair_b");
+
+    std::vector<KeySpace::key_pair_t> pairs;
+    pairs.push_back(KeySpace::key_pair_t(a, b));
+    pairs.push_back(KeySpace::key_pair_t(b, a));
+
+    std::vector<Key> keys;
+    getKeySpace()->getKeys(pairs, keys);
+
+    ASSERT_EQ(2u, keys.size());
+    EXPECT_EQ(getKey(a, b), keys[0]);
+    EXPECT_EQ(getKey(b, a), keys[1]);
+    EXPECT_NE(keys[0], keys[1]);
+}
+
+TEST(wali$KeySpace$reserve, doesNotCreateKeys)
+{
+    size_t before = getKeySpace()->size();
+    getKeySpace()->reserve(before + 100000);
+    EXPECT_EQ(before, getKeySpace()->size());
+
+    Key k = getKey("ks_after_reserve");
+    EXPECT_EQ(before, k);
+    EXPECT_EQ("ks_after_reserve", key2str(k));
+}
+
+TEST(wali$KeySpace$getKeySource, unknownKeyGivesNull)
+{
+    EXPECT_FALSE(getKeySource(getKeySpace()->size() + 12345).is_valid());
+}
@@ -0,0 +1,89 @@
+#include "gtest/gtest.h"
+
+#include "wali/HashMap.hpp"
+#include "wali/RobinHoodHashMap.hpp"
+#include "wali/KeyContainer.hpp"
+
+#include <map>
+
+using namespace wali;
+
+namespace {
+    // Sends every key to one of four hashes, so probe sequences are long
+    // and erase has to shift.
+    struct clumped_hash
+    {
+        size_t operator()(int k) const { return static_cast<size_t>(k % 4); }
+    };
+}
+
+
+TEST(wali$RobinHoodHashMap$insert, behavesLikeHashMap)
+{
+    HashMap<KeyPair, int> chained;
+    RobinHoodHashMap<KeyPair, int> robin;
+
+    for (int i = 0; i < 5000; ++i) {
+        KeyPair kp(i % 97, i % 89);
+        bool a = chained.insert(kp, i).second;
+        std::pair<RobinHoodHashMap<KeyPair, int>::iterator, bool> res = robin.insert(kp, i);
+        EXPECT_EQ(a, res.second);
+        EXPECT_EQ(chained.find(kp)->second, res.first->second);
+    }
+    EXPECT_EQ(chained.size(), robin.size());
+
+    for (HashMap<KeyPair, int>::iterator it = chained.begin(); it != chained.end(); ++it) {
+        RobinHoodHashMap<KeyPair, int>::const_iterator r = robin.find(it->first);
+        ASSERT_TRUE(r != robin.end());
+        EXPECT_EQ(it->second, r->second);
+    }
+    EXPECT_TRUE(robin.find(KeyPair(1000, 1000)) == robin.end());
+}
+
+TEST(wali$RobinHoodHashMap$erase, eraseWhileIteratingVisitsEveryValueOnce)
+{
+    RobinHoodHashMap<int, int, clumped_hash> m(4);
+    for (int i = 0; i < 12; ++i) {
+        m[i] = i * 10;
+    }
+    ASSERT_EQ(12u, m.size());
+
+    std::map<int, int> seen;
+    RobinHoodHashMap<int, int, clumped_hash>::iterator it = m.begin();
+    while (it != m.end()) {
+        seen[it->first]++;
+        if (it->first % 2 == 0) {
+            it = m.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+
+    EXPECT_EQ(12u, seen.size());
+    for (std::map<int, int>::iterator s = seen.begin(); s != seen.end(); ++s) {
+        EXPECT_EQ(1, s->second);
+    }
+    EXPECT_EQ(6u, m.size());
+    for (int i = 0; i < 12; ++i) {
+        EXPECT_EQ(i % 2 == 1, m.find(i) != m.end());
+    }
+}
+
+TEST(wali$RobinHoodHashMap$operator$assign, copiesAreIndependent)
+{
+    RobinHoodHashMap<Key, int> a;
+    a[1] = 10;
+    a[2] = 20;
+
+    RobinHoodHashMap<Key, int> b(a);
+    RobinHoodHashMap<Key, int> c;
+    c = a;
+    a.erase(1);
+    a.clear();
+
+    EXPECT_EQ(0u, a.size());
+    EXPECT_EQ(2u, b.size());
+    EXPECT_EQ(10, b[1]);
+    EXPECT_EQ(20, c[2]);
+}
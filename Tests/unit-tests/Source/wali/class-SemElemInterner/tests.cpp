@@ -0,0 +1,128 @@
+#include "gtest/gtest.h"
+
+#include "wali/SemElemInterner.hpp"
+#include "wali/SemElemPair.hpp"
+#include "wali/ShortestPathSemiring.hpp"
+#include "wali/Reach.hpp"
+#include "wali/wfa/WFA.hpp"
+#include "wali/wfa/TransFunctor.hpp"
+#include "wali/wpds/WPDS.hpp"
+
+#include <sstream>
+
+using namespace wali;
+
+TEST(wali$SemElem$isZero, agreesWithEqualZero)
+{
+    sem_elem_t weights[] = {
+        new ShortestPathSemiring(0),
+        new ShortestPathSemiring(5),
+        new ShortestPathSemiring((unsigned)-1),
+        new Reach(true),
+        new Reach(false),
+        new SemElemPair(new Reach(false), new ShortestPathSemiring((unsigned)-1)),
+        new SemElemPair(new Reach(false), new ShortestPathSemiring(0)),
+        new SemElemPair(new Reach(true), new ShortestPathSemiring(0)),
+    };
+
+    for (size_t i = 0; i < sizeof(weights) / sizeof(weights[0]); ++i) {
+        EXPECT_EQ(weights[i]->equal(weights[i]->zero()), weights[i]->isZero());
+        EXPECT_EQ(weights[i]->equal(weights[i]->one()), weights[i]->isOne());
+    }
+}
+
+
+TEST(wali$SemElemInterner$intern, equalWeightsAreTheSameObject)
+{
+    SemElemInterner interner(new ShortestPathSemiring(0));
+
+    sem_elem_t a = interner.intern(new ShortestPathSemiring(3));
+    sem_elem_t b = interner.intern(new ShortestPathSemiring(3));
+    sem_elem_t c = interner.intern(new ShortestPathSemiring(4));
+
+    EXPECT_EQ(a.get_ptr(), b.get_ptr());
+    EXPECT_NE(a.get_ptr(), c.get_ptr());
+    EXPECT_TRUE(a->equal(b));
+    EXPECT_EQ(2u, interner.size());
+    EXPECT_EQ(1u, interner.getStats().hits);
+    EXPECT_EQ(2u, interner.getStats().misses);
+}
+
+
+TEST(wali$SemElemInterner$intern, zeroAndOneAreCanonical)
+{
+    SemElemInterner interner(new ShortestPathSemiring(7));
+
+    EXPECT_EQ(interner.zero().get_ptr(),
+              interner.intern(new ShortestPathSemiring((unsigned)-1)).get_ptr());
+    EXPECT_EQ(interner.one().get_ptr(),
+              interner.intern(new ShortestPathSemiring(0)).get_ptr());
+    EXPECT_EQ(0u, interner.size());
+
+    interner.intern(new ShortestPathSemiring(2));
+    interner.clear();
+    EXPECT_EQ(0u, interner.size());
+    EXPECT_TRUE(interner.zero()->isZero());
+}
+
+
+namespace {
+    struct InternedWeights : wfa::ConstTransFunctor
+    {
+        SemElemInterner & interner;
+        size_t checked;
+        bool allInterned;
+
+        explicit InternedWeights(SemElemInterner & i)
+            : interner(i), checked(0), allInterned(true)
+        {}
+
+        virtual void operator()(wfa::ITrans const * t) {
+            ++checked;
+            if (interner.intern(t->weight()).get_ptr() != t->weight().get_ptr())
+                allInterned = false;
+        }
+    };
+}
+
+TEST(wali$wpds$WPDS$setInterner, saturationStoresInternedWeights)
+{
+    Key p = getKey("intern_p");
+    Key acc = getKey("intern_acc");
+    Key n[5];
+    for (int i = 0; i < 5; ++i) {
+        std::stringstream ss;
+        ss << "intern_n" << i;
+        n[i] = getKey(ss.str());
+    }
+
+    // Two paths from n0 to n3, so weights get combined; n1 calls n4
+    wpds::WPDS pds;
+    pds.add_rule(p, n[0], p, n[1], new ShortestPathSemiring(1));
+    pds.add_rule(p, n[0], p, n[2], new ShortestPathSemiring(3));
+    pds.add_rule(p, n[1], p, n[4], n[3], new ShortestPathSemiring(1));
+    pds.add_rule(p, n[2], p, n[3], new ShortestPathSemiring(1));
+    pds.add_rule(p, n[4], p, new ShortestPathSemiring(2));
+
+    sem_elem_t one = ShortestPathSemiring(0).one();
+    wfa::WFA query;
+    query.addState(p, one->zero());
+    query.addState(acc, one->zero());
+    query.setInitialState(p);
+    query.addFinalState(acc);
+    query.addTrans(p, n[0], acc, one);
+
+    wfa::WFA plain = pds.poststar(query);
+
+    SemElemInterner interner(one);
+    pds.setInterner(&interner);
+    wfa::WFA interned = pds.poststar(query);
+    pds.setInterner(NULL);
+
+    EXPECT_TRUE(plain.isIsomorphicTo(interned));
+    InternedWeights check(interner);
+    interned.for_each(check);
+    EXPECT_LT(0u, check.checked);
+    EXPECT_TRUE(check.allInterned);
+    EXPECT_LT(0u, interner.getStats().hits);
+}
@@ -0,0 +1,69 @@
+#include "gtest/gtest.h"
+
+#include "wali/Countable.hpp"
+#include "wali/ref_ptr.hpp"
+
+#include <thread>
+#include <vector>
+
+using namespace wali;
+
+namespace {
+    struct Tracked : AtomicCountable
+    {
+        static std::atomic<int> live;
+
+        Tracked() { ++live; }
+        Tracked(Tracked const & that) : AtomicCountable(that) { ++live; }
+        ~Tracked() { --live; }
+    };
+
+    std::atomic<int> Tracked::live(0);
+
+    void copyMany(ref_ptr<Tracked> shared, int times)
+    {
+        for (int i = 0; i < times; ++i) {
+            ref_ptr<Tracked> a = shared;
+            ref_ptr<Tracked> b(a);
+            b = shared;
+            a = NULL;
+        }
+    }
+}
+
+
+TEST(wali$ref_ptr$AtomicCount, incrementAndDecrementReturnNewValue)
+{
+    AtomicCount c;
+    EXPECT_EQ(0u, static_cast<unsigned>(c));
+    EXPECT_EQ(1u, ++c);
+    EXPECT_EQ(2u, ++c);
+    EXPECT_EQ(1u, --c);
+    EXPECT_EQ(0u, --c);
+}
+
+TEST(wali$ref_ptr$AtomicCountable, copyingDoesNotCopyCount)
+{
+    ref_ptr<Tracked> p = new Tracked();
+    ref_ptr<Tracked> q = p;
+    Tracked copy(*p);
+    EXPECT_EQ(2u, static_cast<unsigned>(p->count));
+    EXPECT_EQ(0u, static_cast<unsigned>(copy.count));
+}
+
+TEST(wali$ref_ptr$AtomicCountable, sharedBetweenThreadsIsDeletedOnce)
+{
+    {
+        ref_ptr<Tracked> shared = new Tracked();
+        std::vector<std::thread> threads;
+        for (int i = 0; i < 4; ++i) {
+            threads.push_back(std::thread(copyMany, shared, 100000));
+        }
+        for (size_t i = 0; i < threads.size(); ++i) {
+            threads[i].join();
+        }
+        EXPECT_EQ(1u, static_cast<unsigned>(shared->count));
+        EXPECT_EQ(1, Tracked::live.load());
+    }
+    EXPECT_EQ(0, Tracked::live.load());
+}
@@ -0,0 +1,125 @@
+#include "gtest/gtest.h"
+
+#include "wali/domains/MemoSemElem.hpp"
+#include "wali/ShortestPathSemiring.hpp"
+#include "wali/wpds/WPDS.hpp"
+#include "wali/wfa/WFA.hpp"
+#include "wali/wfa/Trans.hpp"
+
+#include <sstream>
+
+using namespace wali;
+using namespace wali::domains;
+
+namespace {
+    sem_elem_t dist(unsigned d)
+    {
+        return new ShortestPathSemiring(d);
+    }
+
+    Key node(int n)
+    {
+        std::stringstream ss;
+        ss << "memo_n" << n;
+        return getKey(ss.str());
+    }
+
+    struct CollectTrans : wfa::ConstTransFunctor
+    {
+        std::vector<wfa::ITrans const *> trans;
+
+        virtual void operator()(wfa::ITrans const * t) {
+            trans.push_back(t);
+        }
+    };
+
+    /// A loop with two exits, a call, and a diamond
+    wfa::WFA
+    solve(sem_elem_t (*weight)(unsigned))
+    {
+        Key p = getKey("memo_p");
+        Key accept = getKey("memo_accept");
+
+        wpds::WPDS pds;
+        pds.add_rule(p, node(0), p, node(1), weight(1));
+        pds.add_rule(p, node(1), p, node(2), weight(2));
+        pds.add_rule(p, node(2), p, node(1), weight(1));
+        pds.add_rule(p, node(2), p, node(3), weight(5));
+        pds.add_rule(p, node(1), p, node(10), node(3), weight(3));
+        pds.add_rule(p, node(10), p, node(11), weight(1));
+        pds.add_rule(p, node(10), p, node(12), weight(4));
+        pds.add_rule(p, node(11), p, node(13), weight(2));
+        pds.add_rule(p, node(12), p, node(13), weight(0));
+        pds.add_rule(p, node(13), p, weight(1));
+
+        wfa::WFA query;
+        query.addState(p, weight(0)->zero());
+        query.addState(accept, weight(0)->zero());
+        query.setInitialState(p);
+        query.addFinalState(accept);
+        query.addTrans(p, node(0), accept, weight(0));
+        return pds.poststar(query);
+    }
+
+    MemoSemElem::cache_t theCache;
+
+    sem_elem_t memoDist(unsigned d)
+    {
+        return wrapToMemoSemElem(dist(d), theCache);
+    }
+}
+
+
+TEST(wali$domains$OperationCache$extend, repeatedOperandsHit)
+{
+    OperationCache cache(16);
+    sem_elem_t a = dist(2), b = dist(3);
+
+    sem_elem_t first = cache.extend(a, b);
+    sem_elem_t second = cache.extend(a, b);
+    EXPECT_EQ(first.get_ptr(), second.get_ptr());
+    EXPECT_TRUE(first->equal(dist(5)));
+    EXPECT_TRUE(cache.combine(a, b)->equal(dist(2)));
+
+    EXPECT_EQ(1u, cache.getStats().hits);
+    EXPECT_EQ(2u, cache.getStats().misses);
+
+    // Equal operands that are different objects only hit by value
+    cache.extend(dist(2), b);
+    EXPECT_EQ(1u, cache.getStats().hits);
+
+    OperationCache byValue(16, OperationCache::ByValue);
+    byValue.extend(a, b);
+    byValue.extend(dist(2), dist(3));
+    EXPECT_EQ(1u, byValue.getStats().hits);
+
+    cache.clear();
+    cache.extend(a, b);
+    EXPECT_EQ(0u, cache.getStats().hits);
+}
+
+
+TEST(wali$domains$MemoSemElem$poststar, sameAnswersAsBackingDomain)
+{
+    theCache.reset(new OperationCache(256));
+
+    wfa::WFA expected = solve(&dist);
+    wfa::WFA answer = solve(&memoDist);
+
+    ASSERT_EQ(expected.numTransitions(), answer.numTransitions());
+
+    CollectTrans all;
+    expected.for_each(all);
+    for (size_t i = 0; i < all.trans.size(); ++i) {
+        wfa::ITrans const * t = all.trans[i];
+        wfa::Trans found;
+        ASSERT_TRUE(answer.find(t->from(), t->stack(), t->to(), found));
+
+        MemoSemElem * memo = dynamic_cast<MemoSemElem*>(found.weight().get_ptr());
+        ASSERT_TRUE(memo != NULL);
+        EXPECT_TRUE(t->weight()->equal(memo->backingSemElem()));
+    }
+
+    EXPECT_LT(0u, theCache->getStats().misses);
+    theCache.reset();
+}
@@ -0,0 +1,64 @@
+#include "gtest/gtest.h"
+
+#include "wali/graph/IntraGraph.hpp"
+#include "wali/graph/NewtonSolver.hpp"
+#include "wali/graph/RegExp.hpp"
+#include "wali/ShortestPathSemiring.hpp"
+
+using namespace wali;
+using namespace wali::graph;
+
+namespace {
+    sem_elem_t dist(unsigned d)
+    {
+        return new ShortestPathSemiring(d);
+    }
+
+    /// Solves a graph with two cycles:
+    ///
+    ///   source -0-> a -3-> b <-1-> c -2-> d -1-> a,   a -7-> c
+    ///
+    /// and checks the shortest distances from a.
+    void solveWith(NewtonSolver & solver)
+    {
+        RegExpDag dag;
+        dag.startSatProcess(dist(0));
+        IntraGraph gr(&dag, false, dist(0));
+        int a = gr.makeNode(), b = gr.makeNode(), c = gr.makeNode(), d = gr.makeNode();
+        gr.setSource(a, dist(0));
+        gr.addEdge(a, b, dist(3));
+        gr.addEdge(a, c, dist(7));
+        gr.addEdge(b, c, dist(1));
+        gr.addEdge(c, b, dist(1));
+        gr.addEdge(c, d, dist(2));
+        gr.addEdge(d, a, dist(1));
+
+        NewtonStats stats;
+        gr.saturate(solver, stats);
+        dag.stopSatProcess();
+
+        EXPECT_TRUE(gr.getWeight(a)->equal(dist(0)));
+        EXPECT_TRUE(gr.getWeight(b)->equal(dist(3)));
+        EXPECT_TRUE(gr.getWeight(c)->equal(dist(4)));
+        EXPECT_TRUE(gr.getWeight(d)->equal(dist(6)));
+
+        // No mutable edges, so one round solves the system
+        EXPECT_EQ(1u, stats.systems);
+        EXPECT_EQ(1u, stats.rounds);
+        EXPECT_EQ(1u, stats.maxRounds);
+        EXPECT_EQ(1u, stats.roundSeconds.size());
+    }
+}
+
+
+TEST(wali$graph$NewtonSolver$RegExpNewtonSolver, solvesLinearSystem)
+{
+    RegExpNewtonSolver solver;
+    solveWith(solver);
+}
+
+TEST(wali$graph$NewtonSolver$IterativeNewtonSolver, solvesLinearSystem)
+{
+    IterativeNewtonSolver solver;
+    solveWith(solver);
+}
@@ -0,0 +1,64 @@
+#include "gtest/gtest.h"
+
+#include "wali/graph/RegExp.hpp"
+#include "wali/ShortestPathSemiring.hpp"
+
+#include <sstream>
+#include <string>
+
+using namespace wali;
+using namespace wali::graph;
+
+namespace {
+    sem_elem_t dist(unsigned d)
+    {
+        return new ShortestPathSemiring(d);
+    }
+
+    size_t count(std::string const & haystack, std::string const & needle)
+    {
+        size_t n = 0;
+        for (size_t pos = haystack.find(needle); pos != std::string::npos; pos = haystack.find(needle, pos + 1)) {
+            ++n;
+        }
+        return n;
+    }
+}
+
+
+TEST(wali$graph$RegExpDag$extend, sharedChildrenAreEvaluatedForEveryParent)
+{
+    RegExpDag dag;
+    dag.startSatProcess(dist(0));
+    reg_exp_t u0 = dag.updatable(0, dist(3));
+    reg_exp_t u1 = dag.updatable(1, dist(4));
+    reg_exp_t path = dag.extend(u0, dag.constant(dist(2)));
+    reg_exp_t either = dag.combine(path, u1);
+    reg_exp_t both = dag.extend(u0, u1);
+    reg_exp_t loop = dag.star(both);
+    dag.update(0, dist(1));
+
+    EXPECT_TRUE(either->get_weight()->equal(dist(3)));
+    EXPECT_TRUE(both->get_weight()->equal(dist(5)));
+    EXPECT_TRUE(loop->get_weight()->equal(dist(0)));
+    dag.stopSatProcess();
+}
+
+TEST(wali$graph$RegExpDag$compress, longChainsBecomeOneNode)
+{
+    RegExpDag dag;
+    dag.startSatProcess(dist(0));
+    reg_exp_t chain = dag.updatable(0, dist(1));
+    for (int i = 1; i < 6; ++i) {
+        chain = dag.extend(chain, dag.updatable(i, dist(i + 1)));
+    }
+    EXPECT_TRUE(chain->get_weight()->equal(dist(21)));
+
+    reg_exp_cache_t cache;
+    reg_exp_t flat = dag.compress(chain, cache);
+    std::stringstream ss;
+    flat->print(ss);
+    EXPECT_EQ(5u, count(ss.str(), " x ("));
+    EXPECT_TRUE(flat->get_weight()->equal(dist(21)));
+    dag.stopSatProcess();
+}
@@ -0,0 +1,84 @@
+#include "gtest/gtest.h"
+
+#include "wali/util/Arena.hpp"
+#include "wali/wfa/WFA.hpp"
+#include "wali/wfa/Trans.hpp"
+#include "wali/ShortestPathSemiring.hpp"
+
+using namespace wali;
+using wali::util::Arena;
+using wali::util::ArenaHandle;
+
+namespace {
+    struct Node : util::ArenaAllocated
+    {
+        static int live;
+        long payload[5];
+
+        Node() { ++live; }
+        ~Node() { --live; }
+    };
+
+    int Node::live = 0;
+}
+
+
+TEST(wali$util$Arena$allocate, freedBlocksAreReused)
+{
+    ArenaHandle arena;
+    Node * a = new (arena.get()) Node();
+    delete a;
+    Node * b = new (arena.get()) Node();
+    EXPECT_EQ(a, b);
+    EXPECT_EQ(2u, arena->numAllocations());
+    EXPECT_EQ(1u, arena->numLive());
+    delete b;
+    EXPECT_EQ(0u, arena->numLive());
+    EXPECT_EQ(0u, arena->bytesLive());
+}
+
+TEST(wali$util$Arena$reset, releasesChunksOnlyOnceEverythingIsFreed)
+{
+    ArenaHandle arena;
+    Node * kept = new (arena.get()) Node();
+    for (int i = 0; i < 5000; ++i) {
+        delete new (arena.get()) Node();
+    }
+    arena->reset();
+    EXPECT_LT(0u, arena->bytesReserved());
+
+    delete kept;
+    arena->reset();
+    EXPECT_EQ(0u, arena->bytesReserved());
+    EXPECT_EQ(0, Node::live);
+}
+
+TEST(wali$util$Arena$detach, objectsMayOutliveTheirOwner)
+{
+    Node * escaped;
+    Node * heap = new Node();
+    {
+        ArenaHandle arena;
+        escaped = new (arena.get()) Node();
+    }
+    EXPECT_EQ(2, Node::live);
+    delete escaped;
+    delete heap;
+    EXPECT_EQ(0, Node::live);
+}
+
+TEST(wali$wfa$WFA$clear, releasesTheTransArena)
+{
+    sem_elem_t one = new ShortestPathSemiring(0);
+    wfa::WFA fa;
+    Key p = getKey("arena_p"), q = getKey("arena_q");
+    fa.addState(p, one->zero());
+    fa.addState(q, one->zero());
+    fa.addTrans(p, getKey("arena_a"), q, one);
+    fa.addTrans(p, getKey("arena_b"), q, one);
+
+    EXPECT_EQ(2u, fa.getTransArena()->numLive());
+    fa.clear();
+    EXPECT_EQ(0u, fa.getTransArena()->numLive());
+    EXPECT_EQ(0u, fa.getTransArena()->bytesReserved());
+}
@@ -0,0 +1,100 @@
+#include "gtest/gtest.h"
+
+#include "wali/wfa/Trans.hpp"
+#include "wali/wfa/TransSet.hpp"
+#include "wali/ShortestPathSemiring.hpp"
+
+#include <vector>
+
+using namespace wali;
+using namespace wali::wfa;
+
+namespace {
+    struct Transitions
+    {
+        sem_elem_t one;
+        std::vector<ITrans*> all;
+
+        Transitions() : one(new ShortestPathSemiring(0)) {}
+
+        ~Transitions() {
+            for (size_t i = 0; i < all.size(); ++i) {
+                delete all[i];
+            }
+        }
+
+        ITrans * make(int to) {
+            all.push_back(new Trans(getKey("ts_p"), getKey("ts_a"), getKey(to), one));
+            return all.back();
+        }
+    };
+}
+
+
+TEST(wali$wfa$TransSet$insert, loopSeesTransitionsAddedWhileIterating)
+{
+    Transitions ts;
+    TransSet set;
+    set.insert(ts.make(0));
+
+    int visited = 0;
+    for (TransSet::iterator it = set.begin(); it != set.end(); ++it) {
+        ++visited;
+        if (set.size() < 20) {
+            set.insert(ts.make(static_cast<int>(set.size())));
+        }
+    }
+    EXPECT_EQ(20, visited);
+    EXPECT_EQ(20u, set.size());
+}
+
+TEST(wali$wfa$TransSet$erase, erasingBehindTheIteratorKeepsItValid)
+{
+    Transitions ts;
+    TransSet set;
+    for (int i = 0; i < 12; ++i) {
+        set.insert(ts.make(i));
+    }
+
+    TransSet::iterator it = set.begin();
+    TransSet::iterator itEND = set.end();
+    int visited = 0;
+    while (it != itEND) {
+        TransSet::iterator eraseIt = it;
+        ++it;
+        ++visited;
+        if (visited % 3 != 0) {
+            set.erase(eraseIt);
+        }
+    }
+    EXPECT_EQ(12, visited);
+    EXPECT_EQ(4u, set.size());
+    EXPECT_TRUE(set.find(getKey("ts_p"), getKey("ts_a"), getKey(2)) != set.end());
+    EXPECT_TRUE(set.find(getKey("ts_p"), getKey("ts_a"), getKey(3)) == set.end());
+}
+
+TEST(wali$wfa$TransSet$find, largeSetsSurviveHolesAndCopies)
+{
+    Transitions ts;
+    TransSet set;
+    for (int i = 0; i < 128; ++i) {
+        set.insert(ts.make(i));
+    }
+    for (int i = 0; i < 128; ++i) {
+        if (i % 4 != 0) {
+            EXPECT_TRUE(set.erase(getKey("ts_p"), getKey("ts_a"), getKey(i)) != NULL);
+        }
+    }
+    // The set is full and mostly holes, so this squeezes them out.
+    for (int i = 128; i < 160; ++i) {
+        set.insert(ts.make(i));
+    }
+
+    TransSet copy(set);
+    EXPECT_EQ(64u, copy.size());
+    for (int i = 0; i < 160; ++i) {
+        bool present = (i >= 128 || i % 4 == 0);
+        EXPECT_EQ(present, set.find(getKey("ts_p"), getKey("ts_a"), getKey(i)) != set.end());
+        EXPECT_EQ(present, copy.find(getKey("ts_p"), getKey("ts_a"), getKey(i)) != copy.end());
+    }
+}
@@ -0,0 +1,72 @@
+#include "gtest/gtest.h"
+
+#include "wali/ShortestPathSemiring.hpp"
+#include "wali/wpds/fwpds/FWPDS.hpp"
+#include "wali/wfa/WFA.hpp"
+
+#include "fixtures/SmallProgram.hpp"
+
+using namespace wali;
+using namespace wali::wpds;
+using namespace wali::wpds::fwpds;
+using namespace wali::wfa;
+
+namespace {
+    testing::SmallProgram const prog("fpar");
+
+    /// Procedure 0 calls procedures 1 to 'workers' one after another.
+    /// Each of those is recursive and calls procedure workers + 1, a
+    /// leaf, so the workers are independent SCCs between procedure 0
+    /// and the leaf. Every procedure has six nodes.
+    void buildProgram(FWPDS & pds, int workers)
+    {
+        int leaf = workers + 1;
+        for (int n = 0; n < 5; ++n) {
+            if (n < workers) {
+                prog.call(pds, 0, n, n + 1, n + 1, 1);
+            }
+            else {
+                prog.step(pds, 0, n, n + 1, 1);
+            }
+        }
+        prog.ret(pds, 0, 5, 1);
+
+        for (int proc = 1; proc <= workers; ++proc) {
+            for (int n = 0; n < 5; ++n) {
+                if (n == 1) {
+                    prog.call(pds, proc, n, proc, n + 1, proc);
+                }
+                else if (n == 3) {
+                    prog.call(pds, proc, n, leaf, n + 1, 1);
+                }
+                else {
+                    prog.step(pds, proc, n, n + 1, n + proc);
+                }
+            }
+            // skip the recursive call, and return
+            prog.step(pds, proc, 0, 2, 2 * proc);
+            prog.ret(pds, proc, 5, 1);
+        }
+
+        prog.chain(pds, leaf, 5);
+    }
+}
+
+
+TEST(wali$wpds$fwpds$FWPDS$setParallelism, independentProceduresGiveSameAnswers)
+{
+    FWPDS pds;
+    buildProgram(pds, 4);
+    WFA post_query = prog.query(prog.node(0, 0));
+    WFA pre_query = prog.query(prog.node(0, 5));
+
+    ASSERT_TRUE(pds.setParallelism(1));
+    WFA seq_post = pds.poststar(post_query);
+    WFA seq_pre = pds.prestar(pre_query);
+
+    ASSERT_TRUE(pds.setParallelism(4));
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_TRUE(seq_post.isIsomorphicTo(pds.poststar(post_query)));
+        EXPECT_TRUE(seq_pre.isIsomorphicTo(pds.prestar(pre_query)));
+    }
+}
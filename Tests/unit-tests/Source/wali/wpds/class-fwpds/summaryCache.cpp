@@ -0,0 +1,241 @@
+#include "gtest/gtest.h"
+
+#include "wali/ShortestPathSemiring.hpp"
+#include "wali/wpds/fwpds/FWPDS.hpp"
+#include "wali/wpds/fwpds/FwpdsSummaryCache.hpp"
+#include "wali/wfa/WFA.hpp"
+
+#include "fixtures/SmallProgram.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#include <stdint.h>
+
+using namespace wali;
+using namespace wali::wpds;
+using namespace wali::wpds::fwpds;
+using namespace wali::wfa;
+
+namespace {
+    testing::SmallProgram const prog("fsum");
+
+    /// Procedure 0 calls 1 and 2; procedure 1 is recursive and calls
+    /// 2; procedure 2 is a leaf. Every procedure has four nodes.
+    void buildProgram(FWPDS & pds)
+    {
+        prog.call(pds, 0, 0, 1, 1, 1);
+        prog.call(pds, 0, 1, 2, 2, 2);
+        prog.step(pds, 0, 2, 3, 1);
+        prog.ret(pds, 0, 3, 0);
+
+        prog.step(pds, 1, 0, 1, 3);
+        prog.step(pds, 1, 0, 3, 7);
+        prog.call(pds, 1, 1, 1, 2, 1);
+        prog.call(pds, 1, 2, 2, 3, 2);
+        prog.ret(pds, 1, 3, 1);
+
+        prog.step(pds, 2, 0, 1, 4);
+        prog.step(pds, 2, 1, 2, 1);
+        prog.step(pds, 2, 2, 3, 1);
+        prog.ret(pds, 2, 3, 2);
+    }
+}
+
+
+TEST(wali$wpds$fwpds$FwpdsSummaryCache$poststar, sameAnswersAsFwpds)
+{
+    FWPDS pds;
+    buildProgram(pds);
+    FwpdsSummaryCache cache(pds);
+
+    WFA queries[] = {
+        prog.query(prog.node(0, 0)),
+        prog.query(prog.node(1, 1), prog.node(0, 1)),
+        prog.query(prog.node(2, 0), prog.node(1, 3)),
+        prog.query(prog.node(0, 0)),
+    };
+
+    for (size_t i = 0; i < sizeof(queries) / sizeof(queries[0]); ++i) {
+        WFA expected = pds.poststar(queries[i]);
+        EXPECT_TRUE(expected.isIsomorphicTo(cache.poststar(queries[i])));
+    }
+
+    EXPECT_EQ(1u, cache.getStats().builds);
+    EXPECT_EQ(4u, cache.getStats().queries);
+    EXPECT_LT(0u, cache.getStats().reused);
+}
+
+
+TEST(wali$wpds$fwpds$FwpdsSummaryCache$prestar, sameAnswersAsFwpds)
+{
+    FWPDS pds;
+    buildProgram(pds);
+    FwpdsSummaryCache cache(pds);
+
+    WFA queries[] = {
+        prog.query(prog.node(0, 3)),
+        prog.query(prog.node(2, 2), prog.node(1, 3)),
+        prog.query(prog.node(1, 2), prog.node(0, 1)),
+    };
+
+    for (size_t i = 0; i < sizeof(queries) / sizeof(queries[0]); ++i) {
+        WFA expected = pds.prestar(queries[i]);
+        EXPECT_TRUE(expected.isIsomorphicTo(cache.prestar(queries[i])));
+    }
+
+    EXPECT_EQ(1u, cache.getStats().builds);
+    EXPECT_EQ(3u, cache.getStats().queries);
+}
+
+
+TEST(wali$wpds$fwpds$FwpdsSummaryCache$poststar, rebuildsAfterRulesChange)
+{
+    FWPDS pds;
+    buildProgram(pds);
+    FwpdsSummaryCache cache(pds);
+    WFA q = prog.query(prog.node(0, 0));
+
+    cache.poststar(q);
+    // A shortcut through procedure 2
+    prog.step(pds, 2, 0, 3, 1);
+
+    WFA expected = pds.poststar(q);
+    EXPECT_TRUE(expected.isIsomorphicTo(cache.poststar(q)));
+    EXPECT_EQ(2u, cache.getStats().builds);
+}
+
+
+TEST(wali$wpds$fwpds$FwpdsSummaryCache$load, answersFromSavedSummaries)
+{
+    std::string path = "fwpds-summaries.bin";
+    {
+        FWPDS pds;
+        buildProgram(pds);
+        FwpdsSummaryCache cache(pds);
+        ASSERT_TRUE(cache.save(path));
+    }
+
+    // A new process with the same rules
+    FWPDS pds;
+    buildProgram(pds);
+    FwpdsSummaryCache cache(pds);
+    ASSERT_TRUE(cache.load(path));
+
+    WFA post_query = prog.query(prog.node(1, 1), prog.node(0, 1));
+    WFA pre_query = prog.query(prog.node(2, 2), prog.node(1, 3));
+    EXPECT_TRUE(pds.poststar(post_query).isIsomorphicTo(cache.poststar(post_query)));
+    EXPECT_TRUE(pds.prestar(pre_query).isIsomorphicTo(cache.prestar(pre_query)));
+    EXPECT_EQ(0u, cache.getStats().builds);
+
+    // Different rules
+    FWPDS other;
+    buildProgram(other);
+    prog.step(other, 2, 0, 3, 1);
+    FwpdsSummaryCache stale(other);
+    EXPECT_FALSE(stale.load(path));
+
+    std::remove(path.c_str());
+}
+
+namespace {
+    std::string readFile(std::string const & path)
+    {
+        std::ifstream f(path.c_str(), std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+    }
+
+    /// Writes bytes to path with the uint64 or uint32 at 'at' replaced by v
+    template<typename T>
+    void writePatched(std::string bytes, size_t at, T v, std::string const & path)
+    {
+        std::memcpy(&bytes[at], &v, sizeof(v));
+        std::ofstream f(path.c_str(), std::ios::binary | std::ios::trunc);
+        f.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    }
+
+    uint64_t readU64(std::string const & bytes, size_t at)
+    {
+        uint64_t v;
+        std::memcpy(&v, bytes.data() + at, sizeof(v));
+        return v;
+    }
+}
+
+TEST(wali$wpds$fwpds$FwpdsSummaryCache$load, rejectsDamagedFiles)
+{
+    std::string path = "fwpds-summaries-good.bin";
+    std::string bad = "fwpds-summaries-bad.bin";
+    FWPDS pds;
+    buildProgram(pds);
+    {
+        FwpdsSummaryCache cache(pds);
+        ASSERT_TRUE(cache.save(path));
+    }
+    std::string bytes = readFile(path);
+
+    // Offsets in the header: weightsAt and weightsSize are at 96 and
+    // 104, and transAt at 72
+    size_t const WEIGHTS_AT = 96, WEIGHTS_SIZE = 104, TRANS_AT = 72;
+    uint64_t weightsSize = readU64(bytes, WEIGHTS_SIZE);
+
+    FwpdsSummaryCache cache(pds);
+
+    // weightsAt + weightsSize wraps around to 1
+    writePatched(bytes, WEIGHTS_AT, ~uint64_t(0) - weightsSize + 2, bad);
+    EXPECT_FALSE(cache.load(bad));
+
+    // The trans table ends past the file
+    writePatched(bytes, TRANS_AT, uint64_t(bytes.size()), bad);
+    EXPECT_FALSE(cache.load(bad));
+
+    // The cache is as it was, and still loads a good file
+    EXPECT_EQ(0u, cache.getStats().builds);
+    EXPECT_TRUE(cache.load(path));
+    WFA post_query = prog.query(prog.node(1, 1), prog.node(0, 1));
+    EXPECT_TRUE(pds.poststar(post_query).isIsomorphicTo(cache.poststar(post_query)));
+
+    std::remove(path.c_str());
+    std::remove(bad.c_str());
+}
+
+
+TEST(wali$wpds$fwpds$FwpdsSummaryCache$load, badWeightsAreComputedAgain)
+{
+    std::string path = "fwpds-summaries-good.bin";
+    std::string bad = "fwpds-summaries-bad.bin";
+    FWPDS pds;
+    buildProgram(pds);
+    {
+        FwpdsSummaryCache cache(pds);
+        ASSERT_TRUE(cache.save(path));
+    }
+    std::string bytes = readFile(path);
+
+    // Every TransRecord (40 bytes, from transAt at 72) gets a one-byte
+    // weight (its weightSize is at 32), which does not deserialize
+    size_t const NUM_TRANS = 64, TRANS_AT = 72, TRANS_RECORD = 40, WEIGHT_SIZE = 32;
+    uint64_t numTrans = readU64(bytes, NUM_TRANS);
+    uint64_t transAt = readU64(bytes, TRANS_AT);
+    uint32_t one = 1;
+    for (uint64_t i = 0; i < numTrans; ++i)
+        std::memcpy(&bytes[transAt + i * TRANS_RECORD + WEIGHT_SIZE], &one, sizeof(one));
+    writePatched(bytes, WEIGHT_SIZE + transAt, one, bad);
+
+    // Only the layout is checked at load; the bad weights are found by
+    // the first query, which then computes the summaries
+    FwpdsSummaryCache cache(pds);
+    EXPECT_TRUE(cache.load(bad));
+    EXPECT_EQ(0u, cache.getStats().builds);
+
+    WFA post_query = prog.query(prog.node(1, 1), prog.node(0, 1));
+    EXPECT_TRUE(pds.poststar(post_query).isIsomorphicTo(cache.poststar(post_query)));
+    EXPECT_EQ(1u, cache.getStats().builds);
+    WFA pre_query = prog.query(prog.node(2, 2), prog.node(1, 3));
+    EXPECT_TRUE(pds.prestar(pre_query).isIsomorphicTo(cache.prestar(pre_query)));
+
+    std::remove(path.c_str());
+    std::remove(bad.c_str());
+}
@@ -0,0 +1,193 @@
+#include "gtest/gtest.h"
+
+#include "wali/ShortestPathSemiring.hpp"
+#include "wali/wpds/fwpds/SWPDS.hpp"
+#include "wali/wfa/WFA.hpp"
+
+#include "fixtures/SmallProgram.hpp"
+
+using namespace wali;
+using namespace wali::wpds;
+using namespace wali::wpds::fwpds;
+using namespace wali::wfa;
+
+namespace {
+    testing::SmallProgram const prog("swpds");
+
+    /// Procedure 0 (the entry point) calls 1 and 2; procedure 1 calls
+    /// 2; procedure 2 is a leaf. Procedure 3 is never called.
+    void buildProgram(SWPDS & pds)
+    {
+        prog.call(pds, 0, 0, 1, 1, 1);
+        prog.call(pds, 0, 1, 2, 2, 2);
+        prog.ret(pds, 0, 2, 0);
+
+        prog.step(pds, 1, 0, 1, 3);
+        prog.step(pds, 1, 0, 2, 7);
+        prog.call(pds, 1, 1, 2, 2, 1);
+        prog.ret(pds, 1, 2, 1);
+
+        prog.step(pds, 2, 0, 1, 4);
+        prog.step(pds, 2, 1, 2, 1);
+        prog.ret(pds, 2, 2, 2);
+
+        prog.step(pds, 3, 0, 1, 1);
+        prog.ret(pds, 3, 1, 1);
+
+        pds.addEntryPoint(prog.node(0, 0));
+    }
+}
+
+
+TEST(wali$wpds$fwpds$SWPDS$update, absorbsChangesToUnreachableCode)
+{
+    SWPDS pds;
+    buildProgram(pds);
+    pds.preprocess();
+
+    prog.step(pds, 3, 1, 2, 5);
+    prog.call(pds, 3, 0, 2, 1, 1);
+    EXPECT_FALSE(pds.update());
+
+    SWPDS fresh;
+    buildProgram(fresh);
+    prog.step(fresh, 3, 1, 2, 5);
+    prog.call(fresh, 3, 0, 2, 1, 1);
+    fresh.preprocess();
+
+    WFA post = prog.query(prog.node(0, 0));
+    WFA pre = prog.query(prog.node(2, 2));
+    EXPECT_TRUE(fresh.poststar(post).isIsomorphicTo(pds.poststar(post)));
+    EXPECT_TRUE(fresh.prestar(pre).isIsomorphicTo(pds.prestar(pre)));
+
+    EXPECT_EQ(2u, pds.getUpdateStats().changes);
+    EXPECT_EQ(2u, pds.getUpdateStats().absorbed);
+    EXPECT_EQ(0u, pds.getUpdateStats().resolves);
+}
+
+
+TEST(wali$wpds$fwpds$SWPDS$update, resolvesOnceForReachableChanges)
+{
+    SWPDS pds;
+    buildProgram(pds);
+    pds.preprocess();
+
+    // A shortcut through procedure 2, and procedure 1 no longer calls it
+    prog.step(pds, 2, 0, 2, 1);
+    EXPECT_TRUE(pds.erase_rule(prog.p(), prog.node(1, 1), prog.p(), prog.node(2, 0), prog.node(1, 2)));
+    prog.step(pds, 1, 1, 2, 2);
+
+    SWPDS fresh;
+    buildProgram(fresh);
+    prog.step(fresh, 2, 0, 2, 1);
+    fresh.erase_rule(prog.p(), prog.node(1, 1), prog.p(), prog.node(2, 0), prog.node(1, 2));
+    prog.step(fresh, 1, 1, 2, 2);
+    fresh.preprocess();
+
+    WFA post = prog.query(prog.node(0, 0));
+    WFA pre = prog.query(prog.node(2, 2));
+    EXPECT_TRUE(fresh.poststar(post).isIsomorphicTo(pds.poststar(post)));
+    EXPECT_TRUE(fresh.prestar(pre).isIsomorphicTo(pds.prestar(pre)));
+
+    EXPECT_EQ(3u, pds.getUpdateStats().changes);
+    EXPECT_EQ(0u, pds.getUpdateStats().absorbed);
+    EXPECT_EQ(1u, pds.getUpdateStats().resolves);
+    EXPECT_FALSE(pds.update());
+}
+
+
+TEST(wali$wpds$fwpds$SWPDS$update, entryPoints)
+{
+    SWPDS pds;
+    buildProgram(pds);
+    pds.preprocess();
+    EXPECT_FALSE(pds.reachable(prog.node(3, 1)));
+
+    pds.addEntryPoint(prog.node(3, 0));
+    EXPECT_TRUE(pds.reachable(prog.node(3, 1)));
+
+    pds.removeEntryPoint(prog.node(3, 0));
+    EXPECT_FALSE(pds.reachable(prog.node(3, 1)));
+
+    // Still the target of a push rule
+    pds.addEntryPoint(prog.node(2, 0));
+    pds.removeEntryPoint(prog.node(2, 0));
+    EXPECT_TRUE(pds.reachable(prog.node(2, 1)));
+
+    EXPECT_EQ(4u, pds.getUpdateStats().changes);
+    EXPECT_EQ(1u, pds.getUpdateStats().absorbed);
+    EXPECT_EQ(3u, pds.getUpdateStats().resolves);
+}
+
+
+namespace {
+    void expectSameAnswers(SWPDS & fresh, SWPDS & pds)
+    {
+        WFA post = prog.query(prog.node(0, 0));
+        WFA pre = prog.query(prog.node(2, 2));
+        EXPECT_TRUE(fresh.poststar(post).isIsomorphicTo(pds.poststar(post)));
+        EXPECT_TRUE(fresh.prestar(pre).isIsomorphicTo(pds.prestar(pre)));
+    }
+}
+
+
+TEST(wali$wpds$fwpds$SWPDS$update, solvesOnlyTheChangedProcedure)
+{
+    SWPDS pds;
+    buildProgram(pds);
+    pds.preprocess();
+
+    // Procedure 0 has no callers
+    prog.step(pds, 0, 0, 2, 9);
+    EXPECT_TRUE(pds.update());
+
+    SWPDS fresh;
+    buildProgram(fresh);
+    prog.step(fresh, 0, 0, 2, 9);
+    fresh.preprocess();
+    expectSameAnswers(fresh, pds);
+
+    EXPECT_EQ(1u, pds.getUpdateStats().resolves);
+    EXPECT_EQ(1u, pds.getUpdateStats().procedures);
+}
+
+
+TEST(wali$wpds$fwpds$SWPDS$update, solvesCallersOfChangedSummaries)
+{
+    SWPDS pds;
+    buildProgram(pds);
+    pds.preprocess();
+
+    // A shortcut through procedure 2 changes its summary from 7 to 3,
+    // so procedures 1 and 0 are solved again too
+    prog.step(pds, 2, 0, 2, 1);
+    EXPECT_TRUE(pds.update());
+
+    SWPDS fresh;
+    buildProgram(fresh);
+    prog.step(fresh, 2, 0, 2, 1);
+    fresh.preprocess();
+    expectSameAnswers(fresh, pds);
+
+    EXPECT_EQ(3u, pds.getUpdateStats().procedures);
+}
+
+
+TEST(wali$wpds$fwpds$SWPDS$update, keepsCallersOfUnchangedSummaries)
+{
+    SWPDS pds;
+    buildProgram(pds);
+    pds.preprocess();
+
+    // A longer path through procedure 2 leaves its summary at 7
+    prog.step(pds, 2, 0, 2, 9);
+    EXPECT_TRUE(pds.update());
+
+    SWPDS fresh;
+    buildProgram(fresh);
+    prog.step(fresh, 2, 0, 2, 9);
+    fresh.preprocess();
+    expectSameAnswers(fresh, pds);
+
+    EXPECT_EQ(1u, pds.getUpdateStats().procedures);
+}
@@ -0,0 +1,124 @@
+#include "gtest/gtest.h"
+
+#include "wali/ShortestPathSemiring.hpp"
+#include "wali/wpds/WPDS.hpp"
+#include "wali/wpds/ewpds/EWPDS.hpp"
+#include "wali/wpds/fwpds/FWPDS.hpp"
+#include "wali/wfa/WFA.hpp"
+
+#include "fixtures/SmallProgram.hpp"
+
+#include <vector>
+
+using namespace wali;
+using namespace wali::wpds;
+using namespace wali::wfa;
+
+namespace {
+    testing::SmallProgram const prog("bat");
+
+    /// A small linear congruential generator, so every run sees the
+    /// same programs
+    class Lcg
+    {
+    public:
+        explicit Lcg(unsigned seed) : state(seed) {}
+
+        /// A number in [0, n)
+        int below(int n)
+        {
+            state = state * 1103515245u + 12345u;
+            return static_cast<int>((state >> 16) % static_cast<unsigned>(n));
+        }
+
+    private:
+        unsigned state;
+    };
+
+    /// Procedure proc has nodes 0 to last[proc]. Every node but the last
+    /// steps or calls a random procedure, recursion included, and some
+    /// also branch to a random node; the last node returns.
+    void buildProgram(WPDS & pds, Lcg & rng, std::vector<int> & last)
+    {
+        int procs = 2 + rng.below(3);
+        last.clear();
+        for (int proc = 0; proc < procs; ++proc) {
+            last.push_back(2 + rng.below(4));
+        }
+        for (int proc = 0; proc < procs; ++proc) {
+            for (int n = 0; n < last[proc]; ++n) {
+                if (rng.below(3) == 0) {
+                    prog.call(pds, proc, n, rng.below(procs), n + 1, 1 + rng.below(5));
+                }
+                else {
+                    prog.step(pds, proc, n, n + 1, 1 + rng.below(9));
+                }
+                if (rng.below(4) == 0) {
+                    prog.step(pds, proc, n, rng.below(last[proc] + 1), 1 + rng.below(9));
+                }
+            }
+            prog.ret(pds, proc, last[proc], rng.below(3));
+        }
+    }
+
+    Key randomNode(Lcg & rng, std::vector<int> const & last)
+    {
+        int proc = rng.below(static_cast<int>(last.size()));
+        return prog.node(proc, rng.below(last[proc] + 1));
+    }
+
+    /// Runs poststarBatch on random programs and queries, some of which
+    /// start with a two-symbol stack, and checks each answer against
+    /// poststar of that query alone
+    template<typename Pds>
+    void expectSameAsPoststar(unsigned seed)
+    {
+        Lcg rng(seed);
+        for (int round = 0; round < 25; ++round) {
+            Pds pds;
+            std::vector<int> last;
+            buildProgram(pds, rng, last);
+
+            std::vector<WFA> queries;
+            int count = 1 + rng.below(4);
+            for (int i = 0; i < count; ++i) {
+                Key top = randomNode(rng, last);
+                if (rng.below(2) == 0) {
+                    queries.push_back(prog.query(top));
+                }
+                else {
+                    queries.push_back(prog.query(top, randomNode(rng, last)));
+                }
+            }
+
+            std::vector<WFA const *> inputs;
+            for (size_t i = 0; i < queries.size(); ++i) {
+                inputs.push_back(&queries[i]);
+            }
+            std::vector<WFA> outputs;
+            pds.poststarBatch(inputs, outputs);
+
+            ASSERT_EQ(inputs.size(), outputs.size());
+            for (size_t i = 0; i < inputs.size(); ++i) {
+                EXPECT_TRUE(pds.poststar(*inputs[i]).isIsomorphicTo(outputs[i]))
+                    << "round " << round << ", query " << i;
+            }
+        }
+    }
+}
+
+
+TEST(wali$wpds$WPDS$poststarBatch, eachAnswerIsThatQuerysPoststar)
+{
+    expectSameAsPoststar<WPDS>(1);
+}
+
+TEST(wali$wpds$WPDS$poststarBatch, ewpdsAnswersAreThatQuerysPoststar)
+{
+    expectSameAsPoststar<ewpds::EWPDS>(2);
+}
+
+TEST(wali$wpds$WPDS$poststarBatch, fwpdsAnswersAreThatQuerysPoststar)
+{
+    expectSameAsPoststar<fwpds::FWPDS>(3);
+}
@@ -0,0 +1,120 @@
+#include "gtest/gtest.h"
+
+#include "wali/ShortestPathSemiring.hpp"
+#include "wali/wpds/WPDS.hpp"
+#include "wali/wpds/fwpds/FWPDS.hpp"
+#include "wali/wfa/WFA.hpp"
+#include "wali/wfa/TransSet.hpp"
+
+#include "fixtures/SmallProgram.hpp"
+
+#include <map>
+
+using namespace wali;
+using namespace wali::wpds;
+using namespace wali::wfa;
+
+namespace {
+    testing::SmallProgram const prog("dem");
+
+    /// Procedure 0 calls procedure 1 at node 2 and procedure 2 at
+    /// node 4; procedure 1 calls procedure 2 at node 2. Each has six
+    /// nodes and ends in a return.
+    void buildProgram(WPDS & pds)
+    {
+        for (int proc = 0; proc < 3; ++proc) {
+            std::map<int, int> calls;
+            if (proc < 2) {
+                calls[2] = proc + 1;
+            }
+            if (proc == 0) {
+                calls[4] = 2;
+            }
+            prog.chain(pds, proc, 5, calls);
+        }
+    }
+
+    WFA entryQuery()
+    {
+        return prog.query(prog.node(0, 0));
+    }
+
+    void expectSameTransitions(WFA const & expected, WFA const & actual, Key from, Key stack)
+    {
+        TransSet want = expected.match(from, stack);
+        TransSet got = actual.match(from, stack);
+        ASSERT_FALSE(want.empty());
+        ASSERT_EQ(want.size(), got.size());
+        for (TransSet::iterator it = want.begin(); it != want.end(); ++it) {
+            TransSet::iterator match = got.find(from, stack, (*it)->to());
+            ASSERT_TRUE(match != got.end());
+            EXPECT_TRUE((*it)->weight()->equal((*match)->weight()));
+        }
+    }
+}
+
+
+TEST(wali$wpds$WPDS$poststarDemand, targetsBeforeACallSkipTheCallee)
+{
+    WPDS pds;
+    buildProgram(pds);
+    WFA query = entryQuery();
+    WFA full = pds.poststar(query);
+
+    std::set<KeyPair> targets;
+    targets.insert(KeyPair(prog.p(), prog.node(0, 1)));
+    WFA demand;
+    pds.poststarDemand(query, demand, targets);
+
+    expectSameTransitions(full, demand, prog.p(), prog.node(0, 1));
+    EXPECT_LT(demand.numTransitions(), full.numTransitions());
+    EXPECT_TRUE(demand.match(prog.p(), prog.node(2, 3)).empty());
+}
+
+TEST(wali$wpds$WPDS$poststarDemand, returnSitesWaitForTheirCallees)
+{
+    WPDS pds;
+    buildProgram(pds);
+    WFA query = entryQuery();
+    WFA full = pds.poststar(query);
+
+    std::set<KeyPair> targets;
+    targets.insert(KeyPair(prog.p(), prog.node(1, 4)));
+    targets.insert(KeyPair(prog.p(), prog.node(0, 3)));
+    WFA demand;
+    pds.poststarDemand(query, demand, targets);
+
+    expectSameTransitions(full, demand, prog.p(), prog.node(1, 4));
+    expectSameTransitions(full, demand, prog.p(), prog.node(0, 3));
+}
+
+TEST(wali$wpds$WPDS$poststarDemand, targetAutomatonIncludesTheStackBelow)
+{
+    WPDS pds;
+    buildProgram(pds);
+    WFA query = entryQuery();
+    WFA full = pds.poststar(query);
+
+    // <p, p1_n1 p0_n3>
+    WFA targets = prog.query(prog.node(1, 1), prog.node(0, 3));
+
+    WFA demand;
+    pds.poststarDemand(query, demand, targets);
+
+    expectSameTransitions(full, demand, prog.p(), prog.node(1, 1));
+    TransSet calls = full.match(prog.p(), prog.node(1, 1));
+    Key gstate = (*calls.begin())->to();
+    expectSameTransitions(full, demand, gstate, prog.node(0, 3));
+}
+
+TEST(wali$wpds$WPDS$poststarDemand, fwpdsRunsAFullPoststar)
+{
+    fwpds::FWPDS pds;
+    buildProgram(pds);
+    WFA query = entryQuery();
+    std::set<KeyPair> targets;
+    targets.insert(KeyPair(prog.p(), prog.node(0, 1)));
+    WFA demand;
+    pds.poststarDemand(query, demand, targets);
+    EXPECT_TRUE(pds.poststar(query).isIsomorphicTo(demand));
+}
@@ -0,0 +1,132 @@
+#include "gtest/gtest.h"
+
+#include "wali/ShortestPathSemiring.hpp"
+#include "wali/wpds/WPDS.hpp"
+#include "wali/wpds/ewpds/EWPDS.hpp"
+#include "wali/wfa/WFA.hpp"
+
+#include "fixtures/SmallProgram.hpp"
+
+#include <map>
+
+using namespace wali;
+using namespace wali::wpds;
+using namespace wali::wfa;
+using testing::dist;
+
+namespace {
+    testing::SmallProgram const prog("inc");
+
+    /// Three procedures of six nodes. Node 2 of procedures 0 and 1
+    /// calls the next procedure; each ends in a return.
+    void buildProgram(WPDS & pds)
+    {
+        for (int proc = 0; proc < 3; ++proc) {
+            std::map<int, int> calls;
+            if (proc < 2) {
+                calls[2] = proc + 1;
+            }
+            prog.chain(pds, proc, 5, calls);
+        }
+    }
+
+    WFA entryQuery()
+    {
+        return prog.query(prog.node(0, 0));
+    }
+
+    void expectSameAsPoststar(WPDS & pds, WFA const & query, WFA & answer)
+    {
+        pds.poststarIncremental(query, answer);
+        EXPECT_FALSE(pds.getIncrementalStats().full);
+        WFA fresh = pds.poststar(query);
+        EXPECT_TRUE(fresh.isIsomorphicTo(answer));
+    }
+}
+
+
+TEST(wali$wpds$WPDS$poststarIncremental, firstCallIsAFullPoststar)
+{
+    WPDS pds;
+    buildProgram(pds);
+    WFA query = entryQuery();
+    WFA answer;
+
+    pds.poststarIncremental(query, answer);
+    EXPECT_TRUE(pds.getIncrementalStats().full);
+    EXPECT_TRUE(pds.poststar(query).isIsomorphicTo(answer));
+
+    // Nothing changed, so there is nothing to do
+    pds.poststarIncremental(query, answer);
+    EXPECT_FALSE(pds.getIncrementalStats().full);
+    EXPECT_EQ(0u, pds.getIncrementalStats().restarted);
+}
+
+TEST(wali$wpds$WPDS$poststarIncremental, addedRulesOnlyPropagate)
+{
+    WPDS pds;
+    buildProgram(pds);
+    WFA query = entryQuery();
+    WFA answer;
+    pds.poststarIncremental(query, answer);
+
+    // A shortcut, a new call and a new return
+    prog.step(pds, 0, 0, 4, 1);
+    prog.call(pds, 2, 1, 0, 2, 2);
+    prog.ret(pds, 1, 3, 1);
+    expectSameAsPoststar(pds, query, answer);
+    EXPECT_EQ(0u, pds.getIncrementalStats().retracted);
+}
+
+TEST(wali$wpds$WPDS$poststarIncremental, replacedAndErasedRulesAreRetracted)
+{
+    WPDS pds;
+    buildProgram(pds);
+    WFA query = entryQuery();
+    WFA answer;
+    pds.poststarIncremental(query, answer);
+
+    pds.replace_rule(prog.p(), prog.node(0, 0), prog.p(), prog.node(0, 1), dist(7));
+    expectSameAsPoststar(pds, query, answer);
+    EXPECT_LT(0u, pds.getIncrementalStats().retracted);
+
+    // Cuts off procedure 2 and its generated state
+    pds.erase_rule(prog.p(), prog.node(1, 2), prog.p(), prog.node(2, 0), prog.node(1, 3));
+    expectSameAsPoststar(pds, query, answer);
+    EXPECT_LT(0u, pds.getIncrementalStats().erased);
+
+    prog.call(pds, 1, 2, 2, 3, 4);
+    pds.erase_rule(prog.p(), prog.node(0, 5), prog.p(), WALI_EPSILON, WALI_EPSILON);
+    expectSameAsPoststar(pds, query, answer);
+}
+
+TEST(wali$wpds$WPDS$poststarIncremental, ewpdsRunsAFullPoststar)
+{
+    ewpds::EWPDS pds;
+    buildProgram(pds);
+    WFA query = entryQuery();
+    WFA answer;
+    pds.poststarIncremental(query, answer);
+    prog.step(pds, 0, 0, 4, 1);
+    pds.poststarIncremental(query, answer);
+    EXPECT_TRUE(pds.getIncrementalStats().full);
+    EXPECT_TRUE(pds.poststar(query).isIsomorphicTo(answer));
+}
+
+TEST(wali$wpds$WPDS$poststarIncremental, changedInputRunsAFullPoststar)
+{
+    WPDS pds;
+    buildProgram(pds);
+    WFA query = entryQuery();
+    WFA answer;
+    pds.poststarIncremental(query, answer);
+
+    // Same WFA object, one more transition
+    query.addTrans(prog.p(), prog.node(1, 0), prog.accept(), dist(3));
+    pds.poststarIncremental(query, answer);
+    EXPECT_TRUE(pds.getIncrementalStats().full);
+    EXPECT_TRUE(pds.poststar(query).isIsomorphicTo(answer));
+
+    prog.step(pds, 1, 0, 4, 1);
+    expectSameAsPoststar(pds, query, answer);
+}
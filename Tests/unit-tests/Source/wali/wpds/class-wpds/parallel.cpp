@@ -0,0 +1,119 @@
+#include "gtest/gtest.h"
+
+#include "wali/ShortestPathSemiring.hpp"
+#include "wali/wpds/WPDS.hpp"
+#include "wali/wpds/ewpds/EWPDS.hpp"
+#include "wali/wpds/fwpds/FWPDS.hpp"
+#include "wali/wfa/WFA.hpp"
+
+#include "fixtures/SmallProgram.hpp"
+
+using namespace wali;
+using namespace wali::wpds;
+using namespace wali::wfa;
+using testing::dist;
+
+namespace {
+    testing::SmallProgram const prog("par");
+
+    /// Fills 'pds' with a small program: 'procs' procedures of 'nodes'
+    /// nodes each. Every procedure is a chain with a back edge; every
+    /// third node calls a later procedure (or, from the last procedure,
+    /// itself), so there is recursion and a fair amount of pop/push
+    /// interaction during saturation.
+    void buildProgram(WPDS & pds, int procs, int nodes)
+    {
+        unsigned seed = 7;
+        for (int proc = 0; proc < procs; ++proc) {
+            for (int n = 0; n + 1 < nodes; ++n) {
+                seed = seed * 1103515245u + 12345u;
+                unsigned w = (seed >> 16) % 10 + 1;
+
+                if (n % 3 == 1) {
+                    int callee = (proc + 1 < procs) ? proc + 1 : proc;
+                    prog.call(pds, proc, n, callee, n + 1, w);
+                }
+                else {
+                    prog.step(pds, proc, n, n + 1, w);
+                }
+            }
+            // back edge and return
+            prog.step(pds, proc, nodes - 1, 1, 3);
+            prog.ret(pds, proc, nodes - 1, 1);
+        }
+    }
+
+    WFA entryQuery()
+    {
+        return prog.query(prog.node(0, 0));
+    }
+
+    WFA exitQuery(int procs, int nodes)
+    {
+        WFA query = prog.query(prog.node(0, nodes - 1));
+        sem_elem_t one = dist(0)->one();
+        for (int proc = 1; proc < procs; ++proc) {
+            query.addTrans(prog.p(), prog.node(proc, nodes - 1), prog.accept(), one);
+        }
+        return query;
+    }
+
+    void expectSameAnswers(WPDS & pds, int procs, int nodes)
+    {
+        WFA post_query = entryQuery();
+        WFA pre_query = exitQuery(procs, nodes);
+
+        pds.setParallelism(1);
+        WFA seq_post = pds.poststar(post_query);
+        WFA seq_pre = pds.prestar(pre_query);
+
+        for (unsigned threads = 2; threads <= 4; threads += 2) {
+            ASSERT_TRUE(pds.setParallelism(threads));
+            EXPECT_EQ(threads, pds.getParallelism());
+
+            WFA par_post = pds.poststar(post_query);
+            WFA par_pre = pds.prestar(pre_query);
+            EXPECT_TRUE(seq_post.isIsomorphicTo(par_post));
+            EXPECT_TRUE(seq_pre.isIsomorphicTo(par_pre));
+        }
+    }
+}
+
+
+TEST(wali$wpds$WPDS$setParallelism, zeroMeansOneThread)
+{
+    WPDS pds;
+    EXPECT_EQ(1u, pds.getParallelism());
+    EXPECT_TRUE(pds.setParallelism(0));
+    EXPECT_EQ(1u, pds.getParallelism());
+}
+
+TEST(wali$wpds$WPDS$setParallelism, parallelQueriesOnEmptyWpds)
+{
+    WPDS pds;
+    ASSERT_TRUE(pds.setParallelism(4));
+    WFA query = entryQuery();
+    EXPECT_TRUE(query.isIsomorphicTo(pds.poststar(query)));
+    EXPECT_TRUE(query.isIsomorphicTo(pds.prestar(query)));
+}
+
+TEST(wali$wpds$WPDS$setParallelism, wpdsGivesSameAnswers)
+{
+    WPDS pds;
+    buildProgram(pds, 4, 10);
+    expectSameAnswers(pds, 4, 10);
+}
+
+TEST(wali$wpds$WPDS$setParallelism, ewpdsGivesSameAnswers)
+{
+    ewpds::EWPDS pds;
+    buildProgram(pds, 4, 10);
+    expectSameAnswers(pds, 4, 10);
+}
+
+TEST(wali$wpds$WPDS$setParallelism, fwpdsGivesSameAnswers)
+{
+    fwpds::FWPDS pds;
+    buildProgram(pds, 4, 10);
+    expectSameAnswers(pds, 4, 10);
+}